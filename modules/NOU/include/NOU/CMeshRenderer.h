@@ -23,6 +23,9 @@ namespace nou
 {
 	class CMeshRenderer
 	{
+		//The render system draws all of our renderers at once, sorted by what they draw.
+		friend class RenderSystem;
+
 		public:
 
 		CMeshRenderer(Entity& owner, const Mesh& mesh, Material& mat);
@@ -51,8 +54,12 @@ namespace nou
 
 		Entity* m_owner;
 		Material* m_mat;
+		const Mesh* m_mesh;
 		std::unique_ptr<VertexArray> m_vao;
 
+		//Whether our VAO has been set up to read per-instance transforms.
+		bool m_instancingReady;
+
 		//Having a default constructor makes it easier for us to inherit from
 		//this class later on (e.g., for a mesh renderer with skeletal animation).
 		//However, it does not make sense to instantiate this class on its own
@@ -12,8 +12,39 @@ Minimal and lightly OOP wrapper for the ENTT framework.
 
 #include "entt.hpp"
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 namespace nou
 {
+	//Every entity gets one of these, holding the hierarchy data for its transform.
+	//Entity::UpdateTransforms keeps them sorted depth-first, so parents always
+	//come before their children and every subtree is one unbroken run of nodes.
+	//That means all of the global transforms can be worked out with one pass
+	//straight through the array, and separate subtrees can be done on separate threads.
+	struct CTransformNode
+	{
+		glm::mat4 local;
+		glm::mat4 global;
+
+		//The transform this node belongs to. Its m_local and m_global are kept
+		//in step with ours, so GetGlobal, DoFK etc. still work as usual.
+		Transform* transform;
+
+		//Where our parent is in the sorted nodes (-1 if we don't have one,
+		//or if it doesn't belong to an entity).
+		int32_t parent;
+
+		//The transform's m_globalVersion when we last updated it -
+		//if it doesn't match, someone has updated it outside of the ECS.
+		uint32_t version;
+
+		//Set if our global transform changed in the last update,
+		//so our children know they need to be recomputed too.
+		bool dirty;
+	};
+
 	class Entity
 	{
 		public:
@@ -31,6 +62,13 @@ namespace nou
 		static Entity Create();
 		static std::unique_ptr<Entity> Allocate();
 
+		//Updates the global transform of every entity.
+		//Call this once per frame, after moving things around and before drawing.
+		//Only objects that have moved (or have a parent that moved) are recomputed,
+		//and separate subtrees are split across threads if parallel is set.
+		//This replaces calling DoFK on each of your root objects.
+		static void UpdateTransforms(bool parallel = true);
+
 		Entity(entt::entity id);
 		Entity(Entity&&) = delete;
 
@@ -56,7 +94,25 @@ namespace nou
 
 		protected:
 
+		//Systems that work on every entity at once need to get at the registry.
+		friend class RenderSystem;
+
 		static entt::registry ecs;
 		entt::entity m_id;	
+
+		//The nodes whose subtrees are too big to hand to a single thread -
+		//these are updated first, in order, before the jobs are started.
+		static std::vector<size_t> s_serialNodes;
+
+		//Runs of whole subtrees (start and end in the sorted nodes) that can
+		//each be updated on their own thread.
+		static std::vector<std::pair<size_t, size_t>> s_jobs;
+
+		//Sorts the transform nodes depth-first, fills in their parents,
+		//and splits them up into jobs.
+		static void SortTransforms();
+
+		//Updates a single node. Its parent must already be up to date.
+		static void UpdateNode(CTransformNode* nodes, size_t ix);
 	};
 }
\ No newline at end of file
@@ -3,7 +3,7 @@ NOU Framework - Created for INFR 2310 at Ontario Tech.
 (c) Samantha Stahlke 2020
 
 GLObjects.h
-Classes for managing OpenGL vertex buffers and vertex array objects.
+Classes for managing OpenGL vertex buffers, index buffers, and vertex array objects.
 You'll be learning a LOT more about this in your graphics class.
 */
 
@@ -13,6 +13,7 @@ You'll be learning a LOT more about this in your graphics class.
 #include <vector>
 #include <map>
 #include <string>
+#include <cstdint>
 
 #include "glad/glad.h"
 
@@ -28,23 +29,64 @@ namespace nou
 	{
 		public:
 
+		//How we get new data to the GPU when the buffer is updated.
+		//The GPU usually runs a frame or so behind us, so if we overwrite
+		//data it's still drawing with, the driver has to make us wait.
+		enum class UpdateMode
+		{
+			//For data that's set once (or rarely). Updates may have to wait on the GPU.
+			STATIC,
+			//Each full update hands the old storage back to the driver (called
+			//"orphaning") and writes into a fresh block, so we don't wait on
+			//draws that are still using the old data.
+			ORPHAN,
+			//The buffer holds RING_SIZE copies of the data and stays mapped,
+			//so we can write straight into GPU-visible memory. Each update
+			//moves on to the next copy, and a fence tells us when the GPU is
+			//done with a copy before we write to it again.
+			//Needs OpenGL 4.4 - falls back to ORPHAN otherwise.
+			//Best for data that changes every frame (e.g., animated meshes).
+			PERSISTENT
+		};
+
+		//The number of copies used by PERSISTENT buffers (i.e., triple buffering).
+		static const int RING_SIZE = 3;
+
 		template<typename T>
 		VertexBuffer(GLint elementLen, const std::vector<T>& data, bool dynamic = false)
+			: VertexBuffer(elementLen, data, dynamic ? UpdateMode::ORPHAN : UpdateMode::STATIC)
 		{
-			m_elementLen = elementLen;
-			m_startIndex = 0;
-			m_len = 0;
-			m_dynamic = dynamic;
+		}
 
-			glGenBuffers(1, &m_id);
+		template<typename T>
+		VertexBuffer(GLint elementLen, const std::vector<T>& data, UpdateMode mode)
+		{
+			Init(elementLen, mode);
 			UpdateData(data);
 		}
 
-		~VertexBuffer()
+		//Creates a buffer from raw data - used for interleaved buffers, where
+		//each element is a whole vertex made up of several attributes.
+		//(The number of components for each attribute is given when binding
+		//it to a VAO instead, so ElementLength() will be 0.)
+		VertexBuffer(GLsizei elementSize, GLsizei count, const void* data, bool dynamic = false)
+		{
+			Init(0, dynamic ? UpdateMode::ORPHAN : UpdateMode::STATIC);
+			UpdateData(data, elementSize, count);
+		}
+
+		//Creates a buffer from raw data where each element has elementLen
+		//float components. Pass nullptr to just allocate the buffer,
+		//then fill it in with UpdateRange.
+		VertexBuffer(GLint elementLen, GLsizei elementSize, GLsizei count,
+					 const void* data, UpdateMode mode = UpdateMode::STATIC)
 		{
-			glDeleteBuffers(1, &m_id);
+			Init(elementLen, mode);
+			UpdateData(data, elementSize, count);
 		}
 
+		~VertexBuffer();
+
 		//This is called a copy constructor.
 		//The delete keyword tells the compiler we don't want to allow this object
 		//to be copied.
@@ -79,19 +121,64 @@ namespace nou
 
 		GLuint GetID() const { return m_id; }
 
+		UpdateMode GetUpdateMode() const { return m_mode; }
+
+		//The amount of GPU memory allocated for the buffer
+		//(which for PERSISTENT buffers includes every copy).
+		size_t SizeInBytes() const;
+
+		//The number of times an update has had to wait for the GPU.
+		//If this keeps going up every frame, try a different UpdateMode.
+		size_t GetWaitCount() const { return m_waits; }
+
+		//Switches how the buffer is updated. This reads the current data
+		//back from the GPU, so do it at load time rather than every frame
+		//(or pass the mode to the constructor instead).
+		void SetUpdateMode(UpdateMode mode);
+
+		//Copies the buffer's current data back to the CPU. This may have to
+		//wait for the GPU, so do it at load time rather than every frame.
+		void ReadData(std::vector<unsigned char>& out) const;
+
 		//This uploads the data specified into our OpenGL buffer on the GPU.
+		//We only reallocate the buffer if the new data doesn't fit.
 		template<typename T>
 		void UpdateData(const std::vector<T>& data)
 		{
-			m_len = (GLsizei)data.size();
-			m_elementSize = sizeof(T);
+			UpdateData(data.data(), sizeof(T), (GLsizei)data.size());
+		}
 
-			GLenum usage = (m_dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+		//As above, but for raw data.
+		void UpdateData(const void* data, GLsizei elementSize, GLsizei count);
 
-			glBindBuffer(GL_ARRAY_BUFFER, m_id);
-			glBufferData(GL_ARRAY_BUFFER, m_len * m_elementSize, &(data[0]), usage);
+		//Updates only some of our data, starting from the element given.
+		//Useful if only part of a mesh is moving - but the new data can't go
+		//past the end of the buffer (use UpdateData to resize it).
+		//Returns false (and leaves the buffer alone) if it would.
+		template<typename T>
+		bool UpdateRange(const std::vector<T>& data, GLsizei first)
+		{
+			return UpdateRange(data.data(), first, (GLsizei)data.size());
 		}
 
+		//As above, but for raw data (count is in elements, not bytes).
+		bool UpdateRange(const void* data, GLsizei first, GLsizei count);
+
+		//Updates only part of each element - e.g., one attribute of an
+		//interleaved buffer. The data holds partSize bytes per element,
+		//which are written partOffset bytes into each one, and the rest
+		//of each element is left as it was.
+		bool UpdateRange(const void* data, GLsizei first, GLsizei count,
+						 GLsizei partSize, size_t partOffset);
+
+		//Incremented whenever the buffer moves somewhere else on the GPU
+		//(e.g., a PERSISTENT buffer moving on to its next copy), so that
+		//VertexArrays know to point their attributes at the new spot.
+		uint32_t GetBindVersion() const { return m_bindVersion; }
+
+		//Called by VertexArray when the buffer is used in a draw call.
+		void MarkDrawn() const { m_drawn = true; }
+
 		protected:
 
 		//The OpenGL ID of our VBO.
@@ -106,11 +193,119 @@ namespace nou
 		GLsizei m_len;
 
 		//Any offset we should take to get to the "first" element in our buffer.
-		//(Usually this will be 0 unless you are doing something Fancy(TM).)
+		//(Usually this will be 0 unless you are doing something Fancy(TM),
+		//like using a PERSISTENT buffer.)
 		GLsizei m_startIndex;
 
-		//Whether we expect to update this data frequently.
-		bool m_dynamic;
+		UpdateMode m_mode;
+
+		//The number of bytes we have room for (per copy, for PERSISTENT buffers).
+		GLsizeiptr m_capacity;
+
+		//For PERSISTENT buffers - where the buffer is mapped, which copy we're
+		//on, and the fences telling us when the GPU is done with each copy.
+		unsigned char* m_mapped;
+		int m_region;
+		GLsync m_fences[RING_SIZE];
+
+		//Also for PERSISTENT buffers. Each copy needs all of the data, so we
+		//keep it around on the CPU for when only part of it changes.
+		std::vector<unsigned char> m_shadow;
+
+		uint32_t m_bindVersion;
+		size_t m_waits;
+
+		//Whether we've drawn with the data since it was last written.
+		//If we haven't, a PERSISTENT buffer can overwrite its current copy.
+		mutable bool m_drawn;
+
+		void Init(GLint elementLen, UpdateMode mode);
+
+		//Prints a warning and returns false if the elements aren't all in the buffer.
+		bool CheckRange(GLsizei first, GLsizei count) const;
+
+		//(Re)creates our storage, big enough for the given number of bytes.
+		void Allocate(const void* data, GLsizeiptr size);
+
+		//Unmaps a PERSISTENT buffer and gets rid of its fences.
+		void ReleaseStorage();
+
+		//Moves a PERSISTENT buffer on to a copy the GPU isn't using.
+		void NextRegion();
+		void WaitForRegion(int region);
+	};
+
+	//Class for managing OpenGL index (or "element") buffers.
+	//Rather than spelling out all three vertices of every triangle,
+	//we can store each vertex once and describe the triangles with
+	//indices into our vertex buffers. Vertices shared between triangles
+	//are then only stored (and run through the vertex shader) once.
+	//Same as VertexBuffer, use these through pointers.
+	class IndexBuffer
+	{
+		public:
+
+		//A run of indices to draw. The indices in a range are added to
+		//baseVertex, which lets several pieces of a model share one set of
+		//buffers without having to rewrite their indices.
+		struct Range
+		{
+			GLsizei first;
+			GLsizei count;
+			GLint baseVertex;
+		};
+
+		//Type should be GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, or GL_UNSIGNED_INT.
+		//Pass nullptr as the data to just allocate the buffer, then fill it
+		//in with UpdateRange.
+		IndexBuffer(GLenum type, GLsizei count, const void* data);
+		~IndexBuffer();
+
+		//Same deal as VertexBuffer - no copying.
+		IndexBuffer(const IndexBuffer&) = delete;
+
+		GLenum GetType() const { return m_type; }
+
+		GLsizei Length() const { return m_len; }
+
+		//The size of a single index in bytes.
+		GLsizei IndexSize() const { return m_indexSize; }
+
+		GLuint GetID() const { return m_id; }
+
+		size_t SizeInBytes() const { return (size_t)m_len * (size_t)m_indexSize; }
+
+		//Updates some of our indices, starting from the index given.
+		//Returns false (and leaves the buffer alone) if they don't fit.
+		bool UpdateRange(const void* data, GLsizei first, GLsizei count);
+
+		//Without any ranges, the whole buffer is drawn as one.
+		void AddRange(GLsizei first, GLsizei count, GLint baseVertex = 0);
+		void ClearRanges();
+		const std::vector<Range>& GetRanges() const { return m_ranges; }
+
+		//Draws every range with a single call.
+		//The VAO this is attached to needs to be bound first.
+		void Draw(GLenum mode) const;
+		void DrawInstanced(GLenum mode, GLsizei instanceCount, GLuint baseInstance) const;
+
+		protected:
+
+		//The OpenGL ID of our buffer.
+		GLuint m_id;
+
+		GLenum m_type;
+		GLsizei m_indexSize;
+
+		//The number of indices in our buffer.
+		GLsizei m_len;
+
+		std::vector<Range> m_ranges;
+
+		//Our ranges laid out the way glMultiDrawElementsBaseVertex wants them.
+		std::vector<GLsizei> m_counts;
+		std::vector<const void*> m_offsets;
+		std::vector<GLint> m_baseVertices;
 	};
 
 	//Class for managing OpenGL Vertex Array Objects (VAOs).
@@ -136,6 +331,7 @@ namespace nou
 			m_drawMode = DrawMode::TRIANGLES;
 			glGenVertexArrays(1, &m_id);
 			m_len = 0;
+			m_ibo = nullptr;
 		}
 
 		~VertexArray()
@@ -226,18 +422,35 @@ namespace nou
 		//that this VAO represents, we need the data associated with the
 		//buffer specified to be found in the location specified.
 		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc)
+		{
+			BindAttrib(buf, attribLoc, buf.ElementLength(), 0, 0);
+		}
+
+		//Same as above, but for buffers that hold more than one attribute
+		//(e.g., interleaved vertex data). Stride is the size of a whole
+		//vertex in bytes, and offset is where this attribute starts within it.
+		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc,
+						GLint components, GLsizei stride, size_t offset)
 		{
 			m_vbos[attribLoc] = &buf;
+			m_bindings[attribLoc] = { components, stride, offset, 0 };
 
 			m_len = buf.Length();
 
+			ApplyBinding(attribLoc);
+		}
+
+		//Attaches an index buffer, which Draw and DrawInstanced will then use
+		//to work out which vertices to draw. Pass nullptr to go back to
+		//drawing the vertices in order.
+		void SetIndexBuffer(const IndexBuffer* ibo)
+		{
+			m_ibo = ibo;
+
+			//The element buffer binding is part of the VAO's state,
+			//so this only needs to happen once.
 			glBindVertexArray(m_id);
-			glEnableVertexAttribArray(attribLoc);
-			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
-			glVertexAttribPointer(attribLoc, buf.ElementLength(), 
-								  GL_FLOAT, GL_FALSE, 0,
-								 reinterpret_cast<void*>((long long)buf.StartIndex() *
-														 (long long)buf.ElementSize()));
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (ibo != nullptr) ? ibo->GetID() : 0);
 		}
 
 		void SetDrawMode(DrawMode drawMode)
@@ -249,15 +462,42 @@ namespace nou
 		{
 			m_len = m_vbos.begin()->second->Length();
 
+			Refresh();
 			glBindVertexArray(m_id);
-			glDrawArrays((int)m_drawMode, 0, m_len);
+
+			if (m_ibo != nullptr)
+				m_ibo->Draw((GLenum)m_drawMode);
+			else
+				glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
+		//Draws several copies of our "thing" in one call.
+		//Per-instance data comes from attributes with a divisor set
+		//(see RenderSystem), starting from the given instance.
+		void DrawInstanced(GLsizei instanceCount, GLuint baseInstance = 0)
+		{
+			m_len = m_vbos.begin()->second->Length();
+
+			Refresh();
+			glBindVertexArray(m_id);
+
+			if (m_ibo != nullptr)
+				m_ibo->DrawInstanced((GLenum)m_drawMode, instanceCount, baseInstance);
+			else
+				glDrawArraysInstancedBaseInstance((int)m_drawMode, 0, m_len,
+												  instanceCount, baseInstance);
+		}
+
+		GLuint GetID() const { return m_id; }
+
+		//Draws using indices kept on the CPU.
+		//(Only for VAOs without an index buffer attached.)
 		void DrawElements(const std::vector<GLuint>& indices, size_t count)
 		{
 			if (count == 0)
 				return;
 
+			Refresh();
 			glBindVertexArray(m_id);
 			glDrawElements((int)m_drawMode,
 						   static_cast<GLsizei>(count),
@@ -275,6 +515,54 @@ namespace nou
 
 		//A record of the VBOs associated with this VAO.
 		std::map<GLint, const VertexBuffer*> m_vbos;
+
+		//Our index buffer, if we have one.
+		const IndexBuffer* m_ibo;
+
+		//How each attribute is laid out in its VBO.
+		struct Binding
+		{
+			GLint components;
+			GLsizei stride;
+			size_t offset;
+			//The VBO's bind version when we last pointed the attribute at it.
+			uint32_t version;
+		};
+
+		std::map<GLint, Binding> m_bindings;
+
+		//Points an attribute at wherever its VBO's data currently is.
+		void ApplyBinding(GLint attribLoc)
+		{
+			const VertexBuffer& buf = *m_vbos[attribLoc];
+			Binding& binding = m_bindings[attribLoc];
+
+			size_t offset = binding.offset + (size_t)buf.StartIndex() * (size_t)buf.ElementSize();
+
+			glBindVertexArray(m_id);
+			glEnableVertexAttribArray(attribLoc);
+			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
+			glVertexAttribPointer(attribLoc, binding.components,
+								  GL_FLOAT, GL_FALSE, binding.stride,
+								  reinterpret_cast<void*>(offset));
+
+			binding.version = buf.GetBindVersion();
+		}
+
+		//Called before drawing - rebinds any VBOs that have moved since last time,
+		//and lets them know they're being drawn with.
+		void Refresh()
+		{
+			for (auto& [attribLoc, binding] : m_bindings)
+			{
+				const VertexBuffer* buf = m_vbos[attribLoc];
+
+				if (binding.version != buf->GetBindVersion())
+					ApplyBinding(attribLoc);
+
+				buf->MarkDrawn();
+			}
+		}
 	};
 }
 
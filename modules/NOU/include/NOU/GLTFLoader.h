@@ -12,6 +12,8 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #include "Mesh.h"
 
 #include <string>
+#include <vector>
+#include <memory>
 
 //Forward declaration of objects defined by the tinyGLTF library.
 namespace tinygltf
@@ -28,10 +30,38 @@ namespace nou::GLTF
 		size_t len;
 		int stride;
 		int elementSize;
+		//One of the TINYGLTF_COMPONENT_TYPE_ values (which match OpenGL's GL_FLOAT, etc.)
+		int componentType;
+		int components;
+		bool normalized;
+	};
+
+	//What we need to know about a primitive to load it into a mesh.
+	struct PrimitiveInfo
+	{
+		const tinygltf::Primitive* geom;
+		//Used when printing errors and warnings (e.g., "mesh 0, primitive 1").
+		std::string name;
+
+		int vID, nID, uvID;
+
+		GLsizei vertexCount;
+		GLsizei indexCount;
+
+		//Where the primitive's data starts in the mesh's buffers.
+		GLsizei baseVertex;
+		GLsizei firstIndex;
 	};
 
 	//Loads a 3D model into the mesh object given.
+	//Every primitive of every mesh in the file ends up in this one mesh.
+	//(Node transforms aren't applied, so files with several meshes
+	//that are positioned in the scene are better off using LoadMeshes.)
 	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true);
+
+	//Loads each mesh in the file into its own mesh object.
+	void LoadMeshes(const std::string& filename, std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY = true);
 	
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
@@ -41,17 +71,40 @@ namespace nou::GLTF
 	bool ParseGLTF(const std::string& filename, tinygltf::Model& gltf,
 				   std::string& err, std::string& warn);
 
-	//Takes a glTF model and extracts vertex positions, normals, and texture coordinates.
+	//Takes a glTF model and extracts vertex positions, normals, texture coordinates,
+	//and indices from the mesh with the given index (or from every mesh, if it's -1).
+	//The data is sent straight to the GPU - the mesh doesn't keep a copy of it.
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
-					     std::string& err, std::string& warn);
+					     std::string& err, std::string& warn, int meshIndex = -1);
 
-	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex, 
-					      std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-						  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
+	//Finds the accessors for a primitive and works out how much data it has.
+	bool ProcessPrimitive(const tinygltf::Model& gltf, const tinygltf::Primitive& geom,
+						  PrimitiveInfo& info, bool& hasNormals, bool& hasUVs,
 						  std::string& err, std::string& warn);
 
+	//Copies an attribute into a VBO, starting from the given vertex.
+	//Tightly packed float data goes straight from the glTF buffer to the GPU.
+	//Anything else is converted to floats in scratch first.
+	bool UploadAttrib(const tinygltf::Model& gltf, int accIndex, VertexBuffer& vbo,
+					  GLsizei first, int components, bool flipY,
+					  std::vector<float>& scratch, std::string& err);
+
+	//Same as above, but for a primitive's indices. Indices that are already
+	//in the IBO's format go straight to the GPU. Narrower ones are widened,
+	//and primitives without indices get 0, 1, 2...
+	bool UploadIndices(const tinygltf::Model& gltf, const PrimitiveInfo& info,
+					   IndexBuffer& ibo, std::vector<unsigned char>& scratch,
+					   std::string& err);
+
 	//Utility functions for more easily accessing data stored in glTF buffers.
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name);
+
+	//The getter's data will be nullptr if the accessor doesn't point
+	//to any (valid) data.
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex);
+
+	//Reads an accessor's data as floats (undoing any normalization),
+	//packed one element after the other. Returns false if the data isn't
+	//in a format we can convert.
+	bool ConvertToFloats(const DataGetter& getter, float* out);
 }
\ No newline at end of file
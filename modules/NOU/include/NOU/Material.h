@@ -35,6 +35,9 @@ namespace nou
 		//Should be called by the material's user before drawing the object (i.e., mesh).
 		void Use();
 
+		//Returns the shader program this material draws with.
+		const ShaderProgram* GetProgram() const;
+
 		protected:
 
 		//Small utility struct for managing how and where OpenGL will deal with our texture(s).
@@ -16,6 +16,8 @@ Very basic class for managing the data associated with a 3D model.
 #include <string>
 #include <map>
 #include <memory>
+#include <cstring>
+#include <cstdio>
 
 namespace nou
 {
@@ -34,18 +36,89 @@ namespace nou
 			SKIN_WEIGHT = 4
 		};
 
+		//What to do with our CPU copies of the data once it's been interleaved.
+		enum class CPUData
+		{
+			//Keep everything.
+			KEEP_ALL,
+			//Keep only the positions and normals - the data that morph targets
+			//and CPU skinning blend between. UVs are dropped.
+			KEEP_DEFORMABLE,
+			//Keep nothing - the mesh only lives on the GPU.
+			DISCARD
+		};
+
+		//Where an attribute's data lives on the GPU, for binding to a VAO.
+		struct AttribLayout
+		{
+			const VertexBuffer* buffer;
+			GLint components;
+			GLsizei stride;
+			//Where the attribute starts within each element of the buffer.
+			size_t offset;
+		};
+
 		Mesh() = default;
 		virtual ~Mesh() = default;
 
+		//If the mesh has been interleaved, these will update the attribute
+		//in place on the GPU. (You can't add a new attribute or change the
+		//number of vertices of an interleaved mesh.)
 		void SetVerts(const std::vector<glm::vec3>& verts);
 		void SetNormals(const std::vector<glm::vec3>& normals);
 		void SetUVs(const std::vector<glm::vec2>& uvs);
 
+		//Lists the vertices making up each triangle. Without indices,
+		//every three vertices in a row make up a triangle.
+		//Pass an empty vector to go back to drawing without indices.
+		void SetIndices(const std::vector<GLuint>& indices);
+
+		//Used by loaders (e.g., GLTF::LoadMesh) to send data straight to the GPU
+		//without keeping a copy on the CPU. These make empty buffers of the
+		//given size, which the loader then fills in with UpdateRange.
+		//Returns nullptr for an interleaved mesh, since its layout is fixed.
+		VertexBuffer* CreateVBO(Attrib attrib, GLint elementLen, GLsizei elementSize, GLsizei count);
+		IndexBuffer* CreateIBO(GLenum type, GLsizei count);
+
+		//Packs positions, normals, and UVs into a single vertex buffer,
+		//so the GPU fetches each vertex from one place instead of three.
+		//Call this after setting the mesh's data and before creating any
+		//renderers with it. Prints the mesh's memory usage before and after.
+		//Attributes that only live on the GPU (e.g., from GLTF::LoadMesh)
+		//are read back first, so this is best done at load time.
+		//Returns false (and leaves the mesh alone) if the attributes
+		//don't all have the same number of elements.
+		bool Interleave(CPUData keep = CPUData::DISCARD);
+		bool IsInterleaved() const;
+
 		//Fetches a vertex buffer associated with the desired attribute.
 		//Used by mesh rendering components to grab the requisite data
 		//associated with this model in OpenGL.
+		//For an interleaved mesh, every attribute shares the same buffer,
+		//so use GetAttribLayout to find out where in it to look.
 		const VertexBuffer* GetVBO(Attrib attrib) const;
 
+		//Fills in the buffer and layout to bind for the desired attribute.
+		//Returns false if the mesh doesn't have that attribute.
+		bool GetAttribLayout(Attrib attrib, AttribLayout& layout) const;
+
+		//Returns nullptr if the mesh doesn't use indices.
+		const IndexBuffer* GetIBO() const;
+
+		size_t GetVertexCount() const;
+
+		//Sets how the mesh's vertex buffers are updated by SetVerts etc.
+		//Use VertexBuffer::UpdateMode::PERSISTENT for meshes that change
+		//every frame (e.g., morph targets or CPU skinning).
+		//This applies to the interleaved buffer too, if there is one.
+		void SetUpdateMode(VertexBuffer::UpdateMode mode);
+
+		//Memory used by our data, in bytes.
+		size_t GetCPUMemory() const;
+		size_t GetGPUMemory() const;
+
+		void PrintMemoryUsage(const std::string& label) const;
+
 		protected:
 
 		std::vector<glm::vec3> m_verts;
@@ -53,6 +126,14 @@ namespace nou
 		std::vector<glm::vec2> m_uvs;
 
 		std::map<Attrib, std::unique_ptr<VertexBuffer>> m_vbo;
+		std::unique_ptr<IndexBuffer> m_ibo;
+
+		//Used in place of m_vbo once the mesh has been interleaved.
+		std::unique_ptr<VertexBuffer> m_interleaved;
+		std::map<Attrib, AttribLayout> m_layout;
+		CPUData m_keep = CPUData::KEEP_ALL;
+
+		VertexBuffer::UpdateMode m_updateMode = VertexBuffer::UpdateMode::STATIC;
 
 		//Sets up a VertexBuffer for the desired attribute.
 		template<typename T>
@@ -71,10 +152,56 @@ namespace nou
 			//If our VBO does not already exist, make a new one.
 			if (it == m_vbo.end())
 				m_vbo.insert({attrib,
-					std::make_unique<VertexBuffer>(elementLen, data)});
+					std::make_unique<VertexBuffer>(elementLen, data, m_updateMode)});
 			//If our VBO does exist, update it with the new data specified.
 			else
 				it->second->UpdateData(data);
 		}
+
+		//Writes one attribute into the interleaved buffer, leaving the others alone.
+		template<typename T>
+		bool UpdateInterleaved(Attrib attrib, const std::vector<T>& data)
+		{
+			auto it = m_layout.find(attrib);
+
+			if (it == m_layout.end() || data.size() != (size_t)m_interleaved->Length())
+			{
+				printf("Can't change the layout or vertex count of an interleaved mesh.\n");
+				return false;
+			}
+
+			const AttribLayout& layout = it->second;
+
+			//This goes through the buffer's update mode, so a PERSISTENT
+			//interleaved buffer is written without waiting on the GPU.
+			return m_interleaved->UpdateRange(data.data(), 0, (GLsizei)data.size(),
+											  (GLsizei)sizeof(T), layout.offset);
+		}
+
+		//Reads an attribute back from its own vertex buffer, if it has one and
+		//we don't already have it on the CPU. Returns false if the buffer's
+		//elements aren't the size we expect.
+		template<typename T>
+		bool ReadBackVBO(Attrib attrib, std::vector<T>& out) const
+		{
+			auto it = m_vbo.find(attrib);
+
+			if (!out.empty() || it == m_vbo.end())
+				return true;
+
+			if (it->second->ElementSize() != (GLsizei)sizeof(T))
+				return false;
+
+			std::vector<unsigned char> bytes;
+			it->second->ReadData(bytes);
+
+			out.resize(bytes.size() / sizeof(T));
+			memcpy(out.data(), bytes.data(), out.size() * sizeof(T));
+
+			return true;
+		}
+
+		//Whether we should hold on to a CPU copy of an attribute after interleaving.
+		bool KeepsCPUData(Attrib attrib) const;
 	};
 }
\ No newline at end of file
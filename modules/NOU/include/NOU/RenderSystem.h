@@ -0,0 +1,75 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+RenderSystem.h
+Draws every CMeshRenderer in the scene at once, with as few
+state changes and draw calls as we can get away with.
+*/
+
+#pragma once
+
+#include "CMeshRenderer.h"
+
+#include "GLM/glm.hpp"
+
+#include <vector>
+
+namespace nou
+{
+	class RenderSystem
+	{
+		public:
+
+		//Per-instance transforms are read from these attribute locations.
+		//They come after the ones used by meshes (see Mesh::Attrib).
+		//(A mat4 takes up 4 locations, and a mat3 takes up 3.)
+		static const GLuint INSTANCE_MODEL_LOC = 5;
+		static const GLuint INSTANCE_NORMAL_LOC = 9;
+
+		//Draws every entity with a CMeshRenderer from the current camera.
+		//Renderers are sorted by shader program, then material, then mesh,
+		//so each program and material is only bound once, and viewproj is
+		//only uploaded once per program.
+		//If a program reads its transforms from instance attributes
+		//(see ShaderProgram::UsesInstancing), everything sharing a mesh
+		//and material is drawn with a single instanced draw call.
+		//Make sure your transforms are up to date (e.g., via
+		//Entity::UpdateTransforms) before calling this.
+		static void Draw();
+
+		//Returns the number of draw calls made by the last call to Draw.
+		static size_t GetDrawCallCount();
+
+		protected:
+
+		struct DrawItem
+		{
+			const ShaderProgram* program;
+			Material* material;
+			const Mesh* mesh;
+			CMeshRenderer* renderer;
+		};
+
+		//Laid out to match the instance attributes.
+		struct InstanceData
+		{
+			glm::mat4 model;
+			glm::mat3 normal;
+		};
+
+		//These are kept around between frames so we aren't reallocating them every time.
+		static std::vector<DrawItem> s_items;
+		static std::vector<InstanceData> s_instances;
+
+		static GLuint s_instanceBuffer;
+		static GLsizeiptr s_instanceCapacity;
+		static size_t s_drawCalls;
+
+		//Uploads all of this frame's instance data in one go.
+		static void UploadInstances();
+
+		//Points a renderer's VAO at the instance buffer (only needs to happen once per VAO).
+		static void SetupInstancing(CMeshRenderer& renderer);
+	};
+}
\ No newline at end of file
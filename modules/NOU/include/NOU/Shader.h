@@ -11,6 +11,7 @@ Utility classes for managing OpenGL shaders and shader programs.
 #include <memory>
 #include <string>
 #include <vector>
+#include <unordered_map>
 
 #include "glad/glad.h"
 
@@ -62,10 +63,30 @@ namespace nou
 		//Fetches the shader program currently in use.
 		static const ShaderProgram* Current();
 
+		//Returns the OpenGL ID of the program.
+		GLuint GetID() const;
+
 		//Utility functions for managing uniforms - variables
 		//we send to the shader that persist until we change them.
+		//Locations are looked up once and then cached, so setting
+		//uniforms by name every frame doesn't query OpenGL every time.
 		GLint GetUniformLoc(const std::string& name) const;
 
+		//Returns the location of a vertex attribute, or -1 if the
+		//program doesn't use it.
+		GLint GetAttribLoc(const std::string& name) const;
+
+		//Locations of the uniforms the render system sets on every program,
+		//looked up once when the program is linked (-1 if it doesn't use them).
+		GLint GetViewProjLoc() const;
+		GLint GetModelLoc() const;
+		GLint GetNormalLoc() const;
+
+		//True if the program reads its transforms from per-instance
+		//attributes (an inModel attribute) instead of the model and
+		//normal uniforms, like the *_instanced.vert shaders do.
+		bool UsesInstancing() const;
+
 		template<typename T>
 		void SetUniform(const std::string& name, const T& value) const;
 
@@ -77,6 +98,15 @@ namespace nou
 		//The OpenGL ID of our shader program.
 		GLuint m_id;
 
+		//Uniform locations we've already looked up.
+		mutable std::unordered_map<std::string, GLint> m_uniformLocs;
+
+		//What the render system needs to know to draw with us.
+		GLint m_viewprojLoc;
+		GLint m_modelLoc;
+		GLint m_normalLoc;
+		bool m_instanced;
+
 		//The shader program currently in use.
 		static const ShaderProgram* m_current;
 
@@ -14,6 +14,7 @@ Simple class for managing object transforms with basic hierarchy support.
 #include "GLM/gtx/quaternion.hpp"
 
 #include <vector>
+#include <cstdint>
 
 //Simple implementation of a transform component.
 
@@ -37,10 +38,15 @@ namespace nou
 		//call this once per frame before making all of your draw
 		//calls on the root node of your Scene.
 		//(FK stands for "forward kinematics", by the way.)
+		//If all of your transforms belong to entities, Entity::UpdateTransforms
+		//will do the same for every hierarchy at once, and faster.
 		void DoFK();
 
 		//This will recompute and return the global transform
 		//of this object.
+		//Only the objects on the path to the root that have actually
+		//changed are recomputed, so calling this on every object in
+		//a hierarchy no longer redoes the same work over and over.
 		const glm::mat4& RecomputeGlobal();
 
 		//This will return the current global transform of the
@@ -58,17 +64,65 @@ namespace nou
 		//Pass in nullptr if you wish for the object to not have a parent.
 		void SetParent(Transform* parent);
 
+		//Returns how many parents are above this object (0 for a root).
+		uint32_t GetDepth() const;
+
+		//Changes to m_pos, m_scale and m_rotation are picked up
+		//automatically, but this will force the object (and everything
+		//below it) to be recomputed on the next update.
+		void MarkDirty();
+
 		protected:
 
+		//Entities keep their transforms' hierarchy in the ECS, sorted
+		//depth-first, and need to know when that order has changed.
+		friend class Entity;
+
+		//The local values m_local was last built from - if they don't
+		//match the public ones, the object has been moved.
+		//(These are kept right after the public values, since they're
+		//checked against each other for every object on every update.)
+		glm::vec3 m_cachedPos;
+		glm::vec3 m_cachedScale;
+		glm::quat m_cachedRotation;
+		bool m_dirty;
+
+		uint32_t m_depth;
+		//Bumped every time m_global changes. Children remember the version
+		//of their parent's global they were computed from, so they know
+		//when they need to be recomputed without any flags being pushed down.
+		uint32_t m_globalVersion;
+		uint32_t m_parentVersion;
+
+		//Where this object's node was put in the ECS by the last sort
+		//(-1 if it has never been sorted, e.g. it doesn't belong to an entity).
+		int32_t m_node;
+
 		Transform* m_parent;
 		std::vector<Transform*> m_children;
 
 		glm::mat4 m_global;
+		glm::mat4 m_local;
+
+		//Set whenever a parent is changed, so the ECS knows to re-sort.
+		static bool s_hierarchyChanged;
 
 		//These functions are protected since they will be handled
 		//by SetParent - we don't want to have to manually update this ourselves
 		//whenever we switch an object's parent!
 		void AddChild(Transform* child);
 		void RemoveChild(Transform* child);
+
+		//Updates the depth of this object and everything below it.
+		void SetDepth(uint32_t depth);
+
+		//Rebuilds m_local if the local values have changed.
+		//Returns true if they had.
+		bool UpdateLocal();
+
+		//Recomputes m_global if this object or its parent have changed
+		//since the last update. The parent must already be up to date.
+		//Returns true if m_global was recomputed.
+		bool UpdateGlobal();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+lit_instanced.vert
+Vertex shader.
+Passes world vertex position and transformed normal direction
+to the fragment shader.
+Instanced version - the model and normal matrices are per-instance
+attributes filled in by the RenderSystem, rather than uniforms.
+*/
+
+#version 420 core
+
+uniform mat4 viewproj;
+
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec3 inNorm;
+
+//Per-instance transforms (see RenderSystem::INSTANCE_MODEL_LOC).
+layout(location = 5) in mat4 inModel;
+layout(location = 9) in mat3 inNormalMat;
+
+layout(location = 0) out vec4 outPos;
+layout(location = 1) out vec3 outNorm;
+
+void main()
+{
+    outNorm = inNormalMat * inNorm;
+    outPos = inModel * inPos;
+
+    gl_Position = viewproj * outPos;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+texturedunlit_instanced.vert
+Vertex shader.
+Passes world vertex position and UV coordinates to the fragment shader.
+Instanced version - the model and normal matrices are per-instance
+attributes filled in by the RenderSystem, rather than uniforms.
+*/
+
+#version 420 core
+
+uniform mat4 viewproj;
+
+layout(location = 0) in vec4 inPos;
+layout(location = 2) in vec2 inUV;
+
+//Per-instance transform (see RenderSystem::INSTANCE_MODEL_LOC).
+layout(location = 5) in mat4 inModel;
+
+layout(location = 2) out vec2 outUV;
+
+void main()
+{
+    outUV = inUV;
+    gl_Position = viewproj * inModel * inPos;
+}
\ No newline at end of file
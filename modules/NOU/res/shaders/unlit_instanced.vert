@@ -0,0 +1,24 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+unlit_instanced.vert
+Vertex shader.
+Passes world vertex position to the fragment shader.
+Instanced version - the model and normal matrices are per-instance
+attributes filled in by the RenderSystem, rather than uniforms.
+*/
+
+#version 420 core
+
+uniform mat4 viewproj;
+
+layout(location = 0) in vec4 inPos;
+
+//Per-instance transform (see RenderSystem::INSTANCE_MODEL_LOC).
+layout(location = 5) in mat4 inModel;
+
+void main()
+{
+    gl_Position = viewproj * inModel * inPos;
+}
\ No newline at end of file
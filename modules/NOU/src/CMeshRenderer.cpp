@@ -19,7 +19,9 @@ namespace nou
 	{
 		m_owner = nullptr;
 		m_mat = nullptr;
+		m_mesh = nullptr;
 		m_vao = nullptr;
+		m_instancingReady = false;
 	}
 
 	CMeshRenderer::CMeshRenderer(Entity& owner, 
@@ -28,7 +30,9 @@ namespace nou
 	{
 		m_owner = &owner;
 		m_mat = &mat;
+		m_mesh = nullptr;
 		m_vao = std::make_unique<VertexArray>();
+		m_instancingReady = false;
 		SetMesh(mesh);	
 	}
 
@@ -38,16 +42,20 @@ namespace nou
 	//the data needed to draw our 3D model.
 	void CMeshRenderer::SetMesh(const Mesh& mesh)
 	{
-		const VertexBuffer* vbo;
+		Mesh::AttribLayout layout;
 
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
+		m_mesh = &mesh;
 
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::NORMAL)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::NORMAL);
+		//Interleaved meshes keep everything in one buffer, so we also
+		//need to know where each attribute sits within a vertex.
+		for (Mesh::Attrib attrib : { Mesh::Attrib::POSITION, Mesh::Attrib::NORMAL, Mesh::Attrib::UV })
+		{
+			if (mesh.GetAttribLayout(attrib, layout))
+				m_vao->BindAttrib(*layout.buffer, (GLint)attrib,
+								  layout.components, layout.stride, layout.offset);
+		}
 
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
+		m_vao->SetIndexBuffer(mesh.GetIBO());
 	}
 
 	void CMeshRenderer::SetMaterial(Material& mat)
@@ -55,6 +63,8 @@ namespace nou
 		m_mat = &mat;
 	}
 
+	//Draws just this renderer. To draw everything in the scene,
+	//RenderSystem::Draw is much faster than calling this on every entity.
 	void CMeshRenderer::Draw()
 	{
 		m_mat->Use();
@@ -8,9 +8,142 @@ Minimal and lightly OOP wrapper for the ENTT framework.
 
 #include "NOU/Entity.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 namespace nou
 {
 	entt::registry Entity::ecs;
+	std::vector<size_t> Entity::s_serialNodes;
+	std::vector<std::pair<size_t, size_t>> Entity::s_jobs;
+
+	//Fewer nodes than this aren't worth waking the worker threads up for.
+	static const size_t PARALLEL_MIN_NODES = 4096;
+
+	//Subtrees up to this size are handed to a thread whole, and small ones
+	//are bundled together until they reach it. Anything bigger is split
+	//up into the subtrees below its root.
+	static const size_t JOB_NODES = 1024;
+
+	//A set of threads that sticks around between updates, so we aren't
+	//starting (and joining) new threads every frame.
+	class TransformWorkers
+	{
+		public:
+
+		~TransformWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_quit = true;
+			}
+
+			m_wake.notify_all();
+
+			for (auto& thread : m_threads)
+				thread.join();
+		}
+
+		//How many threads we can use, counting the calling one.
+		unsigned int NumThreads()
+		{
+			return std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		//Calls job(0) to job(count - 1) across the workers and the calling
+		//thread, and returns once they have all finished.
+		void Run(size_t count, const std::function<void(size_t)>& job)
+		{
+			//The threads are only started the first time we need them.
+			if (m_threads.empty())
+			{
+				for (unsigned int ix = 1; ix < NumThreads(); ++ix)
+					m_threads.emplace_back([this]() { WorkerLoop(); });
+			}
+
+			{
+				//A worker that woke up late for the last job may still be
+				//on its way out of it, so we let it go before setting this one up.
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_done.wait(lock, [this]() { return m_active == 0; });
+
+				m_job = &job;
+				m_count = count;
+				m_next = 0;
+				m_remaining = count;
+				m_generation++;
+			}
+
+			m_wake.notify_all();
+			DoJobs();
+
+			//Workers may still be looking at this job after the last part
+			//is done, so we wait for them to leave it before it goes out of scope.
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this]() { return m_remaining == 0 && m_active == 0; });
+			m_job = nullptr;
+		}
+
+		protected:
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		const std::function<void(size_t)>* m_job = nullptr;
+		size_t m_count = 0;
+		std::atomic<size_t> m_next = 0;
+		std::atomic<size_t> m_remaining = 0;
+		unsigned int m_active = 0;
+		uint64_t m_generation = 0;
+		bool m_quit = false;
+
+		void DoJobs()
+		{
+			for (size_t ix = m_next++; ix < m_count; ix = m_next++)
+			{
+				(*m_job)(ix);
+
+				if (--m_remaining == 0)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_done.notify_all();
+				}
+			}
+		}
+
+		void WorkerLoop()
+		{
+			uint64_t generation = 0;
+
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_wake.wait(lock, [&]() { return m_quit || m_generation != generation; });
+
+					if (m_quit)
+						return;
+
+					generation = m_generation;
+					m_active++;
+				}
+
+				DoJobs();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_active--;
+				m_done.notify_all();
+			}
+		}
+	};
+
+	static TransformWorkers s_workers;
 
 	Entity Entity::Create()
 	{
@@ -27,11 +160,214 @@ namespace nou
 	Entity::Entity(entt::entity id)
 	{
 		m_id = id;
+
+		//Our transform lives as long as we do, so the node can safely point to it.
+		if (m_id != entt::null)
+		{
+			ecs.emplace<CTransformNode>(m_id, CTransformNode{ glm::mat4(1.0f), glm::mat4(1.0f), &transform, -1, 0, true });
+			Transform::s_hierarchyChanged = true;
+		}
 	}
 
 	Entity::~Entity()
 	{
-		if(m_id != entt::null)
+		if (m_id != entt::null)
+		{
 			ecs.destroy(m_id);
+			//Removing a node moves another one into its place, breaking the sort order.
+			Transform::s_hierarchyChanged = true;
+		}
+	}
+
+	void Entity::UpdateTransforms(bool parallel)
+	{
+		if (Transform::s_hierarchyChanged)
+			SortTransforms();
+
+		auto view = ecs.view<CTransformNode>();
+		CTransformNode* nodes = view.raw();
+		size_t count = view.size();
+
+		if (!parallel || count < PARALLEL_MIN_NODES || s_jobs.size() < 2 || s_workers.NumThreads() == 1)
+		{
+			//Parents come before their children, so one pass does everything.
+			for (size_t ix = 0; ix < count; ++ix)
+				UpdateNode(nodes, ix);
+
+			return;
+		}
+
+		//The tops of the big subtrees come first, since the jobs below them
+		//need them. (They're in depth-first order, so parents are still first.)
+		for (size_t ix : s_serialNodes)
+			UpdateNode(nodes, ix);
+
+		//Every job is made of whole subtrees, so they don't depend on each other.
+		s_workers.Run(s_jobs.size(), [nodes](size_t job)
+		{
+			for (size_t ix = s_jobs[job].first; ix < s_jobs[job].second; ++ix)
+				UpdateNode(nodes, ix);
+		});
+	}
+
+	void Entity::SortTransforms()
+	{
+		auto view = ecs.view<CTransformNode>();
+		CTransformNode* nodes = view.raw();
+		size_t count = view.size();
+
+		//Let every transform know where its node currently is, so that we
+		//can tell which parents belong to entities (and which don't).
+		for (size_t ix = 0; ix < count; ++ix)
+			nodes[ix].transform->m_node = (int32_t)ix;
+
+		auto isNode = [&nodes, count](const Transform* t)
+		{
+			return t != nullptr && t->m_node >= 0 && (size_t)t->m_node < count &&
+				   nodes[t->m_node].transform == t;
+		};
+
+		//Walk each hierarchy depth-first, from every transform without an entity parent.
+		//(We go through the roots in their current order, so that things stay
+		//roughly in the order they were created in - and so close together in memory.)
+		std::vector<Transform*> order;
+		std::vector<Transform*> stack;
+		order.reserve(count);
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			Transform* root = nodes[ix].transform;
+
+			if (isNode(root->m_parent))
+				continue;
+
+			stack.push_back(root);
+
+			while (!stack.empty())
+			{
+				Transform* t = stack.back();
+				stack.pop_back();
+				order.push_back(t);
+
+				//Pushed in reverse, so the first child comes out first.
+				for (auto it = t->m_children.rbegin(); it != t->m_children.rend(); ++it)
+				{
+					if (isNode(*it))
+						stack.push_back(*it);
+				}
+			}
+		}
+
+		for (size_t ix = 0; ix < order.size(); ++ix)
+			order[ix]->m_node = (int32_t)ix;
+
+		//ENTT keeps components in the reverse order of iteration,
+		//so sorting back-to-front for iteration leaves the raw array
+		//in depth-first order - which is the order we walk it in.
+		ecs.sort<CTransformNode>([](const CTransformNode& lhs, const CTransformNode& rhs)
+		{
+			return lhs.transform->m_node > rhs.transform->m_node;
+		});
+
+		nodes = view.raw();
+
+		//Every parent is now before its children, so we can add up the
+		//size of each subtree by going backwards.
+		std::vector<size_t> sizes(count, 1);
+
+		for (size_t ix = count; ix-- > 0;)
+		{
+			const Transform* parent = nodes[ix].transform->m_parent;
+			nodes[ix].parent = isNode(parent) ? parent->m_node : -1;
+
+			if (nodes[ix].parent >= 0)
+				sizes[nodes[ix].parent] += sizes[ix];
+		}
+
+		//Split everything up into jobs. A subtree that's small enough becomes
+		//(part of) a job and we skip to the next one after it. A bigger one has
+		//its root done up front, and we carry on into its children.
+		s_serialNodes.clear();
+		s_jobs.clear();
+
+		for (size_t ix = 0; ix < count;)
+		{
+			if (sizes[ix] > JOB_NODES)
+			{
+				s_serialNodes.push_back(ix);
+				ix++;
+				continue;
+			}
+
+			size_t end = ix + sizes[ix];
+
+			if (!s_jobs.empty() && s_jobs.back().second == ix && end - s_jobs.back().first <= JOB_NODES)
+				s_jobs.back().second = end;
+			else
+				s_jobs.push_back({ ix, end });
+
+			ix = end;
+		}
+
+		Transform::s_hierarchyChanged = false;
+	}
+
+	void Entity::UpdateNode(CTransformNode* nodes, size_t ix)
+	{
+		CTransformNode& node = nodes[ix];
+		Transform& t = *node.transform;
+
+		//If our parent doesn't belong to an entity, it isn't in the array,
+		//so we let the transform update itself from it and just copy the result.
+		if (node.parent < 0 && t.m_parent != nullptr)
+		{
+			t.UpdateGlobal();
+			node.dirty = (node.version != t.m_globalVersion);
+
+			if (node.dirty)
+			{
+				node.local = t.m_local;
+				node.global = t.m_global;
+				node.version = t.m_globalVersion;
+			}
+
+			return;
+		}
+
+		//We need to be recomputed if we've moved, if our parent has,
+		//or if someone has updated our transform outside of the ECS
+		//(e.g. with RecomputeGlobal) since our last update.
+		bool changed = t.UpdateLocal() || node.version != t.m_globalVersion;
+
+		if (changed)
+			node.local = t.m_local;
+
+		if (node.parent >= 0)
+		{
+			const CTransformNode& parent = nodes[node.parent];
+
+			if (!changed && !parent.dirty)
+			{
+				node.dirty = false;
+				return;
+			}
+
+			node.global = parent.global * node.local;
+			t.m_parentVersion = parent.version;
+		}
+		else
+		{
+			if (!changed)
+			{
+				node.dirty = false;
+				return;
+			}
+
+			node.global = node.local;
+		}
+
+		t.m_global = node.global;
+		node.version = ++t.m_globalVersion;
+		node.dirty = true;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,493 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+GLObjects.cpp
+Classes for managing OpenGL vertex buffers, index buffers, and vertex array objects.
+You'll be learning a LOT more about this in your graphics class.
+*/
+
+#include "NOU/GLObjects.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+namespace nou
+{
+	//How long to wait on a fence before checking again (1 ms, in nanoseconds).
+	static const GLuint64 FENCE_TIMEOUT = 1000000;
+
+	VertexBuffer::~VertexBuffer()
+	{
+		ReleaseStorage();
+		glDeleteBuffers(1, &m_id);
+	}
+
+	void VertexBuffer::Init(GLint elementLen, UpdateMode mode)
+	{
+		m_elementLen = elementLen;
+		m_elementSize = 0;
+		m_startIndex = 0;
+		m_len = 0;
+		m_capacity = 0;
+
+		m_mapped = nullptr;
+		m_region = 0;
+
+		for (auto& fence : m_fences)
+			fence = nullptr;
+
+		m_bindVersion = 1;
+		m_waits = 0;
+		m_drawn = false;
+
+		//Persistent mapping needs glBufferStorage, which is new in 4.4.
+		if (mode == UpdateMode::PERSISTENT && !GLAD_GL_VERSION_4_4)
+		{
+			printf("Persistent buffers need OpenGL 4.4 - using orphaning instead.\n");
+			mode = UpdateMode::ORPHAN;
+		}
+
+		m_mode = mode;
+
+		glGenBuffers(1, &m_id);
+	}
+
+	size_t VertexBuffer::SizeInBytes() const
+	{
+		return (size_t)m_capacity * ((m_mode == UpdateMode::PERSISTENT) ? RING_SIZE : 1);
+	}
+
+	void VertexBuffer::SetUpdateMode(UpdateMode mode)
+	{
+		if (mode == UpdateMode::PERSISTENT && !GLAD_GL_VERSION_4_4)
+		{
+			printf("Persistent buffers need OpenGL 4.4 - using orphaning instead.\n");
+			mode = UpdateMode::ORPHAN;
+		}
+
+		if (mode == m_mode)
+			return;
+
+		//Grab a copy of our current data so we can put it in the new storage.
+		std::vector<unsigned char> data;
+		ReadData(data);
+
+		m_mode = mode;
+		Allocate(data.data(), (GLsizeiptr)data.size());
+	}
+
+	void VertexBuffer::ReadData(std::vector<unsigned char>& out) const
+	{
+		size_t size = (size_t)m_len * m_elementSize;
+
+		//PERSISTENT buffers already keep a copy of everything on the CPU.
+		if (m_mode == UpdateMode::PERSISTENT)
+		{
+			out.assign(m_shadow.begin(), m_shadow.begin() + std::min(size, m_shadow.size()));
+			return;
+		}
+
+		out.resize(size);
+
+		if (size > 0)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, out.data());
+		}
+	}
+
+	void VertexBuffer::UpdateData(const void* data, GLsizei elementSize, GLsizei count)
+	{
+		GLsizeiptr size = (GLsizeiptr)elementSize * count;
+
+		m_len = count;
+		m_elementSize = elementSize;
+
+		//If the data doesn't fit, we need a bigger buffer.
+		//(Each copy in a PERSISTENT buffer has to start on a whole element, too.)
+		if (size > m_capacity ||
+			(m_mode == UpdateMode::PERSISTENT && elementSize > 0 && m_capacity % elementSize != 0))
+		{
+			Allocate(data, size);
+			return;
+		}
+
+		if (size == 0)
+			return;
+
+		switch (m_mode)
+		{
+			case UpdateMode::STATIC:
+				glBindBuffer(GL_ARRAY_BUFFER, m_id);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+				break;
+
+			case UpdateMode::ORPHAN:
+				//Passing nullptr tells the driver we don't care about the old
+				//contents, so it can give us new memory rather than waiting.
+				glBindBuffer(GL_ARRAY_BUFFER, m_id);
+				glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_DYNAMIC_DRAW);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+				break;
+
+			case UpdateMode::PERSISTENT:
+				memcpy(m_shadow.data(), data, size);
+				NextRegion();
+				memcpy(m_mapped + m_region * m_capacity, data, size);
+				break;
+		}
+
+		m_drawn = false;
+	}
+
+	bool VertexBuffer::CheckRange(GLsizei first, GLsizei count) const
+	{
+		//(Widened so a huge count can't wrap around and sneak past the check.)
+		if (first < 0 || count < 0 || (GLint64)first + count > m_len)
+		{
+			printf("Tried to update elements %d to %lld of a buffer with only %d elements.\n",
+				first, (long long)first + count - 1, m_len);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool VertexBuffer::UpdateRange(const void* data, GLsizei first, GLsizei count)
+	{
+		if (!CheckRange(first, count))
+			return false;
+
+		if (count == 0)
+			return true;
+
+		GLintptr offset = (GLintptr)first * m_elementSize;
+		GLsizeiptr size = (GLsizeiptr)count * m_elementSize;
+
+		switch (m_mode)
+		{
+			case UpdateMode::STATIC:
+			case UpdateMode::ORPHAN:
+				//We can't orphan here, since we need to keep the rest of the data.
+				glBindBuffer(GL_ARRAY_BUFFER, m_id);
+				glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+				break;
+
+			case UpdateMode::PERSISTENT:
+			{
+				memcpy(m_shadow.data() + offset, data, size);
+
+				int region = m_region;
+				NextRegion();
+
+				//If we're still on the same copy, the rest of it is already up to date.
+				//Otherwise the copy we moved on to might be a few updates out of date,
+				//so it gets all of the data, not just the part that changed.
+				//(That's just a memcpy, though - it won't wait on the GPU.)
+				if (m_region == region)
+					memcpy(m_mapped + m_region * m_capacity + offset, data, size);
+				else
+					memcpy(m_mapped + m_region * m_capacity, m_shadow.data(), (size_t)m_len * m_elementSize);
+				break;
+			}
+		}
+
+		m_drawn = false;
+		return true;
+	}
+
+	//Copies partSize bytes per element from tightly packed data into part of each element.
+	static void CopyParts(unsigned char* dest, const unsigned char* src, GLsizei count,
+						  GLsizei elementSize, GLsizei partSize, size_t partOffset)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+			memcpy(dest + (size_t)i * elementSize + partOffset, src + (size_t)i * partSize, partSize);
+	}
+
+	bool VertexBuffer::UpdateRange(const void* data, GLsizei first, GLsizei count,
+								   GLsizei partSize, size_t partOffset)
+	{
+		if (partSize <= 0 || partOffset + partSize > (size_t)m_elementSize)
+		{
+			printf("Tried to update %d bytes at offset %zu of elements that are only %d bytes.\n",
+				partSize, partOffset, m_elementSize);
+			return false;
+		}
+
+		//Whole elements can go in with a single copy.
+		if (partSize == m_elementSize)
+			return UpdateRange(data, first, count);
+
+		if (!CheckRange(first, count))
+			return false;
+
+		if (count == 0)
+			return true;
+
+		const unsigned char* src = static_cast<const unsigned char*>(data);
+
+		GLintptr offset = (GLintptr)first * m_elementSize;
+		GLsizeiptr size = (GLsizeiptr)count * m_elementSize;
+
+		switch (m_mode)
+		{
+			case UpdateMode::STATIC:
+			case UpdateMode::ORPHAN:
+			{
+				//We don't invalidate the range since the rest of each element needs
+				//to stay put, so this may have to wait for the GPU to finish with it.
+				glBindBuffer(GL_ARRAY_BUFFER, m_id);
+				unsigned char* dest = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, offset,
+												size, GL_MAP_WRITE_BIT));
+
+				if (dest == nullptr)
+				{
+					printf("Couldn't map a vertex buffer to update it.\n");
+					return false;
+				}
+
+				CopyParts(dest, src, count, m_elementSize, partSize, partOffset);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				break;
+			}
+
+			case UpdateMode::PERSISTENT:
+			{
+				CopyParts(m_shadow.data() + offset, src, count, m_elementSize, partSize, partOffset);
+
+				int region = m_region;
+				NextRegion();
+
+				//Same as above - a new copy needs all of the data.
+				if (m_region == region)
+					CopyParts(m_mapped + m_region * m_capacity + offset, src, count, m_elementSize, partSize, partOffset);
+				else
+					memcpy(m_mapped + m_region * m_capacity, m_shadow.data(), (size_t)m_len * m_elementSize);
+				break;
+			}
+		}
+
+		m_drawn = false;
+		return true;
+	}
+
+	void VertexBuffer::Allocate(const void* data, GLsizeiptr size)
+	{
+		//Storage made with glBufferStorage can't be resized,
+		//so we start over with a new buffer.
+		if (m_mapped != nullptr)
+		{
+			ReleaseStorage();
+			glDeleteBuffers(1, &m_id);
+			glGenBuffers(1, &m_id);
+		}
+
+		m_capacity = size;
+		m_startIndex = 0;
+		m_region = 0;
+		m_drawn = false;
+		m_bindVersion++;
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_id);
+
+		if (m_mode != UpdateMode::PERSISTENT)
+		{
+			GLenum usage = (m_mode == UpdateMode::STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+			glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+			return;
+		}
+
+		if (size == 0)
+		{
+			m_shadow.clear();
+			return;
+		}
+
+		//Coherent mapping means anything we write is visible to the GPU
+		//without us having to flush it ourselves.
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(GL_ARRAY_BUFFER, size * RING_SIZE, nullptr, flags);
+		m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size * RING_SIZE, flags));
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		if (bytes != nullptr)
+			m_shadow.assign(bytes, bytes + size);
+		else
+			m_shadow.assign(size, 0);
+
+		if (m_mapped == nullptr)
+		{
+			printf("Couldn't map a persistent buffer - using orphaning instead.\n");
+			glDeleteBuffers(1, &m_id);
+			glGenBuffers(1, &m_id);
+			m_mode = UpdateMode::ORPHAN;
+			Allocate(data, size);
+			return;
+		}
+
+		for (int region = 0; region < RING_SIZE; region++)
+			memcpy(m_mapped + region * size, m_shadow.data(), size);
+	}
+
+	void VertexBuffer::ReleaseStorage()
+	{
+		for (auto& fence : m_fences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		if (m_mapped != nullptr)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			m_mapped = nullptr;
+		}
+	}
+
+	void VertexBuffer::NextRegion()
+	{
+		//If nothing has been drawn with the current copy since we last
+		//wrote to it, the GPU can't be using it - so just overwrite it.
+		//(This keeps several updates in one frame from cycling the whole ring.)
+		if (!m_drawn)
+			return;
+
+		//The fence goes in after every draw that's been issued so far,
+		//which includes everything that reads from the current copy.
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		m_region = (m_region + 1) % RING_SIZE;
+		WaitForRegion(m_region);
+
+		m_startIndex = (GLsizei)(m_region * (m_capacity / m_elementSize));
+		m_bindVersion++;
+	}
+
+	void VertexBuffer::WaitForRegion(int region)
+	{
+		GLsync& fence = m_fences[region];
+
+		if (fence == nullptr)
+			return;
+
+		//With three copies the GPU would have to be two whole frames
+		//behind for this to actually wait.
+		GLenum result = glClientWaitSync(fence, 0, 0);
+
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			m_waits++;
+
+			do
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	IndexBuffer::IndexBuffer(GLenum type, GLsizei count, const void* data)
+	{
+		m_type = type;
+		m_len = count;
+
+		switch (type)
+		{
+			case GL_UNSIGNED_BYTE:
+				m_indexSize = sizeof(GLubyte);
+				break;
+			case GL_UNSIGNED_SHORT:
+				m_indexSize = sizeof(GLushort);
+				break;
+			default:
+				m_type = GL_UNSIGNED_INT;
+				m_indexSize = sizeof(GLuint);
+				break;
+		}
+
+		glGenBuffers(1, &m_id);
+
+		//Binding to GL_ELEMENT_ARRAY_BUFFER would change whichever VAO
+		//happens to be bound, so we upload through a different target.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+		glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)SizeInBytes(), data, GL_STATIC_DRAW);
+	}
+
+	IndexBuffer::~IndexBuffer()
+	{
+		glDeleteBuffers(1, &m_id);
+	}
+
+	bool IndexBuffer::UpdateRange(const void* data, GLsizei first, GLsizei count)
+	{
+		if (first < 0 || count < 0 || (GLint64)first + count > m_len)
+		{
+			printf("Tried to update indices %d to %lld of a buffer with only %d indices.\n",
+				first, (long long)first + count - 1, m_len);
+			return false;
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)first * m_indexSize,
+						(GLsizeiptr)count * m_indexSize, data);
+		return true;
+	}
+
+	void IndexBuffer::AddRange(GLsizei first, GLsizei count, GLint baseVertex)
+	{
+		m_ranges.push_back({ first, count, baseVertex });
+
+		m_counts.push_back(count);
+		m_offsets.push_back(reinterpret_cast<const void*>((size_t)first * m_indexSize));
+		m_baseVertices.push_back(baseVertex);
+	}
+
+	void IndexBuffer::ClearRanges()
+	{
+		m_ranges.clear();
+		m_counts.clear();
+		m_offsets.clear();
+		m_baseVertices.clear();
+	}
+
+	void IndexBuffer::Draw(GLenum mode) const
+	{
+		if (m_ranges.empty())
+		{
+			glDrawElements(mode, m_len, m_type, nullptr);
+			return;
+		}
+
+		glMultiDrawElementsBaseVertex(mode, m_counts.data(), m_type,
+									  m_offsets.data(), (GLsizei)m_ranges.size(),
+									  m_baseVertices.data());
+	}
+
+	void IndexBuffer::DrawInstanced(GLenum mode, GLsizei instanceCount, GLuint baseInstance) const
+	{
+		if (m_ranges.empty())
+		{
+			glDrawElementsInstancedBaseInstance(mode, m_len, m_type, nullptr,
+												instanceCount, baseInstance);
+			return;
+		}
+
+		//There's no multi-draw version of this (short of indirect drawing),
+		//so we make one call per range.
+		for (size_t i = 0; i < m_ranges.size(); ++i)
+		{
+			glDrawElementsInstancedBaseVertexBaseInstance(mode, m_counts[i], m_type, m_offsets[i],
+														  instanceCount, m_baseVertices[i], baseInstance);
+		}
+	}
+}
\ No newline at end of file
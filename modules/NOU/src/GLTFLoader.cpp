@@ -10,11 +10,142 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #include "NOU/GLTFLoader.h"
 
 #include <sstream>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
 
 #include "tiny_gltf.h"
 
 namespace nou::GLTF
 {
+	//Reads every element of an attribute as floats. Integer data is
+	//either converted directly, or mapped to [0, 1] ([-1, 1] if signed)
+	//if it's normalized.
+	template<typename T>
+	static void ReadComponents(const DataGetter& src, float* out)
+	{
+		bool normalize = src.normalized && std::is_integral<T>::value;
+		float scale = normalize ? 1.0f / (float)std::numeric_limits<T>::max() : 1.0f;
+		
+		for (size_t i = 0; i < src.len; ++i)
+		{
+			const unsigned char* element = src.data + i * src.stride;
+
+			for (int c = 0; c < src.components; ++c)
+			{
+				T value;
+				memcpy(&value, element + c * sizeof(T), sizeof(T));
+
+				float f = (float)value * scale;
+
+				//Signed types have one more negative value than positive,
+				//so the smallest one would end up slightly below -1.
+				if (normalize && std::is_signed<T>::value)
+					f = std::max(f, -1.0f);
+
+				out[i * src.components + c] = f;
+			}
+		}
+	}
+
+	//Copies indices of type S into a buffer of (at least as wide) type D.
+	//Returns the largest index, so we can check they're all in range
+	//while we're already reading them.
+	template<typename S, typename D>
+	static GLuint ReadIndices(const DataGetter& src, D* out)
+	{
+		S largest = 0;
+
+		for (size_t i = 0; i < src.len; ++i)
+		{
+			S index;
+			memcpy(&index, src.data + i * src.stride, sizeof(S));
+			out[i] = (D)index;
+			largest = std::max(largest, index);
+		}
+
+		return (GLuint)largest;
+	}
+
+	template<typename D>
+	static GLuint WidenIndices(const DataGetter& src, D* out)
+	{
+		switch (src.componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return ReadIndices<GLubyte, D>(src, out);
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				return ReadIndices<GLushort, D>(src, out);
+			default:
+				return ReadIndices<GLuint, D>(src, out);
+		}
+	}
+
+	//Same as above, for indices that go straight to the GPU without being copied.
+	template<typename S>
+	static GLuint FindLargestIndex(const DataGetter& src)
+	{
+		S largest = 0;
+
+		for (size_t i = 0; i < src.len; ++i)
+		{
+			S index;
+			memcpy(&index, src.data + i * src.stride, sizeof(S));
+			largest = std::max(largest, index);
+		}
+
+		return (GLuint)largest;
+	}
+
+	static GLuint FindLargestIndex(const DataGetter& src)
+	{
+		switch (src.componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return FindLargestIndex<GLubyte>(src);
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				return FindLargestIndex<GLushort>(src);
+			default:
+				return FindLargestIndex<GLuint>(src);
+		}
+	}
+
+	//For primitives without indices - every vertex is used once, in order.
+	template<typename D>
+	static void FillSequential(D* out, GLsizei count)
+	{
+		for (GLsizei i = 0; i < count; ++i)
+			out[i] = (D)i;
+	}
+
+	static GLsizei IndexSize(GLenum type)
+	{
+		switch (type)
+		{
+			case GL_UNSIGNED_BYTE:
+				return sizeof(GLubyte);
+			case GL_UNSIGNED_SHORT:
+				return sizeof(GLushort);
+			default:
+				return sizeof(GLuint);
+		}
+	}
+
+	//The smallest index type that will fit the primitive's indices.
+	static GLenum IndexTypeFor(const tinygltf::Model& gltf, const PrimitiveInfo& info)
+	{
+		if (info.geom->indices != -1)
+			return (GLenum)gltf.accessors[info.geom->indices].componentType;
+
+		if (info.vertexCount <= 256)
+			return GL_UNSIGNED_BYTE;
+
+		if (info.vertexCount <= 65536)
+			return GL_UNSIGNED_SHORT;
+
+		return GL_UNSIGNED_INT;
+	}
+
 	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY)
 	{
 		auto gltf = std::make_unique<tinygltf::Model>();
@@ -41,6 +172,42 @@ namespace nou::GLTF
 		printf("Loaded mesh from %s.\n", filename.c_str());
 	}
 
+	void LoadMeshes(const std::string& filename, std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY)
+	{
+		auto gltf = std::make_unique<tinygltf::Model>();
+
+		std::string err, warn;
+
+		if (!ParseGLTF(filename, *gltf, err, warn))
+		{
+			DumpErrorsAndWarnings(filename, err, warn);
+			return;
+		}
+
+		size_t loaded = 0;
+
+		for (size_t i = 0; i < gltf->meshes.size(); ++i)
+		{
+			auto mesh = std::make_unique<Mesh>();
+
+			//One bad mesh shouldn't stop us from loading the rest.
+			if (!ExtractGeometry(*gltf, *mesh, flipUVY, err, warn, (int)i))
+			{
+				DumpErrorsAndWarnings(filename, err, warn);
+				err.clear();
+				warn.clear();
+				continue;
+			}
+
+			meshes.push_back(std::move(mesh));
+			++loaded;
+		}
+
+		DumpErrorsAndWarnings(filename, err, warn);
+		printf("Loaded %zu mesh(es) from %s.\n", loaded, filename.c_str());
+	}
+
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
 							   const std::string& warn)
@@ -103,178 +270,358 @@ namespace nou::GLTF
 	}
 
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
-						 std::string& err, std::string& warn)
+						 std::string& err, std::string& warn, int meshIndex)
 	{
 		if (gltf.meshes.size() == 0)
 		{
 			err = "No meshes in file.";
 			return false;
 		}
-			
-		const tinygltf::Mesh& meshData = gltf.meshes[0];
 
-		if (meshData.primitives.size() == 0)
+		if (meshIndex >= (int)gltf.meshes.size())
 		{
-			err = "No geometry data associated with mesh.";
+			err = "Mesh " + std::to_string(meshIndex) + " doesn't exist.";
 			return false;
 		}
 
-		std::vector<glm::vec3> verts;
-		std::vector<glm::vec3> normals;
-		std::vector<glm::vec2> uvs;
+		size_t firstMesh = (meshIndex < 0) ? 0 : (size_t)meshIndex;
+		size_t lastMesh = (meshIndex < 0) ? gltf.meshes.size() : firstMesh + 1;
+
+		std::vector<PrimitiveInfo> prims;
 
 		bool hasNormals = true, hasUVs = true;
 
-		for (size_t i = 0; i < meshData.primitives.size(); ++i)
+		GLsizei numVerts = 0, numIndices = 0;
+		GLenum indexType = GL_UNSIGNED_BYTE;
+
+		//First, we work out how much data there is, so that we can make
+		//buffers big enough for everything in one go.
+		for (size_t m = firstMesh; m < lastMesh; ++m)
 		{
-			if(!ProcessPrimitive(gltf, i, verts, uvs, normals, 
-						         flipUVY, hasNormals, hasUVs, err, warn))
-				return false;
-		}
+			const tinygltf::Mesh& meshData = gltf.meshes[m];
 
-		mesh.SetVerts(verts);
+			for (size_t p = 0; p < meshData.primitives.size(); ++p)
+			{
+				const tinygltf::Primitive& geom = meshData.primitives[p];
 
-		if(hasNormals)
-			mesh.SetNormals(normals);
+				PrimitiveInfo info;
+				info.name = "mesh " + std::to_string(m) + ", primitive " + std::to_string(p);
 
-		if(hasUVs)
-			mesh.SetUVs(uvs);
+				//We only draw triangles - no points or lines.
+				if (geom.mode != -1 && geom.mode != TINYGLTF_MODE_TRIANGLES)
+				{
+					warn += "\nSkipping " + info.name + " since it isn't made of triangles.";
+					continue;
+				}
 
-		return true;
-	}
+				if (!ProcessPrimitive(gltf, geom, info, hasNormals, hasUVs, err, warn))
+					return false;
 
-	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex,
-		                  std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-		                  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
-		                  std::string& err, std::string& warn)
-	{
-		const tinygltf::Primitive geom = gltf.meshes[0].primitives[geomIndex];
+				info.baseVertex = numVerts;
+				info.firstIndex = numIndices;
+
+				numVerts += info.vertexCount;
+				numIndices += info.indexCount;
+
+				//All of our primitives share an index buffer, so it needs to use
+				//a type big enough for the largest of them.
+				GLenum type = IndexTypeFor(gltf, info);
+
+				if (IndexSize(type) > IndexSize(indexType))
+					indexType = type;
+
+				prims.push_back(info);
+			}
+		}
 
-		if (geom.indices == -1)
+		if (prims.size() == 0)
 		{
-			err = "File is missing primitive indices. "\
-				"Consider changing your GLTF export settings, or else this loader " \
-				"must be augmented to support files without indices.";
+			err = "No geometry data associated with mesh.";
+			return false;
+		}
+
+		VertexBuffer* vbo = mesh.CreateVBO(Mesh::Attrib::POSITION, 3, sizeof(glm::vec3), numVerts);
 
+		if (vbo == nullptr)
+		{
+			err = "Can't load into a mesh that has been interleaved.";
 			return false;
 		}
 
-		//glTF stores data per-vertex.
-		//This indexer will allow us to access the data that tells
-		//us which vertices make up the faces of the object.
-		//This allows us to specify our data in the order we need it
-		//for OpenGL vertex buffers - in other words, spelling out the vertex
-		//data as a set of triangles.
-		DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+		VertexBuffer* nbo = nullptr;
+		VertexBuffer* uvbo = nullptr;
 
-		if (faceIndexer.elementSize != sizeof(GLshort))
+		//We don't want to leave data from whatever the mesh held before lying around.
+		if (hasNormals)
+			nbo = mesh.CreateVBO(Mesh::Attrib::NORMAL, 3, sizeof(glm::vec3), numVerts);
+		else
+			mesh.SetNormals(std::vector<glm::vec3>());
+
+		if (hasUVs)
+			uvbo = mesh.CreateVBO(Mesh::Attrib::UV, 2, sizeof(glm::vec2), numVerts);
+		else
+			mesh.SetUVs(std::vector<glm::vec2>());
+
+		IndexBuffer* ibo = mesh.CreateIBO(indexType, numIndices);
+
+		//Only used for data that needs converting, and reused between primitives.
+		std::vector<float> floatScratch;
+		std::vector<unsigned char> indexScratch;
+
+		//Now we can actually get to extracting our data.
+		for (auto& info : prims)
 		{
-			err = "Primitive indices are in a currently unsupported format. " \
-				"Consider changing your GLTF export settings, or else this loader " \
-				"must be augmented to support the provided format.";
+			if (!UploadAttrib(gltf, info.vID, *vbo, info.baseVertex, 3, false, floatScratch, err))
+				return false;
 
-			return false;
+			if (hasNormals &&
+				!UploadAttrib(gltf, info.nID, *nbo, info.baseVertex, 3, false, floatScratch, err))
+				return false;
+
+			//We may need to flip our vertical UV-coordinate.
+			//You will probably need to do this, depending on your export settings/texture.
+			if (hasUVs &&
+				!UploadAttrib(gltf, info.uvID, *uvbo, info.baseVertex, 2, flipUVY, floatScratch, err))
+				return false;
+
+			if (!UploadIndices(gltf, info, *ibo, indexScratch, err))
+				return false;
+
+			ibo->AddRange(info.firstIndex, info.indexCount, info.baseVertex);
 		}
 
-		int vID = FindAccessor(geom, "POSITION");
+		return true;
+	}
+
+	bool ProcessPrimitive(const tinygltf::Model& gltf, const tinygltf::Primitive& geom,
+						  PrimitiveInfo& info, bool& hasNormals, bool& hasUVs,
+						  std::string& err, std::string& warn)
+	{
+		info.geom = &geom;
+
+		info.vID = FindAccessor(geom, "POSITION");
 
-		if (vID == -1)
+		if (info.vID == -1)
 		{
-			err = "No vertex positions found in mesh primitive " + std::to_string(geomIndex);
+			err = "No vertex positions found in " + info.name;
 			return false;
 		}
 
-		int nID = FindAccessor(geom, "NORMAL");
-		hasNormals = hasNormals && nID != -1;
+		info.nID = FindAccessor(geom, "NORMAL");
+		hasNormals = hasNormals && info.nID != -1;
 
-		if (!hasNormals)
-			warn += "\nNo normals found in mesh primitive " + std::to_string(geomIndex);
+		if (info.nID == -1)
+			warn += "\nNo normals found in " + info.name;
 
-		int uvID = FindAccessor(geom, "TEXCOORD_0");
-		hasUVs = hasUVs && uvID != -1;
+		info.uvID = FindAccessor(geom, "TEXCOORD_0");
+		hasUVs = hasUVs && info.uvID != -1;
 
-		if (uvID == -1)
-			warn += "\nNo UVs found in mesh primitive " + std::to_string(geomIndex);
+		if (info.uvID == -1)
+			warn += "\nNo UVs found in " + info.name;
 
-		DataGetter vGetter, nGetter, uvGetter;
+		//The file could point us at accessors that don't exist.
+		for (int accIndex : { info.vID, info.nID, info.uvID, geom.indices })
+		{
+			if (accIndex < -1 || accIndex >= (int)gltf.accessors.size())
+			{
+				err = "Accessor " + std::to_string(accIndex) + " in " + info.name + " doesn't exist.";
+				return false;
+			}
+		}
 
-		vGetter = BuildGetter(gltf, vID);
+		const tinygltf::Accessor& vAcc = gltf.accessors[info.vID];
+		info.vertexCount = (GLsizei)vAcc.count;
 
-		if (vGetter.elementSize != sizeof(glm::vec3))
+		//Every attribute shares the same vertices, so they all need one element per vertex.
+		//(Otherwise we'd read past the end of the shorter ones, or spill into the next primitive.)
+		for (int accIndex : { info.nID, info.uvID })
 		{
-			err = "Vertex position data is in a currently unsupported format. " \
-				"Consider changing your GLTF export settings, or else this loader " \
-				"must be augmented to support the provided format.";
-
-			return false;
+			if (accIndex != -1 && gltf.accessors[accIndex].count != vAcc.count)
+			{
+				err = "Accessor " + std::to_string(accIndex) + " in " + info.name + " has " +
+					std::to_string(gltf.accessors[accIndex].count) + " elements, but there are " +
+					std::to_string(vAcc.count) + " vertex positions.";
+				return false;
+			}
 		}
 
-		if (hasNormals)
+		//Primitives without indices just use every vertex in order.
+		if (geom.indices != -1)
 		{
-			nGetter = BuildGetter(gltf, nID);
+			const tinygltf::Accessor& iAcc = gltf.accessors[geom.indices];
 
-			if (nGetter.elementSize != sizeof(glm::vec3))
+			if (iAcc.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+				iAcc.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+				iAcc.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
 			{
-				hasNormals = false;
-				warn += "\nNormal data is in a currently unsupported format. " \
-					"Consider changing your GLTF export settings, or else this loader " \
-					"must be augmented to support the provided format.";
+				err = "Indices in " + info.name + " aren't unsigned integers.";
+				return false;
+			}
+
+			info.indexCount = (GLsizei)iAcc.count;
+
+			//If the file tells us the largest index, we can catch bad ones up front.
+			//(Every index is still checked as it's uploaded, since max could be wrong.)
+			if (!iAcc.maxValues.empty() && iAcc.maxValues[0] >= (double)info.vertexCount)
+			{
+				err = "Indices in " + info.name + " go up to " + std::to_string((size_t)iAcc.maxValues[0]) +
+					", but there are only " + std::to_string(info.vertexCount) + " vertices.";
+				return false;
 			}
 		}
+		else
+			info.indexCount = info.vertexCount;
 
+		for (int accIndex : { info.vID, info.nID, info.uvID, geom.indices })
+		{
+			if (accIndex != -1 && gltf.accessors[accIndex].sparse.isSparse)
+				warn += "\nSparse data in " + info.name + " isn't supported, and will be ignored.";
+		}
 
-		if (hasUVs)
+		return true;
+	}
+
+	bool UploadAttrib(const tinygltf::Model& gltf, int accIndex, VertexBuffer& vbo,
+					  GLsizei first, int components, bool flipY,
+					  std::vector<float>& scratch, std::string& err)
+	{
+		DataGetter getter = BuildGetter(gltf, accIndex);
+
+		if (getter.data == nullptr)
+		{
+			err = "Accessor " + std::to_string(accIndex) + " doesn't point to any valid data.";
+			return false;
+		}
+
+		if (getter.components != components)
 		{
-			uvGetter = BuildGetter(gltf, uvID);
+			err = "Accessor " + std::to_string(accIndex) + " has " + std::to_string(getter.components) +
+				" components per element, but " + std::to_string(components) + " were expected.";
+			return false;
+		}
+
+		std::string rangeErr = "Accessor " + std::to_string(accIndex) + " doesn't fit in the vertex buffer.";
 
-			if (uvGetter.elementSize != sizeof(glm::vec2))
+		//If the data is already what OpenGL wants, we don't need to touch it at all.
+		if (getter.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+			getter.stride == getter.elementSize && !flipY)
+		{
+			if (!vbo.UpdateRange(getter.data, first, (GLsizei)getter.len))
 			{
-				hasUVs = false;
-				warn += "\nUV data is in a currently unsupported format. " \
-					"Consider changing your GLTF export settings, or else this loader " \
-					"must be augmented to support the provided format.";
+				err = rangeErr;
+				return false;
 			}
-		}
 
-		size_t startIndex = verts.size();
+			return true;
+		}
 
-		verts.resize(verts.size() + faceIndexer.len);
+		scratch.resize(getter.len * components);
 
-		if (hasNormals)
-			normals.resize(normals.size() + faceIndexer.len);
+		if (!ConvertToFloats(getter, scratch.data()))
+		{
+			err = "Accessor " + std::to_string(accIndex) + " is in a currently unsupported format. " \
+				"Consider changing your GLTF export settings, or else this loader " \
+				"must be augmented to support the provided format.";
+			return false;
+		}
 
-		if (hasUVs)
-			uvs.resize(uvs.size() + faceIndexer.len);
+		if (flipY)
+		{
+			for (size_t i = 0; i < getter.len; ++i)
+				scratch[i * components + 1] = 1.0f - scratch[i * components + 1];
+		}
 
-		//This is the bit where we actually get to extracting our data.
-		for (size_t i = startIndex, f = 0; i < startIndex + faceIndexer.len && f < faceIndexer.len; ++i, ++f)
+		if (!vbo.UpdateRange(scratch.data(), first, (GLsizei)getter.len))
 		{
-			//What vertex do we need to look at?
-			GLshort vertIndex;
-			memcpy(&vertIndex, &faceIndexer.data[f * faceIndexer.stride], sizeof(GLshort));
+			err = rangeErr;
+			return false;
+		}
 
-			size_t vert = vertIndex;
+		return true;
+	}
 
-			//Grab our vertex position.
-			memcpy(&verts[i], &vGetter.data[vert * vGetter.stride], sizeof(glm::vec3));
+	bool UploadIndices(const tinygltf::Model& gltf, const PrimitiveInfo& info,
+					   IndexBuffer& ibo, std::vector<unsigned char>& scratch,
+					   std::string& err)
+	{
+		GLenum type = ibo.GetType();
 
-			//Grab our vertex normal.
-			if (hasNormals)
-				memcpy(&normals[i], &nGetter.data[vert * nGetter.stride], sizeof(glm::vec3));
+		scratch.resize((size_t)info.indexCount * ibo.IndexSize());
 
-			//Grab our texture coordinates.
-			if (hasUVs)
+		if (info.geom->indices == -1)
+		{
+			switch (type)
+			{
+				case GL_UNSIGNED_BYTE:
+					FillSequential((GLubyte*)scratch.data(), info.indexCount);
+					break;
+				case GL_UNSIGNED_SHORT:
+					FillSequential((GLushort*)scratch.data(), info.indexCount);
+					break;
+				default:
+					FillSequential((GLuint*)scratch.data(), info.indexCount);
+					break;
+			}
+
+			if (!ibo.UpdateRange(scratch.data(), info.firstIndex, info.indexCount))
 			{
-				memcpy(&uvs[i], &uvGetter.data[vert * uvGetter.stride], sizeof(glm::vec2));
+				err = "The indices in " + info.name + " don't fit in the index buffer.";
+				return false;
+			}
 
-				//We may need to flip our vertical UV-coordinate.
-				//You will probably need to do this, depending on your export settings/texture.
-				if (flipUVY)
-					uvs[i].y = 1.0f - uvs[i].y;
+			return true;
+		}
+
+		DataGetter getter = BuildGetter(gltf, info.geom->indices);
+
+		if (getter.data == nullptr)
+		{
+			err = "The indices in " + info.name + " don't point to any valid data.";
+			return false;
+		}
+
+		//We don't trust the accessor's max (ProcessPrimitive only uses it to reject
+		//files early), so every index gets looked at, even ones we don't copy.
+		GLuint largest = 0;
+		const void* data = scratch.data();
+
+		//Indices of the same type as our buffer can go straight to the GPU.
+		if ((GLenum)getter.componentType == type && getter.stride == getter.elementSize)
+		{
+			largest = FindLargestIndex(getter);
+			data = getter.data;
+		}
+		else
+		{
+			switch (type)
+			{
+				case GL_UNSIGNED_BYTE:
+					largest = WidenIndices(getter, (GLubyte*)scratch.data());
+					break;
+				case GL_UNSIGNED_SHORT:
+					largest = WidenIndices(getter, (GLushort*)scratch.data());
+					break;
+				default:
+					largest = WidenIndices(getter, (GLuint*)scratch.data());
+					break;
 			}
 		}
 
+		//An index past the end of the primitive would read another primitive's
+		//vertices - or past the end of the buffer entirely.
+		if (getter.len > 0 && largest >= (GLuint)info.vertexCount)
+		{
+			err = "Indices in " + info.name + " go up to " + std::to_string(largest) +
+				", but there are only " + std::to_string(info.vertexCount) + " vertices.";
+			return false;
+		}
+
+		if (!ibo.UpdateRange(data, info.firstIndex, info.indexCount))
+		{
+			err = "The indices in " + info.name + " don't fit in the index buffer.";
+			return false;
+		}
+
 		return true;
 	}
 
@@ -290,16 +637,76 @@ namespace nou::GLTF
 
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex)
 	{
+		if (accIndex < 0 || accIndex >= (int)gltf.accessors.size())
+			return { nullptr, 0, 0, 0, 0, 0, false };
+
 		const tinygltf::Accessor& acc = gltf.accessors[accIndex];
+
+		int components = tinygltf::GetNumComponentsInType(acc.type);
+		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) * components;
+
+		DataGetter getter = { nullptr, acc.count, 0, size, acc.componentType, components, acc.normalized };
+
+		//Accessors without a buffer view are meant to be all zeroes,
+		//which isn't much use to us.
+		if (acc.bufferView < 0 || acc.bufferView >= (int)gltf.bufferViews.size())
+			return getter;
+
 		const tinygltf::BufferView& bv = gltf.bufferViews[acc.bufferView];
+
+		if (bv.buffer < 0 || bv.buffer >= (int)gltf.buffers.size())
+			return getter;
+
 		const tinygltf::Buffer& buf = gltf.buffers[bv.buffer];
 
-		const unsigned char* data = &(buf.data[bv.byteOffset + acc.byteOffset]);
-		size_t len = acc.count;
-		int stride = acc.ByteStride(bv);
-		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) *
-				   tinygltf::GetNumComponentsInType(acc.type);
+		getter.stride = acc.ByteStride(bv);
+
+		if (getter.stride <= 0 || size <= 0)
+			return getter;
+
+		//Make sure the view fits in its buffer, and the whole accessor fits in
+		//its view, so a bad file can't send us reading off the end of either.
+		//(Written so that none of the sums can overflow.)
+		if (bv.byteOffset > buf.data.size() || bv.byteLength > buf.data.size() - bv.byteOffset)
+			return getter;
+
+		if (acc.count > 0)
+		{
+			if (acc.byteOffset > bv.byteLength ||
+				acc.count - 1 > (bv.byteLength - acc.byteOffset) / getter.stride ||
+				acc.byteOffset + (acc.count - 1) * getter.stride + size > bv.byteLength)
+				return getter;
+		}
+
+		getter.data = &(buf.data[bv.byteOffset + acc.byteOffset]);
 
-		return { data, len, stride, size };
+		return getter;
+	}
+
+	bool ConvertToFloats(const DataGetter& getter, float* out)
+	{
+		switch (getter.componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:
+				ReadComponents<float>(getter, out);
+				return true;
+			case TINYGLTF_COMPONENT_TYPE_BYTE:
+				ReadComponents<GLbyte>(getter, out);
+				return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				ReadComponents<GLubyte>(getter, out);
+				return true;
+			case TINYGLTF_COMPONENT_TYPE_SHORT:
+				ReadComponents<GLshort>(getter, out);
+				return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				ReadComponents<GLushort>(getter, out);
+				return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				ReadComponents<GLuint>(getter, out);
+				return true;
+			default:
+				return false;
+		}
 	}
 }
\ No newline at end of file
@@ -43,12 +43,18 @@ namespace nou
 		m_program->SetUniform("matColor", m_color);
 
 		//Bind the textures used by this material.
+		//The sampler uniform wants the slot number (0, 1, ...), while
+		//glActiveTexture wants the enum (GL_TEXTURE0, GL_TEXTURE1, ...).
 		for (auto& t : m_tex)
 		{
-			glUniform1i(t.loc, t.slot);
-			glActiveTexture(t.slot - GL_TEXTURE0);
-			glEnable(GL_TEXTURE_2D);
+			glUniform1i(t.loc, t.slot - GL_TEXTURE0);
+			glActiveTexture(t.slot);
 			glBindTexture(GL_TEXTURE_2D, t.id);
 		}
 	}
+
+	const ShaderProgram* Material::GetProgram() const
+	{
+		return m_program;
+	}
 }
\ No newline at end of file
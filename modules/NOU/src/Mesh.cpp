@@ -12,24 +12,197 @@ namespace nou
 {
 	void Mesh::SetVerts(const std::vector<glm::vec3>& verts)
 	{
+		if (IsInterleaved())
+		{
+			if (UpdateInterleaved(Attrib::POSITION, verts) && KeepsCPUData(Attrib::POSITION))
+				m_verts = verts;
+			return;
+		}
+
 		m_verts = verts;
 		SetVBO(Attrib::POSITION, 3, m_verts);
 	}
 
 	void Mesh::SetNormals(const std::vector<glm::vec3>& normals)
 	{
+		if (IsInterleaved())
+		{
+			if (UpdateInterleaved(Attrib::NORMAL, normals) && KeepsCPUData(Attrib::NORMAL))
+				m_normals = normals;
+			return;
+		}
+
 		m_normals = normals;
-		SetVBO(Attrib::NORMAL, 3, m_normals);			
+		SetVBO(Attrib::NORMAL, 3, m_normals);
 	}
 
 	void Mesh::SetUVs(const std::vector<glm::vec2>& uvs)
 	{
+		if (IsInterleaved())
+		{
+			if (UpdateInterleaved(Attrib::UV, uvs) && KeepsCPUData(Attrib::UV))
+				m_uvs = uvs;
+			return;
+		}
+
 		m_uvs = uvs;
 		SetVBO(Attrib::UV, 2, m_uvs);
 	}
 
+	void Mesh::SetIndices(const std::vector<GLuint>& indices)
+	{
+		if (indices.empty())
+		{
+			m_ibo.reset();
+			return;
+		}
+
+		m_ibo = std::make_unique<IndexBuffer>(GL_UNSIGNED_INT, (GLsizei)indices.size(), indices.data());
+	}
+
+	VertexBuffer* Mesh::CreateVBO(Attrib attrib, GLint elementLen, GLsizei elementSize, GLsizei count)
+	{
+		if (IsInterleaved())
+			return nullptr;
+
+		//Whatever we had on the CPU won't match the new data.
+		switch (attrib)
+		{
+			case Attrib::POSITION:
+				std::vector<glm::vec3>().swap(m_verts);
+				break;
+			case Attrib::NORMAL:
+				std::vector<glm::vec3>().swap(m_normals);
+				break;
+			case Attrib::UV:
+				std::vector<glm::vec2>().swap(m_uvs);
+				break;
+			default:
+				break;
+		}
+
+		auto& vbo = m_vbo[attrib];
+		vbo = std::make_unique<VertexBuffer>(elementLen, elementSize, count, nullptr, m_updateMode);
+
+		return vbo.get();
+	}
+
+	IndexBuffer* Mesh::CreateIBO(GLenum type, GLsizei count)
+	{
+		m_ibo = std::make_unique<IndexBuffer>(type, count, nullptr);
+		return m_ibo.get();
+	}
+
+	const IndexBuffer* Mesh::GetIBO() const
+	{
+		return m_ibo.get();
+	}
+
+	bool Mesh::Interleave(CPUData keep)
+	{
+		if (IsInterleaved())
+			return true;
+
+		size_t cpuBefore = GetCPUMemory();
+		size_t gpuBefore = GetGPUMemory();
+
+		//Meshes loaded straight to the GPU don't have their data on the CPU,
+		//so we fetch it back from their buffers to build the interleaved one.
+		//(If we bail out, the mesh is left with those CPU copies - it still
+		//draws from its separate buffers either way.)
+		if (!ReadBackVBO(Attrib::POSITION, m_verts) ||
+			!ReadBackVBO(Attrib::NORMAL, m_normals) ||
+			!ReadBackVBO(Attrib::UV, m_uvs))
+		{
+			printf("Can't interleave a mesh whose vertex buffers aren't made of floats.\n");
+			return false;
+		}
+
+		size_t count = m_verts.size();
+
+		if (count == 0)
+		{
+			printf("Can't interleave a mesh with no vertices.\n");
+			return false;
+		}
+
+		if ((!m_normals.empty() && m_normals.size() != count) ||
+			(!m_uvs.empty() && m_uvs.size() != count))
+		{
+			printf("Can't interleave a mesh with a different number of positions, normals, and UVs.\n");
+			return false;
+		}
+
+		//Work out where each attribute goes within a vertex.
+		//Everything is made of floats, so we lay the vertex out as floats too.
+		size_t normalOffset = 3;
+		size_t uvOffset = normalOffset + (m_normals.empty() ? 0 : 3);
+		size_t vertexFloats = uvOffset + (m_uvs.empty() ? 0 : 2);
+		GLsizei stride = (GLsizei)(vertexFloats * sizeof(float));
+
+		std::vector<float> data(count * vertexFloats);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			float* vertex = &data[i * vertexFloats];
+
+			memcpy(vertex, &m_verts[i], sizeof(glm::vec3));
+
+			if (!m_normals.empty())
+				memcpy(vertex + normalOffset, &m_normals[i], sizeof(glm::vec3));
+
+			if (!m_uvs.empty())
+				memcpy(vertex + uvOffset, &m_uvs[i], sizeof(glm::vec2));
+		}
+
+		m_interleaved = std::make_unique<VertexBuffer>(0, stride, (GLsizei)count, data.data(), m_updateMode);
+
+		m_layout.clear();
+		m_layout[Attrib::POSITION] = { m_interleaved.get(), 3, stride, 0 };
+
+		if (!m_normals.empty())
+			m_layout[Attrib::NORMAL] = { m_interleaved.get(), 3, stride, normalOffset * sizeof(float) };
+
+		if (!m_uvs.empty())
+			m_layout[Attrib::UV] = { m_interleaved.get(), 2, stride, uvOffset * sizeof(float) };
+
+		//The separate buffers are no longer needed...
+		m_vbo.clear();
+
+		//...and neither are whichever CPU copies we aren't keeping.
+		//(Swapping with an empty vector actually frees the memory, unlike clear.)
+		m_keep = keep;
+
+		if (!KeepsCPUData(Attrib::POSITION))
+			std::vector<glm::vec3>().swap(m_verts);
+
+		if (!KeepsCPUData(Attrib::NORMAL))
+			std::vector<glm::vec3>().swap(m_normals);
+
+		if (!KeepsCPUData(Attrib::UV))
+			std::vector<glm::vec2>().swap(m_uvs);
+
+		printf("Interleaved mesh (%zu vertices): CPU %.1f KB -> %.1f KB, GPU %.1f KB -> %.1f KB.\n",
+			count,
+			cpuBefore / 1024.0f, GetCPUMemory() / 1024.0f,
+			gpuBefore / 1024.0f, GetGPUMemory() / 1024.0f);
+
+		return true;
+	}
+
+	bool Mesh::IsInterleaved() const
+	{
+		return m_interleaved != nullptr;
+	}
+
 	const VertexBuffer* Mesh::GetVBO(Mesh::Attrib attrib) const
 	{
+		if (IsInterleaved())
+		{
+			auto it = m_layout.find(attrib);
+			return (it == m_layout.end()) ? nullptr : it->second.buffer;
+		}
+
 		auto it = m_vbo.find(attrib);
 
 		if (it == m_vbo.end())
@@ -37,4 +210,89 @@ namespace nou
 
 		return it->second.get();
 	}
+
+	bool Mesh::GetAttribLayout(Attrib attrib, AttribLayout& layout) const
+	{
+		if (IsInterleaved())
+		{
+			auto it = m_layout.find(attrib);
+
+			if (it == m_layout.end())
+				return false;
+
+			layout = it->second;
+			return true;
+		}
+
+		const VertexBuffer* vbo = GetVBO(attrib);
+
+		if (vbo == nullptr)
+			return false;
+
+		//Separate buffers are tightly packed, so there's no stride or offset.
+		layout = { vbo, vbo->ElementLength(), 0, 0 };
+		return true;
+	}
+
+	void Mesh::SetUpdateMode(VertexBuffer::UpdateMode mode)
+	{
+		m_updateMode = mode;
+
+		for (auto& [attrib, vbo] : m_vbo)
+			vbo->SetUpdateMode(mode);
+
+		if (m_interleaved != nullptr)
+			m_interleaved->SetUpdateMode(mode);
+	}
+
+	size_t Mesh::GetVertexCount() const
+	{
+		if (IsInterleaved())
+			return (size_t)m_interleaved->Length();
+
+		const VertexBuffer* vbo = GetVBO(Attrib::POSITION);
+		return (vbo == nullptr) ? 0 : (size_t)vbo->Length();
+	}
+
+	size_t Mesh::GetCPUMemory() const
+	{
+		return m_verts.capacity() * sizeof(glm::vec3) +
+			   m_normals.capacity() * sizeof(glm::vec3) +
+			   m_uvs.capacity() * sizeof(glm::vec2);
+	}
+
+	size_t Mesh::GetGPUMemory() const
+	{
+		size_t total = (m_ibo != nullptr) ? m_ibo->SizeInBytes() : 0;
+
+		if (IsInterleaved())
+			return total + m_interleaved->SizeInBytes();
+
+		for (auto& [attrib, vbo] : m_vbo)
+			total += vbo->SizeInBytes();
+
+		return total;
+	}
+
+	void Mesh::PrintMemoryUsage(const std::string& label) const
+	{
+		printf("%s: %zu vertices, %zu indices, %s, CPU %.1f KB, GPU %.1f KB.\n",
+			label.c_str(), GetVertexCount(),
+			(m_ibo != nullptr) ? (size_t)m_ibo->Length() : (size_t)0,
+			IsInterleaved() ? "interleaved" : "separate buffers",
+			GetCPUMemory() / 1024.0f, GetGPUMemory() / 1024.0f);
+	}
+
+	bool Mesh::KeepsCPUData(Attrib attrib) const
+	{
+		switch (m_keep)
+		{
+			case CPUData::KEEP_ALL:
+				return true;
+			case CPUData::KEEP_DEFORMABLE:
+				return attrib == Attrib::POSITION || attrib == Attrib::NORMAL;
+			default:
+				return false;
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+RenderSystem.cpp
+Draws every CMeshRenderer in the scene at once, with as few
+state changes and draw calls as we can get away with.
+*/
+
+#include "NOU/RenderSystem.h"
+#include "NOU/CCamera.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+
+namespace nou
+{
+	std::vector<RenderSystem::DrawItem> RenderSystem::s_items;
+	std::vector<RenderSystem::InstanceData> RenderSystem::s_instances;
+
+	GLuint RenderSystem::s_instanceBuffer = 0;
+	GLsizeiptr RenderSystem::s_instanceCapacity = 0;
+	size_t RenderSystem::s_drawCalls = 0;
+
+	void RenderSystem::Draw()
+	{
+		s_items.clear();
+		s_instances.clear();
+		s_drawCalls = 0;
+
+		if (CCamera::current == nullptr)
+			return;
+
+		//Gather everything we need to draw...
+		Entity::ecs.view<CMeshRenderer>().each([](CMeshRenderer& renderer)
+		{
+			if (renderer.m_mat != nullptr && renderer.m_mesh != nullptr)
+				s_items.push_back({ renderer.m_mat->GetProgram(), renderer.m_mat, renderer.m_mesh, &renderer });
+		});
+
+		//...then sort it so that everything using the same program, material
+		//and mesh ends up next to each other.
+		std::sort(s_items.begin(), s_items.end(), [](const DrawItem& lhs, const DrawItem& rhs)
+		{
+			return std::tie(lhs.program, lhs.material, lhs.mesh) <
+				   std::tie(rhs.program, rhs.material, rhs.mesh);
+		});
+
+		//Transforms for instanced programs go into one buffer, in the same order
+		//as the items, so each group of instances is a contiguous range.
+		for (auto& item : s_items)
+		{
+			if (item.program->UsesInstancing())
+			{
+				const Transform& transform = item.renderer->m_owner->transform;
+				s_instances.push_back({ transform.GetGlobal(), transform.GetNormal() });
+			}
+		}
+
+		UploadInstances();
+
+		const glm::mat4& viewproj = CCamera::current->Get<CCamera>().GetVP();
+
+		const ShaderProgram* program = nullptr;
+		Material* material = nullptr;
+		GLuint baseInstance = 0;
+
+		for (size_t ix = 0; ix < s_items.size();)
+		{
+			DrawItem& item = s_items[ix];
+
+			//Binds the program and textures.
+			if (item.material != material)
+			{
+				material = item.material;
+				material->Use();
+			}
+
+			//Uniforms stick around in the program, so we only need to set this once.
+			if (item.program != program)
+			{
+				program = item.program;
+				glUniformMatrix4fv(program->GetViewProjLoc(), 1, GL_FALSE, &viewproj[0][0]);
+			}
+
+			if (item.program->UsesInstancing())
+			{
+				size_t end = ix + 1;
+
+				while (end < s_items.size() &&
+					   s_items[end].material == item.material &&
+					   s_items[end].mesh == item.mesh)
+					++end;
+
+				GLsizei count = static_cast<GLsizei>(end - ix);
+
+				SetupInstancing(*item.renderer);
+				item.renderer->m_vao->DrawInstanced(count, baseInstance);
+
+				baseInstance += count;
+				ix = end;
+			}
+			else
+			{
+				const Transform& transform = item.renderer->m_owner->transform;
+				glm::mat3 normal = transform.GetNormal();
+
+				glUniformMatrix4fv(item.program->GetModelLoc(), 1, GL_FALSE, &transform.GetGlobal()[0][0]);
+				glUniformMatrix3fv(item.program->GetNormalLoc(), 1, GL_FALSE, &normal[0][0]);
+				item.renderer->m_vao->Draw();
+
+				++ix;
+			}
+
+			++s_drawCalls;
+		}
+	}
+
+	size_t RenderSystem::GetDrawCallCount()
+	{
+		return s_drawCalls;
+	}
+
+	void RenderSystem::UploadInstances()
+	{
+		if (s_instances.empty())
+			return;
+
+		if (s_instanceBuffer == 0)
+			glGenBuffers(1, &s_instanceBuffer);
+
+		GLsizeiptr size = (GLsizeiptr)(s_instances.size() * sizeof(InstanceData));
+
+		//Grow the buffer if we need to. Otherwise, we hand OpenGL a fresh block
+		//of memory (called "orphaning") so we don't have to wait on last frame's
+		//draws to finish reading the old one.
+		if (size > s_instanceCapacity)
+			s_instanceCapacity = std::max(size, s_instanceCapacity * 2);
+
+		glBindBuffer(GL_ARRAY_BUFFER, s_instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, s_instanceCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, s_instances.data());
+	}
+
+	void RenderSystem::SetupInstancing(CMeshRenderer& renderer)
+	{
+		if (renderer.m_instancingReady)
+			return;
+
+		glBindVertexArray(renderer.m_vao->GetID());
+		glBindBuffer(GL_ARRAY_BUFFER, s_instanceBuffer);
+
+		//Matrices are passed as one attribute per column.
+		//The divisor of 1 means they advance once per instance, rather than per vertex.
+		for (GLuint col = 0; col < 4; ++col)
+		{
+			GLuint loc = INSTANCE_MODEL_LOC + col;
+			glEnableVertexAttribArray(loc);
+			glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+								  reinterpret_cast<void*>(offsetof(InstanceData, model) + col * sizeof(glm::vec4)));
+			glVertexAttribDivisor(loc, 1);
+		}
+
+		for (GLuint col = 0; col < 3; ++col)
+		{
+			GLuint loc = INSTANCE_NORMAL_LOC + col;
+			glEnableVertexAttribArray(loc);
+			glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+								  reinterpret_cast<void*>(offsetof(InstanceData, normal) + col * sizeof(glm::vec3)));
+			glVertexAttribDivisor(loc, 1);
+		}
+
+		renderer.m_instancingReady = true;
+	}
+}
\ No newline at end of file
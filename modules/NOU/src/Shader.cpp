@@ -130,6 +130,11 @@ namespace nou
 
 	ShaderProgram::ShaderProgram(const std::vector<Shader*>& shaders)
 	{
+		m_viewprojLoc = -1;
+		m_modelLoc = -1;
+		m_normalLoc = -1;
+		m_instanced = false;
+
 		//Create a new shader program object.
 		m_id = glCreateProgram();
 
@@ -148,7 +153,15 @@ namespace nou
 
 		//Provide feedback on the program's linking.
 		if (result)
+		{
 			printf("Linked shader program successfully.\n");
+
+			//Look up what the render system needs now, so it never has to ask OpenGL while drawing.
+			m_viewprojLoc = GetUniformLoc("viewproj");
+			m_modelLoc = GetUniformLoc("model");
+			m_normalLoc = GetUniformLoc("normal");
+			m_instanced = GetAttribLoc("inModel") >= 0;
+		}
 		else
 		{
 			GLint buflen = 0;
@@ -182,9 +195,47 @@ namespace nou
 		return m_current;
 	}
 
+	GLuint ShaderProgram::GetID() const
+	{
+		return m_id;
+	}
+
 	GLint ShaderProgram::GetUniformLoc(const std::string& name) const
 	{
-		return glGetUniformLocation(m_id, name.c_str());
+		auto it = m_uniformLocs.find(name);
+
+		if (it != m_uniformLocs.end())
+			return it->second;
+
+		GLint loc = glGetUniformLocation(m_id, name.c_str());
+		m_uniformLocs[name] = loc;
+
+		return loc;
+	}
+
+	GLint ShaderProgram::GetAttribLoc(const std::string& name) const
+	{
+		return glGetAttribLocation(m_id, name.c_str());
+	}
+
+	GLint ShaderProgram::GetViewProjLoc() const
+	{
+		return m_viewprojLoc;
+	}
+
+	GLint ShaderProgram::GetModelLoc() const
+	{
+		return m_modelLoc;
+	}
+
+	GLint ShaderProgram::GetNormalLoc() const
+	{
+		return m_normalLoc;
+	}
+
+	bool ShaderProgram::UsesInstancing() const
+	{
+		return m_instanced;
 	}
 
 	template<>
@@ -12,6 +12,8 @@ Simple class for managing object transforms with basic hierarchy support.
 
 namespace nou
 {
+	bool Transform::s_hierarchyChanged = true;
+
 	Transform::Transform()
 	{
 		m_parent = nullptr;
@@ -21,29 +23,40 @@ namespace nou
 		m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 
 		m_global = glm::mat4(1.0f);
+		m_local = glm::mat4(1.0f);
+
+		m_cachedPos = m_pos;
+		m_cachedScale = m_scale;
+		m_cachedRotation = m_rotation;
+		m_dirty = true;
+
+		m_depth = 0;
+		m_globalVersion = 0;
+		m_parentVersion = 0;
+		m_node = -1;
 	}
 
 	Transform::~Transform()
 	{
 		SetParent(nullptr);
+
+		//Our children would otherwise be left pointing at us
+		//after we're gone, so they become roots instead.
+		for (auto* child : m_children)
+		{
+			child->m_parent = nullptr;
+			child->m_dirty = true;
+			child->SetDepth(0);
+		}
 	}
 
 	void Transform::DoFK()
 	{
-		//First, grab our local transform...
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(glm::normalize(m_rotation)) *
-						  glm::scale(m_scale);
-
-		//If we have a parent, we need to multiply by our parent's
-		//global transform.
-		if (m_parent != nullptr)
-			m_global = m_parent->m_global * local;
-
-		//If we have no parent object, our global transform is our
-		//local transform!
-		else
-			m_global = local;
+		//First, update our own global transform. We'll only redo the
+		//math if we've moved or our parent has since the last update.
+		//(The parent has to have been updated already - which it will
+		//have been if we're being called from its DoFK.)
+		UpdateGlobal();
 
 		//FK is recursive - we now repeat this process on our child nodes.
 		//Eventually, we'll be at the bottom of the hierarchy and this will
@@ -56,17 +69,18 @@ namespace nou
 
 	const glm::mat4& Transform::RecomputeGlobal()
 	{
-		//Just as with FK, compute our local, then multiply with
-		//our parent's transform if applicable.
+		//Rather than recursing up to the root (and recomputing every
+		//ancestor on every call), we gather the path to the root and
+		//update it top-down. UpdateGlobal skips anything that hasn't
+		//changed, so each ancestor's matrix is only rebuilt when needed.
+		static thread_local std::vector<Transform*> path;
+		path.clear();
 
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(m_rotation) *
-						  glm::scale(m_scale);
+		for (Transform* node = this; node != nullptr; node = node->m_parent)
+			path.push_back(node);
 
-		if (m_parent != nullptr)
-			m_global = m_parent->RecomputeGlobal() * local;
-		else
-			m_global = local;
+		for (auto it = path.rbegin(); it != path.rend(); ++it)
+			(*it)->UpdateGlobal();
 
 		return m_global;
 	}
@@ -88,7 +102,7 @@ namespace nou
 		if(m_scale.x == m_scale.y && m_scale.x == m_scale.z)
 			return glm::mat3(m_global);
 
-		//If we do have a non-uniform scale, then we need to undo that scale, 
+		//If we do have a non-uniform scale, then we need to undo that scale,
 		//hence the inverse. However, we want to preserve our rotation.
 		//Since the inverse of a rotation matrix IS its transpose, by adding
 		//in the transpose we can effectively spit our rotation matrix with
@@ -109,7 +123,23 @@ namespace nou
 
 		//If we have a parent now, add this as a child to that object.
 		if(m_parent != nullptr)
-			m_parent->AddChild(this);			
+			m_parent->AddChild(this);
+
+		//Our global transform now depends on a different parent (or none),
+		//and we (and our children) may have moved up or down the hierarchy.
+		m_dirty = true;
+		SetDepth(m_parent != nullptr ? m_parent->m_depth + 1 : 0);
+		s_hierarchyChanged = true;
+	}
+
+	uint32_t Transform::GetDepth() const
+	{
+		return m_depth;
+	}
+
+	void Transform::MarkDirty()
+	{
+		m_dirty = true;
 	}
 
 	void Transform::AddChild(Transform* child)
@@ -129,4 +159,73 @@ namespace nou
 
 		}
 	}
+
+	void Transform::SetDepth(uint32_t depth)
+	{
+		if (m_depth == depth)
+			return;
+
+		m_depth = depth;
+		s_hierarchyChanged = true;
+
+		for (auto* child : m_children)
+		{
+			child->SetDepth(depth + 1);
+		}
+	}
+
+	bool Transform::UpdateLocal()
+	{
+		if (!m_dirty &&
+			m_pos == m_cachedPos &&
+			m_scale == m_cachedScale &&
+			m_rotation == m_cachedRotation)
+			return false;
+
+		//This is translate * rotate * scale, but built directly rather than
+		//by multiplying three matrices together: the scale just stretches
+		//the columns of the rotation, and the position goes in the last column.
+		glm::mat3 rotation = glm::toMat3(glm::normalize(m_rotation));
+
+		m_local = glm::mat4(glm::vec4(rotation[0] * m_scale.x, 0.0f),
+							glm::vec4(rotation[1] * m_scale.y, 0.0f),
+							glm::vec4(rotation[2] * m_scale.z, 0.0f),
+							glm::vec4(m_pos, 1.0f));
+
+		m_cachedPos = m_pos;
+		m_cachedScale = m_scale;
+		m_cachedRotation = m_rotation;
+		m_dirty = false;
+
+		return true;
+	}
+
+	bool Transform::UpdateGlobal()
+	{
+		bool localChanged = UpdateLocal();
+
+		//If we have a parent, we need to multiply by our parent's
+		//global transform - but only if it (or we) changed since last time.
+		if (m_parent != nullptr)
+		{
+			if (!localChanged && m_parentVersion == m_parent->m_globalVersion)
+				return false;
+
+			m_global = m_parent->m_global * m_local;
+			m_parentVersion = m_parent->m_globalVersion;
+		}
+
+		//If we have no parent object, our global transform is our
+		//local transform!
+		else
+		{
+			if (!localChanged)
+				return false;
+
+			m_global = m_local;
+		}
+
+		m_globalVersion++;
+		return true;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a particle system that stores it's particles in
+// structure-of-arrays pools, simulates them with SSE/AVX across worker
+// threads (or in a compute shader), and draws them as instanced
+// camera facing billboards
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <GLM/glm.hpp>
+#include <glad/glad.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <random>
+
+namespace TTK
+{
+	/*
+	 * Describes how an emitter spawns and simulates it's particles
+	 */
+	struct EmitterSettings {
+		// The point that particles are spawned at
+		glm::vec3 Position       = glm::vec3(0.0f);
+		// The half-extents of a box around Position that particles will spawn in
+		glm::vec3 PositionSpread = glm::vec3(0.0f);
+		// The initial velocity of a particle
+		glm::vec3 Velocity       = glm::vec3(0.0f, 0.0f, 1.0f);
+		// The half-extents of a box of random velocity added to each particle
+		glm::vec3 VelocitySpread = glm::vec3(0.5f);
+		// Constant acceleration applied to all particles
+		glm::vec3 Gravity        = glm::vec3(0.0f, 0.0f, -9.81f);
+		// Linear drag, as a fraction of velocity lost per second
+		float     Drag           = 0.1f;
+		// The range of lifetimes for spawned particles, in seconds
+		float     LifetimeMin    = 1.0f;
+		float     LifetimeMax    = 2.0f;
+		// The number of particles to spawn per second
+		float     EmitRate       = 1000.0f;
+		// Particles will lerp between these colors and sizes over their lifetime
+		glm::vec4 StartColor     = glm::vec4(1.0f);
+		glm::vec4 EndColor       = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+		float     StartSize      = 0.1f;
+		float     EndSize        = 0.0f;
+	};
+
+	/*
+	 * Per-frame timings for one simulation path of a particle benchmark, all in milliseconds
+	 */
+	struct ParticleTimings {
+		// CPU time spent in Update and Draw
+		double UpdateCpuMs = 0.0;
+		double DrawCpuMs   = 0.0;
+		// GPU time spent on the work submitted by Update and Draw, from timer queries
+		double UpdateGpuMs = 0.0;
+		double DrawGpuMs   = 0.0;
+	};
+
+	/*
+	 * The results of ParticleSystem::RunBenchmark, averaged over all the measured frames
+	 */
+	struct ParticleBenchmarkResult {
+		size_t          Particles = 0;
+		uint32_t        Threads   = 0;
+		int             Frames    = 0;
+		// Timings with the particles simulated on the CPU
+		ParticleTimings Cpu;
+		// Timings with the particles simulated in a compute shader
+		ParticleTimings Compute;
+	};
+
+	/*
+	 * A single particle emitter, with a fixed size pool of particles
+	 *
+	 * Particles are stored as a structure of arrays so that the update can work on 4 (SSE) or 8 (AVX)
+	 * particles at a time, and the pool is split into chunks that are simulated on worker threads.
+	 * Dead particles are removed by swapping in the last live particle, so the live particles are always
+	 * packed at the front of the pool.
+	 *
+	 * Rendering streams the live particles into a persistently mapped ring buffer, which is written
+	 * directly by the worker threads, and draws them as instanced billboards in a single draw call.
+	 *
+	 * If the compute path is enabled, particle state lives on the GPU instead and is simulated by a
+	 * compute shader, the CPU only writes newly spawned particles.
+	 */
+	class ParticleSystem {
+	public:
+		/*
+		 * Creates a new particle system
+		 * @param maxParticles The maximum number of particles that can be alive at once
+		 * @param numThreads The number of threads to simulate with, or 0 to use all hardware threads
+		 */
+		ParticleSystem(size_t maxParticles, uint32_t numThreads = 0);
+		~ParticleSystem();
+
+		ParticleSystem(const ParticleSystem& other) = delete;
+		ParticleSystem& operator=(const ParticleSystem& other) = delete;
+
+		/*
+		 * Gets the settings for this emitter, changes will apply to newly spawned particles (and to
+		 * gravity and drag for all particles)
+		 */
+		EmitterSettings& Settings() { return m_Settings; }
+
+		/*
+		 * Spawns the given number of particles right away, limited by the space left in the pool
+		 * @param count The number of particles to spawn
+		 */
+		void Emit(size_t count);
+		/*
+		 * Spawns particles according to the emit rate, and simulates all live particles
+		 * @param dt The time since the last update, in seconds
+		 */
+		void Update(float dt);
+		/*
+		 * Draws all the live particles as camera facing billboards
+		 * @param view The camera's view matrix
+		 * @param projection The camera's projection matrix
+		 */
+		void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+		/*
+		 * Sets whether the particles are simulated by a compute shader instead of the CPU. Any live
+		 * particles are carried over when switching
+		 * @param value True to simulate on the GPU, false to simulate on the CPU
+		 */
+		void SetUseCompute(bool value);
+		bool GetUseCompute() const { return m_UseCompute; }
+
+		/*
+		 * Gets the number of live particles (in compute mode, this is an upper bound since the GPU
+		 * retires particles without telling us)
+		 */
+		size_t GetAliveCount() const { return m_Count; }
+		size_t GetMaxParticles() const { return m_MaxParticles; }
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		/*
+		 * Gets the time spent simulating the particles on the CPU in the last update, in milliseconds
+		 */
+		double GetLastUpdateMs() const { return m_LastUpdateMs; }
+		/*
+		 * Gets the time spent in the last draw on the CPU (including streaming particle data), in milliseconds
+		 */
+		double GetLastDrawMs() const { return m_LastDrawMs; }
+
+		/*
+		 * Returns the name of the SIMD instruction set the CPU path was compiled with
+		 */
+		static const char* GetSimdName();
+
+		/*
+		 * Fills a particle system with particles that live for the whole run, and times updating and
+		 * drawing them on both the CPU and compute paths. Draws into whatever framebuffer is bound, and
+		 * waits on the GPU for it's timings, so this should not be called in the middle of a frame we
+		 * care about
+		 * @param view The camera's view matrix to draw with
+		 * @param projection The camera's projection matrix to draw with
+		 * @param numParticles The number of particles to simulate
+		 * @param frames The number of frames to time on each path
+		 * @param numThreads The number of threads to simulate with, or 0 to use all hardware threads
+		 */
+		static ParticleBenchmarkResult RunBenchmark(const glm::mat4& view, const glm::mat4& projection,
+		                                            size_t numParticles = 1000000, int frames = 100, uint32_t numThreads = 0);
+
+	private:
+		EmitterSettings m_Settings;
+		size_t          m_MaxParticles;
+		size_t          m_Count;
+		float           m_EmitAccumulator;
+		bool            m_UseCompute;
+		std::mt19937    m_Random;
+
+		// Our particle pool, each is an aligned array of m_MaxParticles floats
+		float* m_PosX;
+		float* m_PosY;
+		float* m_PosZ;
+		float* m_VelX;
+		float* m_VelY;
+		float* m_VelZ;
+		float* m_Age;
+		float* m_Lifetime;
+
+		// The per-instance data we stream to the GPU
+		struct InstanceData {
+			glm::vec3 Position;
+			float     NormalizedAge;
+		};
+
+		// Persistently mapped ring buffer of instance data, with one region per frame in flight
+		static const int RingFrames = 3;
+		GLuint        m_InstanceBuffer;
+		InstanceData* m_InstanceMapping;
+		GLsync        m_RingFences[RingFrames];
+		int           m_RingIndex;
+		GLuint        m_VAO;
+		GLuint        m_RenderShader;
+
+		// GPU particle state for the compute path, as 2 vec4s per particle (pos + age, vel + lifetime)
+		GLuint m_ComputeState;
+		GLuint m_ComputeShader;
+		size_t m_ComputeHead;
+
+		// Our worker threads, the calling thread also does a share of the work
+		std::vector<std::thread>                 m_Workers;
+		std::mutex                               m_JobMutex;
+		std::condition_variable                  m_JobStart;
+		std::condition_variable                  m_JobDone;
+		std::function<void(size_t, size_t)>      m_Job;
+		size_t                                   m_JobCount;
+		uint64_t                                 m_JobGeneration;
+		uint32_t                                 m_JobsRemaining;
+		bool                                     m_IsRunning;
+
+		double m_LastUpdateMs;
+		double m_LastDrawMs;
+
+		void __RandomParticle(glm::vec3& position, glm::vec3& velocity, float& lifetime);
+		void __SimulateRange(size_t begin, size_t end, float dt);
+		void __WriteInstances(InstanceData* dest, size_t begin, size_t end);
+		void __CompactDead();
+		void __ParallelFor(size_t count, const std::function<void(size_t, size_t)>& job);
+		void __WorkerThread(uint32_t index);
+		void __EmitCompute(size_t count);
+		void __CompileShaders();
+
+		static ParticleTimings __TimeFrames(ParticleSystem& system, const glm::mat4& view, const glm::mat4& projection, int frames);
+	};
+}
@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a renderer for very large point clouds. Clouds are
+// converted into an octree on disk ahead of time, and the nodes that are
+// needed for the current view are streamed into a fixed size pool of GPU
+// memory on a background thread
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <GLM/glm.hpp>
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+
+namespace TTK
+{
+	/*
+	 * Settings used when converting a point cloud into an octree
+	 */
+	struct PointCloudBuildSettings {
+		// The most points that a single octree node can hold, this is also the unit of streaming
+		uint32_t MaxPointsPerNode  = 20000;
+		// The most points to hold in memory at once. Nodes with more points than this below them are
+		// split into a temporary file per child, as many levels down as it takes for the children to fit
+		uint64_t MaxPointsInMemory = 16 * 1024 * 1024;
+		// Nodes will not be split past this depth, extra points in a full node at this depth are dropped
+		uint32_t MaxDepth          = 20;
+	};
+
+	/*
+	 * Settings used when streaming and rendering a point cloud
+	 */
+	struct PointCloudRenderSettings {
+		// The number of bytes of GPU memory to use for point data
+		size_t   MemoryBudget    = 256 * 1024 * 1024;
+		// The most points that will be drawn in a single frame
+		uint32_t PointBudget     = 5 * 1000 * 1000;
+		// Nodes are refined until the spacing between their points is less than this many pixels on screen
+		float    MaxScreenError  = 2.0f;
+		// The size to draw each point, in pixels
+		float    PointSize       = 2.0f;
+		// The most node loads that can be waiting on the background thread at once
+		uint32_t MaxPendingLoads = 16;
+	};
+
+	/*
+	 * An out-of-core point cloud, backed by an octree on disk
+	 *
+	 * Every node in the octree holds an evenly sampled subset of the points in it's bounds, with the
+	 * remaining points pushed down to it's children. Drawing a node and all of it's loaded ancestors
+	 * gives a view of the cloud that gets denser as more nodes are loaded
+	 *
+	 * Each frame, we walk the octree from the root in order of projected size, and select every
+	 * node whose point spacing is still larger than the allowed screen space error, until the per-frame
+	 * point budget is used up. Selected nodes that are not resident are read in on a background
+	 * thread, straight into a persistently mapped GPU buffer that is split into one slot per node.
+	 * When the pool is full, the least recently used nodes that were not selected are evicted
+	 */
+	class PointCloud {
+	public:
+		/*
+		 * Converts a PLY (ascii or binary little endian) or XYZ text file into an octree on disk. The input
+		 * is streamed twice, and partitioned through temporary files until each part fits in memory, so the
+		 * cloud itself does not need to
+		 * @param inputPath The path to the .ply or .xyz file to convert
+		 * @param outputPath The path to write the octree to, the point data will be written beside it
+		 *                   with the extension .points
+		 * @param settings The settings to build the octree with
+		 * @returns True if the octree was built, false if the input could not be read
+		 */
+		static bool Build(const std::string& inputPath, const std::string& outputPath, const PointCloudBuildSettings& settings = PointCloudBuildSettings());
+
+		/*
+		 * Opens an octree that was created by Build, only the node hierarchy is read right away
+		 * @param path The path to the octree file
+		 * @param settings The settings to stream and render the cloud with
+		 */
+		PointCloud(const std::string& path, const PointCloudRenderSettings& settings = PointCloudRenderSettings());
+		~PointCloud();
+
+		PointCloud(const PointCloud& other) = delete;
+		PointCloud& operator=(const PointCloud& other) = delete;
+
+		/*
+		 * Selects the nodes to draw for the given view, and queues up loads for any nodes that are missing.
+		 * Should be called once per frame before Draw
+		 * @param view The camera's view matrix
+		 * @param projection The camera's projection matrix
+		 * @param viewportHeight The height of the viewport, in pixels
+		 */
+		void Update(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+		/*
+		 * Draws all of the resident nodes that were selected in the last update
+		 * @param viewProjection The view projection matrix to render with
+		 */
+		void Draw(const glm::mat4& viewProjection);
+
+		PointCloudRenderSettings& Settings() { return m_Settings; }
+
+		/*
+		 * Gets the bounds of the entire cloud
+		 */
+		const glm::vec3& GetBoundsMin() const { return m_BoundsMin; }
+		const glm::vec3& GetBoundsMax() const { return m_BoundsMax; }
+
+		uint64_t GetTotalPoints() const { return m_TotalPoints; }
+		size_t   GetNodeCount() const { return m_Nodes.size(); }
+		// The number of points that were drawn in the last frame
+		uint32_t GetDrawnPoints() const { return m_DrawnPoints; }
+		// The number of nodes that are currently in GPU memory
+		uint32_t GetResidentNodes() const { return m_ResidentNodes; }
+		uint32_t GetSlotCount() const { return m_SlotCount; }
+		// The number of loads that are queued or in progress on the background thread
+		uint32_t GetPendingLoads() const { return m_PendingLoads; }
+
+	private:
+		// The layout of a single point, both on disk and on the GPU
+		struct Point {
+			glm::vec3 Position;
+			uint32_t  Color;
+		};
+
+		enum class NodeState {
+			Unloaded,
+			Loading,
+			Resident
+		};
+
+		struct Node {
+			glm::vec3 Min;
+			glm::vec3 Max;
+			uint64_t  FileOffset;
+			uint32_t  PointCount;
+			int32_t   Children[8];
+			uint32_t  Level;
+
+			NodeState State = NodeState::Unloaded;
+			int32_t   Slot = -1;
+			uint64_t  LastSelectedFrame = 0;
+		};
+
+		struct LoadRequest {
+			int32_t NodeIndex;
+			int32_t Slot;
+		};
+
+		PointCloudRenderSettings m_Settings;
+		std::string       m_PointsPath;
+		std::vector<Node> m_Nodes;
+		glm::vec3         m_BoundsMin;
+		glm::vec3         m_BoundsMax;
+		uint64_t          m_TotalPoints;
+		uint32_t          m_SlotCapacity;
+
+		// Our pool of point memory, persistently mapped so the loader can write to it directly
+		static const int RingFrames = 3;
+		GLuint   m_PointBuffer;
+		Point*   m_PointMapping;
+		uint32_t m_SlotCount;
+		std::vector<int32_t> m_FreeSlots;
+		// Resident nodes that can be evicted this frame, oldest last. Only built when we run out of free slots
+		std::vector<int32_t> m_EvictionCandidates;
+		bool     m_HasEvictionCandidates;
+		GLsync   m_FrameFences[RingFrames];
+		uint64_t m_Frame;
+		GLuint   m_VAO;
+		GLuint   m_Shader;
+
+		// The nodes selected in the last update, and the draw ranges for the resident ones
+		std::vector<int32_t> m_Selected;
+		std::vector<GLint>   m_DrawFirsts;
+		std::vector<GLsizei> m_DrawCounts;
+		uint32_t m_DrawnPoints;
+		uint32_t m_ResidentNodes;
+		uint32_t m_PendingLoads;
+
+		// The background loader, requests are handed over with m_LoadMutex held
+		std::thread             m_Loader;
+		std::mutex              m_LoadMutex;
+		std::condition_variable m_LoadSignal;
+		std::deque<LoadRequest> m_LoadRequests;
+		std::vector<int32_t>    m_CompletedLoads;
+		bool                    m_IsRunning;
+
+		void __LoaderThread();
+		void __ApplyCompletedLoads();
+		int32_t __AllocateSlot();
+		void __CompileShader();
+	};
+}
@@ -0,0 +1,702 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this file in your GDW games.
+//
+// This file implements the TTK particle system
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTK/ParticleSystem.h"
+#include "Logging.h"
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+// Pick the widest instruction set we've been compiled for
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define TTK_PARTICLE_AVX
+	#define TTK_PARTICLE_SIMD_WIDTH 8
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define TTK_PARTICLE_SSE
+	#define TTK_PARTICLE_SIMD_WIDTH 4
+#else
+	#define TTK_PARTICLE_SIMD_WIDTH 1
+#endif
+
+// Our pools are padded and aligned so that SIMD loads never cross into another allocation
+static const size_t PoolAlignment = 32;
+
+static float* AllocatePool(size_t count) {
+	size_t bytes = ((count * sizeof(float) + PoolAlignment - 1) / PoolAlignment) * PoolAlignment;
+#if defined(TTK_PARTICLE_AVX) || defined(TTK_PARTICLE_SSE)
+	return static_cast<float*>(_mm_malloc(bytes, PoolAlignment));
+#else
+	return static_cast<float*>(malloc(bytes));
+#endif
+}
+
+static void FreePool(float* pool) {
+#if defined(TTK_PARTICLE_AVX) || defined(TTK_PARTICLE_SSE)
+	_mm_free(pool);
+#else
+	free(pool);
+#endif
+}
+
+// Splits count items into numChunks chunks, keeping chunk boundaries on SIMD width multiples
+static size_t ChunkBoundary(size_t count, size_t chunk, size_t numChunks) {
+	if (chunk >= numChunks) return count;
+	return (count * chunk / numChunks) & ~static_cast<size_t>(7);
+}
+
+static GLuint CompileProgram(const std::vector<std::pair<GLenum, const char*>>& parts) {
+	GLuint result = glCreateProgram();
+
+	std::vector<GLuint> shaders;
+	for (auto& [type, source] : parts) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		// Check each stage as we go, a broken stage would otherwise only show up as a vague link error
+		GLint status = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			if (length > 0) {
+				char* log = new char[length];
+				glGetShaderInfoLog(shader, length, &length, log);
+				LOG_ERROR("Particle shader part failed to compile:\n{}", log);
+				delete[] log;
+			}
+			else {
+				LOG_ERROR("Particle shader part failed to compile for an unknown reason!");
+			}
+			glDeleteShader(shader);
+			for (GLuint part : shaders) {
+				glDeleteShader(part);
+			}
+			glDeleteProgram(result);
+			throw std::runtime_error("Failed to compile particle shader!");
+		}
+
+		glAttachShader(result, shader);
+		shaders.push_back(shader);
+	}
+
+	glLinkProgram(result);
+
+	GLint success = 0;
+	glGetProgramiv(result, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE) {
+		GLint length = 0;
+		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &length);
+		if (length > 0) {
+			char* log = new char[length];
+			glGetProgramInfoLog(result, length, &length, log);
+			LOG_ERROR("Particle shader failed to link:\n{}", log);
+			delete[] log;
+		}
+		else {
+			LOG_ERROR("Particle shader failed to link for an unknown reason!");
+		}
+		for (GLuint shader : shaders) {
+			glDeleteShader(shader);
+		}
+		glDeleteProgram(result);
+		throw std::runtime_error("Failed to link particle shader program!");
+	}
+
+	// Remove shader parts to save space
+	for (GLuint shader : shaders) {
+		glDetachShader(result, shader);
+		glDeleteShader(shader);
+	}
+
+	return result;
+}
+
+TTK::ParticleSystem::ParticleSystem(size_t maxParticles, uint32_t numThreads) :
+	m_Settings(EmitterSettings()),
+	m_MaxParticles(maxParticles),
+	m_Count(0),
+	m_EmitAccumulator(0.0f),
+	m_UseCompute(false),
+	m_Random(std::random_device()()),
+	m_InstanceBuffer(0),
+	m_InstanceMapping(nullptr),
+	m_RingIndex(0),
+	m_VAO(0),
+	m_RenderShader(0),
+	m_ComputeState(0),
+	m_ComputeShader(0),
+	m_ComputeHead(0),
+	m_JobCount(0),
+	m_JobGeneration(0),
+	m_JobsRemaining(0),
+	m_IsRunning(true),
+	m_LastUpdateMs(0.0),
+	m_LastDrawMs(0.0)
+{
+	m_PosX = AllocatePool(maxParticles);
+	m_PosY = AllocatePool(maxParticles);
+	m_PosZ = AllocatePool(maxParticles);
+	m_VelX = AllocatePool(maxParticles);
+	m_VelY = AllocatePool(maxParticles);
+	m_VelZ = AllocatePool(maxParticles);
+	m_Age = AllocatePool(maxParticles);
+	m_Lifetime = AllocatePool(maxParticles);
+
+	// Persistently map our instance ring, so that the worker threads can write straight into it
+	for (int ix = 0; ix < RingFrames; ix++) {
+		m_RingFences[ix] = nullptr;
+	}
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr ringSize = static_cast<GLsizeiptr>(sizeof(InstanceData) * maxParticles * RingFrames);
+	glCreateBuffers(1, &m_InstanceBuffer);
+	glNamedBufferStorage(m_InstanceBuffer, ringSize, nullptr, flags);
+	m_InstanceMapping = static_cast<InstanceData*>(glMapNamedBufferRange(m_InstanceBuffer, 0, ringSize, flags));
+
+	// Particle state for the compute path, every particle starts out dead (age == lifetime)
+	std::vector<glm::vec4> initialState(maxParticles * 2, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	glCreateBuffers(1, &m_ComputeState);
+	glNamedBufferStorage(m_ComputeState, sizeof(glm::vec4) * initialState.size(), initialState.data(), GL_DYNAMIC_STORAGE_BIT);
+
+	// Billboard corners are generated from gl_VertexID, so our only attributes are per-instance
+	glCreateVertexArrays(1, &m_VAO);
+	glVertexArrayAttribFormat(m_VAO, 0, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(m_VAO, 0, 0);
+	glVertexArrayBindingDivisor(m_VAO, 0, 1);
+	glEnableVertexArrayAttrib(m_VAO, 0);
+	glVertexArrayAttribFormat(m_VAO, 1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4));
+	glVertexArrayAttribBinding(m_VAO, 1, 0);
+
+	__CompileShaders();
+
+	// Spin up our workers, the calling thread will count as one of our threads
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (uint32_t ix = 1; ix < numThreads; ix++) {
+		m_Workers.emplace_back(&ParticleSystem::__WorkerThread, this, ix);
+	}
+}
+
+TTK::ParticleSystem::~ParticleSystem() {
+	{
+		std::lock_guard<std::mutex> lock(m_JobMutex);
+		m_IsRunning = false;
+	}
+	m_JobStart.notify_all();
+	for (std::thread& worker : m_Workers) {
+		worker.join();
+	}
+
+	for (int ix = 0; ix < RingFrames; ix++) {
+		if (m_RingFences[ix] != nullptr) {
+			glDeleteSync(m_RingFences[ix]);
+		}
+	}
+	glUnmapNamedBuffer(m_InstanceBuffer);
+	glDeleteBuffers(1, &m_InstanceBuffer);
+	glDeleteBuffers(1, &m_ComputeState);
+	glDeleteVertexArrays(1, &m_VAO);
+	glDeleteProgram(m_RenderShader);
+	glDeleteProgram(m_ComputeShader);
+
+	FreePool(m_PosX);
+	FreePool(m_PosY);
+	FreePool(m_PosZ);
+	FreePool(m_VelX);
+	FreePool(m_VelY);
+	FreePool(m_VelZ);
+	FreePool(m_Age);
+	FreePool(m_Lifetime);
+}
+
+const char* TTK::ParticleSystem::GetSimdName() {
+#if defined(TTK_PARTICLE_AVX)
+	return "AVX";
+#elif defined(TTK_PARTICLE_SSE)
+	return "SSE";
+#else
+	return "Scalar";
+#endif
+}
+
+TTK::ParticleBenchmarkResult TTK::ParticleSystem::RunBenchmark(const glm::mat4& view, const glm::mat4& projection, size_t numParticles, int frames, uint32_t numThreads) {
+	ParticleBenchmarkResult result;
+	result.Particles = numParticles;
+	result.Frames = std::max(frames, 1);
+
+	ParticleSystem system(numParticles, numThreads);
+	result.Threads = system.GetThreadCount();
+
+	// Every particle is spawned up front and outlives the run, so both paths work on the full pool every frame
+	EmitterSettings& settings = system.Settings();
+	settings.PositionSpread = glm::vec3(5.0f);
+	settings.VelocitySpread = glm::vec3(2.0f);
+	settings.LifetimeMin = 1.0e6f;
+	settings.LifetimeMax = 1.0e6f;
+	settings.EmitRate = 0.0f;
+	settings.StartSize = 0.02f;
+	settings.EndSize = 0.02f;
+	system.Emit(numParticles);
+
+	result.Cpu = __TimeFrames(system, view, projection, result.Frames);
+	system.SetUseCompute(true);
+	result.Compute = __TimeFrames(system, view, projection, result.Frames);
+
+	LOG_INFO("Particle benchmark: {} particles, {} threads ({}), {} frames", numParticles, result.Threads, GetSimdName(), result.Frames);
+	LOG_INFO("\tCPU path:     update {:.3f}ms CPU / {:.3f}ms GPU, draw {:.3f}ms CPU / {:.3f}ms GPU",
+		result.Cpu.UpdateCpuMs, result.Cpu.UpdateGpuMs, result.Cpu.DrawCpuMs, result.Cpu.DrawGpuMs);
+	LOG_INFO("\tCompute path: update {:.3f}ms CPU / {:.3f}ms GPU, draw {:.3f}ms CPU / {:.3f}ms GPU",
+		result.Compute.UpdateCpuMs, result.Compute.UpdateGpuMs, result.Compute.DrawCpuMs, result.Compute.DrawGpuMs);
+
+	return result;
+}
+
+TTK::ParticleTimings TTK::ParticleSystem::__TimeFrames(ParticleSystem& system, const glm::mat4& view, const glm::mat4& projection, int frames) {
+	const float dt = 1.0f / 60.0f;
+	ParticleTimings result;
+
+	// Get the first-use costs (shader warm up, page faults in the pools and ring) out of the way
+	for (int ix = 0; ix < RingFrames; ix++) {
+		system.Update(dt);
+		system.Draw(view, projection);
+	}
+	glFinish();
+
+	// Two timer queries per frame, one around the update and one around the draw. We only read them back once
+	// all the frames are submitted, so that waiting on the results doesn't serialize the CPU and GPU
+	std::vector<GLuint> queries(static_cast<size_t>(frames) * 2);
+	glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	for (int frame = 0; frame < frames; frame++) {
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame * 2 + 0]);
+		system.Update(dt);
+		glEndQuery(GL_TIME_ELAPSED);
+		result.UpdateCpuMs += system.GetLastUpdateMs();
+
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame * 2 + 1]);
+		system.Draw(view, projection);
+		glEndQuery(GL_TIME_ELAPSED);
+		result.DrawCpuMs += system.GetLastDrawMs();
+	}
+	glFinish();
+
+	for (int frame = 0; frame < frames; frame++) {
+		GLuint64 updateNs = 0, drawNs = 0;
+		glGetQueryObjectui64v(queries[frame * 2 + 0], GL_QUERY_RESULT, &updateNs);
+		glGetQueryObjectui64v(queries[frame * 2 + 1], GL_QUERY_RESULT, &drawNs);
+		result.UpdateGpuMs += updateNs / 1.0e6;
+		result.DrawGpuMs += drawNs / 1.0e6;
+	}
+	glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	result.UpdateCpuMs /= frames;
+	result.DrawCpuMs /= frames;
+	result.UpdateGpuMs /= frames;
+	result.DrawGpuMs /= frames;
+	return result;
+}
+
+void TTK::ParticleSystem::Emit(size_t count) {
+	if (m_UseCompute) {
+		__EmitCompute(count);
+		return;
+	}
+
+	count = std::min(count, m_MaxParticles - m_Count);
+	for (size_t ix = m_Count; ix < m_Count + count; ix++) {
+		glm::vec3 pos, vel;
+		float lifetime;
+		__RandomParticle(pos, vel, lifetime);
+		m_PosX[ix] = pos.x; m_PosY[ix] = pos.y; m_PosZ[ix] = pos.z;
+		m_VelX[ix] = vel.x; m_VelY[ix] = vel.y; m_VelZ[ix] = vel.z;
+		m_Age[ix] = 0.0f;
+		m_Lifetime[ix] = lifetime;
+	}
+	m_Count += count;
+}
+
+void TTK::ParticleSystem::Update(float dt) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Spawn new particles for this frame
+	m_EmitAccumulator += m_Settings.EmitRate * dt;
+	size_t toEmit = static_cast<size_t>(m_EmitAccumulator);
+	m_EmitAccumulator -= static_cast<float>(toEmit);
+	Emit(toEmit);
+
+	if (m_UseCompute) {
+		// The GPU does all the work, we just need to kick it off
+		glUseProgram(m_ComputeShader);
+		glUniform1f(0, dt);
+		glUniform3fv(1, 1, &m_Settings.Gravity.x);
+		glUniform1f(2, std::max(0.0f, 1.0f - m_Settings.Drag * dt));
+		glUniform1ui(3, static_cast<GLuint>(m_Count));
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_ComputeState);
+		glDispatchCompute(static_cast<GLuint>((m_Count + 255) / 256), 1, 1);
+		// Make sure the simulation results are visible when we source them as vertex attributes, and that
+		// the shader's writes are done before we emit into the buffer or read it back with glGet/glNamedBufferSubData
+		glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	}
+	else {
+		__ParallelFor(m_Count, [this, dt](size_t begin, size_t end) {
+			__SimulateRange(begin, end, dt);
+		});
+		__CompactDead();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_LastUpdateMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void TTK::ParticleSystem::Draw(const glm::mat4& view, const glm::mat4& projection) {
+	if (m_Count == 0) {
+		return;
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (m_UseCompute) {
+		// Source our instances directly from the simulation state
+		glVertexArrayVertexBuffer(m_VAO, 0, m_ComputeState, 0, sizeof(glm::vec4) * 2);
+		glEnableVertexArrayAttrib(m_VAO, 1);
+	}
+	else {
+		// Wait for the GPU to finish with this section of the ring before we overwrite it
+		if (m_RingFences[m_RingIndex] != nullptr) {
+			glClientWaitSync(m_RingFences[m_RingIndex], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_RingFences[m_RingIndex]);
+			m_RingFences[m_RingIndex] = nullptr;
+		}
+
+		InstanceData* region = m_InstanceMapping + m_MaxParticles * m_RingIndex;
+		__ParallelFor(m_Count, [this, region](size_t begin, size_t end) {
+			__WriteInstances(region, begin, end);
+		});
+
+		glVertexArrayVertexBuffer(m_VAO, 0, m_InstanceBuffer, sizeof(InstanceData) * m_MaxParticles * m_RingIndex, sizeof(InstanceData));
+		// Without the lifetime attribute, the shader will see a lifetime of 1 and use our normalized age as is
+		glDisableVertexArrayAttrib(m_VAO, 1);
+		glVertexAttrib4f(1, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	// Particles are blended, so they shouldn't write to depth
+	GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	glUseProgram(m_RenderShader);
+	glUniformMatrix4fv(0, 1, false, &view[0][0]);
+	glUniformMatrix4fv(1, 1, false, &projection[0][0]);
+	glUniform4fv(2, 1, &m_Settings.StartColor.x);
+	glUniform4fv(3, 1, &m_Settings.EndColor.x);
+	glUniform2f(4, m_Settings.StartSize, m_Settings.EndSize);
+	glBindVertexArray(m_VAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_Count));
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	if (!blendEnabled) {
+		glDisable(GL_BLEND);
+	}
+
+	if (!m_UseCompute) {
+		m_RingFences[m_RingIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_RingIndex = (m_RingIndex + 1) % RingFrames;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_LastDrawMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void TTK::ParticleSystem::SetUseCompute(bool value) {
+	if (value == m_UseCompute) {
+		return;
+	}
+
+	std::vector<glm::vec4> state;
+	if (value) {
+		// Pack our live particles into the GPU state, the rest of the buffer is left as is
+		state.resize(m_Count * 2);
+		for (size_t ix = 0; ix < m_Count; ix++) {
+			state[ix * 2 + 0] = glm::vec4(m_PosX[ix], m_PosY[ix], m_PosZ[ix], m_Age[ix]);
+			state[ix * 2 + 1] = glm::vec4(m_VelX[ix], m_VelY[ix], m_VelZ[ix], m_Lifetime[ix]);
+		}
+		if (!state.empty()) {
+			glNamedBufferSubData(m_ComputeState, 0, sizeof(glm::vec4) * state.size(), state.data());
+		}
+		m_ComputeHead = m_Count % m_MaxParticles;
+	}
+	else {
+		// Read back the GPU state, and keep only the particles that are still alive
+		state.resize(m_Count * 2);
+		if (!state.empty()) {
+			glGetNamedBufferSubData(m_ComputeState, 0, sizeof(glm::vec4) * state.size(), state.data());
+		}
+		size_t alive = 0;
+		for (size_t ix = 0; ix < m_Count; ix++) {
+			const glm::vec4& posAge = state[ix * 2 + 0];
+			const glm::vec4& velLife = state[ix * 2 + 1];
+			if (posAge.w < velLife.w) {
+				m_PosX[alive] = posAge.x; m_PosY[alive] = posAge.y; m_PosZ[alive] = posAge.z; m_Age[alive] = posAge.w;
+				m_VelX[alive] = velLife.x; m_VelY[alive] = velLife.y; m_VelZ[alive] = velLife.z; m_Lifetime[alive] = velLife.w;
+				alive++;
+			}
+		}
+		m_Count = alive;
+	}
+	m_UseCompute = value;
+}
+
+void TTK::ParticleSystem::__RandomParticle(glm::vec3& position, glm::vec3& velocity, float& lifetime) {
+	std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> life(m_Settings.LifetimeMin, std::max(m_Settings.LifetimeMin, m_Settings.LifetimeMax));
+	position = m_Settings.Position + m_Settings.PositionSpread * glm::vec3(signedUnit(m_Random), signedUnit(m_Random), signedUnit(m_Random));
+	velocity = m_Settings.Velocity + m_Settings.VelocitySpread * glm::vec3(signedUnit(m_Random), signedUnit(m_Random), signedUnit(m_Random));
+	lifetime = life(m_Random);
+}
+
+void TTK::ParticleSystem::__SimulateRange(size_t begin, size_t end, float dt) {
+	const float damping = std::max(0.0f, 1.0f - m_Settings.Drag * dt);
+	const glm::vec3 dv = m_Settings.Gravity * dt;
+	size_t ix = begin;
+
+#if defined(TTK_PARTICLE_AVX)
+	const __m256 vDt = _mm256_set1_ps(dt);
+	const __m256 vDamp = _mm256_set1_ps(damping);
+	const __m256 vDvx = _mm256_set1_ps(dv.x), vDvy = _mm256_set1_ps(dv.y), vDvz = _mm256_set1_ps(dv.z);
+	for (; ix + 8 <= end; ix += 8) {
+		__m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_load_ps(m_VelX + ix), vDvx), vDamp);
+		__m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_load_ps(m_VelY + ix), vDvy), vDamp);
+		__m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_load_ps(m_VelZ + ix), vDvz), vDamp);
+		_mm256_store_ps(m_VelX + ix, vx);
+		_mm256_store_ps(m_VelY + ix, vy);
+		_mm256_store_ps(m_VelZ + ix, vz);
+		_mm256_store_ps(m_PosX + ix, _mm256_add_ps(_mm256_load_ps(m_PosX + ix), _mm256_mul_ps(vx, vDt)));
+		_mm256_store_ps(m_PosY + ix, _mm256_add_ps(_mm256_load_ps(m_PosY + ix), _mm256_mul_ps(vy, vDt)));
+		_mm256_store_ps(m_PosZ + ix, _mm256_add_ps(_mm256_load_ps(m_PosZ + ix), _mm256_mul_ps(vz, vDt)));
+		_mm256_store_ps(m_Age + ix, _mm256_add_ps(_mm256_load_ps(m_Age + ix), vDt));
+	}
+#elif defined(TTK_PARTICLE_SSE)
+	const __m128 vDt = _mm_set1_ps(dt);
+	const __m128 vDamp = _mm_set1_ps(damping);
+	const __m128 vDvx = _mm_set1_ps(dv.x), vDvy = _mm_set1_ps(dv.y), vDvz = _mm_set1_ps(dv.z);
+	for (; ix + 4 <= end; ix += 4) {
+		__m128 vx = _mm_mul_ps(_mm_add_ps(_mm_load_ps(m_VelX + ix), vDvx), vDamp);
+		__m128 vy = _mm_mul_ps(_mm_add_ps(_mm_load_ps(m_VelY + ix), vDvy), vDamp);
+		__m128 vz = _mm_mul_ps(_mm_add_ps(_mm_load_ps(m_VelZ + ix), vDvz), vDamp);
+		_mm_store_ps(m_VelX + ix, vx);
+		_mm_store_ps(m_VelY + ix, vy);
+		_mm_store_ps(m_VelZ + ix, vz);
+		_mm_store_ps(m_PosX + ix, _mm_add_ps(_mm_load_ps(m_PosX + ix), _mm_mul_ps(vx, vDt)));
+		_mm_store_ps(m_PosY + ix, _mm_add_ps(_mm_load_ps(m_PosY + ix), _mm_mul_ps(vy, vDt)));
+		_mm_store_ps(m_PosZ + ix, _mm_add_ps(_mm_load_ps(m_PosZ + ix), _mm_mul_ps(vz, vDt)));
+		_mm_store_ps(m_Age + ix, _mm_add_ps(_mm_load_ps(m_Age + ix), vDt));
+	}
+#endif
+
+	// Handle whatever is left over at the end of the range
+	for (; ix < end; ix++) {
+		m_VelX[ix] = (m_VelX[ix] + dv.x) * damping;
+		m_VelY[ix] = (m_VelY[ix] + dv.y) * damping;
+		m_VelZ[ix] = (m_VelZ[ix] + dv.z) * damping;
+		m_PosX[ix] += m_VelX[ix] * dt;
+		m_PosY[ix] += m_VelY[ix] * dt;
+		m_PosZ[ix] += m_VelZ[ix] * dt;
+		m_Age[ix] += dt;
+	}
+}
+
+void TTK::ParticleSystem::__WriteInstances(InstanceData* dest, size_t begin, size_t end) {
+	for (size_t ix = begin; ix < end; ix++) {
+		dest[ix].Position = glm::vec3(m_PosX[ix], m_PosY[ix], m_PosZ[ix]);
+		dest[ix].NormalizedAge = m_Age[ix] / m_Lifetime[ix];
+	}
+}
+
+void TTK::ParticleSystem::__CompactDead() {
+	// Swap the last live particle into any dead slots, so live particles stay packed at the front
+	size_t ix = 0;
+	while (ix < m_Count) {
+		if (m_Age[ix] >= m_Lifetime[ix]) {
+			m_Count--;
+			m_PosX[ix] = m_PosX[m_Count]; m_PosY[ix] = m_PosY[m_Count]; m_PosZ[ix] = m_PosZ[m_Count];
+			m_VelX[ix] = m_VelX[m_Count]; m_VelY[ix] = m_VelY[m_Count]; m_VelZ[ix] = m_VelZ[m_Count];
+			m_Age[ix] = m_Age[m_Count];
+			m_Lifetime[ix] = m_Lifetime[m_Count];
+		}
+		else {
+			ix++;
+		}
+	}
+}
+
+void TTK::ParticleSystem::__ParallelFor(size_t count, const std::function<void(size_t, size_t)>& job) {
+	// Small workloads aren't worth waking up the workers for
+	static const size_t MinParallelCount = 4096;
+	if (m_Workers.empty() || count < MinParallelCount) {
+		job(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_JobMutex);
+		m_Job = job;
+		m_JobCount = count;
+		m_JobsRemaining = static_cast<uint32_t>(m_Workers.size());
+		m_JobGeneration++;
+	}
+	m_JobStart.notify_all();
+
+	// The calling thread takes the first chunk
+	size_t numChunks = m_Workers.size() + 1;
+	job(0, ChunkBoundary(count, 1, numChunks));
+
+	std::unique_lock<std::mutex> lock(m_JobMutex);
+	m_JobDone.wait(lock, [this] { return m_JobsRemaining == 0; });
+}
+
+void TTK::ParticleSystem::__WorkerThread(uint32_t index) {
+	uint64_t lastGeneration = 0;
+	while (true) {
+		std::function<void(size_t, size_t)> job;
+		size_t count;
+		{
+			std::unique_lock<std::mutex> lock(m_JobMutex);
+			m_JobStart.wait(lock, [&] { return !m_IsRunning || m_JobGeneration != lastGeneration; });
+			if (!m_IsRunning) {
+				return;
+			}
+			lastGeneration = m_JobGeneration;
+			job = m_Job;
+			count = m_JobCount;
+		}
+
+		size_t numChunks = m_Workers.size() + 1;
+		size_t begin = ChunkBoundary(count, index, numChunks);
+		size_t end = ChunkBoundary(count, index + 1, numChunks);
+		if (end > begin) {
+			job(begin, end);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_JobMutex);
+			m_JobsRemaining--;
+		}
+		m_JobDone.notify_one();
+	}
+}
+
+void TTK::ParticleSystem::__EmitCompute(size_t count) {
+	count = std::min(count, m_MaxParticles);
+	if (count == 0) {
+		return;
+	}
+
+	std::vector<glm::vec4> state(count * 2);
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 pos, vel;
+		float lifetime;
+		__RandomParticle(pos, vel, lifetime);
+		state[ix * 2 + 0] = glm::vec4(pos, 0.0f);
+		state[ix * 2 + 1] = glm::vec4(vel, lifetime);
+	}
+
+	// The GPU pool is a ring, new particles overwrite the oldest ones. We may need to split
+	// the upload in two if we wrap around the end of the pool
+	size_t first = std::min(count, m_MaxParticles - m_ComputeHead);
+	glNamedBufferSubData(m_ComputeState, sizeof(glm::vec4) * 2 * m_ComputeHead, sizeof(glm::vec4) * 2 * first, state.data());
+	if (first < count) {
+		glNamedBufferSubData(m_ComputeState, 0, sizeof(glm::vec4) * 2 * (count - first), state.data() + first * 2);
+	}
+	m_ComputeHead = (m_ComputeHead + count) % m_MaxParticles;
+	m_Count = std::min(m_Count + count, m_MaxParticles);
+}
+
+void TTK::ParticleSystem::__CompileShaders() {
+	const char* vsSource = R"LIT(#version 430
+            layout (location = 0) uniform mat4 xView;
+            layout (location = 1) uniform mat4 xProjection;
+            layout (location = 2) uniform vec4 xStartColor;
+            layout (location = 3) uniform vec4 xEndColor;
+            layout (location = 4) uniform vec2 xSize;
+
+            // Position and age, and velocity and lifetime (lifetime is 1 if age is already normalized)
+            layout (location = 0) in vec4 vertexPosAge;
+            layout (location = 1) in vec4 vertexVelLifetime;
+
+            layout (location = 0) out vec4 fragmentColor;
+            layout (location = 1) out vec2 fragmentUV;
+            void main() {
+                float t = vertexPosAge.w / vertexVelLifetime.w;
+                // Dead particles (only possible on the compute path) are collapsed outside of the clip volume
+                if (t >= 1.0) {
+                    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+                    return;
+                }
+                // Expand the billboard in view space so it always faces the camera
+                vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+                vec4 viewPos = xView * vec4(vertexPosAge.xyz, 1.0);
+                viewPos.xy += corner * mix(xSize.x, xSize.y, t);
+                gl_Position = xProjection * viewPos;
+                fragmentColor = mix(xStartColor, xEndColor, t);
+                fragmentUV = corner;
+            })LIT";
+
+	const char* fsSource = R"LIT(#version 430
+            layout (location = 0) in vec4 fragColor;
+            layout (location = 1) in vec2 fragUV;
+            out vec4 frag_color;
+            void main() {
+                // Soft round particles
+                float alpha = fragColor.a * (1.0 - smoothstep(0.5, 1.0, length(fragUV)));
+                if (alpha < 0.01) {
+                    discard;
+                }
+                frag_color = vec4(fragColor.rgb, alpha);
+            })LIT";
+
+	const char* csSource = R"LIT(#version 430
+            layout (local_size_x = 256) in;
+
+            struct Particle {
+                vec4 PosAge;
+                vec4 VelLifetime;
+            };
+            layout (std430, binding = 0) buffer ParticleState {
+                Particle particles[];
+            };
+
+            layout (location = 0) uniform float xDt;
+            layout (location = 1) uniform vec3  xGravity;
+            layout (location = 2) uniform float xDamping;
+            layout (location = 3) uniform uint  xCount;
+
+            void main() {
+                uint ix = gl_GlobalInvocationID.x;
+                if (ix >= xCount) {
+                    return;
+                }
+                Particle p = particles[ix];
+                if (p.PosAge.w >= p.VelLifetime.w) {
+                    return;
+                }
+                p.VelLifetime.xyz = (p.VelLifetime.xyz + xGravity * xDt) * xDamping;
+                p.PosAge.xyz += p.VelLifetime.xyz * xDt;
+                p.PosAge.w += xDt;
+                particles[ix] = p;
+            })LIT";
+
+	m_RenderShader = CompileProgram({ { GL_VERTEX_SHADER, vsSource }, { GL_FRAGMENT_SHADER, fsSource } });
+	m_ComputeShader = CompileProgram({ { GL_COMPUTE_SHADER, csSource } });
+}
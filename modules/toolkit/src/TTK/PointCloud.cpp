@@ -0,0 +1,1001 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this file in your GDW games.
+//
+// This file implements the TTK out-of-core point cloud renderer
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTK/PointCloud.h"
+#include "Logging.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+	// The on disk layout of the octree file, the node hierarchy is stored as a flat array of
+	// nodes after the header, with the root at index 0
+	struct FileHeader {
+		char     Magic[4];
+		uint32_t Version;
+		float    Min[3];
+		float    Max[3];
+		uint64_t TotalPoints;
+		uint32_t NodeCount;
+		uint32_t MaxPointsPerNode;
+	};
+
+	struct FileNode {
+		float    Min[3];
+		float    Max[3];
+		uint64_t FileOffset;
+		uint32_t PointCount;
+		uint32_t Level;
+		int32_t  Children[8];
+	};
+
+	const char     FileMagic[4] = { 'T', 'P', 'C', 'O' };
+	const uint32_t FileVersion = 1;
+
+	// Points are read from the input in chunks of this size
+	const size_t ReadChunkSize = 64 * 1024;
+
+	// Same layout as TTK::PointCloud::Point, but visible to our build helpers
+	struct BuildPoint {
+		glm::vec3 Position;
+		uint32_t  Color;
+	};
+	static_assert(sizeof(BuildPoint) == 16, "Points must be tightly packed");
+
+	struct BuildNode {
+		glm::vec3 Min;
+		glm::vec3 Max;
+		uint32_t  Level;
+		int32_t   Children[8];
+		uint64_t  FileOffset = 0;
+		uint32_t  PointCount = 0;
+	};
+
+	typedef std::function<void(const BuildPoint*, size_t)> PointSink;
+	// Streams every point in some set of points to a sink, returning false if they could not be read
+	typedef std::function<bool(const PointSink&)> PointSource;
+
+	uint32_t PackColor(float r, float g, float b, float a) {
+		auto toByte = [](float v) { return static_cast<uint32_t>(glm::clamp(v, 0.0f, 255.0f) + 0.5f); };
+		return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+	}
+
+	std::string ToLower(std::string value) {
+		std::transform(value.begin(), value.end(), value.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+		return value;
+	}
+
+	// Reads an XYZ text file, with one "x y z [r g b]" point per line
+	bool ReadXyz(const std::string& path, const PointSink& sink) {
+		std::ifstream file(path);
+		if (!file) {
+			LOG_ERROR("Failed to open point cloud \"{}\"", path);
+			return false;
+		}
+
+		std::vector<BuildPoint> chunk;
+		chunk.reserve(ReadChunkSize);
+		std::string line;
+		while (std::getline(file, line)) {
+			const char* cursor = line.c_str();
+			char* end = nullptr;
+			float values[6];
+			int count = 0;
+			while (count < 6) {
+				values[count] = strtof(cursor, &end);
+				if (end == cursor) break;
+				cursor = end;
+				count++;
+			}
+			// Skip blank lines and comments
+			if (count < 3) {
+				continue;
+			}
+
+			BuildPoint point;
+			point.Position = glm::vec3(values[0], values[1], values[2]);
+			if (count == 6) {
+				// Colors may be stored as bytes or as normalized floats
+				bool isNormalized = values[3] <= 1.0f && values[4] <= 1.0f && values[5] <= 1.0f;
+				float scale = isNormalized ? 255.0f : 1.0f;
+				point.Color = PackColor(values[3] * scale, values[4] * scale, values[5] * scale, 255.0f);
+			} else {
+				point.Color = 0xFFFFFFFF;
+			}
+			chunk.push_back(point);
+
+			if (chunk.size() == ReadChunkSize) {
+				sink(chunk.data(), chunk.size());
+				chunk.clear();
+			}
+		}
+		if (!chunk.empty()) {
+			sink(chunk.data(), chunk.size());
+		}
+		return true;
+	}
+
+	// Reads a PLY file in either ascii or binary little endian format. Only the vertex element is read,
+	// using the x, y, z, red, green, blue and alpha properties
+	bool ReadPly(const std::string& path, const PointSink& sink) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			LOG_ERROR("Failed to open point cloud \"{}\"", path);
+			return false;
+		}
+
+		enum class PropType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+		struct Property {
+			PropType Type;
+			size_t   Offset;
+			int      Target; // 0-2 are x, y, z, 3-6 are r, g, b, a, -1 is ignored
+		};
+
+		std::vector<Property> properties;
+		size_t stride = 0;
+		uint64_t vertexCount = 0;
+		bool isBinary = false;
+		bool inVertexElement = false;
+		bool seenVertexElement = false;
+
+		std::string line;
+		if (!std::getline(file, line) || line.compare(0, 3, "ply") != 0) {
+			LOG_ERROR("\"{}\" is not a PLY file", path);
+			return false;
+		}
+		while (std::getline(file, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			std::istringstream stream(line);
+			std::string keyword;
+			stream >> keyword;
+
+			if (keyword == "end_header") {
+				break;
+			} else if (keyword == "format") {
+				std::string format;
+				stream >> format;
+				if (format == "binary_little_endian") {
+					isBinary = true;
+				} else if (format != "ascii") {
+					LOG_ERROR("Unsupported PLY format \"{}\" in \"{}\"", format, path);
+					return false;
+				}
+			} else if (keyword == "element") {
+				std::string name;
+				uint64_t count;
+				stream >> name >> count;
+				if (name == "vertex") {
+					vertexCount = count;
+					inVertexElement = true;
+					seenVertexElement = true;
+				} else {
+					if (!seenVertexElement && count > 0) {
+						LOG_ERROR("PLY elements before the vertex element are not supported (\"{}\")", path);
+						return false;
+					}
+					inVertexElement = false;
+				}
+			} else if (keyword == "property" && inVertexElement) {
+				std::string type, name;
+				stream >> type >> name;
+				if (type == "list") {
+					LOG_ERROR("List properties on vertices are not supported (\"{}\")", path);
+					return false;
+				}
+
+				static const std::pair<const char*, std::pair<PropType, size_t>> typeNames[] = {
+					{ "char", { PropType::Int8, 1 } },     { "int8", { PropType::Int8, 1 } },
+					{ "uchar", { PropType::UInt8, 1 } },   { "uint8", { PropType::UInt8, 1 } },
+					{ "short", { PropType::Int16, 2 } },   { "int16", { PropType::Int16, 2 } },
+					{ "ushort", { PropType::UInt16, 2 } }, { "uint16", { PropType::UInt16, 2 } },
+					{ "int", { PropType::Int32, 4 } },     { "int32", { PropType::Int32, 4 } },
+					{ "uint", { PropType::UInt32, 4 } },   { "uint32", { PropType::UInt32, 4 } },
+					{ "float", { PropType::Float32, 4 } }, { "float32", { PropType::Float32, 4 } },
+					{ "double", { PropType::Float64, 8 } },{ "float64", { PropType::Float64, 8 } }
+				};
+				Property property;
+				size_t size = 0;
+				for (const auto& [typeName, info] : typeNames) {
+					if (type == typeName) {
+						property.Type = info.first;
+						size = info.second;
+					}
+				}
+				if (size == 0) {
+					LOG_ERROR("Unknown PLY property type \"{}\" in \"{}\"", type, path);
+					return false;
+				}
+				static const char* targets[] = { "x", "y", "z", "red", "green", "blue", "alpha" };
+				property.Target = -1;
+				for (int ix = 0; ix < 7; ix++) {
+					if (name == targets[ix]) property.Target = ix;
+				}
+				property.Offset = stride;
+				stride += size;
+				properties.push_back(property);
+			}
+		}
+
+		if (!seenVertexElement || stride == 0) {
+			LOG_ERROR("PLY file \"{}\" has no vertices", path);
+			return false;
+		}
+
+		auto readBinary = [](PropType type, const uint8_t* data) -> double {
+			switch (type) {
+				case PropType::Int8:    { int8_t v;   memcpy(&v, data, 1); return v; }
+				case PropType::UInt8:   { uint8_t v;  memcpy(&v, data, 1); return v; }
+				case PropType::Int16:   { int16_t v;  memcpy(&v, data, 2); return v; }
+				case PropType::UInt16:  { uint16_t v; memcpy(&v, data, 2); return v; }
+				case PropType::Int32:   { int32_t v;  memcpy(&v, data, 4); return v; }
+				case PropType::UInt32:  { uint32_t v; memcpy(&v, data, 4); return v; }
+				case PropType::Float32: { float v;    memcpy(&v, data, 4); return v; }
+				case PropType::Float64: { double v;   memcpy(&v, data, 8); return v; }
+			}
+			return 0.0;
+		};
+
+		std::vector<BuildPoint> chunk;
+		chunk.reserve(ReadChunkSize);
+		std::vector<uint8_t> raw(stride * ReadChunkSize);
+		uint64_t remaining = vertexCount;
+		while (remaining > 0) {
+			size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, ReadChunkSize));
+			if (isBinary) {
+				file.read(reinterpret_cast<char*>(raw.data()), stride * count);
+				if (static_cast<size_t>(file.gcount()) != stride * count) {
+					LOG_ERROR("Unexpected end of file in \"{}\"", path);
+					return false;
+				}
+			}
+
+			for (size_t ix = 0; ix < count; ix++) {
+				// Colors default to opaque white if they are missing
+				double values[7] = { 0.0, 0.0, 0.0, 255.0, 255.0, 255.0, 255.0 };
+				bool isFloatColor[7] = { false };
+				if (isBinary) {
+					const uint8_t* vertex = raw.data() + ix * stride;
+					for (const Property& property : properties) {
+						if (property.Target >= 0) {
+							values[property.Target] = readBinary(property.Type, vertex + property.Offset);
+							isFloatColor[property.Target] = property.Type == PropType::Float32 || property.Type == PropType::Float64;
+						}
+					}
+				} else {
+					if (!std::getline(file, line)) {
+						LOG_ERROR("Unexpected end of file in \"{}\"", path);
+						return false;
+					}
+					const char* cursor = line.c_str();
+					char* end = nullptr;
+					for (const Property& property : properties) {
+						double value = strtod(cursor, &end);
+						cursor = end;
+						if (property.Target >= 0) {
+							values[property.Target] = value;
+							isFloatColor[property.Target] = property.Type == PropType::Float32 || property.Type == PropType::Float64;
+						}
+					}
+				}
+				for (int channel = 3; channel < 7; channel++) {
+					if (isFloatColor[channel]) values[channel] *= 255.0;
+				}
+
+				BuildPoint point;
+				point.Position = glm::vec3(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+				point.Color = PackColor(static_cast<float>(values[3]), static_cast<float>(values[4]), static_cast<float>(values[5]), static_cast<float>(values[6]));
+				chunk.push_back(point);
+			}
+
+			sink(chunk.data(), chunk.size());
+			chunk.clear();
+			remaining -= count;
+		}
+		return true;
+	}
+
+	// Reads back one of the temporary files that Build partitions points into
+	bool ReadTempPoints(const std::string& path, const PointSink& sink) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			LOG_ERROR("Failed to open temporary point file \"{}\"", path);
+			return false;
+		}
+
+		std::vector<BuildPoint> chunk(ReadChunkSize);
+		while (file.read(reinterpret_cast<char*>(chunk.data()), sizeof(BuildPoint) * chunk.size()) || file.gcount() > 0) {
+			sink(chunk.data(), static_cast<size_t>(file.gcount()) / sizeof(BuildPoint));
+		}
+		return true;
+	}
+
+	bool ReadPoints(const std::string& path, const PointSink& sink) {
+		std::string extension = ToLower(std::filesystem::path(path).extension().string());
+		if (extension == ".ply") {
+			return ReadPly(path, sink);
+		} else if (extension == ".xyz" || extension == ".txt") {
+			return ReadXyz(path, sink);
+		}
+		LOG_ERROR("Unsupported point cloud format \"{}\"", extension);
+		return false;
+	}
+
+	int GetOctant(const glm::vec3& point, const glm::vec3& center) {
+		return (point.x >= center.x ? 1 : 0) | (point.y >= center.y ? 2 : 0) | (point.z >= center.z ? 4 : 0);
+	}
+
+	int32_t GetOrCreateChild(std::vector<BuildNode>& nodes, int32_t parent, int octant) {
+		if (nodes[parent].Children[octant] < 0) {
+			BuildNode child;
+			glm::vec3 center = (nodes[parent].Min + nodes[parent].Max) * 0.5f;
+			for (int axis = 0; axis < 3; axis++) {
+				bool upper = (octant >> axis) & 1;
+				child.Min[axis] = upper ? center[axis] : nodes[parent].Min[axis];
+				child.Max[axis] = upper ? nodes[parent].Max[axis] : center[axis];
+			}
+			child.Level = nodes[parent].Level + 1;
+			std::fill(child.Children, child.Children + 8, -1);
+			nodes.push_back(child);
+			nodes[parent].Children[octant] = static_cast<int32_t>(nodes.size() - 1);
+		}
+		return nodes[parent].Children[octant];
+	}
+
+	struct NodeWriter {
+		std::ofstream Stream;
+		uint64_t      Offset = 0;
+		uint64_t      Dropped = 0;
+
+		void Write(BuildNode& node, const BuildPoint* points, size_t count) {
+			node.FileOffset = Offset;
+			node.PointCount = static_cast<uint32_t>(count);
+			Stream.write(reinterpret_cast<const char*>(points), sizeof(BuildPoint) * count);
+			Offset += sizeof(BuildPoint) * count;
+		}
+	};
+
+	// Builds the part of the octree below the given node. Since the points are shuffled, the first points
+	// are an even sample of the node's bounds, which we keep in the node itself and push the rest down
+	void BuildSubtree(std::vector<BuildNode>& nodes, int32_t index, std::vector<BuildPoint>& points, NodeWriter& writer, const TTK::PointCloudBuildSettings& settings) {
+		size_t keep = std::min<size_t>(points.size(), settings.MaxPointsPerNode);
+		writer.Write(nodes[index], points.data(), keep);
+
+		if (points.size() == keep) {
+			return;
+		}
+		if (nodes[index].Level >= settings.MaxDepth) {
+			writer.Dropped += points.size() - keep;
+			return;
+		}
+
+		glm::vec3 center = (nodes[index].Min + nodes[index].Max) * 0.5f;
+		std::vector<BuildPoint> children[8];
+		for (size_t ix = keep; ix < points.size(); ix++) {
+			children[GetOctant(points[ix].Position, center)].push_back(points[ix]);
+		}
+		// Release our points before recursing, so we only hold one copy of the data at each level
+		std::vector<BuildPoint>().swap(points);
+
+		for (int octant = 0; octant < 8; octant++) {
+			if (!children[octant].empty()) {
+				int32_t child = GetOrCreateChild(nodes, index, octant);
+				BuildSubtree(nodes, child, children[octant], writer, settings);
+			}
+		}
+	}
+
+	// Builds the part of the octree below the given node from points that may not fit in memory. If they fit,
+	// they are read in and handed to BuildSubtree. Otherwise they are streamed once: an even sample is picked
+	// for the node itself (selection sampling, since we know how many points there are), and the rest are split
+	// into a temporary file per child, which are then built the same way. Only the sample and a write buffer
+	// per child are held in memory, however the points are spread out
+	bool BuildSubtreeOutOfCore(std::vector<BuildNode>& nodes, int32_t index, const PointSource& source, uint64_t count,
+							   const std::string& tempPath, NodeWriter& writer, std::mt19937& random,
+							   const TTK::PointCloudBuildSettings& settings) {
+		if (count <= settings.MaxPointsInMemory) {
+			std::vector<BuildPoint> points;
+			points.reserve(static_cast<size_t>(count));
+			if (!source([&](const BuildPoint* chunk, size_t chunkSize) { points.insert(points.end(), chunk, chunk + chunkSize); })) {
+				return false;
+			}
+			std::shuffle(points.begin(), points.end(), random);
+			BuildSubtree(nodes, index, points, writer, settings);
+			return true;
+		}
+
+		const bool canSplit = nodes[index].Level < settings.MaxDepth;
+		const glm::vec3 center = (nodes[index].Min + nodes[index].Max) * 0.5f;
+		const size_t keep = static_cast<size_t>(std::min<uint64_t>(count, settings.MaxPointsPerNode));
+		const size_t flushSize = std::max<size_t>(4096, static_cast<size_t>(settings.MaxPointsInMemory / 8));
+
+		auto childPath = [&](int octant) { return tempPath + ".node" + std::to_string(index) + "_" + std::to_string(octant); };
+		std::vector<BuildPoint> sample;
+		sample.reserve(keep);
+		std::vector<BuildPoint> buffers[8];
+		uint64_t childCounts[8] = { 0 };
+		auto flush = [&](int octant) {
+			std::ofstream file(childPath(octant), std::ios::binary | std::ios::app);
+			file.write(reinterpret_cast<const char*>(buffers[octant].data()), sizeof(BuildPoint) * buffers[octant].size());
+			buffers[octant].clear();
+		};
+		for (int octant = 0; octant < 8; octant++) {
+			std::remove(childPath(octant).c_str());
+		}
+
+		uint64_t seen = 0;
+		bool success = source([&](const BuildPoint* points, size_t pointCount) {
+			for (size_t ix = 0; ix < pointCount; ix++, seen++) {
+				// Each point is kept with a probability of (samples still needed) / (points still to come)
+				if (seen < count && sample.size() < keep &&
+					std::uniform_int_distribution<uint64_t>(0, count - seen - 1)(random) < keep - sample.size()) {
+					sample.push_back(points[ix]);
+				} else if (canSplit) {
+					int octant = GetOctant(points[ix].Position, center);
+					buffers[octant].push_back(points[ix]);
+					childCounts[octant]++;
+					if (buffers[octant].size() >= flushSize) {
+						flush(octant);
+					}
+				} else {
+					writer.Dropped++;
+				}
+			}
+		});
+		for (int octant = 0; octant < 8; octant++) {
+			if (!buffers[octant].empty()) {
+				flush(octant);
+			}
+			std::vector<BuildPoint>().swap(buffers[octant]);
+		}
+
+		if (success) {
+			writer.Write(nodes[index], sample.data(), sample.size());
+		}
+		std::vector<BuildPoint>().swap(sample);
+
+		for (int octant = 0; octant < 8; octant++) {
+			if (success && childCounts[octant] > 0) {
+				int32_t child = GetOrCreateChild(nodes, index, octant);
+				std::string path = childPath(octant);
+				PointSource childSource = [path](const PointSink& sink) { return ReadTempPoints(path, sink); };
+				success = BuildSubtreeOutOfCore(nodes, child, childSource, childCounts[octant], tempPath, writer, random, settings);
+			}
+			std::remove(childPath(octant).c_str());
+		}
+		return success;
+	}
+}
+
+bool TTK::PointCloud::Build(const std::string& inputPath, const std::string& outputPath, const PointCloudBuildSettings& settings) {
+	LOG_ASSERT(settings.MaxPointsPerNode > 0, "Nodes must be able to hold at least one point");
+
+	// First pass, find the bounds of the cloud
+	glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+	uint64_t totalPoints = 0;
+	bool success = ReadPoints(inputPath, [&](const BuildPoint* points, size_t count) {
+		for (size_t ix = 0; ix < count; ix++) {
+			min = glm::min(min, points[ix].Position);
+			max = glm::max(max, points[ix].Position);
+		}
+		totalPoints += count;
+	});
+	if (!success) {
+		return false;
+	}
+	if (totalPoints == 0) {
+		LOG_ERROR("Point cloud \"{}\" is empty", inputPath);
+		return false;
+	}
+
+	// Our octree uses cubic nodes, so expand the bounds to a cube
+	glm::vec3 center = (min + max) * 0.5f;
+	float halfSize = glm::max(glm::max(max.x - min.x, max.y - min.y), max.z - min.z) * 0.5f;
+	halfSize = glm::max(halfSize * 1.0001f, 1e-4f);
+	glm::vec3 cubeMin = center - glm::vec3(halfSize);
+	glm::vec3 cubeMax = center + glm::vec3(halfSize);
+
+	// Second pass, build the tree from the root down. Nodes with more points below them than we can hold in
+	// memory are split through temporary files until their children fit
+	std::vector<BuildNode> nodes;
+	BuildNode root;
+	root.Min = cubeMin;
+	root.Max = cubeMax;
+	root.Level = 0;
+	std::fill(root.Children, root.Children + 8, -1);
+	nodes.push_back(root);
+
+	std::string pointsPath = std::filesystem::path(outputPath).replace_extension(".points").string();
+	NodeWriter writer;
+	writer.Stream.open(pointsPath, std::ios::binary);
+	if (!writer.Stream) {
+		LOG_ERROR("Failed to open \"{}\" for writing", pointsPath);
+		return false;
+	}
+
+	std::mt19937 random(1234);
+	PointSource input = [&](const PointSink& sink) { return ReadPoints(inputPath, sink); };
+	success = BuildSubtreeOutOfCore(nodes, 0, input, totalPoints, outputPath, writer, random, settings);
+	writer.Stream.close();
+	if (!success) {
+		return false;
+	}
+
+	if (writer.Dropped > 0) {
+		LOG_WARN("Dropped {} points from nodes at the maximum depth", writer.Dropped);
+	}
+
+	// Finally write out the node hierarchy
+	std::ofstream index(outputPath, std::ios::binary);
+	if (!index) {
+		LOG_ERROR("Failed to open \"{}\" for writing", outputPath);
+		return false;
+	}
+	FileHeader header;
+	memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+	header.Version = FileVersion;
+	memcpy(header.Min, &min.x, sizeof(header.Min));
+	memcpy(header.Max, &max.x, sizeof(header.Max));
+	header.TotalPoints = totalPoints - writer.Dropped;
+	header.NodeCount = static_cast<uint32_t>(nodes.size());
+	header.MaxPointsPerNode = settings.MaxPointsPerNode;
+	index.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+	for (const BuildNode& node : nodes) {
+		FileNode record;
+		memcpy(record.Min, &node.Min.x, sizeof(record.Min));
+		memcpy(record.Max, &node.Max.x, sizeof(record.Max));
+		record.FileOffset = node.FileOffset;
+		record.PointCount = node.PointCount;
+		record.Level = node.Level;
+		memcpy(record.Children, node.Children, sizeof(record.Children));
+		index.write(reinterpret_cast<const char*>(&record), sizeof(FileNode));
+	}
+
+	LOG_INFO("Built point cloud octree \"{}\" with {} points in {} nodes", outputPath, header.TotalPoints, nodes.size());
+	return true;
+}
+
+TTK::PointCloud::PointCloud(const std::string& path, const PointCloudRenderSettings& settings) :
+	m_Settings(settings),
+	m_TotalPoints(0),
+	m_SlotCapacity(0),
+	m_PointBuffer(0),
+	m_PointMapping(nullptr),
+	m_SlotCount(0),
+	m_HasEvictionCandidates(false),
+	m_Frame(RingFrames),
+	m_VAO(0),
+	m_Shader(0),
+	m_DrawnPoints(0),
+	m_ResidentNodes(0),
+	m_PendingLoads(0),
+	m_IsRunning(true)
+{
+	static_assert(sizeof(Point) == sizeof(BuildPoint), "Point layout must match the file layout");
+
+	std::ifstream file(path, std::ios::binary);
+	FileHeader header;
+	if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) ||
+		memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 || header.Version != FileVersion) {
+		LOG_ERROR("\"{}\" is not a valid point cloud octree", path);
+		throw std::runtime_error("Failed to open point cloud!");
+	}
+
+	m_PointsPath = std::filesystem::path(path).replace_extension(".points").string();
+	m_BoundsMin = glm::vec3(header.Min[0], header.Min[1], header.Min[2]);
+	m_BoundsMax = glm::vec3(header.Max[0], header.Max[1], header.Max[2]);
+	m_TotalPoints = header.TotalPoints;
+	m_SlotCapacity = header.MaxPointsPerNode;
+
+	uint32_t nodesWithPoints = 0;
+	m_Nodes.resize(header.NodeCount);
+	for (Node& node : m_Nodes) {
+		FileNode record;
+		if (!file.read(reinterpret_cast<char*>(&record), sizeof(FileNode))) {
+			LOG_ERROR("Unexpected end of file in \"{}\"", path);
+			throw std::runtime_error("Failed to open point cloud!");
+		}
+		node.Min = glm::vec3(record.Min[0], record.Min[1], record.Min[2]);
+		node.Max = glm::vec3(record.Max[0], record.Max[1], record.Max[2]);
+		node.FileOffset = record.FileOffset;
+		node.PointCount = record.PointCount;
+		node.Level = record.Level;
+		memcpy(node.Children, record.Children, sizeof(node.Children));
+		if (node.PointCount > 0) {
+			nodesWithPoints++;
+		}
+	}
+
+	// Carve our memory budget into one slot per node, we never need more slots than there are nodes
+	size_t slotBytes = sizeof(Point) * m_SlotCapacity;
+	m_SlotCount = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(m_Settings.MemoryBudget / slotBytes, nodesWithPoints)));
+	m_FreeSlots.resize(m_SlotCount);
+	for (uint32_t ix = 0; ix < m_SlotCount; ix++) {
+		m_FreeSlots[ix] = static_cast<int32_t>(m_SlotCount - 1 - ix);
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &m_PointBuffer);
+	glNamedBufferStorage(m_PointBuffer, slotBytes * m_SlotCount, nullptr, flags);
+	m_PointMapping = static_cast<Point*>(glMapNamedBufferRange(m_PointBuffer, 0, slotBytes * m_SlotCount, flags));
+
+	glCreateVertexArrays(1, &m_VAO);
+	glVertexArrayVertexBuffer(m_VAO, 0, m_PointBuffer, 0, sizeof(Point));
+	glVertexArrayAttribFormat(m_VAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Point, Position));
+	glVertexArrayAttribFormat(m_VAO, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Point, Color));
+	glVertexArrayAttribBinding(m_VAO, 0, 0);
+	glVertexArrayAttribBinding(m_VAO, 1, 0);
+	glEnableVertexArrayAttrib(m_VAO, 0);
+	glEnableVertexArrayAttrib(m_VAO, 1);
+
+	for (int ix = 0; ix < RingFrames; ix++) {
+		m_FrameFences[ix] = nullptr;
+	}
+
+	__CompileShader();
+
+	m_Loader = std::thread(&PointCloud::__LoaderThread, this);
+
+	LOG_INFO("Opened point cloud \"{}\" with {} points, {} nodes and {} slots", path, m_TotalPoints, m_Nodes.size(), m_SlotCount);
+}
+
+TTK::PointCloud::~PointCloud() {
+	{
+		std::lock_guard<std::mutex> lock(m_LoadMutex);
+		m_IsRunning = false;
+	}
+	m_LoadSignal.notify_all();
+	m_Loader.join();
+
+	for (int ix = 0; ix < RingFrames; ix++) {
+		if (m_FrameFences[ix] != nullptr) {
+			glDeleteSync(m_FrameFences[ix]);
+		}
+	}
+	glUnmapNamedBuffer(m_PointBuffer);
+	glDeleteBuffers(1, &m_PointBuffer);
+	glDeleteVertexArrays(1, &m_VAO);
+	glDeleteProgram(m_Shader);
+}
+
+void TTK::PointCloud::Update(const glm::mat4& view, const glm::mat4& projection, int viewportHeight) {
+	m_Frame++;
+
+	// Wait until the GPU is done with the frame that used this fence, after this, any slot that
+	// was last drawn RingFrames or more frames ago is safe to overwrite
+	GLsync& fence = m_FrameFences[m_Frame % RingFrames];
+	if (fence != nullptr) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	__ApplyCompletedLoads();
+
+	// Extract our frustum planes from the view projection matrix
+	glm::mat4 viewProj = projection * view;
+	glm::vec4 planes[6];
+	for (int ix = 0; ix < 3; ix++) {
+		glm::vec4 row(viewProj[0][ix], viewProj[1][ix], viewProj[2][ix], viewProj[3][ix]);
+		glm::vec4 w(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+		planes[ix * 2 + 0] = w + row;
+		planes[ix * 2 + 1] = w - row;
+	}
+	glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+	float pixelsPerUnit = static_cast<float>(viewportHeight) * 0.5f * projection[1][1];
+
+	// Estimates how far apart the points in a node are on screen, in pixels
+	auto screenError = [&](const Node& node) {
+		glm::vec3 closest = glm::clamp(cameraPos, node.Min, node.Max);
+		float distance = glm::max(glm::length(closest - cameraPos), 1e-4f);
+		float spacing = (node.Max.x - node.Min.x) / glm::sqrt(static_cast<float>(m_SlotCapacity));
+		return spacing * pixelsPerUnit / distance;
+	};
+	auto isVisible = [&](const Node& node) {
+		for (const glm::vec4& plane : planes) {
+			glm::vec3 positive(plane.x >= 0.0f ? node.Max.x : node.Min.x,
+							   plane.y >= 0.0f ? node.Max.y : node.Min.y,
+							   plane.z >= 0.0f ? node.Max.z : node.Min.z);
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Walk the tree, largest screen error first. We only descend into nodes that are resident, so
+	// that the cloud always fills in from coarse to fine
+	typedef std::pair<float, int32_t> QueueEntry;
+	std::priority_queue<QueueEntry> queue;
+	m_Selected.clear();
+	uint32_t selectedPoints = 0;
+	if (!m_Nodes.empty() && isVisible(m_Nodes[0])) {
+		queue.push({ screenError(m_Nodes[0]), 0 });
+	}
+	while (!queue.empty()) {
+		auto [error, index] = queue.top();
+		queue.pop();
+		Node& node = m_Nodes[index];
+		if (selectedPoints + node.PointCount > m_Settings.PointBudget) {
+			break;
+		}
+		selectedPoints += node.PointCount;
+		node.LastSelectedFrame = m_Frame;
+		m_Selected.push_back(index);
+
+		bool canRefine = node.State == NodeState::Resident || node.PointCount == 0;
+		if (canRefine && error > m_Settings.MaxScreenError) {
+			for (int32_t child : node.Children) {
+				if (child >= 0 && isVisible(m_Nodes[child])) {
+					queue.push({ screenError(m_Nodes[child]), child });
+				}
+			}
+		}
+	}
+
+	// Drop any queued loads for nodes that are no longer needed, so they don't hold up the ones that are
+	{
+		std::lock_guard<std::mutex> lock(m_LoadMutex);
+		auto it = std::remove_if(m_LoadRequests.begin(), m_LoadRequests.end(), [&](const LoadRequest& request) {
+			Node& node = m_Nodes[request.NodeIndex];
+			if (node.LastSelectedFrame == m_Frame) {
+				return false;
+			}
+			node.State = NodeState::Unloaded;
+			node.Slot = -1;
+			m_FreeSlots.push_back(request.Slot);
+			m_PendingLoads--;
+			return true;
+		});
+		m_LoadRequests.erase(it, m_LoadRequests.end());
+	}
+
+	// Request loads for the missing nodes, in order of priority
+	m_HasEvictionCandidates = false;
+	std::vector<LoadRequest> requests;
+	for (int32_t index : m_Selected) {
+		if (m_PendingLoads + requests.size() >= m_Settings.MaxPendingLoads) {
+			break;
+		}
+		Node& node = m_Nodes[index];
+		if (node.State != NodeState::Unloaded || node.PointCount == 0) {
+			continue;
+		}
+		int32_t slot = __AllocateSlot();
+		if (slot < 0) {
+			break;
+		}
+		node.State = NodeState::Loading;
+		node.Slot = slot;
+		requests.push_back({ index, slot });
+	}
+	if (!requests.empty()) {
+		{
+			std::lock_guard<std::mutex> lock(m_LoadMutex);
+			m_LoadRequests.insert(m_LoadRequests.end(), requests.begin(), requests.end());
+		}
+		m_PendingLoads += static_cast<uint32_t>(requests.size());
+		m_LoadSignal.notify_one();
+	}
+
+	// Gather the draw ranges for the selected nodes that we can actually draw
+	m_DrawFirsts.clear();
+	m_DrawCounts.clear();
+	m_DrawnPoints = 0;
+	for (int32_t index : m_Selected) {
+		const Node& node = m_Nodes[index];
+		if (node.State == NodeState::Resident && node.PointCount > 0) {
+			m_DrawFirsts.push_back(static_cast<GLint>(node.Slot * m_SlotCapacity));
+			m_DrawCounts.push_back(static_cast<GLsizei>(node.PointCount));
+			m_DrawnPoints += node.PointCount;
+		}
+	}
+}
+
+void TTK::PointCloud::Draw(const glm::mat4& viewProjection) {
+	if (!m_DrawCounts.empty()) {
+		glEnable(GL_PROGRAM_POINT_SIZE);
+		glUseProgram(m_Shader);
+		glUniformMatrix4fv(0, 1, false, &viewProjection[0][0]);
+		glUniform1f(1, m_Settings.PointSize);
+		glBindVertexArray(m_VAO);
+		glMultiDrawArrays(GL_POINTS, m_DrawFirsts.data(), m_DrawCounts.data(), static_cast<GLsizei>(m_DrawCounts.size()));
+		glBindVertexArray(0);
+	}
+
+	GLsync& fence = m_FrameFences[m_Frame % RingFrames];
+	if (fence != nullptr) {
+		glDeleteSync(fence);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TTK::PointCloud::__LoaderThread() {
+	std::ifstream file(m_PointsPath, std::ios::binary);
+	if (!file) {
+		LOG_ERROR("Failed to open point data \"{}\"", m_PointsPath);
+	}
+
+	while (true) {
+		LoadRequest request;
+		{
+			std::unique_lock<std::mutex> lock(m_LoadMutex);
+			m_LoadSignal.wait(lock, [this] { return !m_IsRunning || !m_LoadRequests.empty(); });
+			if (!m_IsRunning) {
+				return;
+			}
+			request = m_LoadRequests.front();
+			m_LoadRequests.pop_front();
+		}
+
+		// The offset and count of a node never change after opening, so we can read them without the lock.
+		// The slot belongs to this request until we hand it back, so we can write straight into the mapping
+		const Node& node = m_Nodes[request.NodeIndex];
+		Point* dest = m_PointMapping + static_cast<size_t>(request.Slot) * m_SlotCapacity;
+		if (file) {
+			file.seekg(static_cast<std::streamoff>(node.FileOffset));
+			file.read(reinterpret_cast<char*>(dest), sizeof(Point) * node.PointCount);
+			if (!file) {
+				LOG_ERROR("Failed to read point cloud node {}", request.NodeIndex);
+				file.clear();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_LoadMutex);
+			m_CompletedLoads.push_back(request.NodeIndex);
+		}
+	}
+}
+
+void TTK::PointCloud::__ApplyCompletedLoads() {
+	std::vector<int32_t> completed;
+	{
+		std::lock_guard<std::mutex> lock(m_LoadMutex);
+		completed.swap(m_CompletedLoads);
+	}
+	for (int32_t index : completed) {
+		m_Nodes[index].State = NodeState::Resident;
+		m_ResidentNodes++;
+		m_PendingLoads--;
+	}
+}
+
+int32_t TTK::PointCloud::__AllocateSlot() {
+	if (!m_FreeSlots.empty()) {
+		int32_t slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+		return slot;
+	}
+
+	// Find the resident nodes that weren't selected this frame, and that the GPU is done reading from
+	if (!m_HasEvictionCandidates) {
+		m_EvictionCandidates.clear();
+		for (size_t ix = 0; ix < m_Nodes.size(); ix++) {
+			const Node& node = m_Nodes[ix];
+			if (node.State == NodeState::Resident && node.LastSelectedFrame + RingFrames <= m_Frame) {
+				m_EvictionCandidates.push_back(static_cast<int32_t>(ix));
+			}
+		}
+		std::sort(m_EvictionCandidates.begin(), m_EvictionCandidates.end(), [this](int32_t a, int32_t b) {
+			return m_Nodes[a].LastSelectedFrame > m_Nodes[b].LastSelectedFrame;
+		});
+		m_HasEvictionCandidates = true;
+	}
+	if (m_EvictionCandidates.empty()) {
+		return -1;
+	}
+
+	Node& victim = m_Nodes[m_EvictionCandidates.back()];
+	m_EvictionCandidates.pop_back();
+	int32_t slot = victim.Slot;
+	victim.State = NodeState::Unloaded;
+	victim.Slot = -1;
+	m_ResidentNodes--;
+	return slot;
+}
+
+void TTK::PointCloud::__CompileShader() {
+	const char* vsSource = R"LIT(#version 430
+            layout (location = 0) uniform mat4 xTransform;
+            layout (location = 1) uniform float xPointSize;
+
+            layout (location = 0) in vec3 vertexPosition;
+            layout (location = 1) in vec4 vertexColor;
+
+            layout (location = 0) out vec4 fragmentColor;
+            void main() {
+                gl_Position = xTransform * vec4(vertexPosition, 1);
+                gl_PointSize = xPointSize;
+                fragmentColor = vertexColor;
+            })LIT";
+
+	const char* fsSource = R"LIT(#version 430
+            layout (location = 0) in vec4 fragColor;
+            out vec4 frag_color;
+            void main() {
+                frag_color = fragColor;
+            })LIT";
+
+	const std::pair<GLenum, const char*> parts[] = {
+		{ GL_VERTEX_SHADER, vsSource },
+		{ GL_FRAGMENT_SHADER, fsSource }
+	};
+
+	m_Shader = glCreateProgram();
+	std::vector<GLuint> shaders;
+	for (auto& [type, source] : parts) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		// Check each stage as we go, a broken stage would otherwise only show up as a vague link error
+		GLint status = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			if (length > 0) {
+				char* log = new char[length];
+				glGetShaderInfoLog(shader, length, &length, log);
+				LOG_ERROR("Point cloud shader part failed to compile:\n{}", log);
+				delete[] log;
+			}
+			else {
+				LOG_ERROR("Point cloud shader part failed to compile for an unknown reason!");
+			}
+			glDeleteShader(shader);
+			for (GLuint part : shaders) {
+				glDeleteShader(part);
+			}
+			glDeleteProgram(m_Shader);
+			m_Shader = 0;
+			throw std::runtime_error("Failed to compile point cloud shader!");
+		}
+
+		glAttachShader(m_Shader, shader);
+		shaders.push_back(shader);
+	}
+
+	glLinkProgram(m_Shader);
+
+	GLint success = 0;
+	glGetProgramiv(m_Shader, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE) {
+		GLint length = 0;
+		glGetProgramiv(m_Shader, GL_INFO_LOG_LENGTH, &length);
+		if (length > 0) {
+			char* log = new char[length];
+			glGetProgramInfoLog(m_Shader, length, &length, log);
+			LOG_ERROR("Point cloud shader failed to link:\n{}", log);
+			delete[] log;
+		}
+		else {
+			LOG_ERROR("Point cloud shader failed to link for an unknown reason!");
+		}
+		for (GLuint shader : shaders) {
+			glDeleteShader(shader);
+		}
+		glDeleteProgram(m_Shader);
+		m_Shader = 0;
+		throw std::runtime_error("Failed to link point cloud shader program!");
+	}
+
+	// Remove shader parts to save space
+	for (GLuint shader : shaders) {
+		glDetachShader(m_Shader, shader);
+		glDeleteShader(shader);
+	}
+}
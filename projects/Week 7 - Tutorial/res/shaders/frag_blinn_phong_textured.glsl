@@ -1,10 +1,11 @@
-#version 410
+#version 460
 
 
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+layout(location = 4) flat in uint inMaterialIndex;
 
 // We output a single color to the color buffer
 layout(location = 0) out vec4 frag_color;
@@ -42,19 +43,27 @@ uniform vec3  u_CamPos;
 
 // Represents a collection of attributes that would define a material
 // For instance, you can think of this like material settings in 
-// Unity
+// Unity. Must match MaterialParams in Graphics/MaterialTable.h
 struct Material {
-	sampler2D Diffuse;
-	float     Shininess;
+	float Shininess;
+	float _Padding0;
+	float _Padding1;
+	float _Padding2;
 };
-// Create a uniform for the material
-uniform Material u_Material;
+// All of the materials in the scene, indexed by the base instance of the draw
+layout(std430, binding = 0) readonly buffer MaterialTable {
+	Material u_Materials[];
+};
+
+// The diffuse texture for the current material, always bound to slot 0
+layout(binding = 0) uniform sampler2D u_Diffuse;
 
 // Calculates the contribution the given light has for
 // the current fragment
 // @param normal The fragment's normal (normalized)
 // @param Light  The light to caluclate the contribution for
-vec3 CalcLightContribution(vec3 normal, Light light) {
+// @param shininess The specular power of the material
+vec3 CalcLightContribution(vec3 normal, Light light, float shininess) {
 	// Get the direction to the light in world space
 	vec3 toLight = light.Position - inWorldPos;
 	// Get distance between fragment and light
@@ -68,7 +77,7 @@ vec3 CalcLightContribution(vec3 normal, Light light) {
 	vec3 halfDir     = normalize(toLight + viewDir);
 
 	// Calculate our specular power
-	float specPower  = pow(max(dot(normal, halfDir), 0.0), u_Material.Shininess);
+	float specPower  = pow(max(dot(normal, halfDir), 0.0), shininess);
 	// Calculate specular color
 	vec3 specularOut = specPower * light.Color;
 
@@ -92,14 +101,17 @@ void main() {
 	// Normalize our input normal
 	vec3 normal = normalize(inNormal);
 
+	// Look up our material parameters
+	Material material = u_Materials[inMaterialIndex];
+
 	// Iterate over all lights
 	for(int ix = 0; ix < u_NumLights && ix < MAX_LIGHTS; ix++) {
 		// Additive lighting model
-		lightAccumulation += CalcLightContribution(normal, u_Lights[ix]);
+		lightAccumulation += CalcLightContribution(normal, u_Lights[ix], material.Shininess);
 	}
 
 	// Get the albedo from the diffuse / albedo map
-	vec4 textureColor = texture(u_Material.Diffuse, inUV);
+	vec4 textureColor = texture(u_Diffuse, inUV);
 
 	// combine for the final result
 	vec3 result = (u_AmbientCol + lightAccumulation)  * inColor * textureColor.rgb;
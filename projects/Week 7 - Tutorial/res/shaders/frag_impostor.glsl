@@ -0,0 +1,109 @@
+#version 460
+
+layout(location = 0) in vec3 inWorldPos;
+layout(location = 1) in vec4 inFrameUV01;
+layout(location = 2) in vec4 inFrameUV23;
+layout(location = 3) flat in ivec2 inBaseFrame;
+layout(location = 4) flat in vec4  inFrameWeights;
+layout(location = 5) flat in vec4  inToCameraRadius;
+layout(location = 6) flat in mat3  inNormalMatrix;
+
+layout(location = 0) out vec4 frag_color;
+
+// The baked atlases, see ImpostorBaker
+layout(binding = 0) uniform sampler2D u_Albedo;
+layout(binding = 1) uniform sampler2D u_NormalDepth;
+uniform int u_FramesPerAxis;
+
+uniform mat4 u_ViewProjection;
+uniform vec3 u_CamPos;
+
+// Global light properties
+uniform vec3  u_AmbientCol;
+
+// Represents a single light source
+struct Light {
+	vec3  Position;
+	vec3  Color;
+	float Attenuation;
+};
+
+#define MAX_LIGHTS 8
+uniform Light u_Lights[MAX_LIGHTS];
+uniform int u_NumLights;
+
+// Must match MaterialParams in Graphics/MaterialTable.h
+struct Material {
+	float Shininess;
+	float _Padding0;
+	float _Padding1;
+	float _Padding2;
+};
+layout(std430, binding = 0) readonly buffer MaterialTable {
+	Material u_Materials[];
+};
+// Impostors are instanced, so the material comes from a uniform instead of the base instance
+uniform int u_MaterialIndex;
+
+// Samples a single frame of the atlas, texels outside of the frame have no coverage
+void SampleFrame(ivec2 frame, vec2 uv, float weight, inout vec4 albedo, inout vec4 normalDepth) {
+	if (any(lessThan(uv, vec2(0))) || any(greaterThan(uv, vec2(1)))) {
+		return;
+	}
+	vec2 atlasUV = (vec2(frame) + uv) / float(u_FramesPerAxis);
+	vec4 color = texture(u_Albedo, atlasUV);
+	// Weight by coverage so we don't blend in the empty space around the object
+	float w = weight * color.a;
+	albedo      += vec4(color.rgb * w, w);
+	normalDepth += texture(u_NormalDepth, atlasUV) * w;
+}
+
+// Same lighting model as frag_blinn_phong_textured.glsl
+vec3 CalcLightContribution(vec3 worldPos, vec3 normal, Light light, float shininess) {
+	vec3 toLight = light.Position - worldPos;
+	float dist = length(toLight);
+	toLight = normalize(toLight);
+
+	vec3 viewDir = normalize(u_CamPos - worldPos);
+	vec3 halfDir = normalize(toLight + viewDir);
+
+	float specPower  = pow(max(dot(normal, halfDir), 0.0), shininess);
+	vec3 specularOut = specPower * light.Color;
+
+	float diffuseFactor = max(dot(normal, toLight), 0);
+	vec3  diffuseOut = diffuseFactor * light.Color;
+
+	float attenuation = 1.0 / (1.0 + light.Attenuation * pow(dist, 2));
+	return (diffuseOut + specularOut) * attenuation;
+}
+
+void main() {
+	vec4 albedo = vec4(0);
+	vec4 normalDepth = vec4(0);
+	SampleFrame(inBaseFrame,                inFrameUV01.xy, inFrameWeights.x, albedo, normalDepth);
+	SampleFrame(inBaseFrame + ivec2(1, 0), inFrameUV01.zw, inFrameWeights.y, albedo, normalDepth);
+	SampleFrame(inBaseFrame + ivec2(0, 1), inFrameUV23.xy, inFrameWeights.z, albedo, normalDepth);
+	SampleFrame(inBaseFrame + ivec2(1, 1), inFrameUV23.zw, inFrameWeights.w, albedo, normalDepth);
+
+	// Alpha test against the blended coverage
+	if (albedo.a < 0.5) {
+		discard;
+	}
+	albedo.rgb /= albedo.a;
+	normalDepth /= albedo.a;
+
+	// Depth 0 is the front of the bounding sphere and 1 is the back, push the fragment off the billboard
+	vec3 worldPos = inWorldPos + inToCameraRadius.xyz * inToCameraRadius.w * (1.0 - 2.0 * normalDepth.a);
+	vec4 clipPos = u_ViewProjection * vec4(worldPos, 1.0);
+	gl_FragDepth = (clipPos.z / clipPos.w) * 0.5 + 0.5;
+
+	vec3 normal = normalize(inNormalMatrix * (normalDepth.rgb * 2.0 - 1.0));
+	float shininess = u_Materials[u_MaterialIndex].Shininess;
+
+	vec3 lightAccumulation = vec3(0);
+	for(int ix = 0; ix < u_NumLights && ix < MAX_LIGHTS; ix++) {
+		lightAccumulation += CalcLightContribution(worldPos, normal, u_Lights[ix], shininess);
+	}
+
+	frag_color = vec4((u_AmbientCol + lightAccumulation) * albedo.rgb, 1.0);
+}
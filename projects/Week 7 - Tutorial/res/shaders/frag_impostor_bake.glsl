@@ -0,0 +1,26 @@
+#version 460
+
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+// Albedo in rgb, coverage in a
+layout(location = 0) out vec4 outAlbedo;
+// Object space normal in rgb, depth in a
+layout(location = 1) out vec4 outNormalDepth;
+
+layout(binding = 0) uniform sampler2D u_Diffuse;
+uniform int u_UseTexture;
+
+void main() {
+	vec4 textureColor = u_UseTexture != 0 ? texture(u_Diffuse, inUV) : vec4(1.0);
+
+	// Cut out transparent texels, so they don't end up covering the impostor
+	if (textureColor.a < 0.5) {
+		discard;
+	}
+
+	outAlbedo = vec4(inColor * textureColor.rgb, 1.0);
+	// Our projection is orthographic, so depth is linear across the bounding sphere
+	outNormalDepth = vec4(normalize(inNormal) * 0.5 + 0.5, gl_FragCoord.z);
+}
@@ -0,0 +1,44 @@
+#version 460
+
+layout(location = 0) in vec3 inWorldPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec2 inLightmapUV;
+
+// We output a single color to the color buffer
+layout(location = 0) out vec4 frag_color;
+
+////////////////////////////////////////////////////////////////
+///////////// Application Level Uniforms ///////////////////////
+////////////////////////////////////////////////////////////////
+
+// Global light properties
+uniform vec3  u_AmbientCol;
+
+// The largest value stored in the lightmap, must match LightmapBaker::RGBM_RANGE
+#define RGBM_RANGE 8.0
+
+////////////////////////////////////////////////////////////////
+/////////////// Instance Level Uniforms ////////////////////////
+////////////////////////////////////////////////////////////////
+
+// The diffuse texture for the current material, always bound to slot 0
+layout(binding = 0) uniform sampler2D u_Diffuse;
+// The baked lighting for all static objects in the scene, RGBM encoded
+layout(binding = 1) uniform sampler2D u_Lightmap;
+
+// Static objects have their diffuse lighting baked, so we don't need to loop over our lights here
+void main() {
+	// Decode the light reaching this fragment from the lightmap
+	vec4 lightmap = texture(u_Lightmap, inLightmapUV);
+	vec3 lightAccumulation = lightmap.rgb * lightmap.a * RGBM_RANGE;
+
+	// Get the albedo from the diffuse / albedo map
+	vec4 textureColor = texture(u_Diffuse, inUV);
+
+	// combine for the final result
+	vec3 result = (u_AmbientCol + lightAccumulation) * inColor * textureColor.rgb;
+
+	frag_color = vec4(result, textureColor.a);
+}
@@ -0,0 +1,105 @@
+#version 460
+
+// The corner of the billboard, in the [-1, 1] range
+layout(location = 0) in vec2 inCorner;
+// The transform of the object we're standing in for (takes up locations 1-4)
+layout(location = 1) in mat4 inModel;
+
+layout(location = 0) out vec3 outWorldPos;
+// The UVs within each of the 4 frames we're blending between
+layout(location = 1) out vec4 outFrameUV01;
+layout(location = 2) out vec4 outFrameUV23;
+// The bottom left frame of the 4 we're blending, and the weights for each frame
+layout(location = 3) flat out ivec2 outBaseFrame;
+layout(location = 4) flat out vec4  outFrameWeights;
+// The direction to the camera, and the size of the object in world space (for reconstructing depth)
+layout(location = 5) flat out vec4  outToCameraRadius;
+// Rotation for taking our baked object space normals into world space
+layout(location = 6) flat out mat3  outNormalMatrix;
+
+uniform mat4  u_ViewProjection;
+uniform vec3  u_CamPos;
+
+uniform int   u_FramesPerAxis;
+uniform int   u_Hemisphere;
+uniform vec3  u_ImpostorCenter;
+uniform float u_ImpostorRadius;
+
+// Like sign, but never returns zero (so we don't collapse points on the axes)
+vec2 SignNotZero(vec2 v) {
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Must match Impostor::OctahedralEncode
+vec2 OctahedralEncode(vec3 dir) {
+	if (u_Hemisphere != 0) {
+		dir.z = max(dir.z, 0.0);
+	}
+	dir /= max(abs(dir.x) + abs(dir.y) + abs(dir.z), 0.00001);
+	if (u_Hemisphere != 0) {
+		return vec2(dir.x + dir.y, dir.x - dir.y);
+	}
+	return dir.z < 0.0 ? (1.0 - abs(dir.yx)) * SignNotZero(dir.xy) : dir.xy;
+}
+
+// Must match Impostor::OctahedralDecode
+vec3 OctahedralDecode(vec2 coord) {
+	vec3 result;
+	if (u_Hemisphere != 0) {
+		vec2 rotated = vec2(coord.x + coord.y, coord.x - coord.y) * 0.5;
+		result = vec3(rotated, 1.0 - abs(rotated.x) - abs(rotated.y));
+	} else {
+		result = vec3(coord, 1.0 - abs(coord.x) - abs(coord.y));
+		if (result.z < 0.0) {
+			result.xy = (1.0 - abs(result.yx)) * SignNotZero(result.xy);
+		}
+	}
+	return normalize(result);
+}
+
+// Projects an object space offset from the center into the UV space of the given frame
+// Must match the view used in ImpostorBaker::Bake
+vec2 FrameUV(ivec2 frame, vec3 offset) {
+	vec3 dir = OctahedralDecode(vec2(frame) / float(u_FramesPerAxis - 1) * 2.0 - 1.0);
+	vec3 up = abs(dir.z) > 0.999 ? vec3(0, 1, 0) : vec3(0, 0, 1);
+	vec3 right = normalize(cross(up, dir));
+	up = cross(dir, right);
+	return vec2(dot(offset, right), dot(offset, up)) / u_ImpostorRadius * 0.5 + 0.5;
+}
+
+void main() {
+	mat3 rotScale = mat3(inModel);
+	// We assume a uniform scale, which lets us use the transpose as our inverse rotation
+	float scale   = length(rotScale[0]);
+	vec3  center  = (inModel * vec4(u_ImpostorCenter, 1.0)).xyz;
+	float radius  = u_ImpostorRadius * scale;
+	vec3  toCam   = normalize(u_CamPos - center);
+
+	// Build our camera facing billboard
+	vec3 up    = abs(toCam.z) > 0.999 ? vec3(0, 1, 0) : vec3(0, 0, 1);
+	vec3 right = normalize(cross(up, toCam));
+	up = cross(toCam, right);
+	outWorldPos = center + (right * inCorner.x + up * inCorner.y) * radius;
+	gl_Position = u_ViewProjection * vec4(outWorldPos, 1.0);
+
+	// Find where the view direction lands in our grid of frames
+	vec3 objDir  = normalize(transpose(rotScale) * toCam);
+	vec2 grid    = (OctahedralEncode(objDir) * 0.5 + 0.5) * float(u_FramesPerAxis - 1);
+	vec2 base    = clamp(floor(grid), vec2(0), vec2(u_FramesPerAxis - 2));
+	vec2 weights = clamp(grid - base, vec2(0), vec2(1));
+	outBaseFrame = ivec2(base);
+	outFrameWeights = vec4(
+		(1.0 - weights.x) * (1.0 - weights.y),
+		weights.x         * (1.0 - weights.y),
+		(1.0 - weights.x) * weights.y,
+		weights.x         * weights.y
+	);
+
+	// Project our billboard corner into each of the frames we're blending between
+	vec3 offset = transpose(rotScale) * (outWorldPos - center) / (scale * scale);
+	outFrameUV01 = vec4(FrameUV(outBaseFrame, offset), FrameUV(outBaseFrame + ivec2(1, 0), offset));
+	outFrameUV23 = vec4(FrameUV(outBaseFrame + ivec2(0, 1), offset), FrameUV(outBaseFrame + ivec2(1, 1), offset));
+
+	outToCameraRadius = vec4(toCam, radius);
+	outNormalMatrix = rotScale / scale;
+}
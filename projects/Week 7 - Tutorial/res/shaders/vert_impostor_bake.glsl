@@ -0,0 +1,22 @@
+#version 460
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+layout(location = 1) out vec3 outColor;
+layout(location = 2) out vec3 outNormal;
+layout(location = 3) out vec2 outUV;
+
+// The view projection for the frame we're baking, the mesh is baked in object space
+uniform mat4 u_ViewProjection;
+
+void main() {
+	gl_Position = u_ViewProjection * vec4(inPosition, 1.0);
+
+	// Normals are stored in object space, so the impostor can be rotated at runtime
+	outNormal = inNormal;
+	outUV = inUV;
+	outColor = inColor;
+}
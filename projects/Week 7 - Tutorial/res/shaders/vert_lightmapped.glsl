@@ -0,0 +1,40 @@
+#version 460
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec2 inLightmapUV;
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec3 outColor;
+layout(location = 2) out vec3 outNormal;
+layout(location = 3) out vec2 outUV;
+layout(location = 4) out vec2 outLightmapUV;
+
+// Complete MVP
+uniform mat4 u_ModelViewProjection;
+// Just the model transform
+uniform mat4 u_Model;
+// Normal Matrix for transforming normals
+uniform mat3 u_NormalMatrix;
+
+void main() {
+
+	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+
+	// Pass vertex pos in world space to frag shader
+	outWorldPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+
+	// Normals
+	outNormal = u_NormalMatrix * inNormal;
+
+	// Pass our UV coords to the fragment shader
+	outUV = inUV;
+	outLightmapUV = inLightmapUV;
+
+	///////////
+	outColor = inColor;
+
+}
+
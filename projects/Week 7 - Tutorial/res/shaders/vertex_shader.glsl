@@ -1,4 +1,4 @@
-#version 410
+#version 460
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -9,6 +9,8 @@ layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
+// Index into the material table, selected per draw via the base instance
+layout(location = 4) flat out uint outMaterialIndex;
 
 // Complete MVP
 uniform mat4 u_ModelViewProjection;
@@ -34,5 +36,8 @@ void main() {
 	///////////
 	outColor = inColor;
 
+	// Forward the material index for this draw to the fragment shader
+	outMaterialIndex = uint(gl_BaseInstance);
+
 }
 
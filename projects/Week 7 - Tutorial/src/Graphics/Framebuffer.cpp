@@ -0,0 +1,80 @@
+#include "Framebuffer.h"
+#include "Logging.h"
+
+Framebuffer::Framebuffer(uint32_t width, uint32_t height) :
+	_handle(0),
+	_depthHandle(0),
+	_width(width),
+	_height(height),
+	_colorAttachments(std::vector<Texture2D::Sptr>())
+{
+	glCreateFramebuffers(1, &_handle);
+}
+
+Framebuffer::~Framebuffer() {
+	if (_depthHandle != 0) {
+		glDeleteRenderbuffers(1, &_depthHandle);
+		_depthHandle = 0;
+	}
+	if (_handle != 0) {
+		glDeleteFramebuffers(1, &_handle);
+		_handle = 0;
+	}
+}
+
+Texture2D::Sptr Framebuffer::AddColorAttachment(InternalFormat format) {
+	LOG_ASSERT(_colorAttachments.size() < 8, "Too many color attachments on framebuffer!");
+
+	Texture2DDescription desc;
+	desc.Width  = _width;
+	desc.Height = _height;
+	desc.Format = format;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap   = WrapMode::ClampToEdge;
+	Texture2D::Sptr result = std::make_shared<Texture2D>(desc);
+
+	// We want linear filtering for render targets, since they only have a single mip level
+	glTextureParameteri(result->GetHandle(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(result->GetHandle(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)_colorAttachments.size();
+	glNamedFramebufferTexture(_handle, attachment, result->GetHandle(), 0);
+	_colorAttachments.push_back(result);
+
+	// Make sure all our color attachments will be drawn into
+	std::vector<GLenum> drawBuffers;
+	for (size_t ix = 0; ix < _colorAttachments.size(); ix++) {
+		drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum)ix);
+	}
+	glNamedFramebufferDrawBuffers(_handle, (GLsizei)drawBuffers.size(), drawBuffers.data());
+
+	return result;
+}
+
+void Framebuffer::AddDepthAttachment() {
+	if (_depthHandle != 0) {
+		LOG_WARN("Framebuffer already has a depth attachment!");
+		return;
+	}
+	glCreateRenderbuffers(1, &_depthHandle);
+	glNamedRenderbufferStorage(_depthHandle, GL_DEPTH_COMPONENT24, _width, _height);
+	glNamedFramebufferRenderbuffer(_handle, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthHandle);
+}
+
+bool Framebuffer::Validate() const {
+	GLenum status = glCheckNamedFramebufferStatus(_handle, GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR("Framebuffer is incomplete! Status: 0x{:x}", status);
+		return false;
+	}
+	return true;
+}
+
+void Framebuffer::Bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, _handle);
+	glViewport(0, 0, _width, _height);
+}
+
+void Framebuffer::Unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
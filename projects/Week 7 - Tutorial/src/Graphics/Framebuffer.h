@@ -0,0 +1,86 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "Texture2D.h"
+
+/// <summary>
+/// The framebuffer wraps around an OpenGL FBO, and lets us render into textures instead of the window
+/// </summary>
+/// <see>https://www.khronos.org/opengl/wiki/Framebuffer_Object</see>
+class Framebuffer final
+{
+public:
+	typedef std::shared_ptr<Framebuffer> Sptr;
+
+	static inline Sptr Create(uint32_t width, uint32_t height) {
+		return std::make_shared<Framebuffer>(width, height);
+	}
+
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	Framebuffer(const Framebuffer& other) = delete;
+	Framebuffer(Framebuffer&& other) = delete;
+	Framebuffer& operator=(const Framebuffer& other) = delete;
+	Framebuffer& operator=(Framebuffer&& other) = delete;
+
+public:
+	/// <summary>
+	/// Creates a new empty framebuffer with the given dimensions. Attachments must be added before it can be rendered to
+	/// </summary>
+	/// <param name="width">The width of the framebuffer, in pixels</param>
+	/// <param name="height">The height of the framebuffer, in pixels</param>
+	Framebuffer(uint32_t width, uint32_t height);
+	~Framebuffer();
+
+	/// <summary>
+	/// Creates a new texture with the given format and attaches it as the next color attachment
+	/// </summary>
+	/// <param name="format">The internal format for the texture, must be a sized color format (ex: RGBA8)</param>
+	/// <returns>The texture that was attached</returns>
+	Texture2D::Sptr AddColorAttachment(InternalFormat format = InternalFormat::RGBA8);
+	/// <summary>
+	/// Creates a depth renderbuffer and attaches it to this framebuffer
+	/// </summary>
+	void AddDepthAttachment();
+
+	/// <summary>
+	/// Checks that this framebuffer is complete and ready to be rendered to
+	/// </summary>
+	/// <returns>True if the framebuffer can be rendered to, false if otherwise</returns>
+	bool Validate() const;
+
+	/// <summary>
+	/// Binds this framebuffer for drawing, and sets the viewport to cover the entire framebuffer
+	/// </summary>
+	void Bind();
+	/// <summary>
+	/// Binds the default framebuffer (the window) for drawing. Note that this will not restore the viewport
+	/// </summary>
+	static void Unbind();
+
+	/// <summary>
+	/// Gets the color texture attached at the given index
+	/// </summary>
+	const Texture2D::Sptr& GetColorAttachment(int index = 0) const { return _colorAttachments[index]; }
+	/// <summary>
+	/// Gets the width of this framebuffer in pixels
+	/// </summary>
+	uint32_t GetWidth() const { return _width; }
+	/// <summary>
+	/// Gets the height of this framebuffer in pixels
+	/// </summary>
+	uint32_t GetHeight() const { return _height; }
+	/// <summary>
+	/// Returns the underlying OpenGL handle that this class is wrapping around
+	/// </summary>
+	GLuint GetHandle() const { return _handle; }
+
+protected:
+	GLuint   _handle;
+	GLuint   _depthHandle;
+	uint32_t _width;
+	uint32_t _height;
+	std::vector<Texture2D::Sptr> _colorAttachments;
+};
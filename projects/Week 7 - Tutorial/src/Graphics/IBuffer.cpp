@@ -1,4 +1,5 @@
 #include "IBuffer.h"
+#include "Logging.h"
 
 IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 	_elementCount(0),
@@ -25,6 +26,23 @@ void IBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount
 	_elementSize = elementSize;
 }
 
+void IBuffer::LoadDataFromBuffer(GLuint source, size_t elementSize, size_t elementCount, size_t sourceOffset) {
+	// Allocate our storage, then let the GPU fill it in
+	glNamedBufferData(_handle, elementSize * elementCount, nullptr, (GLenum)_usage);
+	if (elementCount > 0) {
+		glCopyNamedBufferSubData(source, _handle, sourceOffset, 0, elementSize * elementCount);
+	}
+
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+}
+
+void IBuffer::UpdateData(const void* data, size_t elementSize, size_t elementCount, size_t elementOffset) {
+	LOG_ASSERT(elementSize == _elementSize, "Element size does not match the size of the data loaded into this buffer!");
+	LOG_ASSERT(elementOffset + elementCount <= _elementCount, "Update range is outside of the bounds of the buffer!");
+	glNamedBufferSubData(_handle, elementOffset * elementSize, elementCount * elementSize, data);
+}
+
 void IBuffer::Bind() {
 	glBindBuffer((GLenum)_type, _handle);
 }
@@ -7,7 +7,8 @@
 /// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferData.xhtml</see>
 enum class BufferType {
 	Vertex = GL_ARRAY_BUFFER,
-	Index = GL_ELEMENT_ARRAY_BUFFER
+	Index = GL_ELEMENT_ARRAY_BUFFER,
+	ShaderStorage = GL_SHADER_STORAGE_BUFFER
 };
 
 /// <summary>
@@ -73,6 +74,26 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Loads data into this buffer from another OpenGL buffer, using glCopyNamedBufferSubData. The data
+	/// never passes through the CPU, making this ideal for copying out of mapped staging buffers
+	/// </summary>
+	/// <param name="source">The OpenGL handle of the buffer to copy from</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to copy</param>
+	/// <param name="sourceOffset">The offset into the source buffer to start copying from, in bytes</param>
+	virtual void LoadDataFromBuffer(GLuint source, size_t elementSize, size_t elementCount, size_t sourceOffset = 0);
+
+	/// <summary>
+	/// Updates a range of elements that have already been loaded into this buffer, using the bindless
+	/// method glNamedBufferSubData. Unlike LoadData, this will not re-allocate the buffer's storage
+	/// </summary>
+	/// <param name="data">The data to copy into the buffer</param>
+	/// <param name="elementSize">The size of a single element, in bytes (must match the size used in LoadData)</param>
+	/// <param name="elementCount">The number of elements to update</param>
+	/// <param name="elementOffset">The index of the first element to update</param>
+	virtual void UpdateData(const void* data, size_t elementSize, size_t elementCount, size_t elementOffset = 0);
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
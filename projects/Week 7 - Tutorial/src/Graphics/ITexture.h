@@ -53,6 +53,11 @@ public:
 	/// <param name="color">The color to clear to</param>
 	void Clear(const glm::vec4& color);
 
+	/// <summary>
+	/// Returns the underlying OpenGL handle that this class is wrapping around
+	/// </summary>
+	GLuint GetHandle() const { return _handle; }
+
 protected:
 	ITexture(TextureType type);
 
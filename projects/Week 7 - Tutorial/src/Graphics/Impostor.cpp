@@ -0,0 +1,107 @@
+#include "Impostor.h"
+#include "Logging.h"
+
+Impostor::Impostor(const Texture2D::Sptr& albedo, const Texture2D::Sptr& normalDepth, uint32_t framesPerAxis, bool hemisphere, const glm::vec3& center, float radius) :
+	_albedo(albedo),
+	_normalDepth(normalDepth),
+	_framesPerAxis(framesPerAxis),
+	_hemisphere(hemisphere),
+	_center(center),
+	_radius(radius),
+	_materialIndex(0),
+	_instances(std::vector<glm::mat4>())
+{
+	LOG_ASSERT(framesPerAxis >= 2, "Impostors need at least 2 frames per axis to blend between!");
+
+	// Our quad is just the 4 corners of the billboard, the shader will orient it towards the camera
+	static const glm::vec2 corners[4] = {
+		glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, 1.0f)
+	};
+	VertexBuffer::Sptr quad = VertexBuffer::Create();
+	quad->LoadData(corners, 4);
+
+	_instanceBuffer = VertexBuffer::Create(BufferUsage::StreamDraw);
+
+	_vao = VertexArrayObject::Create();
+	_vao->AddVertexBuffer(quad, {
+		BufferAttribute(0, 2, AttributeType::Float, sizeof(glm::vec2), 0, AttribUsage::Position)
+	});
+	// A mat4 attribute takes up 4 slots, one per column
+	_vao->AddVertexBuffer(_instanceBuffer, {
+		BufferAttribute(1, 4, AttributeType::Float, sizeof(glm::mat4), sizeof(glm::vec4) * 0, AttribUsage::User0),
+		BufferAttribute(2, 4, AttributeType::Float, sizeof(glm::mat4), sizeof(glm::vec4) * 1, AttribUsage::User1),
+		BufferAttribute(3, 4, AttributeType::Float, sizeof(glm::mat4), sizeof(glm::vec4) * 2, AttribUsage::User2),
+		BufferAttribute(4, 4, AttributeType::Float, sizeof(glm::mat4), sizeof(glm::vec4) * 3, AttribUsage::User3),
+	}, 1);
+}
+
+void Impostor::AddInstance(const glm::mat4& transform) {
+	_instances.push_back(transform);
+}
+
+void Impostor::Draw(const Shader::Sptr& shader) {
+	if (_instances.empty()) {
+		return;
+	}
+
+	// Re-specifying the data store lets the driver orphan last frame's instances instead of stalling
+	_instanceBuffer->LoadData(_instances.data(), _instances.size());
+
+	_albedo->Bind(0);
+	_normalDepth->Bind(1);
+
+	shader->SetUniform("u_FramesPerAxis", (int)_framesPerAxis);
+	shader->SetUniform("u_Hemisphere", _hemisphere ? 1 : 0);
+	shader->SetUniform("u_ImpostorCenter", _center);
+	shader->SetUniform("u_ImpostorRadius", _radius);
+	shader->SetUniform("u_MaterialIndex", (int)_materialIndex);
+
+	_vao->DrawInstanced((uint32_t)_instances.size(), 0, DrawMode::TriangleStrip);
+
+	_instances.clear();
+}
+
+glm::vec3 Impostor::GetFrameDirection(uint32_t x, uint32_t y) const {
+	// Frames sit on the grid vertices, so the outer frames land exactly on the edges of the octahedron
+	glm::vec2 coord = glm::vec2(x, y) / (float)(_framesPerAxis - 1);
+	return OctahedralDecode(coord * 2.0f - 1.0f, _hemisphere);
+}
+
+// Like sign, but never returns zero (so we don't collapse points on the axes)
+inline glm::vec2 SignNotZero(const glm::vec2& v) {
+	return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+glm::vec3 Impostor::OctahedralDecode(const glm::vec2& coord, bool hemisphere) {
+	glm::vec3 result;
+	if (hemisphere) {
+		// Rotate the square by 45 degrees so the entire square maps onto the upper half of the octahedron
+		glm::vec2 rotated = glm::vec2(coord.x + coord.y, coord.x - coord.y) * 0.5f;
+		result = glm::vec3(rotated, 1.0f - glm::abs(rotated.x) - glm::abs(rotated.y));
+	} else {
+		result = glm::vec3(coord, 1.0f - glm::abs(coord.x) - glm::abs(coord.y));
+		// The lower half of the octahedron is folded out into the corners of the square
+		if (result.z < 0.0f) {
+			glm::vec2 folded = (1.0f - glm::abs(glm::vec2(result.y, result.x))) * SignNotZero(glm::vec2(result));
+			result.x = folded.x;
+			result.y = folded.y;
+		}
+	}
+	return glm::normalize(result);
+}
+
+glm::vec2 Impostor::OctahedralEncode(const glm::vec3& direction, bool hemisphere) {
+	glm::vec3 dir = direction;
+	if (hemisphere) {
+		// Clamp views from below onto the horizon
+		dir.z = glm::max(dir.z, 0.0f);
+	}
+	dir /= glm::max(glm::abs(dir.x) + glm::abs(dir.y) + glm::abs(dir.z), 0.00001f);
+	if (hemisphere) {
+		return glm::vec2(dir.x + dir.y, dir.x - dir.y);
+	} else if (dir.z < 0.0f) {
+		return (1.0f - glm::abs(glm::vec2(dir.y, dir.x))) * SignNotZero(glm::vec2(dir));
+	} else {
+		return glm::vec2(dir);
+	}
+}
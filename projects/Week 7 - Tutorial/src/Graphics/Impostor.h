@@ -0,0 +1,107 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Texture2D.h"
+#include "Shader.h"
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// An octahedral impostor stores a grid of pre-rendered views of a mesh (see ImpostorBaker), and can
+/// stand in for that mesh at a distance by drawing a single camera facing quad per instance. The quad
+/// blends between the 4 baked views that are closest to the current view direction.
+/// 
+/// The atlas is laid out as FramesPerAxis x FramesPerAxis frames, where frame (x, y) was rendered looking
+/// back at the mesh from the direction given by GetFrameDirection(x, y)
+/// </summary>
+class Impostor final
+{
+public:
+	typedef std::shared_ptr<Impostor> Sptr;
+
+	static inline Sptr Create(const Texture2D::Sptr& albedo, const Texture2D::Sptr& normalDepth, uint32_t framesPerAxis, bool hemisphere, const glm::vec3& center, float radius) {
+		return std::make_shared<Impostor>(albedo, normalDepth, framesPerAxis, hemisphere, center, radius);
+	}
+
+	// We'll disallow moving and copying, since we own GPU resources
+	Impostor(const Impostor& other) = delete;
+	Impostor(Impostor&& other) = delete;
+	Impostor& operator=(const Impostor& other) = delete;
+	Impostor& operator=(Impostor&& other) = delete;
+
+public:
+	/// <summary>
+	/// Creates a new impostor from a baked atlas
+	/// </summary>
+	/// <param name="albedo">The albedo atlas, with coverage stored in alpha</param>
+	/// <param name="normalDepth">The object space normal (rgb) and depth (a) atlas</param>
+	/// <param name="framesPerAxis">The number of frames along each axis of the atlas</param>
+	/// <param name="hemisphere">True if the frames only cover the upper hemisphere (+Z)</param>
+	/// <param name="center">The center of the mesh's bounding sphere, in object space</param>
+	/// <param name="radius">The radius of the mesh's bounding sphere, in object space</param>
+	Impostor(const Texture2D::Sptr& albedo, const Texture2D::Sptr& normalDepth, uint32_t framesPerAxis, bool hemisphere, const glm::vec3& center, float radius);
+	~Impostor() = default;
+
+	/// <summary>
+	/// Queues up an instance of this impostor to be drawn on the next call to Draw
+	/// </summary>
+	/// <param name="transform">The world transform of the object the impostor is standing in for</param>
+	void AddInstance(const glm::mat4& transform);
+	/// <summary>
+	/// Draws all the instances queued since the last draw in a single instanced draw call, then clears the queue.
+	/// The shader should already be bound, and have it's view projection, camera and light uniforms set
+	/// </summary>
+	/// <param name="shader">The impostor shader to render with</param>
+	void Draw(const Shader::Sptr& shader);
+
+	/// <summary>
+	/// Sets the index of the material (in the material table) to use when shading this impostor
+	/// </summary>
+	void SetMaterialIndex(uint32_t index) { _materialIndex = index; }
+	uint32_t GetMaterialIndex() const { return _materialIndex; }
+
+	/// <summary>
+	/// Gets the number of instances currently queued for drawing
+	/// </summary>
+	size_t GetInstanceCount() const { return _instances.size(); }
+	uint32_t GetFramesPerAxis() const { return _framesPerAxis; }
+	bool IsHemisphere() const { return _hemisphere; }
+	const glm::vec3& GetCenter() const { return _center; }
+	float GetRadius() const { return _radius; }
+	const Texture2D::Sptr& GetAlbedo() const { return _albedo; }
+	const Texture2D::Sptr& GetNormalDepth() const { return _normalDepth; }
+
+	/// <summary>
+	/// Gets the direction (in object space) that the given frame of the atlas is viewed from
+	/// </summary>
+	/// <param name="x">The x index of the frame in the atlas</param>
+	/// <param name="y">The y index of the frame in the atlas</param>
+	glm::vec3 GetFrameDirection(uint32_t x, uint32_t y) const;
+
+	/// <summary>
+	/// Maps a point in the [-1, 1] square to a direction on the unit sphere (or the +Z hemisphere)
+	/// </summary>
+	static glm::vec3 OctahedralDecode(const glm::vec2& coord, bool hemisphere);
+	/// <summary>
+	/// Maps a direction on the unit sphere (or the +Z hemisphere) to a point in the [-1, 1] square
+	/// </summary>
+	static glm::vec2 OctahedralEncode(const glm::vec3& direction, bool hemisphere);
+
+protected:
+	Texture2D::Sptr _albedo;
+	Texture2D::Sptr _normalDepth;
+	uint32_t        _framesPerAxis;
+	bool            _hemisphere;
+	glm::vec3       _center;
+	float           _radius;
+	uint32_t        _materialIndex;
+
+	// The transforms for all the instances we're going to draw this frame
+	std::vector<glm::mat4>  _instances;
+	// Per-instance transforms, re-uploaded every draw
+	VertexBuffer::Sptr      _instanceBuffer;
+	// A unit quad, with the instance buffer attached
+	VertexArrayObject::Sptr _vao;
+};
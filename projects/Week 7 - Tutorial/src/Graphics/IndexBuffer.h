@@ -50,6 +50,24 @@ public:
 		_elementType = elementType;
 	}
 
+	// Same as LoadData, copying from another buffer needs to know the element type
+	inline void LoadDataFromBuffer(GLuint source, size_t elementSize, size_t elementCount, size_t sourceOffset = 0) override {
+		throw std::runtime_error("Must use the LoadDataFromBuffer that specifies the element type");
+	}
+
+	/// <summary>
+	/// Loads data into our index buffer from another OpenGL buffer, specifying the type of indices we are using via the elementType parameter
+	/// </summary>
+	/// <param name="source">The OpenGL handle of the buffer to copy from</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to copy</param>
+	/// <param name="elementType">The type of elements you are storing (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)</param>
+	/// <param name="sourceOffset">The offset into the source buffer to start copying from, in bytes</param>
+	inline void LoadDataFromBuffer(GLuint source, size_t elementSize, size_t elementCount, IndexType elementType, size_t sourceOffset = 0) {
+		IBuffer::LoadDataFromBuffer(source, elementSize, elementCount, sourceOffset);
+		_elementType = elementType;
+	}
+
 	/// <summary>
 	/// Loads data of a known type into this index buffer
 	/// </summary>
@@ -0,0 +1,72 @@
+#include "MaterialTable.h"
+#include "Logging.h"
+#include <algorithm>
+
+MaterialTable::MaterialTable(uint32_t initialCapacity) :
+	_params(std::vector<MaterialParams>()),
+	_buffer(ShaderStorageBuffer::Create(BufferUsage::DynamicDraw)),
+	_capacity(std::max(initialCapacity, 1u)),
+	_dirtyBegin(0),
+	_dirtyEnd(0),
+	_needsRealloc(true)
+{
+	_params.reserve(_capacity);
+}
+
+uint32_t MaterialTable::Allocate(const MaterialParams& params) {
+	uint32_t index = static_cast<uint32_t>(_params.size());
+	_params.push_back(params);
+	// If we've run out of room on the GPU, double our capacity and re-upload everything next flush
+	if (_params.size() > _capacity) {
+		_capacity *= 2;
+		_needsRealloc = true;
+	}
+	__MarkDirty(index);
+	return index;
+}
+
+void MaterialTable::Set(uint32_t index, const MaterialParams& params) {
+	LOG_ASSERT(index < _params.size(), "Material index out of range!");
+	_params[index] = params;
+	__MarkDirty(index);
+}
+
+const MaterialParams& MaterialTable::Get(uint32_t index) const {
+	LOG_ASSERT(index < _params.size(), "Material index out of range!");
+	return _params[index];
+}
+
+void MaterialTable::Clear() {
+	_params.clear();
+	_dirtyBegin = _dirtyEnd = 0;
+}
+
+void MaterialTable::Flush() {
+	if (_needsRealloc) {
+		// Allocate the full capacity, then copy in what we have so far
+		_buffer->LoadData<MaterialParams>(nullptr, _capacity);
+		if (!_params.empty()) {
+			_buffer->UpdateData(_params.data(), sizeof(MaterialParams), _params.size(), 0);
+		}
+		_needsRealloc = false;
+	}
+	else if (_dirtyEnd > _dirtyBegin) {
+		// Only upload the range of entries that has been modified
+		_buffer->UpdateData(_params.data() + _dirtyBegin, sizeof(MaterialParams), _dirtyEnd - _dirtyBegin, _dirtyBegin);
+	}
+	_dirtyBegin = _dirtyEnd = 0;
+}
+
+void MaterialTable::Bind(int slot) {
+	_buffer->BindBase(slot);
+}
+
+void MaterialTable::__MarkDirty(uint32_t index) {
+	if (_dirtyEnd == _dirtyBegin) {
+		_dirtyBegin = index;
+		_dirtyEnd   = index + 1;
+	} else {
+		_dirtyBegin = std::min(_dirtyBegin, index);
+		_dirtyEnd   = std::max(_dirtyEnd, index + 1);
+	}
+}
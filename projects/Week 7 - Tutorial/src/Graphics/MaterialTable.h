@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "ShaderStorageBuffer.h"
+
+/// <summary>
+/// The per-material parameters that live on the GPU. This MUST match the layout of the
+/// MaterialParams struct declared in the shaders (std430 rules), so keep it padded to a multiple of 16 bytes
+/// </summary>
+struct MaterialParams {
+	float Shininess  = 1.0f;
+	float _padding[3] = { 0.0f, 0.0f, 0.0f };
+};
+static_assert(sizeof(MaterialParams) % 16 == 0, "MaterialParams must be padded to a multiple of 16 bytes to match std430 layout");
+
+/// <summary>
+/// A material table keeps the parameters for every material in a single GPU resident shader storage
+/// buffer, rather than pushing them as uniforms before every draw. Draws select their material via
+/// the base instance (see VertexArrayObject::DrawInstanced), which shaders read as gl_BaseInstance.
+/// 
+/// Edits are made on a CPU side copy, and only the range of entries that changed will be re-uploaded when
+/// Flush is called
+/// </summary>
+class MaterialTable
+{
+public:
+	typedef std::shared_ptr<MaterialTable> Sptr;
+
+	static inline Sptr Create(uint32_t initialCapacity = 64) {
+		return std::make_shared<MaterialTable>(initialCapacity);
+	}
+
+	// We'll disallow moving and copying, since we own a GPU buffer
+	MaterialTable(const MaterialTable& other) = delete;
+	MaterialTable(MaterialTable&& other) = delete;
+	MaterialTable& operator=(const MaterialTable& other) = delete;
+	MaterialTable& operator=(MaterialTable&& other) = delete;
+
+public:
+	/// <summary>
+	/// Creates a new material table with room for the given number of materials. The table will
+	/// grow as needed if more materials are allocated
+	/// </summary>
+	/// <param name="initialCapacity">The number of materials to reserve space for on the GPU</param>
+	MaterialTable(uint32_t initialCapacity = 64);
+	~MaterialTable() = default;
+
+	/// <summary>
+	/// Allocates a new entry in the table, initialized with the given parameters
+	/// </summary>
+	/// <param name="params">The initial parameters for the entry</param>
+	/// <returns>The index of the new entry, to be passed as the base instance when drawing</returns>
+	uint32_t Allocate(const MaterialParams& params = MaterialParams());
+	/// <summary>
+	/// Updates the parameters for an entry in the table. The change will be uploaded on the next call to Flush
+	/// </summary>
+	/// <param name="index">The index of the entry to update, as returned by Allocate</param>
+	/// <param name="params">The new parameters for the entry</param>
+	void Set(uint32_t index, const MaterialParams& params);
+	/// <summary>
+	/// Gets the CPU side copy of the parameters for the given entry
+	/// </summary>
+	const MaterialParams& Get(uint32_t index) const;
+	/// <summary>
+	/// Removes all entries from the table
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Uploads any entries that have changed since the last flush to the GPU. Should be called once per
+	/// frame before any draws that use the table
+	/// </summary>
+	void Flush();
+	/// <summary>
+	/// Binds the underlying storage buffer to the given shader storage binding point
+	/// </summary>
+	/// <param name="slot">The binding point, matching layout(binding = slot) in the shader</param>
+	void Bind(int slot);
+
+	/// <summary>
+	/// Returns the number of entries allocated in this table
+	/// </summary>
+	uint32_t GetCount() const { return static_cast<uint32_t>(_params.size()); }
+	/// <summary>
+	/// Returns the number of entries that the GPU buffer currently has room for
+	/// </summary>
+	uint32_t GetCapacity() const { return _capacity; }
+
+protected:
+	// CPU side copy of all our parameters
+	std::vector<MaterialParams> _params;
+	// The GPU resident copy of our parameters
+	ShaderStorageBuffer::Sptr   _buffer;
+	// The number of entries the GPU buffer has storage for
+	uint32_t                    _capacity;
+	// The range of entries that need to be uploaded, [_dirtyBegin, _dirtyEnd)
+	uint32_t                    _dirtyBegin;
+	uint32_t                    _dirtyEnd;
+	// True if the GPU buffer needs to be re-allocated (ex: we've grown past our capacity)
+	bool                        _needsRealloc;
+
+	void __MarkDirty(uint32_t index);
+};
@@ -0,0 +1,99 @@
+#include "SecondaryView.h"
+#include <Logging.h>
+#include <cfloat>
+
+// How much each new timing contributes to our cost estimate
+static const float COST_SMOOTHING = 0.2f;
+
+SecondaryView::SecondaryView(const Camera::Sptr& camera, uint32_t width, uint32_t height) :
+	Name("Unnamed View"),
+	_camera(camera),
+	_framebuffer(nullptr),
+	_baseWidth(width),
+	_baseHeight(height),
+	_resolutionScale(1.0f),
+	_updateInterval(0.0f),
+	_cullMask(~0u),
+	_isEnabled(true),
+	_lastUpdateTime(-1.0),
+	_timerQuery(0),
+	_isQueryPending(false),
+	_estimatedCostMs(DEFAULT_COST_MS)
+{
+	LOG_ASSERT(camera != nullptr, "Secondary views need a camera");
+	LOG_ASSERT(width > 0 && height > 0, "Secondary views must have a non-zero size");
+	_camera->ResizeWindow(width, height);
+	glCreateQueries(GL_TIME_ELAPSED, 1, &_timerQuery);
+	__RecreateFramebuffer();
+}
+
+SecondaryView::~SecondaryView() {
+	if (_timerQuery != 0) {
+		glDeleteQueries(1, &_timerQuery);
+	}
+}
+
+void SecondaryView::SetResolutionScale(float value) {
+	value = glm::clamp(value, 0.05f, 1.0f);
+	if (value != _resolutionScale) {
+		_resolutionScale = value;
+		__RecreateFramebuffer();
+	}
+}
+
+float SecondaryView::GetUrgency(double time) const {
+	if (_lastUpdateTime < 0.0) {
+		return FLT_MAX;
+	}
+	// Views that update every frame are always due
+	if (_updateInterval <= 0.0f) {
+		return 1.0f;
+	}
+	return static_cast<float>((time - _lastUpdateTime) / _updateInterval);
+}
+
+void SecondaryView::Render(const RenderFunc& render, double time) {
+	_framebuffer->Bind();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Only time this render if we've already collected the result for the last one
+	bool isTiming = !_isQueryPending;
+	if (isTiming) {
+		glBeginQuery(GL_TIME_ELAPSED, _timerQuery);
+	}
+	render(_camera, _cullMask, glm::ivec2(GetWidth(), GetHeight()));
+	if (isTiming) {
+		glEndQuery(GL_TIME_ELAPSED);
+		_isQueryPending = true;
+	}
+
+	_lastUpdateTime = time;
+}
+
+void SecondaryView::PollTiming() {
+	if (!_isQueryPending) {
+		return;
+	}
+	GLint isAvailable = GL_FALSE;
+	glGetQueryObjectiv(_timerQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+	if (isAvailable) {
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(_timerQuery, GL_QUERY_RESULT, &elapsedNs);
+		float elapsedMs = static_cast<float>(elapsedNs / 1000000.0);
+		_estimatedCostMs = glm::mix(_estimatedCostMs, elapsedMs, COST_SMOOTHING);
+		_isQueryPending = false;
+	}
+}
+
+void SecondaryView::__RecreateFramebuffer() {
+	uint32_t width  = glm::max(static_cast<uint32_t>(_baseWidth * _resolutionScale), 1u);
+	uint32_t height = glm::max(static_cast<uint32_t>(_baseHeight * _resolutionScale), 1u);
+
+	_framebuffer = Framebuffer::Create(width, height);
+	_framebuffer->AddColorAttachment(InternalFormat::RGBA8);
+	_framebuffer->AddDepthAttachment();
+	LOG_ASSERT(_framebuffer->Validate(), "Secondary view framebuffer is incomplete");
+
+	// The old contents are gone, so make sure we get redrawn soon
+	_lastUpdateTime = -1.0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+#include <memory>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+#include "Framebuffer.h"
+#include "Camera.h"
+
+/// <summary>
+/// An extra view of the scene (ex: a minimap, security monitor or reflection capture) that is rendered into
+/// a texture rather than the window. Secondary views can be rendered at a fraction of their full resolution,
+/// only every so often, and with a mask that selects which layers of the scene they can see
+/// </summary>
+class SecondaryView final
+{
+public:
+	typedef std::shared_ptr<SecondaryView> Sptr;
+
+	/// <summary>
+	/// The function used to render the scene into a view
+	/// </summary>
+	/// <param name="camera">The camera to render the scene from</param>
+	/// <param name="cullMask">A bitmask of the layers that should be drawn</param>
+	/// <param name="viewportSize">The size of the target being rendered to, in pixels</param>
+	typedef std::function<void(const Camera::Sptr& camera, uint32_t cullMask, const glm::ivec2& viewportSize)> RenderFunc;
+
+	static inline Sptr Create(const Camera::Sptr& camera, uint32_t width, uint32_t height) {
+		return std::make_shared<SecondaryView>(camera, width, height);
+	}
+
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	SecondaryView(const SecondaryView& other) = delete;
+	SecondaryView(SecondaryView&& other) = delete;
+	SecondaryView& operator=(const SecondaryView& other) = delete;
+	SecondaryView& operator=(SecondaryView&& other) = delete;
+
+public:
+	/// <summary>
+	/// Creates a new secondary view that renders from the given camera
+	/// </summary>
+	/// <param name="camera">The camera to render from, it's aspect ratio will be set to match the view</param>
+	/// <param name="width">The width of the view at full resolution, in pixels</param>
+	/// <param name="height">The height of the view at full resolution, in pixels</param>
+	SecondaryView(const Camera::Sptr& camera, uint32_t width, uint32_t height);
+	~SecondaryView();
+
+	/// <summary>
+	/// A human readable name for this view, used for debugging
+	/// </summary>
+	std::string Name;
+
+	/// <summary>
+	/// Sets the fraction of the full resolution that this view is rendered at, between 0.05 and 1
+	/// </summary>
+	void SetResolutionScale(float value);
+	float GetResolutionScale() const { return _resolutionScale; }
+	/// <summary>
+	/// Sets the time between updates for this view in seconds, or 0 to update it every frame
+	/// </summary>
+	void SetUpdateInterval(float seconds) { _updateInterval = glm::max(seconds, 0.0f); }
+	float GetUpdateInterval() const { return _updateInterval; }
+	/// <summary>
+	/// Sets the bitmask of scene layers that this view can see
+	/// </summary>
+	void SetCullMask(uint32_t value) { _cullMask = value; }
+	uint32_t GetCullMask() const { return _cullMask; }
+	/// <summary>
+	/// Sets whether this view gets updated at all
+	/// </summary>
+	void SetEnabled(bool value) { _isEnabled = value; }
+	bool IsEnabled() const { return _isEnabled; }
+
+	const Camera::Sptr& GetCamera() const { return _camera; }
+	/// <summary>
+	/// Gets the texture that this view renders into. Note that this texture will be replaced if the resolution scale changes
+	/// </summary>
+	const Texture2D::Sptr& GetTexture() const { return _framebuffer->GetColorAttachment(); }
+	uint32_t GetWidth() const { return _framebuffer->GetWidth(); }
+	uint32_t GetHeight() const { return _framebuffer->GetHeight(); }
+
+	/// <summary>
+	/// Gets how overdue this view is for an update, as a fraction of it's update interval. Views that
+	/// have never been rendered are always overdue
+	/// </summary>
+	/// <param name="time">The current time, in seconds</param>
+	float GetUrgency(double time) const;
+	/// <summary>
+	/// Gets how long this view took to render on the GPU, smoothed over the last few updates, in milliseconds
+	/// </summary>
+	float GetEstimatedCostMs() const { return _estimatedCostMs; }
+
+	/// <summary>
+	/// Renders the scene into this view. Leaves this view's framebuffer bound
+	/// </summary>
+	/// <param name="render">The function that will render the scene</param>
+	/// <param name="time">The current time, in seconds</param>
+	void Render(const RenderFunc& render, double time);
+	/// <summary>
+	/// Checks if the GPU timing for our last render is ready, and updates our cost estimate if it is
+	/// </summary>
+	void PollTiming();
+
+	/// <summary>
+	/// The cost we assume for views that we haven't timed yet, in milliseconds
+	/// </summary>
+	static constexpr float DEFAULT_COST_MS = 0.5f;
+
+protected:
+	Camera::Sptr      _camera;
+	Framebuffer::Sptr _framebuffer;
+	uint32_t _baseWidth;
+	uint32_t _baseHeight;
+	float    _resolutionScale;
+	float    _updateInterval;
+	uint32_t _cullMask;
+	bool     _isEnabled;
+	double   _lastUpdateTime;
+
+	// A GPU timer query, so we can find out how much each update costs without stalling
+	GLuint   _timerQuery;
+	bool     _isQueryPending;
+	float    _estimatedCostMs;
+
+	void __RecreateFramebuffer();
+};
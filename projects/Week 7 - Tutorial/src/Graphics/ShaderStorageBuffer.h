@@ -0,0 +1,41 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// The shader storage buffer stores arbitrary blocks of data that shaders can read from (and write to)
+/// via an indexed binding point
+/// </summary>
+/// <see>https://www.khronos.org/opengl/wiki/Shader_Storage_Buffer_Object</see>
+class ShaderStorageBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<ShaderStorageBuffer> Sptr;
+
+	static inline Sptr Create(BufferUsage usage = BufferUsage::DynamicDraw) {
+		return std::make_shared<ShaderStorageBuffer>(usage);
+	}
+
+	/// <summary>
+	/// Creates a new shader storage buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_DYNAMIC_DRAW</param>
+	ShaderStorageBuffer(BufferUsage usage = BufferUsage::DynamicDraw) : IBuffer(BufferType::ShaderStorage, usage) { }
+
+	/// <summary>
+	/// Binds this buffer to the given indexed binding point, so that it can be accessed by
+	/// shader blocks declared with layout(binding = slot)
+	/// </summary>
+	/// <param name="slot">The index of the binding point to bind to</param>
+	void BindBase(int slot) { glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, _handle); }
+
+	/// <summary>
+	/// Unbinds the current shader storage buffer
+	/// </summary>
+	static void UnBind() { IBuffer::UnBind(BufferType::ShaderStorage); }
+	/// <summary>
+	/// Unbinds whatever buffer is bound to the given indexed binding point
+	/// </summary>
+	/// <param name="slot">The index of the binding point to clear</param>
+	static void UnBindBase(int slot) { glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, 0); }
+};
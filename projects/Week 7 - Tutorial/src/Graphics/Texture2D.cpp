@@ -24,9 +24,10 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 }
 
 void Texture2D::_LoadDataFromFile() {
-	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
-
+	// Textures without a file are allowed to have a size, their storage is allocated up front and filled in with LoadData
 	if (!_description.Filename.empty()) {
+		LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
+
 		// Variables that will store properties about our image
 		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
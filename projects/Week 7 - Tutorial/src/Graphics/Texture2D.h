@@ -49,6 +49,8 @@ struct Texture2DDescription {
 };
 
 class Texture2D : public ITexture {
+	// The texture streamer needs to swap out our storage as mip levels are streamed in and out
+	friend class TextureStreamer;
 public:
 	typedef std::shared_ptr<Texture2D> Sptr;
 
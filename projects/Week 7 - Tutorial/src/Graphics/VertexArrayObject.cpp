@@ -2,6 +2,7 @@
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
 #include "Logging.h"
+#include <algorithm>
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
@@ -29,17 +30,21 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 	Unbind();
 }
 
-void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes)
+void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes, uint32_t instanceDivisor)
 {
-	if (_vertexBuffers.size() == 0) {
-		_vertexCount = buffer->GetElementCount();
-	} else if (buffer->GetElementCount() != _vertexCount) {
-		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
+	// Per-instance buffers don't contribute to the vertex count
+	if (instanceDivisor == 0) {
+		if (_vertexCount == 0) {
+			_vertexCount = buffer->GetElementCount();
+		} else if (buffer->GetElementCount() != _vertexCount) {
+			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
+		}
 	}
 
 	VertexBufferBinding binding;
 	binding.Buffer = buffer;
 	binding.Attributes = attributes;
+	binding.InstanceDivisor = instanceDivisor;
 	_vertexBuffers.push_back(binding);
 
 
@@ -49,10 +54,20 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const
 		glEnableVertexArrayAttrib(_handle, attrib.Slot);
 		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
 							  (void*)attrib.Offset);
+		glVertexAttribDivisor(attrib.Slot, instanceDivisor);
 	}
 	Unbind();
 }
 
+void VertexArrayObject::RefreshVertexCount() {
+	_vertexCount = 0;
+	for (const VertexBufferBinding& binding : _vertexBuffers) {
+		if (binding.InstanceDivisor == 0) {
+			_vertexCount = _vertexCount == 0 ? (uint32_t)binding.Buffer->GetElementCount() : std::min(_vertexCount, (uint32_t)binding.Buffer->GetElementCount());
+		}
+	}
+}
+
 void VertexArrayObject::Draw(DrawMode mode) {
 	Bind();
 	if (_indexBuffer == nullptr) {
@@ -63,6 +78,16 @@ void VertexArrayObject::Draw(DrawMode mode) {
 	Unbind();
 }
 
+void VertexArrayObject::DrawInstanced(uint32_t instanceCount, uint32_t baseInstance, DrawMode mode) {
+	Bind();
+	if (_indexBuffer == nullptr) {
+		glDrawArraysInstancedBaseInstance((GLenum)mode, 0, _vertexCount, instanceCount, baseInstance);
+	} else {
+		glDrawElementsInstancedBaseInstance((GLenum)mode, _indexBuffer->GetElementCount(), (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
+	}
+	Unbind();
+}
+
 void VertexArrayObject::Bind() {
 	glBindVertexArray(_handle);
 }
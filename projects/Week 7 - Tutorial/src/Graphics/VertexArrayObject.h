@@ -98,7 +98,7 @@ struct BufferAttribute
 	/// </summary>
 	AttribUsage Usage;
 
-	BufferAttribute(uint32_t slot, uint32_t size, AttributeType type, GLsizei stride, GLsizei offset, AttribUsage usage, bool normalized = false) :
+	constexpr BufferAttribute(uint32_t slot, uint32_t size, AttributeType type, GLsizei stride, GLsizei offset, AttribUsage usage, bool normalized = false) :
 		Slot(slot), Size(size), Type(type), Stride(stride), Offset(offset), Usage(usage), Normalized(normalized) { }
 };
 
@@ -139,9 +139,23 @@ public:
 	/// </summary>
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
-	void AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes);
+	/// <param name="instanceDivisor">If non-zero, the attributes will advance once per this many instances instead of once per vertex</param>
+	void AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes, uint32_t instanceDivisor = 0);
+	/// <summary>
+	/// Re-reads the vertex count from the per-vertex buffers, should be called after one of the buffers has
+	/// been re-loaded with a different number of vertices
+	/// </summary>
+	void RefreshVertexCount();
 
 	void Draw(DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Draws one or more instances of this VAO, offsetting the instance index by baseInstance. The base
+	/// instance is visible in shaders as gl_BaseInstance, and can be used to index per-draw data (ex: materials)
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	/// <param name="baseInstance">The offset to add to the instance index (gl_BaseInstance)</param>
+	/// <param name="mode">The primitive type to render</param>
+	void DrawInstanced(uint32_t instanceCount, uint32_t baseInstance = 0, DrawMode mode = DrawMode::TriangleList);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -158,13 +172,28 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 	
-protected:
 	// Helper structure to store a buffer and the attributes
 	struct VertexBufferBinding
 	{
 		VertexBuffer::Sptr Buffer;
 		std::vector<BufferAttribute> Attributes;
+		uint32_t InstanceDivisor = 0;
 	};
+
+	/// <summary>
+	/// Returns the index buffer bound to this VAO, or nullptr if the VAO is not indexed
+	/// </summary>
+	const IndexBuffer::Sptr& GetIndexBuffer() const { return _indexBuffer; }
+	/// <summary>
+	/// Returns all the vertex buffers and their attributes that have been added to this VAO
+	/// </summary>
+	const std::vector<VertexBufferBinding>& GetVertexBuffers() const { return _vertexBuffers; }
+	/// <summary>
+	/// Returns the number of vertices in this VAO (not including any per-instance buffers)
+	/// </summary>
+	uint32_t GetVertexCount() const { return _vertexCount; }
+
+protected:
 	
 	// The index buffer bound to this VAO
 	IndexBuffer::Sptr _indexBuffer;
@@ -0,0 +1,150 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <type_traits>
+#include <cstddef>
+#include <vector>
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// Holds the attribute declaration for a vertex type as a constexpr array, specialize this for every vertex
+/// type (see VertexTypes.h). Expected to have a static constexpr BufferAttribute ATTRIBUTES[]
+/// </summary>
+template <typename Vertex>
+struct VertexDeclaration;
+
+/// <summary>
+/// Describes how a member type maps onto a vertex attribute, for the types we use in vertices
+/// </summary>
+template <typename T> struct VertexMemberTraits { static constexpr GLint Size = 0; static constexpr AttributeType Type = AttributeType::Unknown; };
+template <> struct VertexMemberTraits<float>     { static constexpr GLint Size = 1; static constexpr AttributeType Type = AttributeType::Float; };
+template <> struct VertexMemberTraits<glm::vec2> { static constexpr GLint Size = 2; static constexpr AttributeType Type = AttributeType::Float; };
+template <> struct VertexMemberTraits<glm::vec3> { static constexpr GLint Size = 3; static constexpr AttributeType Type = AttributeType::Float; };
+template <> struct VertexMemberTraits<glm::vec4> { static constexpr GLint Size = 4; static constexpr AttributeType Type = AttributeType::Float; };
+
+// Detects whether a vertex type has a member with the given name, so we can find the attributes at compile time
+#define VERTEX_MEMBER_DETECTOR(Member) \
+	template <typename Vertex, typename = void> struct HasVertexMember_##Member : std::false_type { }; \
+	template <typename Vertex> struct HasVertexMember_##Member<Vertex, std::void_t<decltype(std::declval<Vertex&>().Member)>> : std::true_type { };
+
+VERTEX_MEMBER_DETECTOR(Position)
+VERTEX_MEMBER_DETECTOR(Normal)
+VERTEX_MEMBER_DETECTOR(UV)
+VERTEX_MEMBER_DETECTOR(Color)
+
+#undef VERTEX_MEMBER_DETECTOR
+
+/// <summary>
+/// Compile time description of which of the common attributes a vertex type has. All of the setters and getters
+/// resolve at compile time to either a plain member access, or nothing at all if the vertex lacks the attribute,
+/// so generic mesh code can write any vertex type without checking offsets per vertex
+/// </summary>
+/// <typeparam name="Vertex">The type of vertex to describe</typeparam>
+template <typename Vertex>
+struct VertexLayout
+{
+	static constexpr bool HAS_POSITION = HasVertexMember_Position<Vertex>::value;
+	static constexpr bool HAS_NORMAL   = HasVertexMember_Normal<Vertex>::value;
+	static constexpr bool HAS_TEXTURE  = HasVertexMember_UV<Vertex>::value;
+	static constexpr bool HAS_COLOR    = HasVertexMember_Color<Vertex>::value;
+
+	static void SetPosition(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HAS_POSITION) { vertex.Position = value; }
+	}
+	static void SetNormal(Vertex& vertex, const glm::vec3& value) {
+		if constexpr (HAS_NORMAL) { vertex.Normal = value; }
+	}
+	static void SetTexture(Vertex& vertex, const glm::vec2& value) {
+		if constexpr (HAS_TEXTURE) { vertex.UV = value; }
+	}
+	static void SetColor(Vertex& vertex, const glm::vec4& value) {
+		// Colors may have less than 4 components, in which case we just drop the extras
+		if constexpr (HAS_COLOR) { vertex.Color = decltype(vertex.Color)(value); }
+	}
+
+	static glm::vec3 GetPosition(const Vertex& vertex) {
+		if constexpr (HAS_POSITION) { return vertex.Position; } else { return glm::vec3(0.0f); }
+	}
+	static glm::vec3 GetNormal(const Vertex& vertex) {
+		if constexpr (HAS_NORMAL) { return vertex.Normal; } else { return glm::vec3(0.0f); }
+	}
+	static glm::vec2 GetTexture(const Vertex& vertex) {
+		if constexpr (HAS_TEXTURE) { return vertex.UV; } else { return glm::vec2(0.0f); }
+	}
+	static glm::vec4 GetColor(const Vertex& vertex) {
+		if constexpr (HAS_COLOR) {
+			constexpr GLint size = VertexMemberTraits<std::decay_t<decltype(vertex.Color)>>::Size;
+			if constexpr (size == 4) { return vertex.Color; }
+			else if constexpr (size == 3) { return glm::vec4(vertex.Color, 1.0f); }
+			else { return glm::vec4(vertex.Color, 0.0f, 1.0f); }
+		} else {
+			return glm::vec4(1.0f);
+		}
+	}
+
+	/// <summary>
+	/// Creates a vertex with all of the common attributes that it has set
+	/// </summary>
+	static Vertex Create(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col) {
+		Vertex result;
+		SetPosition(result, pos);
+		SetNormal(result, norm);
+		SetTexture(result, uv);
+		SetColor(result, col);
+		return result;
+	}
+
+	/// <summary>
+	/// Checks that an attribute declaration agrees with the vertex struct: every attribute must have the
+	/// vertex's stride, the common attributes must exist exactly when the struct has the matching member,
+	/// and must point at that member with the right size and type. Intended for use in a static_assert
+	/// </summary>
+	template <size_t N>
+	static constexpr bool Validate(const BufferAttribute (&attributes)[N]) {
+		for (size_t ix = 0; ix < N; ix++) {
+			if (attributes[ix].Stride != sizeof(Vertex)) return false;
+		}
+		if constexpr (HAS_POSITION) {
+			if (!__ValidateMember<decltype(std::declval<Vertex&>().Position)>(attributes, AttribUsage::Position, offsetof(Vertex, Position))) return false;
+		} else if (__CountUsage(attributes, AttribUsage::Position) != 0) return false;
+		if constexpr (HAS_NORMAL) {
+			if (!__ValidateMember<decltype(std::declval<Vertex&>().Normal)>(attributes, AttribUsage::Normal, offsetof(Vertex, Normal))) return false;
+		} else if (__CountUsage(attributes, AttribUsage::Normal) != 0) return false;
+		if constexpr (HAS_TEXTURE) {
+			if (!__ValidateMember<decltype(std::declval<Vertex&>().UV)>(attributes, AttribUsage::Texture, offsetof(Vertex, UV))) return false;
+		} else if (__CountUsage(attributes, AttribUsage::Texture) != 0) return false;
+		if constexpr (HAS_COLOR) {
+			if (!__ValidateMember<decltype(std::declval<Vertex&>().Color)>(attributes, AttribUsage::Color, offsetof(Vertex, Color))) return false;
+		} else if (__CountUsage(attributes, AttribUsage::Color) != 0) return false;
+		return true;
+	}
+
+	/// <summary>
+	/// Copies a constexpr attribute declaration into the vector form that VertexArrayObject takes
+	/// </summary>
+	template <size_t N>
+	static std::vector<BufferAttribute> ToVector(const BufferAttribute(&attributes)[N]) {
+		return std::vector<BufferAttribute>(attributes, attributes + N);
+	}
+
+protected:
+	template <size_t N>
+	static constexpr size_t __CountUsage(const BufferAttribute(&attributes)[N], AttribUsage usage) {
+		size_t result = 0;
+		for (size_t ix = 0; ix < N; ix++) {
+			if (attributes[ix].Usage == usage) result++;
+		}
+		return result;
+	}
+
+	template <typename Member, size_t N>
+	static constexpr bool __ValidateMember(const BufferAttribute(&attributes)[N], AttribUsage usage, size_t offset) {
+		typedef VertexMemberTraits<std::decay_t<Member>> Traits;
+		if (__CountUsage(attributes, usage) != 1) return false;
+		for (size_t ix = 0; ix < N; ix++) {
+			if (attributes[ix].Usage == usage) {
+				return attributes[ix].Size == Traits::Size && attributes[ix].Type == Traits::Type && (size_t)attributes[ix].Offset == offset;
+			}
+		}
+		return false;
+	}
+};
@@ -2,6 +2,7 @@
 
 #include <GLM/glm.hpp>
 #include "VertexArrayObject.h"
+#include "VertexLayout.h"
 
 
 struct VertexPosCol {
@@ -17,6 +18,14 @@ struct VertexPosCol {
 	static const std::vector<BufferAttribute> V_DECL;
 };
 
+template <> struct VertexDeclaration<VertexPosCol> {
+	static constexpr BufferAttribute ATTRIBUTES[] = {
+		BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), offsetof(VertexPosCol, Position), AttribUsage::Position),
+		BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexPosCol), offsetof(VertexPosCol, Color), AttribUsage::Color)
+	};
+};
+static_assert(VertexLayout<VertexPosCol>::Validate(VertexDeclaration<VertexPosCol>::ATTRIBUTES), "VertexPosCol does not match its attribute declaration");
+
 struct VertexPosNormCol {
 	glm::vec3 Position;
 	glm::vec3 Normal;
@@ -31,6 +40,15 @@ struct VertexPosNormCol {
 	static const std::vector<BufferAttribute> V_DECL;
 };
 
+template <> struct VertexDeclaration<VertexPosNormCol> {
+	static constexpr BufferAttribute ATTRIBUTES[] = {
+		BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormCol), offsetof(VertexPosNormCol, Position), AttribUsage::Position),
+		BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexPosNormCol), offsetof(VertexPosNormCol, Color), AttribUsage::Color),
+		BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormCol), offsetof(VertexPosNormCol, Normal), AttribUsage::Normal)
+	};
+};
+static_assert(VertexLayout<VertexPosNormCol>::Validate(VertexDeclaration<VertexPosNormCol>::ATTRIBUTES), "VertexPosNormCol does not match its attribute declaration");
+
 struct VertexPosNormTex {
 	glm::vec3 Position;
 	glm::vec3 Normal;
@@ -45,6 +63,15 @@ struct VertexPosNormTex {
 	static const std::vector<BufferAttribute> V_DECL;
 };
 
+template <> struct VertexDeclaration<VertexPosNormTex> {
+	static constexpr BufferAttribute ATTRIBUTES[] = {
+		BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTex), offsetof(VertexPosNormTex, Position), AttribUsage::Position),
+		BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTex), offsetof(VertexPosNormTex, Normal), AttribUsage::Normal),
+		BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosNormTex), offsetof(VertexPosNormTex, UV), AttribUsage::Texture)
+	};
+};
+static_assert(VertexLayout<VertexPosNormTex>::Validate(VertexDeclaration<VertexPosNormTex>::ATTRIBUTES), "VertexPosNormTex does not match its attribute declaration");
+
 struct VertexPosNormTexCol {
 	glm::vec3 Position;
 	glm::vec3 Normal;
@@ -58,4 +85,40 @@ struct VertexPosNormTexCol {
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+template <> struct VertexDeclaration<VertexPosNormTexCol> {
+	static constexpr BufferAttribute ATTRIBUTES[] = {
+		BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTexCol), offsetof(VertexPosNormTexCol, Position), AttribUsage::Position),
+		BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexPosNormTexCol), offsetof(VertexPosNormTexCol, Color), AttribUsage::Color),
+		BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTexCol), offsetof(VertexPosNormTexCol, Normal), AttribUsage::Normal),
+		BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosNormTexCol), offsetof(VertexPosNormTexCol, UV), AttribUsage::Texture)
+	};
+};
+static_assert(VertexLayout<VertexPosNormTexCol>::Validate(VertexDeclaration<VertexPosNormTexCol>::ATTRIBUTES), "VertexPosNormTexCol does not match its attribute declaration");
+
+struct VertexPosNormTexColLm {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 UV;
+	glm::vec4 Color;
+	// A second set of UVs into the scene's baked lightmap, every surface gets it's own unique area
+	glm::vec2 LightmapUV;
+
+	VertexPosNormTexColLm() : Position(glm::vec3(0.0f)), Normal(glm::vec3(0.0f)), UV(glm::vec2(0.0f)), Color(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)), LightmapUV(glm::vec2(0.0f)) {}
+	VertexPosNormTexColLm(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col, const glm::vec2& lightmapUv) :
+		Position(pos), Normal(norm), UV(uv), Color(col), LightmapUV(lightmapUv) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+template <> struct VertexDeclaration<VertexPosNormTexColLm> {
+	static constexpr BufferAttribute ATTRIBUTES[] = {
+		BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosNormTexColLm), offsetof(VertexPosNormTexColLm, Position), AttribUsage::Position),
+		BufferAttribute(1, 4, AttributeType::Float, sizeof(VertexPosNormTexColLm), offsetof(VertexPosNormTexColLm, Color), AttribUsage::Color),
+		BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTexColLm), offsetof(VertexPosNormTexColLm, Normal), AttribUsage::Normal),
+		BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosNormTexColLm), offsetof(VertexPosNormTexColLm, UV), AttribUsage::Texture),
+		BufferAttribute(4, 2, AttributeType::Float, sizeof(VertexPosNormTexColLm), offsetof(VertexPosNormTexColLm, LightmapUV), AttribUsage::Texture1)
+	};
+};
+static_assert(VertexLayout<VertexPosNormTexColLm>::Validate(VertexDeclaration<VertexPosNormTexColLm>::ATTRIBUTES), "VertexPosNormTexColLm does not match its attribute declaration");
@@ -0,0 +1,322 @@
+#include "FrameCapture.h"
+#include <stb_image_write.h>
+#include <Logging.h>
+#include <algorithm>
+#include <cstring>
+#include <imgui.h>
+
+bool FrameCapture::_isInitialized = false;
+FrameCapture::Readback FrameCapture::_ring[RING_SIZE];
+uint32_t FrameCapture::_ringHead = 0;
+uint32_t FrameCapture::_ringCount = 0;
+std::string FrameCapture::_screenshotPath;
+bool FrameCapture::_isCapturing = false;
+CaptureFormat FrameCapture::_format = CaptureFormat::PngSequence;
+std::string FrameCapture::_outputPrefix;
+uint64_t FrameCapture::_capturedFrames = 0;
+uint64_t FrameCapture::_droppedFrames = 0;
+int FrameCapture::_videoWidth = 0;
+int FrameCapture::_videoHeight = 0;
+FILE* FrameCapture::_videoFile = nullptr;
+uint64_t FrameCapture::_videoFramesQueued = 0;
+uint64_t FrameCapture::_nextVideoFrame = 0;
+std::condition_variable FrameCapture::_videoSignal;
+std::vector<std::thread> FrameCapture::_workers;
+std::mutex FrameCapture::_jobMutex;
+std::condition_variable FrameCapture::_jobSignal;
+std::queue<FrameCapture::CaptureJob> FrameCapture::_jobs;
+std::vector<std::vector<uint8_t>> FrameCapture::_freeStorage;
+bool FrameCapture::_isRunning = false;
+
+void FrameCapture::Init(uint32_t numThreads) {
+	if (_isInitialized) return;
+
+	// OpenGL gives us rows bottom to top, STBI's flip setting is global so we set it once up front
+	stbi_flip_vertically_on_write(true);
+	// We'd much rather keep up with the frame rate than save a few bytes
+	stbi_write_png_compression_level = 1;
+
+	_isRunning = true;
+	numThreads = std::max(numThreads, 1u);
+	for (uint32_t ix = 0; ix < numThreads; ix++) {
+		_workers.emplace_back(&FrameCapture::__WorkerThread);
+	}
+	_isInitialized = true;
+}
+
+void FrameCapture::Cleanup() {
+	if (!_isInitialized) return;
+
+	StopCapture();
+	while (_ringCount > 0) {
+		__RetireOldest();
+	}
+
+	// Let our workers finish off the queue before they exit
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_isRunning = false;
+	}
+	_jobSignal.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	_freeStorage.clear();
+
+	for (Readback& readback : _ring) {
+		if (readback.Buffer != 0) {
+			glDeleteBuffers(1, &readback.Buffer);
+		}
+		readback = Readback();
+	}
+	_ringHead = 0;
+	_isInitialized = false;
+}
+
+void FrameCapture::CaptureScreenshot(const std::string& path) {
+	_screenshotPath = path;
+}
+
+void FrameCapture::StartCapture(const std::string& outputPrefix, CaptureFormat format) {
+	if (_isCapturing) {
+		StopCapture();
+	}
+
+	_outputPrefix = outputPrefix;
+	_format = format;
+	_capturedFrames = 0;
+	_droppedFrames = 0;
+	_videoWidth = 0;
+	_videoHeight = 0;
+
+	if (format == CaptureFormat::RawVideo) {
+		std::string path = outputPrefix + ".rgba";
+		_videoFile = fopen(path.c_str(), "wb");
+		if (_videoFile == nullptr) {
+			LOG_ERROR("Failed to open \"{}\" for video capture", path);
+			return;
+		}
+		_videoFramesQueued = 0;
+		_nextVideoFrame = 0;
+	}
+	_isCapturing = true;
+}
+
+void FrameCapture::StopCapture() {
+	if (!_isCapturing) return;
+	_isCapturing = false;
+
+	// Hand off any frames that are still in flight, so they make it into the capture
+	while (_ringCount > 0) {
+		__RetireOldest();
+	}
+
+	if (_videoFile != nullptr) {
+		// Wait for the workers to write out every frame we've queued before closing the file
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_videoSignal.wait(lock, [] { return _nextVideoFrame == _videoFramesQueued; });
+		}
+		fclose(_videoFile);
+		_videoFile = nullptr;
+		LOG_INFO("Captured {} frames ({}x{}) to {}.rgba, {} dropped", _nextVideoFrame, _videoWidth, _videoHeight, _outputPrefix, _droppedFrames);
+	} else {
+		LOG_INFO("Captured {} frames to {}_*.png, {} dropped", _capturedFrames, _outputPrefix, _droppedFrames);
+	}
+}
+
+void FrameCapture::EndFrame(int width, int height) {
+	if (!_isInitialized) return;
+
+	// Hand off any reads that have already finished, without waiting on the GPU
+	while (_ringCount > 0) {
+		GLenum status = glClientWaitSync(_ring[_ringHead].Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		__RetireOldest();
+	}
+
+	bool wantsScreenshot = !_screenshotPath.empty();
+	if ((!_isCapturing && !wantsScreenshot) || width <= 0 || height <= 0) {
+		return;
+	}
+
+	// Raw video needs every frame to be the same size
+	if (_isCapturing && _format == CaptureFormat::RawVideo) {
+		if (_videoWidth == 0) {
+			_videoWidth = width;
+			_videoHeight = height;
+		} else if (_videoWidth != width || _videoHeight != height) {
+			LOG_WARN("Window was resized during video capture, stopping capture");
+			StopCapture();
+			if (!wantsScreenshot) return;
+		}
+	}
+
+	// If the ring is full, we have no choice but to wait for the oldest read
+	if (_ringCount == RING_SIZE) {
+		__RetireOldest();
+	}
+
+	Readback& readback = _ring[(_ringHead + _ringCount) % RING_SIZE];
+	size_t size = static_cast<size_t>(width) * height * 4;
+	if (readback.Capacity < size) {
+		if (readback.Buffer != 0) {
+			glDeleteBuffers(1, &readback.Buffer);
+		}
+		glCreateBuffers(1, &readback.Buffer);
+		glNamedBufferStorage(readback.Buffer, size, nullptr, GL_MAP_READ_BIT);
+		readback.Capacity = size;
+	}
+
+	// Kick off the read, this returns right away since the destination is a buffer object
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.Buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.Width = width;
+	readback.Height = height;
+	readback.IsVideo = _isCapturing && _format == CaptureFormat::RawVideo;
+
+	// A screenshot takes priority over the frame sequence, the sequence will pick up again next frame
+	if (wantsScreenshot) {
+		readback.Path = _screenshotPath;
+		readback.IsVideo = false;
+		_screenshotPath.clear();
+	} else if (!readback.IsVideo) {
+		char number[16];
+		snprintf(number, sizeof(number), "_%06llu", static_cast<unsigned long long>(_capturedFrames));
+		readback.Path = _outputPrefix + number + ".png";
+	} else {
+		readback.Path.clear();
+	}
+	if (_isCapturing && !wantsScreenshot) {
+		_capturedFrames++;
+	}
+	_ringCount++;
+}
+
+void FrameCapture::DrawImGui() {
+	if (ImGui::Button("Screenshot")) {
+		CaptureScreenshot("screenshot.png");
+	}
+	ImGui::SameLine();
+	if (_isCapturing) {
+		if (ImGui::Button("Stop Recording")) {
+			StopCapture();
+		}
+	} else {
+		if (ImGui::Button("Record PNGs")) {
+			StartCapture("capture", CaptureFormat::PngSequence);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Record Raw Video")) {
+			StartCapture("capture", CaptureFormat::RawVideo);
+		}
+	}
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		queued = _jobs.size();
+	}
+	ImGui::Text("Captured: %llu (%llu dropped), %d waiting to encode", (unsigned long long)_capturedFrames, (unsigned long long)_droppedFrames, (int)queued);
+}
+
+void FrameCapture::__RetireOldest() {
+	Readback& readback = _ring[_ringHead];
+	glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(readback.Fence);
+	readback.Fence = nullptr;
+	_ringHead = (_ringHead + 1) % RING_SIZE;
+	_ringCount--;
+
+	CaptureJob job;
+	job.Width = readback.Width;
+	job.Height = readback.Height;
+	job.Path = readback.Path;
+	size_t size = static_cast<size_t>(readback.Width) * readback.Height * 4;
+
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		// If the encoders can't keep up, drop this frame rather than letting the queue grow forever. Video
+		// frames get their position when they are queued, so a dropped frame won't hold up the writer
+		if (_jobs.size() >= MAX_QUEUED_FRAMES) {
+			_droppedFrames++;
+			return;
+		}
+		if (readback.IsVideo) {
+			job.VideoFrame = _videoFramesQueued++;
+		}
+		if (!_freeStorage.empty()) {
+			job.Pixels = std::move(_freeStorage.back());
+			_freeStorage.pop_back();
+		}
+	}
+
+	// This is the only copy the render thread pays for, the GPU has already finished writing the buffer
+	job.Pixels.resize(size);
+	void* mapped = glMapNamedBufferRange(readback.Buffer, 0, size, GL_MAP_READ_BIT);
+	if (mapped != nullptr) {
+		memcpy(job.Pixels.data(), mapped, size);
+		glUnmapNamedBuffer(readback.Buffer);
+	} else {
+		LOG_WARN("Failed to map capture buffer");
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_jobs.push(std::move(job));
+	}
+	_jobSignal.notify_one();
+}
+
+void FrameCapture::__WorkerThread() {
+	while (true) {
+		CaptureJob job;
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_jobSignal.wait(lock, [] { return !_isRunning || !_jobs.empty(); });
+			if (_jobs.empty()) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop();
+		}
+
+		if (job.Path.empty()) {
+			__WriteVideoFrame(job);
+		} else if (stbi_write_png(job.Path.c_str(), job.Width, job.Height, 4, job.Pixels.data(), job.Width * 4) == 0) {
+			LOG_WARN("Failed to write capture to \"{}\"", job.Path);
+		}
+
+		// Hand the storage back so the next frame doesn't have to allocate
+		{
+			std::lock_guard<std::mutex> lock(_jobMutex);
+			_freeStorage.push_back(std::move(job.Pixels));
+		}
+	}
+}
+
+void FrameCapture::__WriteVideoFrame(const CaptureJob& job) {
+	// Several workers may be holding video frames, so wait until it's our turn to write
+	std::unique_lock<std::mutex> lock(_jobMutex);
+	_videoSignal.wait(lock, [&] { return _nextVideoFrame == job.VideoFrame; });
+	lock.unlock();
+
+	// Only the worker holding the next frame can get here, so we can write without the lock. Rows are flipped
+	// so the video comes out top-down
+	if (_videoFile != nullptr) {
+		size_t rowSize = static_cast<size_t>(job.Width) * 4;
+		for (int row = job.Height - 1; row >= 0; row--) {
+			fwrite(job.Pixels.data() + rowSize * row, 1, rowSize, _videoFile);
+		}
+	}
+
+	lock.lock();
+	_nextVideoFrame++;
+	lock.unlock();
+	_videoSignal.notify_all();
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <cstdio>
+
+/// <summary>
+/// The formats that FrameCapture can record to
+/// </summary>
+enum class CaptureFormat {
+	/// <summary>
+	/// Every frame is written to it's own numbered PNG file
+	/// </summary>
+	PngSequence,
+	/// <summary>
+	/// Frames are appended to a single file of raw, top-down RGBA8 pixels, which can be
+	/// converted with ex: ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -i file.rgba out.mp4
+	/// </summary>
+	RawVideo
+};
+
+/// <summary>
+/// Helper class for capturing the contents of the back buffer without stalling the pipeline.
+///
+/// Rather than reading pixels straight into client memory (which forces the CPU to wait for the GPU to finish
+/// the frame), we read into a ring of pixel buffer objects, and only map them a couple of frames later once
+/// their fence has signalled. The pixels are then handed off to worker threads for encoding, so the render
+/// thread only pays for a copy out of the mapped buffer
+/// </summary>
+class FrameCapture {
+public:
+	/// <summary>
+	/// Initializes the frame capture system, should be called after OpenGL has been initialized
+	/// </summary>
+	/// <param name="numThreads">The number of threads to encode frames on</param>
+	static void Init(uint32_t numThreads = 4);
+	/// <summary>
+	/// Finishes any in progress captures, and stops the worker threads. Should be called before closing the application
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Requests that the next frame be saved as a PNG
+	/// </summary>
+	/// <param name="path">The path to save the screenshot to</param>
+	static void CaptureScreenshot(const std::string& path);
+	/// <summary>
+	/// Starts capturing every frame until StopCapture is called
+	/// </summary>
+	/// <param name="outputPrefix">The path to save to, without an extension. PNG sequences will add a frame number</param>
+	/// <param name="format">The format to save frames in</param>
+	static void StartCapture(const std::string& outputPrefix, CaptureFormat format);
+	/// <summary>
+	/// Stops capturing frames, and waits for all captured frames to be written
+	/// </summary>
+	static void StopCapture();
+	static bool IsCapturing() { return _isCapturing; }
+
+	/// <summary>
+	/// Reads back the current frame if one has been requested, and hands off any earlier frames whose reads have finished.
+	/// Should be called once per frame after rendering, but before glfwSwapBuffers
+	/// </summary>
+	/// <param name="width">The width of the back buffer, in pixels</param>
+	/// <param name="height">The height of the back buffer, in pixels</param>
+	static void EndFrame(int width, int height);
+
+	/// <summary>
+	/// Draws an ImGui widget with the capture controls and stats
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The number of pixel buffers we cycle through, a frame's pixels are mapped RING_SIZE - 1 frames after they were read
+	/// </summary>
+	static const uint32_t RING_SIZE = 3;
+	/// <summary>
+	/// The most frames we will let wait for encoding before we start dropping frames
+	/// </summary>
+	static const size_t   MAX_QUEUED_FRAMES = 16;
+
+protected:
+	FrameCapture() = default;
+
+	// A frame that has been read back and is waiting to be encoded
+	struct CaptureJob {
+		std::vector<uint8_t> Pixels;
+		int         Width = 0;
+		int         Height = 0;
+		// The path to write a PNG to, empty for video frames
+		std::string Path;
+		// The position of this frame in the video, so that frames are written in order
+		uint64_t    VideoFrame = 0;
+	};
+
+	// A pixel buffer that we have issued a read into
+	struct Readback {
+		GLuint      Buffer = 0;
+		size_t      Capacity = 0;
+		GLsync      Fence = nullptr;
+		int         Width = 0;
+		int         Height = 0;
+		std::string Path;
+		bool        IsVideo = false;
+	};
+
+	static bool _isInitialized;
+
+	static Readback _ring[RING_SIZE];
+	static uint32_t _ringHead;
+	static uint32_t _ringCount;
+
+	static std::string _screenshotPath;
+	static bool        _isCapturing;
+	static CaptureFormat _format;
+	static std::string _outputPrefix;
+	static uint64_t    _capturedFrames;
+	static uint64_t    _droppedFrames;
+	static int         _videoWidth;
+	static int         _videoHeight;
+
+	// Raw video state, frames are written in the order they were queued
+	static FILE*       _videoFile;
+	static uint64_t    _videoFramesQueued;
+	static uint64_t    _nextVideoFrame;
+	static std::condition_variable _videoSignal;
+
+	// Encode jobs are handed to the worker threads, and the pixel storage is handed back to be reused
+	static std::vector<std::thread> _workers;
+	static std::mutex _jobMutex;
+	static std::condition_variable _jobSignal;
+	static std::queue<CaptureJob> _jobs;
+	static std::vector<std::vector<uint8_t>> _freeStorage;
+	static bool _isRunning;
+
+	static void __WorkerThread();
+	static void __RetireOldest();
+	static void __WriteVideoFrame(const CaptureJob& job);
+};
@@ -0,0 +1,141 @@
+#include "FrameLimiter.h"
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+#include <algorithm>
+#include <imgui.h>
+
+GLFWwindow* FrameLimiter::_window = nullptr;
+uint32_t FrameLimiter::_maxFramesInFlight = 2;
+bool FrameLimiter::_lateInputEnabled = true;
+double FrameLimiter::_inputTime = 0.0;
+FrameLimiter::FrameInFlight FrameLimiter::_frames[MAX_FRAMES_IN_FLIGHT + 1];
+uint32_t FrameLimiter::_head = 0;
+uint32_t FrameLimiter::_inFlightCount = 0;
+double FrameLimiter::_averageLatencyMs = 0.0;
+double FrameLimiter::_observedLatencyMs = 0.0;
+double FrameLimiter::_lastWaitMs = 0.0;
+
+// How much each new latency sample contributes to the smoothed latency
+static const double LATENCY_SMOOTHING = 0.1;
+
+// The size of our ring of frames, we need room for one more frame than we allow in flight,
+// since we insert the new fence before waiting on the old ones
+static const uint32_t RING_SIZE = FrameLimiter::MAX_FRAMES_IN_FLIGHT + 1;
+
+// Adds a new latency sample to a smoothed latency
+static void AddLatencySample(double& average, double latencyMs) {
+	average = average == 0.0 ? latencyMs : average + (latencyMs - average) * LATENCY_SMOOTHING;
+}
+
+void FrameLimiter::Init(GLFWwindow* window, uint32_t maxFramesInFlight) {
+	_window = window;
+	SetMaxFramesInFlight(maxFramesInFlight);
+	_head = 0;
+	_inFlightCount = 0;
+	_averageLatencyMs = 0.0;
+	_observedLatencyMs = 0.0;
+	_lastWaitMs = 0.0;
+	_inputTime = glfwGetTime();
+
+	for (uint32_t ix = 0; ix < RING_SIZE; ix++) {
+		glGenQueries(1, &_frames[ix].Query);
+	}
+}
+
+void FrameLimiter::Cleanup() {
+	for (uint32_t ix = 0; ix < RING_SIZE; ix++) {
+		if (_frames[ix].Fence != nullptr) {
+			glDeleteSync(_frames[ix].Fence);
+			_frames[ix].Fence = nullptr;
+		}
+		if (_frames[ix].Query != 0) {
+			glDeleteQueries(1, &_frames[ix].Query);
+			_frames[ix].Query = 0;
+		}
+	}
+	_head = 0;
+	_inFlightCount = 0;
+	_window = nullptr;
+}
+
+void FrameLimiter::BeginFrame() {
+	glfwPollEvents();
+	_inputTime = glfwGetTime();
+}
+
+void FrameLimiter::SampleLateInput() {
+	if (_lateInputEnabled) {
+		glfwPollEvents();
+		_inputTime = glfwGetTime();
+	}
+}
+
+void FrameLimiter::EndFrame() {
+	// Queue up a timestamp and a fence behind this frame's commands (including the swap). The timestamp is
+	// written when the GPU gets to it, so it tells us when the frame actually finished, not when we noticed
+	FrameInFlight& frame = _frames[(_head + _inFlightCount) % RING_SIZE];
+	glQueryCounter(frame.Query, GL_TIMESTAMP);
+	frame.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.InputTime = _inputTime;
+
+	// Reading GL_TIMESTAMP gives us the GPU's clock right now without waiting, which lets us line it up with
+	// glfwGetTime. We re-do this every frame so that the two clocks can't drift apart
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	frame.ClockOffset = glfwGetTime() - gpuNow / 1.0e9;
+	_inFlightCount++;
+
+	// Retire any frames that have already finished, without blocking, so our latency stays up to date
+	while (_inFlightCount > 0) {
+		GLenum status = glClientWaitSync(_frames[_head].Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		__RetireOldest(0);
+	}
+
+	// Block until we are back within our limit
+	double waitStart = glfwGetTime();
+	while (_inFlightCount > _maxFramesInFlight) {
+		__RetireOldest(GL_TIMEOUT_IGNORED);
+	}
+	_lastWaitMs = (glfwGetTime() - waitStart) * 1000.0;
+}
+
+void FrameLimiter::SetMaxFramesInFlight(uint32_t value) {
+	_maxFramesInFlight = std::clamp(value, 1u, MAX_FRAMES_IN_FLIGHT);
+}
+
+void FrameLimiter::DrawImGui() {
+	int maxFrames = (int)_maxFramesInFlight;
+	if (ImGui::SliderInt("Max frames in flight", &maxFrames, 1, (int)MAX_FRAMES_IN_FLIGHT)) {
+		SetMaxFramesInFlight((uint32_t)maxFrames);
+	}
+	ImGui::Checkbox("Late input sampling", &_lateInputEnabled);
+	ImGui::Text("Input to present: %.2f ms", _averageLatencyMs);
+	ImGui::Text("Input to fence seen (upper bound): %.2f ms", _observedLatencyMs);
+	ImGui::Text("GPU wait: %.2f ms", _lastWaitMs);
+}
+
+void FrameLimiter::__RetireOldest(GLuint64 timeout) {
+	FrameInFlight& frame = _frames[_head];
+	GLenum status = glClientWaitSync(frame.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	if (status == GL_WAIT_FAILED) {
+		LOG_WARN("Failed to wait on frame fence");
+	}
+
+	// This is when we noticed the frame was done, which may be a while after it actually was
+	AddLatencySample(_observedLatencyMs, (glfwGetTime() - frame.InputTime) * 1000.0);
+
+	// The fence has signalled, so the timestamp is ready and reading it won't stall. It marks when the GPU
+	// finished the frame and handed it off for presentation
+	GLuint64 gpuDone = 0;
+	glGetQueryObjectui64v(frame.Query, GL_QUERY_RESULT, &gpuDone);
+	double completeTime = gpuDone / 1.0e9 + frame.ClockOffset;
+	AddLatencySample(_averageLatencyMs, std::max(completeTime - frame.InputTime, 0.0) * 1000.0);
+
+	glDeleteSync(frame.Fence);
+	frame.Fence = nullptr;
+	_head = (_head + 1) % RING_SIZE;
+	_inFlightCount--;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+// Will be included in the CPP to avoid header bloat
+struct GLFWwindow;
+
+/// <summary>
+/// Helper class for limiting how many frames the CPU can queue up ahead of the GPU. Without a limit,
+/// the driver will happily let us run several frames ahead, and every one of those frames adds to the
+/// time between reading input and seeing the result on screen.
+///
+/// After each swap we insert a fence, and if there are more than the allowed number of frames in flight,
+/// we block until the oldest one has finished. Alongside the fence we record a GPU timestamp, so the time
+/// between sampling input for a frame and the GPU finishing that frame gives us a measurement of our input
+/// to present latency. The time at which the CPU notices the fence is also tracked, but since we only check
+/// fences once per frame, that is an upper bound on the real latency
+/// </summary>
+class FrameLimiter {
+public:
+	/// <summary>
+	/// Initializes the frame limiter, should be called after OpenGL has been initialized
+	/// </summary>
+	/// <param name="window">The window that we are polling input from</param>
+	/// <param name="maxFramesInFlight">The most frames that can be queued up on the GPU at once</param>
+	static void Init(GLFWwindow* window, uint32_t maxFramesInFlight = 2);
+	/// <summary>
+	/// Releases any outstanding fences, should be called before closing the application
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Polls for input, and notes the time as the input time for this frame. Call at the start of the render loop,
+	/// in place of glfwPollEvents
+	/// </summary>
+	static void BeginFrame();
+	/// <summary>
+	/// If late input sampling is enabled, polls for input again and moves this frame's input time forward.
+	/// Call right before anything that depends on input (ex: the camera update)
+	/// </summary>
+	static void SampleLateInput();
+	/// <summary>
+	/// Inserts a fence for this frame, and waits for older frames until we are within our frame limit.
+	/// Call right after glfwSwapBuffers
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Sets the most frames that can be queued up on the GPU at once, between 1 and MAX_FRAMES_IN_FLIGHT
+	/// </summary>
+	static void SetMaxFramesInFlight(uint32_t value);
+	static uint32_t GetMaxFramesInFlight() { return _maxFramesInFlight; }
+	/// <summary>
+	/// Sets whether input is polled a second time right before it is used, rather than only at the start of the frame
+	/// </summary>
+	static void SetLateInputEnabled(bool value) { _lateInputEnabled = value; }
+	static bool IsLateInputEnabled() { return _lateInputEnabled; }
+
+	/// <summary>
+	/// Gets a smoothed measurement of the time between sampling input and the GPU finishing that frame, in milliseconds
+	/// </summary>
+	static double GetAverageLatencyMs() { return _averageLatencyMs; }
+	/// <summary>
+	/// Gets a smoothed measurement of the time between sampling input and the CPU seeing that frame's fence signal,
+	/// in milliseconds. This is an upper bound on the latency, as the fence may have signalled well before we checked it
+	/// </summary>
+	static double GetObservedLatencyMs() { return _observedLatencyMs; }
+	/// <summary>
+	/// Gets the time we spent blocked on the GPU in the last EndFrame, in milliseconds
+	/// </summary>
+	static double GetLastWaitMs() { return _lastWaitMs; }
+
+	/// <summary>
+	/// Draws an ImGui widget showing the latency stats, and allowing the settings to be edited
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The largest number of frames we will ever allow in flight
+	/// </summary>
+	static const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+protected:
+	FrameLimiter() = default;
+
+	// A frame that has been submitted to the GPU but that we have not seen complete yet
+	struct FrameInFlight {
+		GLsync Fence       = nullptr;
+		// Timestamp query that records when the GPU reaches the end of the frame
+		GLuint Query       = 0;
+		double InputTime   = 0.0;
+		// The difference between glfwGetTime and the GPU's clock (in seconds) when the frame was submitted
+		double ClockOffset = 0.0;
+	};
+
+	static GLFWwindow* _window;
+	static uint32_t _maxFramesInFlight;
+	static bool     _lateInputEnabled;
+	static double   _inputTime;
+
+	// Ring of frames in flight, _head is the oldest frame, and there are _inFlightCount frames after it
+	static FrameInFlight _frames[MAX_FRAMES_IN_FLIGHT + 1];
+	static uint32_t _head;
+	static uint32_t _inFlightCount;
+
+	static double _averageLatencyMs;
+	static double _observedLatencyMs;
+	static double _lastWaitMs;
+
+	static void __RetireOldest(GLuint64 timeout);
+};
@@ -0,0 +1,146 @@
+#include "IdleMode.h"
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+#include <algorithm>
+#include <imgui.h>
+
+GLFWwindow* IdleMode::_window = nullptr;
+bool IdleMode::_isEnabled = true;
+float IdleMode::_idleRefreshRate = 2.0f;
+uint32_t IdleMode::_redrawFrames = REDRAW_FRAMES;
+double IdleMode::_statsStart = 0.0;
+uint32_t IdleMode::_statsFrames = 0;
+float IdleMode::_framesPerSecond = 0.0f;
+
+// The callbacks that were installed before ours (usually ImGui's), which we forward events on to
+static GLFWkeyfun            prevKeyCallback = nullptr;
+static GLFWcharfun           prevCharCallback = nullptr;
+static GLFWmousebuttonfun    prevMouseButtonCallback = nullptr;
+static GLFWcursorposfun      prevCursorPosCallback = nullptr;
+static GLFWcursorenterfun    prevCursorEnterCallback = nullptr;
+static GLFWscrollfun         prevScrollCallback = nullptr;
+static GLFWwindowsizefun     prevWindowSizeCallback = nullptr;
+static GLFWwindowrefreshfun  prevWindowRefreshCallback = nullptr;
+static GLFWwindowfocusfun    prevWindowFocusCallback = nullptr;
+
+void IdleMode::Init(GLFWwindow* window) {
+	LOG_ASSERT(_window == nullptr, "Init has already been called! Should only be called once per application");
+	_window = window;
+
+	prevKeyCallback           = glfwSetKeyCallback(window, __KeyCallback);
+	prevCharCallback          = glfwSetCharCallback(window, __CharCallback);
+	prevMouseButtonCallback   = glfwSetMouseButtonCallback(window, __MouseButtonCallback);
+	prevCursorPosCallback     = glfwSetCursorPosCallback(window, __CursorPosCallback);
+	prevCursorEnterCallback   = glfwSetCursorEnterCallback(window, __CursorEnterCallback);
+	prevScrollCallback        = glfwSetScrollCallback(window, __ScrollCallback);
+	prevWindowSizeCallback    = glfwSetWindowSizeCallback(window, __WindowSizeCallback);
+	prevWindowRefreshCallback = glfwSetWindowRefreshCallback(window, __WindowRefreshCallback);
+	prevWindowFocusCallback   = glfwSetWindowFocusCallback(window, __WindowFocusCallback);
+
+	_statsStart = glfwGetTime();
+	RequestRedraw();
+}
+
+void IdleMode::Cleanup() {
+	if (_window == nullptr) return;
+
+	glfwSetKeyCallback(_window, prevKeyCallback);
+	glfwSetCharCallback(_window, prevCharCallback);
+	glfwSetMouseButtonCallback(_window, prevMouseButtonCallback);
+	glfwSetCursorPosCallback(_window, prevCursorPosCallback);
+	glfwSetCursorEnterCallback(_window, prevCursorEnterCallback);
+	glfwSetScrollCallback(_window, prevScrollCallback);
+	glfwSetWindowSizeCallback(_window, prevWindowSizeCallback);
+	glfwSetWindowRefreshCallback(_window, prevWindowRefreshCallback);
+	glfwSetWindowFocusCallback(_window, prevWindowFocusCallback);
+	_window = nullptr;
+}
+
+bool IdleMode::WaitForEvents() {
+	if (!_isEnabled || _redrawFrames > 0) {
+		return false;
+	}
+	// Sleep until something happens, or it's time for our low rate refresh. Any input that wakes us will
+	// go through our callbacks and request a redraw
+	glfwWaitEventsTimeout(1.0 / _idleRefreshRate);
+	return true;
+}
+
+void IdleMode::EndFrame() {
+	// Keep drawing while the user is interacting with ImGui (ex: dragging a slider with the mouse held still)
+	if (ImGui::IsAnyItemActive()) {
+		RequestRedraw();
+	}
+	if (_redrawFrames > 0) {
+		_redrawFrames--;
+	}
+
+	_statsFrames++;
+	double now = glfwGetTime();
+	if (now - _statsStart >= 1.0) {
+		_framesPerSecond = static_cast<float>(_statsFrames / (now - _statsStart));
+		_statsFrames = 0;
+		_statsStart = now;
+	}
+}
+
+void IdleMode::RequestRedraw() {
+	_redrawFrames = REDRAW_FRAMES;
+}
+
+void IdleMode::SetIdleRefreshRate(float value) {
+	_idleRefreshRate = std::max(value, 0.1f);
+}
+
+void IdleMode::DrawImGui() {
+	ImGui::Checkbox("Idle mode", &_isEnabled);
+	if (ImGui::DragFloat("Idle refresh (Hz)", &_idleRefreshRate, 0.1f, 0.1f, 60.0f)) {
+		SetIdleRefreshRate(_idleRefreshRate);
+	}
+	ImGui::Text("Drawing at %.1f FPS", _framesPerSecond);
+}
+
+void IdleMode::__KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	RequestRedraw();
+	if (prevKeyCallback) prevKeyCallback(window, key, scancode, action, mods);
+}
+
+void IdleMode::__CharCallback(GLFWwindow* window, unsigned int codepoint) {
+	RequestRedraw();
+	if (prevCharCallback) prevCharCallback(window, codepoint);
+}
+
+void IdleMode::__MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+	RequestRedraw();
+	if (prevMouseButtonCallback) prevMouseButtonCallback(window, button, action, mods);
+}
+
+void IdleMode::__CursorPosCallback(GLFWwindow* window, double x, double y) {
+	RequestRedraw();
+	if (prevCursorPosCallback) prevCursorPosCallback(window, x, y);
+}
+
+void IdleMode::__CursorEnterCallback(GLFWwindow* window, int entered) {
+	RequestRedraw();
+	if (prevCursorEnterCallback) prevCursorEnterCallback(window, entered);
+}
+
+void IdleMode::__ScrollCallback(GLFWwindow* window, double xOffset, double yOffset) {
+	RequestRedraw();
+	if (prevScrollCallback) prevScrollCallback(window, xOffset, yOffset);
+}
+
+void IdleMode::__WindowSizeCallback(GLFWwindow* window, int width, int height) {
+	RequestRedraw();
+	if (prevWindowSizeCallback) prevWindowSizeCallback(window, width, height);
+}
+
+void IdleMode::__WindowRefreshCallback(GLFWwindow* window) {
+	RequestRedraw();
+	if (prevWindowRefreshCallback) prevWindowRefreshCallback(window);
+}
+
+void IdleMode::__WindowFocusCallback(GLFWwindow* window, int focused) {
+	RequestRedraw();
+	if (prevWindowFocusCallback) prevWindowFocusCallback(window, focused);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+
+// Will be included in the CPP to avoid header bloat
+struct GLFWwindow;
+
+/// <summary>
+/// Helper class for only rendering when something has changed. While idle mode is enabled, the render loop
+/// will sleep in glfwWaitEventsTimeout until input arrives, rather than redrawing the same frame as fast as it can.
+///
+/// A redraw is triggered by any input on the window, by an ImGui widget being active, or by anything calling
+/// RequestRedraw (ex: an animation that is running, or an asset that has finished loading). To keep things
+/// like timers and blinking cursors ticking over, we also redraw at a low rate while idle
+/// </summary>
+class IdleMode {
+public:
+	/// <summary>
+	/// Initializes idle mode, hooking into the window's input callbacks. Should be called after ImGuiHelper::Init,
+	/// so that we chain on to ImGui's callbacks
+	/// </summary>
+	/// <param name="window">The window to watch for input</param>
+	static void Init(GLFWwindow* window);
+	/// <summary>
+	/// Restores the window's original callbacks, should be called before ImGuiHelper::Cleanup
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// If idle mode is enabled and nothing needs to be redrawn, blocks until input arrives or the idle refresh
+	/// interval has passed. Call at the start of the render loop, before polling for input
+	/// </summary>
+	/// <returns>True if we slept waiting for events, false if we returned right away</returns>
+	static bool WaitForEvents();
+	/// <summary>
+	/// Checks ImGui for any active widgets, and counts down our pending redraws. Call at the end of the render loop,
+	/// after all of the ImGui widgets for the frame have been submitted
+	/// </summary>
+	static void EndFrame();
+
+	/// <summary>
+	/// Requests that the next few frames be drawn, even if there is no input
+	/// </summary>
+	static void RequestRedraw();
+
+	static void SetEnabled(bool value) { _isEnabled = value; }
+	static bool IsEnabled() { return _isEnabled; }
+	/// <summary>
+	/// Sets how many times per second we redraw while idle
+	/// </summary>
+	static void SetIdleRefreshRate(float value);
+	static float GetIdleRefreshRate() { return _idleRefreshRate; }
+
+	/// <summary>
+	/// Draws an ImGui widget for toggling idle mode, and showing how often we are drawing
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The number of frames we keep drawing after a redraw is requested, so that ImGui has a chance to settle
+	/// (ex: hover highlights need a frame to catch up with the mouse)
+	/// </summary>
+	static const uint32_t REDRAW_FRAMES = 3;
+
+protected:
+	IdleMode() = default;
+
+	static GLFWwindow* _window;
+	static bool     _isEnabled;
+	static float    _idleRefreshRate;
+	static uint32_t _redrawFrames;
+
+	// Used to show how many frames we are actually drawing per second
+	static double   _statsStart;
+	static uint32_t _statsFrames;
+	static float    _framesPerSecond;
+
+	static void __KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void __CharCallback(GLFWwindow* window, unsigned int codepoint);
+	static void __MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void __CursorPosCallback(GLFWwindow* window, double x, double y);
+	static void __CursorEnterCallback(GLFWwindow* window, int entered);
+	static void __ScrollCallback(GLFWwindow* window, double xOffset, double yOffset);
+	static void __WindowSizeCallback(GLFWwindow* window, int width, int height);
+	static void __WindowRefreshCallback(GLFWwindow* window);
+	static void __WindowFocusCallback(GLFWwindow* window, int focused);
+};
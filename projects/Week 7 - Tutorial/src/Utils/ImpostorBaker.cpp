@@ -0,0 +1,130 @@
+#include "ImpostorBaker.h"
+#include "Graphics/Framebuffer.h"
+#include "Logging.h"
+
+#include <cfloat>
+#include <GLM/gtc/matrix_transform.hpp>
+
+Shader::Sptr ImpostorBaker::_bakeShader = nullptr;
+
+bool ImpostorBaker::CalculateBounds(const VertexArrayObject::Sptr& mesh, glm::vec3& center, float& radius) {
+	// Find the buffer that is feeding our positions
+	for (const auto& binding : mesh->GetVertexBuffers()) {
+		for (const BufferAttribute& attrib : binding.Attributes) {
+			if (attrib.Usage != AttribUsage::Position || attrib.Type != AttributeType::Float || attrib.Size < 3) {
+				continue;
+			}
+
+			// Read the vertex data back from the GPU, this is slow but we only do it once at load time
+			const VertexBuffer::Sptr& buffer = binding.Buffer;
+			std::vector<uint8_t> data(buffer->GetTotalSize());
+			glGetNamedBufferSubData(buffer->GetHandle(), 0, data.size(), data.data());
+
+			size_t stride = attrib.Stride == 0 ? sizeof(float) * attrib.Size : attrib.Stride;
+			size_t count = buffer->GetElementCount();
+			if (count == 0) {
+				return false;
+			}
+
+			// Center the sphere on the center of the AABB, then find the furthest vertex from it
+			glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+			for (size_t ix = 0; ix < count; ix++) {
+				glm::vec3 pos = *reinterpret_cast<const glm::vec3*>(data.data() + ix * stride + attrib.Offset);
+				min = glm::min(min, pos);
+				max = glm::max(max, pos);
+			}
+			center = (min + max) * 0.5f;
+			float radiusSq = 0.0f;
+			for (size_t ix = 0; ix < count; ix++) {
+				glm::vec3 pos = *reinterpret_cast<const glm::vec3*>(data.data() + ix * stride + attrib.Offset);
+				glm::vec3 delta = pos - center;
+				radiusSq = glm::max(radiusSq, glm::dot(delta, delta));
+			}
+			radius = glm::sqrt(radiusSq);
+			return true;
+		}
+	}
+	return false;
+}
+
+Impostor::Sptr ImpostorBaker::Bake(const VertexArrayObject::Sptr& mesh, const Texture2D::Sptr& diffuse, const ImpostorBakeSettings& settings) {
+	LOG_ASSERT(settings.FramesPerAxis >= 2, "Impostors need at least 2 frames per axis!");
+
+	glm::vec3 center;
+	float radius;
+	if (mesh == nullptr || !CalculateBounds(mesh, center, radius) || radius <= 0.0f) {
+		LOG_WARN("Cannot bake impostor, mesh has no position data!");
+		return nullptr;
+	}
+
+	// Lazy load our baking shader
+	if (_bakeShader == nullptr) {
+		_bakeShader = Shader::Create();
+		_bakeShader->LoadShaderPartFromFile("shaders/vert_impostor_bake.glsl", ShaderPartType::Vertex);
+		_bakeShader->LoadShaderPartFromFile("shaders/frag_impostor_bake.glsl", ShaderPartType::Fragment);
+		_bakeShader->Link();
+	}
+
+	// Our atlas has a color target for albedo, and one for normals + depth
+	uint32_t size = settings.FramesPerAxis * settings.FrameResolution;
+	Framebuffer::Sptr fbo = Framebuffer::Create(size, size);
+	Texture2D::Sptr albedo = fbo->AddColorAttachment(InternalFormat::RGBA8);
+	Texture2D::Sptr normalDepth = fbo->AddColorAttachment(InternalFormat::RGBA8);
+	fbo->AddDepthAttachment();
+	if (!fbo->Validate()) {
+		return nullptr;
+	}
+
+	Impostor::Sptr result = Impostor::Create(albedo, normalDepth, settings.FramesPerAxis, settings.Hemisphere, center, radius);
+
+	// Store the state we're about to stomp on so we can restore it
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	GLint lastFbo;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &lastFbo);
+
+	fbo->Bind();
+
+	// Empty texels have no coverage, and the furthest possible depth
+	const glm::vec4 albedoClear = glm::vec4(0.0f);
+	const glm::vec4 normalClear = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+	const float depthClear = 1.0f;
+	glClearNamedFramebufferfv(fbo->GetHandle(), GL_COLOR, 0, &albedoClear.x);
+	glClearNamedFramebufferfv(fbo->GetHandle(), GL_COLOR, 1, &normalClear.x);
+	glClearNamedFramebufferfv(fbo->GetHandle(), GL_DEPTH, 0, &depthClear);
+
+	_bakeShader->Bind();
+	if (diffuse != nullptr) {
+		diffuse->Bind(0);
+	}
+	_bakeShader->SetUniform("u_UseTexture", diffuse != nullptr ? 1 : 0);
+
+	// An orthographic box that exactly fits the bounding sphere, the camera sits on the surface
+	// of the sphere so that depth 0 is the front of the sphere and depth 1 is the back
+	glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, radius * 2.0f);
+
+	for (uint32_t y = 0; y < settings.FramesPerAxis; y++) {
+		for (uint32_t x = 0; x < settings.FramesPerAxis; x++) {
+			glm::vec3 dir = result->GetFrameDirection(x, y);
+			// Our world is Z up, fall back to Y when looking straight up or down (must match vert_impostor.glsl)
+			glm::vec3 up = glm::abs(dir.z) > 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+			glm::mat4 view = glm::lookAt(center + dir * radius, center, up);
+
+			glViewport(x * settings.FrameResolution, y * settings.FrameResolution, settings.FrameResolution, settings.FrameResolution);
+			_bakeShader->SetUniformMatrix("u_ViewProjection", projection * view);
+			mesh->Draw();
+		}
+	}
+
+	// Restore our previous state
+	glBindFramebuffer(GL_FRAMEBUFFER, lastFbo);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	Shader::Unbind();
+
+	LOG_INFO("Baked {}x{} impostor atlas ({} views)", size, size, settings.FramesPerAxis * settings.FramesPerAxis);
+	return result;
+}
+
+void ImpostorBaker::Cleanup() {
+	_bakeShader = nullptr;
+}
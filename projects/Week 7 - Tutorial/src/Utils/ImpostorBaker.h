@@ -0,0 +1,58 @@
+#pragma once
+#include "Graphics/Impostor.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/Shader.h"
+
+/// <summary>
+/// Settings for baking an octahedral impostor
+/// </summary>
+struct ImpostorBakeSettings {
+	/// <summary>
+	/// The number of views along each axis of the atlas, total views is FramesPerAxis^2
+	/// </summary>
+	uint32_t FramesPerAxis = 8;
+	/// <summary>
+	/// The size of a single view in the atlas, in pixels
+	/// </summary>
+	uint32_t FrameResolution = 128;
+	/// <summary>
+	/// If true, only views from the upper (+Z) hemisphere are baked, giving more
+	/// resolution to objects that are never seen from below
+	/// </summary>
+	bool     Hemisphere = false;
+};
+
+/// <summary>
+/// Helper class for baking meshes into octahedral impostors at load time. The mesh is rendered from a
+/// sphere (or hemisphere) of views into a single atlas of albedo, object space normals and depth
+/// </summary>
+class ImpostorBaker
+{
+public:
+	/// <summary>
+	/// Bakes a mesh into a new impostor. Expects the mesh to use the VertexPosNormTexCol layout
+	/// </summary>
+	/// <param name="mesh">The mesh to bake</param>
+	/// <param name="diffuse">The diffuse texture to apply to the mesh, or nullptr for vertex colors only</param>
+	/// <param name="settings">The settings to bake with</param>
+	/// <returns>A new impostor, or nullptr if the mesh could not be baked</returns>
+	static Impostor::Sptr Bake(const VertexArrayObject::Sptr& mesh, const Texture2D::Sptr& diffuse, const ImpostorBakeSettings& settings = ImpostorBakeSettings());
+
+	/// <summary>
+	/// Releases the resources used by the baker
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Calculates a bounding sphere for a mesh by reading back it's position data from the GPU
+	/// </summary>
+	/// <param name="mesh">The mesh to calculate bounds for</param>
+	/// <param name="center">Receives the center of the sphere</param>
+	/// <param name="radius">Receives the radius of the sphere</param>
+	/// <returns>True if the mesh has position data, false if otherwise</returns>
+	static bool CalculateBounds(const VertexArrayObject::Sptr& mesh, glm::vec3& center, float& radius);
+
+protected:
+	static Shader::Sptr _bakeShader;
+};
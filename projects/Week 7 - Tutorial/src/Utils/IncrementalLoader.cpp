@@ -0,0 +1,227 @@
+#include "IncrementalLoader.h"
+#include <Logging.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <imgui.h>
+
+// The number of bytes of vertex data we upload in a single slice
+static const size_t UPLOAD_SLICE_BYTES = 256 * 1024;
+
+std::deque<LoaderTask::Sptr> IncrementalLoader::_tasks;
+float IncrementalLoader::_budget = 4.0f;
+size_t IncrementalLoader::_completedCount = 0;
+size_t IncrementalLoader::_queuedCount = 0;
+float IncrementalLoader::_lastUpdateMs = 0.0f;
+std::vector<std::string> IncrementalLoader::_failedTasks;
+
+template <typename T>
+static inline bool IsReady(const std::future<T>& future) {
+	return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool FunctionLoaderTask::Step() {
+	if (_func) {
+		_func();
+	}
+	_isDone = true;
+	return true;
+}
+
+bool LoopLoaderTask::Step() {
+	if (_next < _count) {
+		_func(_next);
+		_next++;
+	}
+	return _next >= _count;
+}
+
+bool WaitLoaderTask::Step() {
+	if (!_isReady()) {
+		return false;
+	}
+	if (_onReady) {
+		_onReady();
+	}
+	_isDone = true;
+	return true;
+}
+
+ShaderLoaderTask::ShaderLoaderTask(const std::string& vsPath, const std::string& fsPath, const std::function<void(const Shader::Sptr&)>& onLoaded) :
+	LoaderTask(vsPath + " + " + fsPath),
+	_vsPath(vsPath),
+	_fsPath(fsPath),
+	_onLoaded(onLoaded),
+	_shader(nullptr),
+	_stage(0)
+{ }
+
+bool ShaderLoaderTask::Step() {
+	switch (_stage) {
+		case 0:
+			_shader = Shader::Create();
+			_shader->LoadShaderPartFromFile(_vsPath.c_str(), ShaderPartType::Vertex);
+			break;
+		case 1:
+			_shader->LoadShaderPartFromFile(_fsPath.c_str(), ShaderPartType::Fragment);
+			break;
+		default:
+			_shader->Link();
+			if (_onLoaded) {
+				_onLoaded(_shader);
+			}
+			_stage = 3;
+			return true;
+	}
+	_stage++;
+	return false;
+}
+
+MeshLoaderTask::MeshLoaderTask(const std::string& name, const ParseFunc& parse, const std::function<void(const VertexArrayObject::Sptr&)>& onLoaded) :
+	LoaderTask(name),
+	_onLoaded(onLoaded),
+	_vertexBuffer(nullptr),
+	_uploadedVertices(0)
+{
+	_parseResult = std::async(std::launch::async, parse);
+}
+
+bool MeshLoaderTask::Step() {
+	if (_vertexBuffer == nullptr) {
+		if (!IsReady(_parseResult)) {
+			return false;
+		}
+		// If the parse threw, this will re-throw it on the main thread
+		_vertices = _parseResult.get();
+
+		// Allocate the buffer without any data, the ranges are copied in as we go
+		_vertexBuffer = VertexBuffer::Create();
+		_vertexBuffer->LoadData<VertexPosNormTexCol>(nullptr, _vertices.size());
+		return false;
+	}
+
+	const size_t sliceVertices = std::max<size_t>(UPLOAD_SLICE_BYTES / sizeof(VertexPosNormTexCol), 1);
+	const size_t count = std::min(_vertices.size() - _uploadedVertices, sliceVertices);
+	if (count > 0) {
+		_vertexBuffer->UpdateData(_vertices.data() + _uploadedVertices, sizeof(VertexPosNormTexCol), count, _uploadedVertices);
+		_uploadedVertices += count;
+	}
+
+	if (_uploadedVertices < _vertices.size()) {
+		return false;
+	}
+
+	// The VAO is only created once the buffer is full, so nothing can draw a half uploaded mesh
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(_vertexBuffer, VertexPosNormTexCol::V_DECL);
+	_vertices.clear();
+	_vertices.shrink_to_fit();
+	if (_onLoaded) {
+		_onLoaded(result);
+	}
+	return true;
+}
+
+float MeshLoaderTask::GetProgress() const {
+	if (_vertexBuffer == nullptr || _vertices.empty()) {
+		return _vertexBuffer == nullptr ? 0.0f : 1.0f;
+	}
+	return 0.5f + 0.5f * _uploadedVertices / static_cast<float>(_vertices.size());
+}
+
+bool MeshLoaderTask::IsWaiting() const {
+	return _vertexBuffer == nullptr && !IsReady(_parseResult);
+}
+
+void IncrementalLoader::Enqueue(const LoaderTask::Sptr& task) {
+	LOG_ASSERT(task != nullptr, "Cannot enqueue a null loader task!");
+	_tasks.push_back(task);
+	_queuedCount++;
+}
+
+bool IncrementalLoader::Update() {
+	auto start = std::chrono::high_resolution_clock::now();
+	float elapsed = 0.0f;
+
+	// The budget is checked after each slice, so we always make some progress even if the budget is tiny
+	while (!_tasks.empty() && !_tasks.front()->IsWaiting()) {
+		__StepFront();
+		elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (elapsed >= _budget) {
+			break;
+		}
+	}
+	_lastUpdateMs = elapsed;
+
+	return IsBusy();
+}
+
+void IncrementalLoader::Flush() {
+	while (!_tasks.empty()) {
+		if (_tasks.front()->IsWaiting()) {
+			std::this_thread::yield();
+			continue;
+		}
+		__StepFront();
+	}
+}
+
+float IncrementalLoader::GetProgress() {
+	if (_queuedCount == 0) {
+		return 100.0f;
+	}
+	float done = static_cast<float>(_completedCount);
+	if (!_tasks.empty()) {
+		done += _tasks.front()->GetProgress();
+	}
+	return 100.0f * done / _queuedCount;
+}
+
+std::string IncrementalLoader::GetCurrentTaskName() {
+	return _tasks.empty() ? std::string() : _tasks.front()->GetName();
+}
+
+void IncrementalLoader::DrawImGui() {
+	ImGui::DragFloat("Load Budget (ms)", &_budget, 0.1f, 0.1f, 100.0f);
+	if (IsBusy()) {
+		char overlay[32];
+		sprintf_s(overlay, "%.1f%%", GetProgress());
+		ImGui::ProgressBar(GetProgress() / 100.0f, ImVec2(-1.0f, 0.0f), overlay);
+		ImGui::Text("Loading: %s", GetCurrentTaskName().c_str());
+		ImGui::Text("%d tasks queued, %.2fms last frame", (int)_tasks.size(), _lastUpdateMs);
+	} else {
+		ImGui::Text("Loader idle");
+	}
+	if (!_failedTasks.empty()) {
+		ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%d tasks failed, see the log for details", (int)_failedTasks.size());
+		for (const std::string& name : _failedTasks) {
+			ImGui::BulletText("%s", name.c_str());
+		}
+		if (ImGui::Button("Clear Failures")) {
+			_failedTasks.clear();
+		}
+	}
+}
+
+void IncrementalLoader::__StepFront() {
+	// Hold a reference to the task, since completing it may queue more work behind it
+	LoaderTask::Sptr task = _tasks.front();
+	bool isDone;
+	try {
+		isDone = task->Step();
+	}
+	catch (const std::exception& e) {
+		LOG_ERROR("Loader task \"{}\" failed: {}", task->GetName(), e.what());
+		_failedTasks.push_back(task->GetName());
+		isDone = true;
+	}
+
+	if (isDone) {
+		_tasks.pop_front();
+		_completedCount++;
+		if (_tasks.empty()) {
+			_completedCount = _queuedCount = 0;
+		}
+	}
+}
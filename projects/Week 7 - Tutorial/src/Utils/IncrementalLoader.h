@@ -0,0 +1,275 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <future>
+
+#include "Graphics/Shader.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexBuffer.h"
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// A piece of loading work that has to run on the main thread, broken up so that it can be done a
+/// slice at a time. Each call to Step should only do a small, bounded amount of work, so that the
+/// loader can stop between slices once it's used up it's time for the frame
+/// </summary>
+class LoaderTask {
+public:
+	typedef std::shared_ptr<LoaderTask> Sptr;
+
+	virtual ~LoaderTask() = default;
+
+	/// <summary>
+	/// Does the next slice of work for this task
+	/// </summary>
+	/// <returns>True once the task has finished all of it's work</returns>
+	virtual bool Step() = 0;
+	/// <summary>
+	/// Gets how far along this task is, between 0 and 1
+	/// </summary>
+	virtual float GetProgress() const = 0;
+	/// <summary>
+	/// Returns true if the task is waiting on work in the background, and stepping it would not do anything
+	/// </summary>
+	virtual bool IsWaiting() const { return false; }
+
+	/// <summary>
+	/// Gets the name of this task, for displaying on load screens
+	/// </summary>
+	const std::string& GetName() const { return _name; }
+
+protected:
+	LoaderTask(const std::string& name) : _name(name) {}
+
+	std::string _name;
+};
+
+/// <summary>
+/// Runs a function as a single slice, for work that is already cheap or can't be broken up
+/// </summary>
+class FunctionLoaderTask : public LoaderTask {
+public:
+	typedef std::shared_ptr<FunctionLoaderTask> Sptr;
+
+	FunctionLoaderTask(const std::string& name, const std::function<void()>& func) : LoaderTask(name), _func(func), _isDone(false) {}
+
+	static inline Sptr Create(const std::string& name, const std::function<void()>& func) {
+		return std::make_shared<FunctionLoaderTask>(name, func);
+	}
+
+	virtual bool Step() override;
+	virtual float GetProgress() const override { return _isDone ? 1.0f : 0.0f; }
+
+protected:
+	std::function<void()> _func;
+	bool _isDone;
+};
+
+/// <summary>
+/// Runs a function once per slice for a fixed number of items, for work made up of lots of small pieces that
+/// don't depend on each other (ex: baking one object at a time)
+/// </summary>
+class LoopLoaderTask : public LoaderTask {
+public:
+	typedef std::shared_ptr<LoopLoaderTask> Sptr;
+
+	LoopLoaderTask(const std::string& name, size_t count, const std::function<void(size_t)>& func) : LoaderTask(name), _func(func), _count(count), _next(0) {}
+
+	/// <summary>
+	/// Creates a new looping task
+	/// </summary>
+	/// <param name="name">The name to display for the task</param>
+	/// <param name="count">The number of items to process</param>
+	/// <param name="func">Invoked once per slice with the index of the item to process</param>
+	static inline Sptr Create(const std::string& name, size_t count, const std::function<void(size_t)>& func) {
+		return std::make_shared<LoopLoaderTask>(name, count, func);
+	}
+
+	virtual bool Step() override;
+	virtual float GetProgress() const override { return _count == 0 ? 1.0f : _next / static_cast<float>(_count); }
+
+protected:
+	std::function<void(size_t)> _func;
+	size_t _count;
+	size_t _next;
+};
+
+/// <summary>
+/// Waits for some work outside of the loader to finish (ex: textures decoding on the streamer's threads) without
+/// blocking. The task reports that it's waiting until the condition is met, so the loader gives up the rest of
+/// the frame instead of stalling on it
+/// </summary>
+class WaitLoaderTask : public LoaderTask {
+public:
+	typedef std::shared_ptr<WaitLoaderTask> Sptr;
+
+	WaitLoaderTask(const std::string& name, const std::function<bool()>& isReady, const std::function<void()>& onReady) : LoaderTask(name), _isReady(isReady), _onReady(onReady), _isDone(false) {}
+
+	/// <summary>
+	/// Creates a new waiting task
+	/// </summary>
+	/// <param name="name">The name to display for the task</param>
+	/// <param name="isReady">Returns true once the work we're waiting on is done, this is polled so it should be cheap</param>
+	/// <param name="onReady">Invoked once the condition has been met, may be empty</param>
+	static inline Sptr Create(const std::string& name, const std::function<bool()>& isReady, const std::function<void()>& onReady = nullptr) {
+		return std::make_shared<WaitLoaderTask>(name, isReady, onReady);
+	}
+
+	virtual bool Step() override;
+	virtual float GetProgress() const override { return _isDone ? 1.0f : 0.0f; }
+	virtual bool IsWaiting() const override { return !_isReady(); }
+
+protected:
+	std::function<bool()> _isReady;
+	std::function<void()> _onReady;
+	bool _isDone;
+};
+
+/// <summary>
+/// Loads a shader program, compiling the vertex shader, fragment shader and linking the program in
+/// separate slices
+/// </summary>
+class ShaderLoaderTask : public LoaderTask {
+public:
+	typedef std::shared_ptr<ShaderLoaderTask> Sptr;
+
+	ShaderLoaderTask(const std::string& vsPath, const std::string& fsPath, const std::function<void(const Shader::Sptr&)>& onLoaded);
+
+	/// <summary>
+	/// Creates a new shader loading task
+	/// </summary>
+	/// <param name="vsPath">The path to the vertex shader</param>
+	/// <param name="fsPath">The path to the fragment shader</param>
+	/// <param name="onLoaded">Invoked with the shader once it has been linked</param>
+	static inline Sptr Create(const std::string& vsPath, const std::string& fsPath, const std::function<void(const Shader::Sptr&)>& onLoaded) {
+		return std::make_shared<ShaderLoaderTask>(vsPath, fsPath, onLoaded);
+	}
+
+	virtual bool Step() override;
+	virtual float GetProgress() const override { return _stage / 3.0f; }
+
+protected:
+	std::string _vsPath;
+	std::string _fsPath;
+	std::function<void(const Shader::Sptr&)> _onLoaded;
+	Shader::Sptr _shader;
+	int _stage;
+};
+
+/// <summary>
+/// Uploads a mesh that is parsed on a background thread (starting as soon as the task is created). Once the
+/// vertices are ready, the vertex buffer is allocated and filled in ranges, and the vertex array is only
+/// created once it's complete
+/// </summary>
+class MeshLoaderTask : public LoaderTask {
+public:
+	typedef std::shared_ptr<MeshLoaderTask> Sptr;
+	typedef std::function<std::vector<VertexPosNormTexCol>()> ParseFunc;
+
+	MeshLoaderTask(const std::string& name, const ParseFunc& parse, const std::function<void(const VertexArrayObject::Sptr&)>& onLoaded);
+
+	/// <summary>
+	/// Creates a new mesh loading task
+	/// </summary>
+	/// <param name="name">The name to display for the task, usually the mesh's path</param>
+	/// <param name="parse">Loads the mesh's vertices, this is run on a background thread so it must not make any OpenGL calls</param>
+	/// <param name="onLoaded">Invoked with the mesh once all of it's data has been uploaded</param>
+	static inline Sptr Create(const std::string& name, const ParseFunc& parse, const std::function<void(const VertexArrayObject::Sptr&)>& onLoaded) {
+		return std::make_shared<MeshLoaderTask>(name, parse, onLoaded);
+	}
+
+	virtual bool Step() override;
+	virtual float GetProgress() const override;
+	virtual bool IsWaiting() const override;
+
+protected:
+	std::function<void(const VertexArrayObject::Sptr&)> _onLoaded;
+	std::future<std::vector<VertexPosNormTexCol>> _parseResult;
+	std::vector<VertexPosNormTexCol> _vertices;
+	VertexBuffer::Sptr _vertexBuffer;
+	size_t _uploadedVertices;
+};
+
+/// <summary>
+/// Runs loading work on the main thread a little at a time. Tasks are run in the order they were queued,
+/// and every frame the loader works through as many slices as it can fit into it's time budget, so that a
+/// load screen (or the scene that is already running) keeps a steady frame rate while the next scene loads.
+///
+/// Anything that can happen off the main thread (parsing meshes) is kicked off in the background by the
+/// tasks themselves, the slices are only the parts that need the GL context. Textures don't need a task of their
+/// own, the TextureStreamer already decodes them in the background and only uploads their smallest mips up front.
+///
+/// Tasks that fail are logged and dropped, and their names are kept so that the failures can be reported
+/// </summary>
+class IncrementalLoader {
+public:
+	/// <summary>
+	/// Adds a task to the end of the queue
+	/// </summary>
+	static void Enqueue(const LoaderTask::Sptr& task);
+
+	/// <summary>
+	/// Runs queued tasks until the frame's time budget has been used up, should be called once per frame on
+	/// the main thread. At least one slice is always run, so loading still makes progress with a tiny budget. If the
+	/// task at the front of the queue is waiting on background work, we give up the rest of the frame rather than spin
+	/// </summary>
+	/// <returns>True if there is still work queued</returns>
+	static bool Update();
+	/// <summary>
+	/// Runs all queued tasks to completion, blocking until they're done
+	/// </summary>
+	static void Flush();
+
+	/// <summary>
+	/// Sets the number of milliseconds the loader can spend per frame
+	/// </summary>
+	static void SetBudget(float milliseconds) { _budget = milliseconds; }
+	static float GetBudget() { return _budget; }
+
+	/// <summary>
+	/// Returns true if there are any tasks still waiting to be run
+	/// </summary>
+	static bool IsBusy() { return !_tasks.empty(); }
+	/// <summary>
+	/// Gets how much of the queued work has been done, as a percentage. This covers all tasks queued since
+	/// the loader was last idle
+	/// </summary>
+	static float GetProgress();
+	/// <summary>
+	/// Gets the name of the task that is currently being run, or an empty string if the loader is idle
+	/// </summary>
+	static std::string GetCurrentTaskName();
+
+	/// <summary>
+	/// Gets the names of all tasks that have failed, since the failures were last cleared
+	/// </summary>
+	static const std::vector<std::string>& GetFailedTasks() { return _failedTasks; }
+	/// <summary>
+	/// Forgets about any tasks that have failed
+	/// </summary>
+	static void ClearFailedTasks() { _failedTasks.clear(); }
+
+	/// <summary>
+	/// Draws the loader's progress and budget controls in the current ImGui window
+	/// </summary>
+	static void DrawImGui();
+
+protected:
+	IncrementalLoader() = default;
+	~IncrementalLoader() = default;
+
+	static std::deque<LoaderTask::Sptr> _tasks;
+	static float _budget;
+	// Counts since the loader was last idle, for working out progress
+	static size_t _completedCount;
+	static size_t _queuedCount;
+	static float _lastUpdateMs;
+	static std::vector<std::string> _failedTasks;
+
+	// Runs a single slice of the task at the front of the queue. Tasks that throw are logged and dropped,
+	// so one bad file doesn't stop the rest of the load
+	static void __StepFront();
+};
@@ -0,0 +1,540 @@
+#include "LightmapBaker.h"
+#include "Utils/TriangleBVH.h"
+#include "Utils/MeshBuilder.h"
+#include "Utils/MeshReadback.h"
+#include "Utils/ParallelFor.h"
+#include "Graphics/VertexTypes.h"
+#include <Logging.h>
+
+#include <stb_rect_pack.h>
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <GLM/gtc/constants.hpp>
+
+// The number of texels a thread grabs at a time, must be a multiple of 4 so batches line up with our ray packets
+static const size_t TEXEL_BATCH = 64;
+// How much of the lightmap we aim to cover with charts on our first packing attempt
+static const float  TARGET_FILL = 0.7f;
+// How much we shrink the charts by each time they fail to pack
+static const float  PACK_SHRINK = 0.9f;
+static const int    MAX_PACK_ATTEMPTS = 64;
+// Positions closer than 1/WELD_SCALE are treated as the same vertex when finding a mesh's connectivity
+static const float  WELD_SCALE = 10000.0f;
+
+// The triangles of a single mesh, read back from the GPU. Every 3 vertices make a triangle
+struct BakeMesh {
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> UVs;
+	std::vector<glm::vec4> Colors;
+};
+
+// A group of connected triangles with similar normals, that get flattened into a single island in the lightmap
+struct Chart {
+	std::vector<uint32_t> Triangles;
+	glm::vec3 Normal;
+	glm::vec3 Tangent;
+	glm::vec3 Bitangent;
+	// The bounds of the flattened triangles, in world units
+	glm::vec2 Min;
+	glm::vec2 Max;
+};
+
+// A texel in the lightmap that is covered by a triangle
+struct Texel {
+	// The world position of the texel, pushed off the surface so rays don't hit it
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	uint32_t  Pixel;
+};
+
+struct WeldKeyHash {
+	size_t operator()(const glm::ivec3& key) const {
+		return (static_cast<size_t>(key.x) * 73856093u) ^ (static_cast<size_t>(key.y) * 19349663u) ^ (static_cast<size_t>(key.z) * 83492791u);
+	}
+};
+
+/// <summary>
+/// Builds an orthonormal basis around a normal
+/// </summary>
+static void MakeBasis(const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent) {
+	glm::vec3 helper = glm::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+	tangent = glm::normalize(glm::cross(helper, normal));
+	bitangent = glm::cross(normal, tangent);
+}
+
+/// <summary>
+/// Reads a mesh back from the GPU as a list of triangles
+/// </summary>
+/// <returns>True if the mesh could be read, false if otherwise</returns>
+static bool ReadMesh(const VertexArrayObject::Sptr& mesh, BakeMesh& result) {
+	MeshData data;
+	if (!MeshReadback::Read(mesh, data)) {
+		return false;
+	}
+
+	// Indexed meshes get expanded out, since we'll be splitting vertices along the chart seams anyways
+	size_t vertexCount = data.Indices.size();
+	result.Positions.resize(vertexCount);
+	result.Normals.resize(vertexCount);
+	result.UVs.resize(vertexCount);
+	result.Colors.resize(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		uint32_t index = data.Indices[ix];
+		result.Positions[ix] = data.Positions[index];
+		result.Normals[ix] = data.Normals[index];
+		result.UVs[ix] = data.UVs[index];
+		result.Colors[ix] = data.Colors[index];
+	}
+	return vertexCount > 0;
+}
+
+/// <summary>
+/// Groups a range of triangles into charts, by flood filling across shared edges as long as the triangles
+/// face within the chart angle of the triangle that started the chart. Keeping every triangle within the
+/// same cone means they can all be projected onto the seed's plane without flipping
+/// </summary>
+static void BuildCharts(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& faceNormals, uint32_t firstTri, uint32_t triCount, float minCos, std::vector<Chart>& charts) {
+	// Weld matching positions together, so we can find the triangles that share an edge
+	std::unordered_map<glm::ivec3, uint32_t, WeldKeyHash> weld;
+	std::vector<uint32_t> vertexIds(triCount * 3);
+	for (uint32_t ix = 0; ix < triCount * 3; ix++) {
+		glm::ivec3 key = glm::ivec3(glm::round(positions[firstTri * 3 + ix] * WELD_SCALE));
+		vertexIds[ix] = weld.emplace(key, static_cast<uint32_t>(weld.size())).first->second;
+	}
+
+	auto edgeKey = [&](uint32_t tri, int edge) -> uint64_t {
+		uint64_t a = vertexIds[tri * 3 + edge], b = vertexIds[tri * 3 + (edge + 1) % 3];
+		return a < b ? (a << 32) | b : (b << 32) | a;
+	};
+	std::unordered_map<uint64_t, std::vector<uint32_t>> edges;
+	for (uint32_t tri = 0; tri < triCount; tri++) {
+		for (int edge = 0; edge < 3; edge++) {
+			edges[edgeKey(tri, edge)].push_back(tri);
+		}
+	}
+
+	std::vector<bool> isAssigned(triCount, false);
+	std::vector<uint32_t> queue;
+	for (uint32_t seed = 0; seed < triCount; seed++) {
+		if (isAssigned[seed]) {
+			continue;
+		}
+		Chart chart;
+		chart.Normal = faceNormals[firstTri + seed];
+		isAssigned[seed] = true;
+		queue.push_back(seed);
+		while (!queue.empty()) {
+			uint32_t tri = queue.back();
+			queue.pop_back();
+			chart.Triangles.push_back(firstTri + tri);
+			for (int edge = 0; edge < 3; edge++) {
+				for (uint32_t neighbour : edges[edgeKey(tri, edge)]) {
+					if (!isAssigned[neighbour] && glm::dot(faceNormals[firstTri + neighbour], chart.Normal) >= minCos) {
+						isAssigned[neighbour] = true;
+						queue.push_back(neighbour);
+					}
+				}
+			}
+		}
+		charts.push_back(std::move(chart));
+	}
+}
+
+/// <summary>
+/// Tries to pack all of the charts into the lightmap at the given density
+/// </summary>
+/// <returns>True if every chart fit, false if otherwise</returns>
+static bool PackCharts(const std::vector<Chart>& charts, float texelsPerUnit, const LightmapBakeSettings& settings, std::vector<stbrp_rect>& rects) {
+	int resolution = static_cast<int>(settings.Resolution);
+	int padding = static_cast<int>(settings.Padding);
+	rects.resize(charts.size());
+	for (size_t ix = 0; ix < charts.size(); ix++) {
+		// We add a texel so that the chart's edges land inside the rect, plus our padding on either side
+		glm::vec2 size = (charts[ix].Max - charts[ix].Min) * texelsPerUnit;
+		int width = static_cast<int>(glm::ceil(size.x)) + 1 + padding * 2;
+		int height = static_cast<int>(glm::ceil(size.y)) + 1 + padding * 2;
+		if (width > resolution || height > resolution) {
+			return false;
+		}
+		rects[ix].id = static_cast<int>(ix);
+		rects[ix].w = static_cast<stbrp_coord>(width);
+		rects[ix].h = static_cast<stbrp_coord>(height);
+	}
+
+	std::vector<stbrp_node> nodes(resolution);
+	stbrp_context context;
+	stbrp_init_target(&context, resolution, resolution, nodes.data(), static_cast<int>(nodes.size()));
+	return stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size())) == 1;
+}
+
+/// <summary>
+/// Finds all the lightmap texels whose centers are covered by a triangle, and works out where they are in the world
+/// </summary>
+static void RasterizeTexels(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<glm::vec3>& faceNormals,
+							const std::vector<glm::vec2>& lightmapUVs, const LightmapBakeSettings& settings, std::vector<Texel>& texels, std::vector<uint8_t>& coverage) {
+	int resolution = static_cast<int>(settings.Resolution);
+	coverage.assign(settings.Resolution * settings.Resolution, 0);
+
+	auto edge = [](const glm::vec2& a, const glm::vec2& b, const glm::vec2& p) {
+		return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+	};
+
+	size_t triCount = positions.size() / 3;
+	for (size_t tri = 0; tri < triCount; tri++) {
+		// Work in texel space, with texel centers on integer coordinates
+		glm::vec2 p0 = lightmapUVs[tri * 3 + 0] * (float)resolution - 0.5f;
+		glm::vec2 p1 = lightmapUVs[tri * 3 + 1] * (float)resolution - 0.5f;
+		glm::vec2 p2 = lightmapUVs[tri * 3 + 2] * (float)resolution - 0.5f;
+		float area = edge(p0, p1, p2);
+		if (glm::abs(area) < 1e-12f) {
+			continue;
+		}
+
+		glm::vec2 min = glm::min(p0, glm::min(p1, p2));
+		glm::vec2 max = glm::max(p0, glm::max(p1, p2));
+		int x0 = glm::max(static_cast<int>(glm::floor(min.x)), 0), x1 = glm::min(static_cast<int>(glm::ceil(max.x)), resolution - 1);
+		int y0 = glm::max(static_cast<int>(glm::floor(min.y)), 0), y1 = glm::min(static_cast<int>(glm::ceil(max.y)), resolution - 1);
+
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				glm::vec2 p = glm::vec2(x, y);
+				float w0 = edge(p1, p2, p) / area;
+				float w1 = edge(p2, p0, p) / area;
+				float w2 = 1.0f - w0 - w1;
+				uint32_t pixel = y * resolution + x;
+				if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f || coverage[pixel]) {
+					continue;
+				}
+				coverage[pixel] = 1;
+
+				Texel texel;
+				texel.Pixel = pixel;
+				texel.Normal = normals[tri * 3] * w0 + normals[tri * 3 + 1] * w1 + normals[tri * 3 + 2] * w2;
+				float length = glm::length(texel.Normal);
+				texel.Normal = length > 0.0f ? texel.Normal / length : faceNormals[tri];
+				// Push off the surface along the geometric normal, flipped to the side our normals are facing
+				glm::vec3 offset = glm::dot(faceNormals[tri], texel.Normal) < 0.0f ? -faceNormals[tri] : faceNormals[tri];
+				texel.Position = positions[tri * 3] * w0 + positions[tri * 3 + 1] * w1 + positions[tri * 3 + 2] * w2 + offset * settings.RayBias;
+				texels.push_back(texel);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Grows the edges of each chart out into the padding around it, so that bilinear filtering and our bounce
+/// rays never read texels that weren't lit
+/// </summary>
+static void Dilate(std::vector<glm::vec3>& image, std::vector<uint8_t> coverage, uint32_t resolution, uint32_t passes) {
+	int size = static_cast<int>(resolution);
+	std::vector<glm::vec3> source;
+	std::vector<uint8_t> sourceCoverage;
+	for (uint32_t pass = 0; pass < passes; pass++) {
+		source = image;
+		sourceCoverage = coverage;
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				if (sourceCoverage[y * size + x]) {
+					continue;
+				}
+				glm::vec3 sum = glm::vec3(0.0f);
+				int count = 0;
+				for (int oy = glm::max(y - 1, 0); oy <= glm::min(y + 1, size - 1); oy++) {
+					for (int ox = glm::max(x - 1, 0); ox <= glm::min(x + 1, size - 1); ox++) {
+						if (sourceCoverage[oy * size + ox]) {
+							sum += source[oy * size + ox];
+							count++;
+						}
+					}
+				}
+				if (count > 0) {
+					image[y * size + x] = sum / (float)count;
+					coverage[y * size + x] = 1;
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Calculates the shadowed direct light reaching each texel, tracing one packet of 4 texels per light
+/// </summary>
+static void TraceDirect(const TriangleBVH& bvh, const std::vector<Texel>& texels, const std::vector<LightmapLight>& lights, uint32_t numThreads, std::vector<glm::vec3>& irradiance) {
+	ParallelFor(texels.size(), TEXEL_BATCH, numThreads, [&](size_t begin, size_t end) {
+		for (size_t first = begin; first < end; first += 4) {
+			size_t count = std::min<size_t>(4, end - first);
+			glm::vec3 result[4] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+			for (const LightmapLight& light : lights) {
+				RayPacket4 packet;
+				float contribution[4] = { 0.0f };
+				for (size_t lane = 0; lane < 4; lane++) {
+					if (lane >= count) {
+						packet.Set((int)lane, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0f);
+						continue;
+					}
+					const Texel& texel = texels[first + lane];
+					glm::vec3 toLight = light.Position - texel.Position;
+					float dist = glm::length(toLight);
+					float nDotL = dist > 0.0f ? glm::dot(texel.Normal, toLight / dist) : 0.0f;
+					// Same attenuation as frag_blinn_phong_textured.glsl
+					contribution[lane] = nDotL / (1.0f + light.Attenuation * dist * dist);
+					// We leave the direction un-normalized so that the light is at t = 1. Lanes facing away from the light are inactive
+					packet.Set((int)lane, texel.Position, toLight, nDotL > 0.0f ? 1.0f : 0.0f);
+				}
+				int occluded = bvh.OccludedPacket(packet);
+				for (size_t lane = 0; lane < count; lane++) {
+					if (packet.TMax[lane] > 0.0f && (occluded & (1 << lane)) == 0) {
+						result[lane] += light.Color * contribution[lane];
+					}
+				}
+			}
+			for (size_t lane = 0; lane < count; lane++) {
+				irradiance[texels[first + lane].Pixel] = result[lane];
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Calculates one bounce of indirect light for each texel, by tracing cosine weighted rays and picking up the
+/// light that was reflected off of whatever they hit in the previous pass. Each packet is 4 rays from the same texel
+/// </summary>
+static void TraceIndirect(const TriangleBVH& bvh, const std::vector<Texel>& texels, const std::vector<glm::vec3>& normals, const std::vector<glm::vec3>& albedo,
+						  const std::vector<glm::vec2>& lightmapUVs, const std::vector<glm::vec3>& previous, uint32_t resolution, uint32_t samples,
+						  uint32_t numThreads, uint32_t seed, std::vector<glm::vec3>& indirect) {
+	ParallelFor(texels.size(), TEXEL_BATCH, numThreads, [&](size_t begin, size_t end) {
+		// Seed from the batch rather than the thread, so that bakes are repeatable
+		std::mt19937 rng(seed ^ static_cast<uint32_t>(begin * 2654435761u));
+		std::uniform_real_distribution<float> random(0.0f, 1.0f);
+
+		for (size_t ix = begin; ix < end; ix++) {
+			const Texel& texel = texels[ix];
+			glm::vec3 tangent, bitangent;
+			MakeBasis(texel.Normal, tangent, bitangent);
+
+			glm::vec3 sum = glm::vec3(0.0f);
+			for (uint32_t sample = 0; sample < samples; sample += 4) {
+				RayPacket4 packet;
+				for (int lane = 0; lane < 4; lane++) {
+					float r1 = random(rng), r2 = random(rng);
+					float radius = glm::sqrt(r1);
+					float phi = glm::two_pi<float>() * r2;
+					glm::vec3 dir = tangent * (radius * glm::cos(phi)) + bitangent * (radius * glm::sin(phi)) + texel.Normal * glm::sqrt(glm::max(0.0f, 1.0f - r1));
+					packet.Set(lane, texel.Position, dir, FLT_MAX);
+				}
+
+				PacketHit4 hit;
+				int hitMask = bvh.IntersectPacket(packet, hit);
+				for (int lane = 0; lane < 4; lane++) {
+					if ((hitMask & (1 << lane)) == 0) {
+						continue;
+					}
+					uint32_t tri = hit.Triangle[lane];
+					float u = hit.U[lane], v = hit.V[lane], w = 1.0f - u - v;
+
+					// Rays that hit the back of a surface are inside of something, and don't pick up any light
+					glm::vec3 normal = normals[tri * 3] * w + normals[tri * 3 + 1] * u + normals[tri * 3 + 2] * v;
+					glm::vec3 dir = glm::vec3(packet.DirX[lane], packet.DirY[lane], packet.DirZ[lane]);
+					if (glm::dot(normal, dir) > 0.0f) {
+						continue;
+					}
+
+					glm::vec2 uv = lightmapUVs[tri * 3] * w + lightmapUVs[tri * 3 + 1] * u + lightmapUVs[tri * 3 + 2] * v;
+					int x = glm::clamp(static_cast<int>(uv.x * resolution), 0, static_cast<int>(resolution) - 1);
+					int y = glm::clamp(static_cast<int>(uv.y * resolution), 0, static_cast<int>(resolution) - 1);
+					glm::vec3 reflectance = albedo[tri * 3] * w + albedo[tri * 3 + 1] * u + albedo[tri * 3 + 2] * v;
+					sum += reflectance * previous[y * resolution + x];
+				}
+			}
+			// With cosine weighted samples, the PDF cancels out the cosine term and the 1/pi of the lambertian BRDF
+			indirect[texel.Pixel] = sum / (float)samples;
+		}
+	});
+}
+
+Texture2D::Sptr LightmapBaker::Bake(const std::vector<LightmapInstance>& instances, const std::vector<LightmapLight>& lights,
+									std::vector<VertexArrayObject::Sptr>& outMeshes, const LightmapBakeSettings& settings) {
+	LOG_ASSERT(settings.Resolution > 0, "Lightmap resolution must be greater than zero!");
+	auto startTime = std::chrono::high_resolution_clock::now();
+	outMeshes.assign(instances.size(), nullptr);
+
+	uint32_t numThreads = settings.NumThreads > 0 ? settings.NumThreads : std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t samples = std::max((settings.IndirectSamples + 3u) & ~3u, 4u);
+	uint32_t resolution = settings.Resolution;
+
+	// Gather all our triangles into world space, we'll keep the object space meshes around to build the output meshes
+	std::vector<BakeMesh> meshes(instances.size());
+	std::vector<uint32_t> firstTriangle(instances.size(), 0);
+	std::vector<glm::vec3> positions, normals, faceNormals, albedo;
+	for (size_t ix = 0; ix < instances.size(); ix++) {
+		firstTriangle[ix] = static_cast<uint32_t>(positions.size() / 3);
+		if (instances[ix].Mesh == nullptr || !ReadMesh(instances[ix].Mesh, meshes[ix])) {
+			LOG_WARN("Skipping lightmap instance {}, could not read it's mesh", ix);
+			meshes[ix] = BakeMesh();
+			continue;
+		}
+
+		const BakeMesh& mesh = meshes[ix];
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instances[ix].Transform)));
+		for (size_t vert = 0; vert < mesh.Positions.size(); vert++) {
+			positions.push_back(glm::vec3(instances[ix].Transform * glm::vec4(mesh.Positions[vert], 1.0f)));
+			glm::vec3 normal = normalMatrix * mesh.Normals[vert];
+			normals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f));
+			albedo.push_back(instances[ix].Albedo * glm::vec3(mesh.Colors[vert]));
+		}
+	}
+	size_t triCount = positions.size() / 3;
+	if (triCount == 0) {
+		LOG_WARN("Nothing to bake into the lightmap!");
+		return nullptr;
+	}
+
+	faceNormals.resize(triCount);
+	for (size_t tri = 0; tri < triCount; tri++) {
+		glm::vec3 normal = glm::cross(positions[tri * 3 + 1] - positions[tri * 3], positions[tri * 3 + 2] - positions[tri * 3]);
+		float length = glm::length(normal);
+		faceNormals[tri] = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+		// Meshes without normals get flat shading
+		for (int corner = 0; corner < 3; corner++) {
+			if (normals[tri * 3 + corner] == glm::vec3(0.0f)) {
+				normals[tri * 3 + corner] = faceNormals[tri];
+			}
+		}
+	}
+
+	// Split each instance into charts, and flatten them onto their planes
+	std::vector<Chart> charts;
+	float minCos = glm::cos(glm::radians(settings.ChartAngle));
+	for (size_t ix = 0; ix < instances.size(); ix++) {
+		uint32_t count = static_cast<uint32_t>(meshes[ix].Positions.size() / 3);
+		if (count > 0) {
+			BuildCharts(positions, faceNormals, firstTriangle[ix], count, minCos, charts);
+		}
+	}
+	std::vector<glm::vec2> chartCoords(positions.size());
+	float chartArea = 0.0f;
+	for (Chart& chart : charts) {
+		MakeBasis(chart.Normal, chart.Tangent, chart.Bitangent);
+		chart.Min = glm::vec2(FLT_MAX);
+		chart.Max = glm::vec2(-FLT_MAX);
+		for (uint32_t tri : chart.Triangles) {
+			for (int corner = 0; corner < 3; corner++) {
+				const glm::vec3& pos = positions[tri * 3 + corner];
+				glm::vec2 coord = glm::vec2(glm::dot(pos, chart.Tangent), glm::dot(pos, chart.Bitangent));
+				chartCoords[tri * 3 + corner] = coord;
+				chart.Min = glm::min(chart.Min, coord);
+				chart.Max = glm::max(chart.Max, coord);
+			}
+		}
+		glm::vec2 size = chart.Max - chart.Min;
+		chartArea += size.x * size.y;
+	}
+
+	// Guess a density that fills most of the lightmap, and shrink it until everything fits
+	float texelsPerUnit = glm::sqrt(TARGET_FILL * resolution * resolution / glm::max(chartArea, 1e-6f));
+	std::vector<stbrp_rect> rects;
+	bool isPacked = false;
+	for (int attempt = 0; attempt < MAX_PACK_ATTEMPTS && !isPacked; attempt++) {
+		isPacked = PackCharts(charts, texelsPerUnit, settings, rects);
+		if (!isPacked) {
+			texelsPerUnit *= PACK_SHRINK;
+		}
+	}
+	if (!isPacked) {
+		LOG_WARN("Could not fit {} charts into a {}x{} lightmap, try a higher resolution", charts.size(), resolution, resolution);
+		return nullptr;
+	}
+
+	std::vector<glm::vec2> lightmapUVs(positions.size());
+	for (size_t ix = 0; ix < charts.size(); ix++) {
+		const Chart& chart = charts[ix];
+		glm::vec2 origin = glm::vec2(rects[ix].x + settings.Padding + 0.5f, rects[ix].y + settings.Padding + 0.5f);
+		for (uint32_t tri : chart.Triangles) {
+			for (int corner = 0; corner < 3; corner++) {
+				glm::vec2 texel = origin + (chartCoords[tri * 3 + corner] - chart.Min) * texelsPerUnit;
+				lightmapUVs[tri * 3 + corner] = texel / (float)resolution;
+			}
+		}
+	}
+
+	std::vector<Texel> texels;
+	std::vector<uint8_t> coverage;
+	RasterizeTexels(positions, normals, faceNormals, lightmapUVs, settings, texels, coverage);
+
+	// Only static geometry goes in the BVH, so only static geometry casts shadows or bounces light
+	TriangleBVH bvh;
+	bvh.Build(positions);
+
+	std::vector<glm::vec3> direct(resolution * resolution, glm::vec3(0.0f));
+	TraceDirect(bvh, texels, lights, numThreads, direct);
+
+	// Each bounce gathers the light reflected by the surfaces it hits in the previous pass
+	std::vector<glm::vec3> total = direct;
+	std::vector<glm::vec3> indirect(resolution * resolution, glm::vec3(0.0f));
+	for (uint32_t bounce = 0; bounce < settings.Bounces; bounce++) {
+		std::vector<glm::vec3> previous = total;
+		Dilate(previous, coverage, resolution, settings.Padding + 1);
+		TraceIndirect(bvh, texels, normals, albedo, lightmapUVs, previous, resolution, samples, numThreads, bounce * 7919u + 1u, indirect);
+		for (const Texel& texel : texels) {
+			total[texel.Pixel] = direct[texel.Pixel] + indirect[texel.Pixel];
+		}
+	}
+	Dilate(total, coverage, resolution, settings.Padding + 1);
+
+	// Encode as RGBM so we can store values brighter than 1 in an 8 bit texture
+	std::vector<uint8_t> pixels(resolution * resolution * 4);
+	for (size_t ix = 0; ix < total.size(); ix++) {
+		glm::vec3 color = total[ix] / RGBM_RANGE;
+		float m = glm::clamp(glm::max(color.r, glm::max(color.g, color.b)), 1e-6f, 1.0f);
+		m = glm::ceil(m * 255.0f) / 255.0f;
+		color = glm::clamp(color / m, 0.0f, 1.0f);
+		pixels[ix * 4 + 0] = static_cast<uint8_t>(color.r * 255.0f + 0.5f);
+		pixels[ix * 4 + 1] = static_cast<uint8_t>(color.g * 255.0f + 0.5f);
+		pixels[ix * 4 + 2] = static_cast<uint8_t>(color.b * 255.0f + 0.5f);
+		pixels[ix * 4 + 3] = static_cast<uint8_t>(m * 255.0f + 0.5f);
+	}
+
+	if (!settings.OutputPath.empty()) {
+		// Our rows are bottom up like OpenGL, image files are top down
+		stbi_flip_vertically_on_write(true);
+		if (stbi_write_png(settings.OutputPath.c_str(), resolution, resolution, 4, pixels.data(), resolution * 4) == 0) {
+			LOG_WARN("Failed to write lightmap to \"{}\"", settings.OutputPath);
+		}
+	}
+
+	Texture2DDescription desc;
+	desc.Width = resolution;
+	desc.Height = resolution;
+	desc.Format = InternalFormat::RGBA8;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	Texture2D::Sptr result = std::make_shared<Texture2D>(desc);
+	result->LoadData(resolution, resolution, PixelFormat::RGBA, PixelType::UByte, pixels.data());
+	// Lightmaps only have a single mip level
+	glTextureParameteri(result->GetHandle(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(result->GetHandle(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Build new meshes with the lightmap UVs. The charts split vertices along their seams, so these aren't indexed
+	for (size_t ix = 0; ix < instances.size(); ix++) {
+		const BakeMesh& mesh = meshes[ix];
+		if (mesh.Positions.empty()) {
+			continue;
+		}
+		MeshBuilder<VertexPosNormTexColLm> builder(BuilderStorage::Staging, mesh.Positions.size());
+		for (size_t vert = 0; vert < mesh.Positions.size(); vert++) {
+			builder.AddVertex(mesh.Positions[vert], mesh.Normals[vert], mesh.UVs[vert], mesh.Colors[vert], lightmapUVs[firstTriangle[ix] * 3 + vert]);
+		}
+		outMeshes[ix] = builder.Bake();
+	}
+
+	float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - startTime).count();
+	LOG_INFO("Baked {}x{} lightmap in {:.2f}s ({} triangles, {} charts, {} texels, {} threads)", resolution, resolution, seconds, triCount, charts.size(), texels.size(), numThreads);
+	return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <string>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/Texture2D.h"
+
+/// <summary>
+/// Settings for baking a lightmap
+/// </summary>
+struct LightmapBakeSettings {
+	/// <summary>
+	/// The width and height of the lightmap, in texels
+	/// </summary>
+	uint32_t    Resolution = 512;
+	/// <summary>
+	/// The number of empty texels we keep around each chart, which get filled with the chart's edge
+	/// colors so that bilinear filtering doesn't bleed between charts
+	/// </summary>
+	uint32_t    Padding = 2;
+	/// <summary>
+	/// The largest angle between two triangles' normals that can be in the same chart, in degrees
+	/// </summary>
+	float       ChartAngle = 45.0f;
+	/// <summary>
+	/// The number of rays we trace per texel for each bounce of indirect light, rounded up to a multiple of 4
+	/// </summary>
+	uint32_t    IndirectSamples = 64;
+	/// <summary>
+	/// The number of times light bounces off surfaces, or 0 for direct light only
+	/// </summary>
+	uint32_t    Bounces = 1;
+	/// <summary>
+	/// The number of threads to trace with, or 0 to use every core
+	/// </summary>
+	uint32_t    NumThreads = 0;
+	/// <summary>
+	/// How far we push rays off of surfaces so they don't hit the surface they started on
+	/// </summary>
+	float       RayBias = 0.001f;
+	/// <summary>
+	/// The file to write the lightmap to, or empty to skip saving it
+	/// </summary>
+	std::string OutputPath = "lightmap.png";
+};
+
+/// <summary>
+/// A mesh in the scene that should receive baked lighting
+/// </summary>
+struct LightmapInstance {
+	VertexArrayObject::Sptr Mesh;
+	glm::mat4               Transform = glm::mat4(1.0f);
+	// How much light the surface reflects, multiplied with the vertex colors, used for bounce lighting
+	glm::vec3               Albedo = glm::vec3(0.6f);
+};
+
+/// <summary>
+/// A point light to bake into the lightmap, matches the light model in frag_blinn_phong_textured.glsl
+/// </summary>
+struct LightmapLight {
+	glm::vec3 Position;
+	glm::vec3 Color;
+	float     Attenuation;
+};
+
+/// <summary>
+/// Helper class for baking static diffuse lighting into a lightmap. Each mesh is split into charts of similarly
+/// facing triangles, which are flattened and packed into a single atlas to give every surface a unique second
+/// set of UVs. Every texel of the atlas is then lit by tracing rays against a BVH of the scene on all of our cores,
+/// giving us shadowed direct light and any number of bounces of indirect light
+/// </summary>
+class LightmapBaker
+{
+public:
+	/// <summary>
+	/// Bakes lighting for a set of static meshes, which will all cast shadows onto each other
+	/// </summary>
+	/// <param name="instances">The meshes to bake, these should use the VertexPosNormTexCol layout</param>
+	/// <param name="lights">The lights to bake</param>
+	/// <param name="outMeshes">Receives a copy of each instance's mesh with lightmap UVs (VertexPosNormTexColLm), or nullptr if it could not be baked</param>
+	/// <param name="settings">The settings to bake with</param>
+	/// <returns>The RGBM encoded lightmap, or nullptr if nothing could be baked</returns>
+	static Texture2D::Sptr Bake(const std::vector<LightmapInstance>& instances, const std::vector<LightmapLight>& lights,
+								std::vector<VertexArrayObject::Sptr>& outMeshes, const LightmapBakeSettings& settings = LightmapBakeSettings());
+
+	/// <summary>
+	/// The largest value that can be stored in our RGBM lightmaps, must match frag_lightmapped.glsl
+	/// </summary>
+	static constexpr float RGBM_RANGE = 8.0f;
+
+protected:
+	LightmapBaker() = default;
+	~LightmapBaker() = default;
+};
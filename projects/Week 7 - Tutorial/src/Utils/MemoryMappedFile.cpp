@@ -0,0 +1,97 @@
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::~MemoryMappedFile() {
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MemoryMappedFile::Open(const std::string& path) {
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_fileHandle = file;
+	_mappingHandle = mapping;
+	_data = static_cast<const uint8_t*>(data);
+	_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+		CloseHandle(_mappingHandle);
+		CloseHandle(_fileHandle);
+	}
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = _mappingHandle = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const std::string& path) {
+	Close();
+
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping holds it's own reference to the file, so we don't need to keep the descriptor around
+	close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+	_data = static_cast<const uint8_t*>(data);
+	_size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	_data = nullptr;
+	_size = 0;
+}
+
+#endif
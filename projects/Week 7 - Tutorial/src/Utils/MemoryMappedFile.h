@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// A read-only view of a file that is mapped into memory, so that loaders can read binary records straight out
+/// of the OS's page cache instead of copying them through a stream. The mapping is released when the object
+/// is destroyed
+/// </summary>
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile() = default;
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+	/// <summary>
+	/// Maps the given file into memory, closing any file that was already open
+	/// </summary>
+	/// <param name="path">The path to the file to map</param>
+	/// <returns>True if the file was mapped, false if it could not be opened or is empty</returns>
+	bool Open(const std::string& path);
+	/// <summary>
+	/// Unmaps the file, any pointers into it's data are invalid after this
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return _data != nullptr; }
+	const uint8_t* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+protected:
+	const uint8_t* _data = nullptr;
+	size_t         _size = 0;
+
+	#ifdef _WIN32
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+	#endif
+};
@@ -1,19 +1,36 @@
 #pragma once
 #include <vector>
 #include "Graphics/VertexArrayObject.h"
+#include "Utils/StagingAllocator.h"
 
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
-/// vertex buffers
+/// vertex buffers. When created with BuilderStorage::Staging, the mesh data is written directly into mapped
+/// GPU visible memory, and Bake copies it into the final buffers without going through the driver's upload path
 /// </summary>
 /// <typeparam name="VertType">The type of vertex that this mesh is using</typeparam>
 template <typename VertType>
 class MeshBuilder
 {
 public:
-	MeshBuilder() :
-		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
+	typedef std::vector<VertType, StagingAllocator<VertType>> VertexList;
+	typedef std::vector<uint32_t, StagingAllocator<uint32_t>> IndexList;
+
+	/// <summary>
+	/// Creates a new mesh builder
+	/// </summary>
+	/// <param name="storage">Where to keep the mesh data while it is being built</param>
+	/// <param name="vertexEstimate">The number of vertices to reserve space for up front</param>
+	/// <param name="indexEstimate">The number of indices to reserve space for up front</param>
+	MeshBuilder(BuilderStorage storage = BuilderStorage::Heap, size_t vertexEstimate = 0, size_t indexEstimate = 0) :
+		_vertices(VertexList(StagingAllocator<VertType>(storage))),
+		_indices(IndexList(StagingAllocator<uint32_t>(storage))),
+		_storage(storage)
+	{
+		// Growing a staging vector means copying into a new range of the pool, so good estimates matter a lot more there
+		_vertices.reserve(vertexEstimate);
+		_indices.reserve(indexEstimate);
+	}
 	~MeshBuilder() = default;
 
 	/// <summary>
@@ -32,12 +49,10 @@ public:
 	/// <param name="data">The array of vertices to add to this mesh</param>
 	/// <param name="count">The number of verties in data</param>
 	/// <returns>The starting index in the mesh for the range of data</returns>
-	uint32_t AddVertexRange(const VertType* data, uint32_t count) {
-		uint32_t index = _vertices.size();
-		// Reserve space for the incoming vertices, ensures the underlying datastore will be large enough
-		_vertices.reserve(_vertices.size() + count);
-		// We can use memcpy to efficiently copy the incoming buffer data to the underlying data store
-		memcpy(_vertices.data() + (_vertices.size() * sizeof(VertType)), data, count * sizeof(VertType));
+	uint32_t AddVertexRange(const VertType* data, size_t count) {
+		uint32_t index = static_cast<uint32_t>(_vertices.size());
+		// Insert will grow the store if needed and copy the range in a single pass
+		_vertices.insert(_vertices.end(), data, data + count);
 		// Return the index of the start of the range
 		return index;
 	}
@@ -70,6 +85,22 @@ public:
 		_indices.push_back(index);
 	}
 
+	/// <summary>
+	/// Adds a range of indices to the index buffer
+	/// </summary>
+	/// <param name="data">The array of indices to add</param>
+	/// <param name="count">The number of indices in data</param>
+	/// <param name="baseVertex">A value to add to every index, such as the result of AddVertexRange</param>
+	void AddIndexRange(const uint32_t* data, size_t count, uint32_t baseVertex = 0) {
+		size_t start = _indices.size();
+		_indices.insert(_indices.end(), data, data + count);
+		if (baseVertex != 0) {
+			for (size_t ix = start; ix < _indices.size(); ix++) {
+				_indices[ix] += baseVertex;
+			}
+		}
+	}
+
 	/// <summary>
 	/// Adds a triangle between the three indices
 	/// </summary>
@@ -122,12 +153,23 @@ public:
 	/// <returns>A VertexArrayObject</returns>
 	VertexArrayObject::Sptr Bake() {
 		VertexBuffer::Sptr vbo = VertexBuffer::Create();
-		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
-
 		IndexBuffer::Sptr ebo = nullptr;
 		if (_indices.size() > 0) {
 			ebo = IndexBuffer::Create();
-			ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		}
+
+		// Staged data is already sitting in a GL buffer, so we can have the GPU copy it over for us
+		if (_storage == BuilderStorage::Staging && _vertices.size() > 0) {
+			vbo->LoadDataFromBuffer(StagingBufferPool::GetHandle(_vertices.data()), sizeof(VertType), _vertices.size(), StagingBufferPool::GetOffset(_vertices.data()));
+		} else {
+			vbo->LoadData(GetVertexDataPtr(), _vertices.size());
+		}
+		if (ebo != nullptr) {
+			if (_storage == BuilderStorage::Staging) {
+				ebo->LoadDataFromBuffer(StagingBufferPool::GetHandle(_indices.data()), sizeof(uint32_t), _indices.size(), IndexType::UInt, StagingBufferPool::GetOffset(_indices.data()));
+			} else {
+				ebo->LoadData(GetIndexDataPtr(), _indices.size());
+			}
 		}
 
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
@@ -137,6 +179,11 @@ public:
 		return result;
 	}
 	
+	/// <summary>
+	/// Returns where this builder is keeping its mesh data
+	/// </summary>
+	BuilderStorage GetStorage() const { return _storage; }
+
 	/// <summary>
 	/// Gets a pointer to the underlying vertex data in the mesh, valid only
 	/// until another call to AddVertex
@@ -155,6 +202,7 @@ public:
 protected:
 	friend class MeshFactory;
 	
-	std::vector<VertType> _vertices;
-	std::vector<uint32_t> _indices;
+	VertexList     _vertices;
+	IndexList      _indices;
+	BuilderStorage _storage;
 };
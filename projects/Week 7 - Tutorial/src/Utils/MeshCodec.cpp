@@ -0,0 +1,652 @@
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+// The number of payload bytes for each of a group's bit widths (0, 2, 4 and 8 bits per byte)
+static const size_t MODE_PAYLOAD[4] = { 0, 4, 8, 16 };
+
+// The largest value we quantize to, we use the full range of a uint16
+static const float QUANTIZE_MAX = 65535.0f;
+
+static inline uint16_t Quantize(float value, float min, float scale) {
+	if (scale <= 0.0f) {
+		return 0;
+	}
+	float result = std::round((value - min) / scale);
+	return static_cast<uint16_t>(std::min(std::max(result, 0.0f), QUANTIZE_MAX));
+}
+
+static inline uint8_t QuantizeUnorm8(float value) {
+	return static_cast<uint8_t>(std::min(std::max(std::round(value * 255.0f), 0.0f), 255.0f));
+}
+
+// Folds a unit vector onto an octahedron and unwraps it into a square, so it can be stored as 2 values
+static inline glm::vec2 OctEncode(const glm::vec3& normal) {
+	float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (l1 <= 0.0f) {
+		return glm::vec2(0.0f);
+	}
+	glm::vec3 n = normal / l1;
+	glm::vec2 result = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		result.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		result.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return result;
+}
+
+static inline uint16_t ZigZag16(uint16_t delta) {
+	return static_cast<uint16_t>((delta << 1) ^ static_cast<uint16_t>(static_cast<int16_t>(delta) >> 15));
+}
+
+void MeshCodec::Encode(const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& sourceIndices, std::vector<uint8_t>& result) {
+	result.clear();
+	const size_t count = vertices.size();
+
+	// Put the triangles in vertex cache order first, which is also the order the index coding compresses best
+	std::vector<uint32_t> indices(sourceIndices);
+	__OptimizeTriangleOrder(indices, count);
+
+	// Put the vertices in the order the indices first use them, so new vertices always come next in the index
+	// stream and neighbouring vertices are close together in space. Unused vertices go at the end
+	std::vector<uint32_t> remap(count, UINT32_MAX);
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	for (uint32_t index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(order.size());
+			order.push_back(index);
+		}
+	}
+	for (uint32_t ix = 0; ix < count; ix++) {
+		if (remap[ix] == UINT32_MAX) {
+			remap[ix] = static_cast<uint32_t>(order.size());
+			order.push_back(ix);
+		}
+	}
+
+	glm::vec3 posMin = glm::vec3(0.0f), posMax = glm::vec3(0.0f);
+	glm::vec2 uvMin = glm::vec2(0.0f), uvMax = glm::vec2(0.0f);
+	if (count > 0) {
+		posMin = posMax = vertices[0].Position;
+		uvMin = uvMax = vertices[0].UV;
+		for (const VertexPosNormTexCol& vertex : vertices) {
+			posMin = glm::min(posMin, vertex.Position);
+			posMax = glm::max(posMax, vertex.Position);
+			uvMin = glm::min(uvMin, vertex.UV);
+			uvMax = glm::max(uvMax, vertex.UV);
+		}
+	}
+
+	Header header;
+	header.VertexCount = static_cast<uint32_t>(count);
+	header.IndexCount = static_cast<uint32_t>(indices.size());
+	header.PositionMin = posMin;
+	header.PositionScale = (posMax - posMin) / QUANTIZE_MAX;
+	header.UVMin = uvMin;
+	header.UVScale = (uvMax - uvMin) / QUANTIZE_MAX;
+	result.resize(sizeof(Header));
+	memcpy(result.data(), &header, sizeof(Header));
+
+	// Quantize every vertex into it's channels, in their new order
+	const size_t groups = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+	const size_t padded = groups * GROUP_SIZE;
+	std::vector<uint16_t> channels(CHANNELS * padded, 0);
+	for (size_t ix = 0; ix < count; ix++) {
+		const VertexPosNormTexCol& vertex = vertices[order[ix]];
+		glm::vec2 oct = OctEncode(vertex.Normal);
+		uint16_t values[CHANNELS] = {
+			Quantize(vertex.Position.x, posMin.x, header.PositionScale.x),
+			Quantize(vertex.Position.y, posMin.y, header.PositionScale.y),
+			Quantize(vertex.Position.z, posMin.z, header.PositionScale.z),
+			Quantize(oct.x, -1.0f, 2.0f / QUANTIZE_MAX),
+			Quantize(oct.y, -1.0f, 2.0f / QUANTIZE_MAX),
+			Quantize(vertex.UV.x, uvMin.x, header.UVScale.x),
+			Quantize(vertex.UV.y, uvMin.y, header.UVScale.y),
+			static_cast<uint16_t>(QuantizeUnorm8(vertex.Color.r) | (QuantizeUnorm8(vertex.Color.g) << 8)),
+			static_cast<uint16_t>(QuantizeUnorm8(vertex.Color.b) | (QuantizeUnorm8(vertex.Color.a) << 8))
+		};
+		for (size_t channel = 0; channel < CHANNELS; channel++) {
+			channels[channel * padded + ix] = values[channel];
+		}
+	}
+
+	// Delta encode each channel against the previous vertex, and split the deltas into a low and high byte plane
+	std::vector<uint8_t> low(padded), high(padded);
+	for (size_t channel = 0; channel < CHANNELS; channel++) {
+		const uint16_t* values = &channels[channel * padded];
+		uint16_t previous = 0;
+		for (size_t ix = 0; ix < padded; ix++) {
+			// The padding repeats the last value, so it's deltas are all zero
+			uint16_t value = ix < count ? values[ix] : previous;
+			uint16_t delta = ZigZag16(static_cast<uint16_t>(value - previous));
+			low[ix] = static_cast<uint8_t>(delta & 0xFF);
+			high[ix] = static_cast<uint8_t>(delta >> 8);
+			previous = value;
+		}
+		__EncodePlane(low.data(), groups, result);
+		__EncodePlane(high.data(), groups, result);
+	}
+
+	std::vector<uint32_t> remapped(indices.size());
+	for (size_t ix = 0; ix < indices.size(); ix++) {
+		remapped[ix] = remap[indices[ix]];
+	}
+	__EncodeIndices(remapped, result);
+}
+
+bool MeshCodec::Decode(const uint8_t* data, size_t size, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	if (size < sizeof(Header)) {
+		return false;
+	}
+	Header header;
+	memcpy(&header, data, sizeof(Header));
+	const uint8_t* cursor = data + sizeof(Header);
+	const uint8_t* end = data + size;
+
+	// Every plane needs at least it's mode bytes, and every triangle at least one byte (a triangle that shares
+	// an edge and a cached vertex with a recent one is a single byte), so we can reject bad counts before
+	// allocating anything for them
+	const size_t count = header.VertexCount;
+	const size_t groups = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+	const size_t padded = groups * GROUP_SIZE;
+	if (((groups + 3) / 4) * CHANNELS * 2 + header.IndexCount / 3 > static_cast<size_t>(end - cursor)) {
+		return false;
+	}
+
+	// Decode each channel's planes, then undo the zigzag and delta encoding 8 values at a time
+	std::vector<uint8_t> low(padded), high(padded);
+	std::vector<uint16_t> channels(CHANNELS * padded);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	for (size_t channel = 0; channel < CHANNELS; channel++) {
+		if (!__DecodePlane(cursor, end, low.data(), groups) || !__DecodePlane(cursor, end, high.data(), groups)) {
+			return false;
+		}
+		uint16_t* values = &channels[channel * padded];
+		__m128i previous = zero;
+		for (size_t ix = 0; ix < padded; ix += 8) {
+			__m128i delta = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&low[ix])), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&high[ix])));
+			delta = _mm_xor_si128(_mm_srli_epi16(delta, 1), _mm_sub_epi16(zero, _mm_and_si128(delta, one)));
+			// Prefix sum across the 8 lanes, then carry on from the last value of the previous 8
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 2));
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 4));
+			delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 8));
+			__m128i result = _mm_add_epi16(delta, previous);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&values[ix]), result);
+			previous = _mm_shufflehi_epi16(result, _MM_SHUFFLE(3, 3, 3, 3));
+			previous = _mm_unpackhi_epi64(previous, previous);
+		}
+	}
+
+	// Dequantize 4 vertices at a time, the channels are padded so we never read past them
+	vertices.resize(count);
+	const __m128 posMin[3] = { _mm_set1_ps(header.PositionMin.x), _mm_set1_ps(header.PositionMin.y), _mm_set1_ps(header.PositionMin.z) };
+	const __m128 posScale[3] = { _mm_set1_ps(header.PositionScale.x), _mm_set1_ps(header.PositionScale.y), _mm_set1_ps(header.PositionScale.z) };
+	const __m128 uvMin[2] = { _mm_set1_ps(header.UVMin.x), _mm_set1_ps(header.UVMin.y) };
+	const __m128 uvScale[2] = { _mm_set1_ps(header.UVScale.x), _mm_set1_ps(header.UVScale.y) };
+	const __m128 octScale = _mm_set1_ps(2.0f / QUANTIZE_MAX);
+	const __m128 octOffset = _mm_set1_ps(-1.0f);
+	const __m128 colorScale = _mm_set1_ps(1.0f / 255.0f);
+	const __m128 oneF = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	for (size_t ix = 0; ix < count; ix += 4) {
+		auto load = [&](size_t channel) {
+			__m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&channels[channel * padded + ix]));
+			return _mm_unpacklo_epi16(values, zero);
+		};
+
+		float lanes[12][4];
+		for (int axis = 0; axis < 3; axis++) {
+			_mm_storeu_ps(lanes[axis], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(load(axis)), posScale[axis]), posMin[axis]));
+		}
+
+		// Unfold the octahedral normals and re-normalize them
+		__m128 nx = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(load(3)), octScale), octOffset);
+		__m128 ny = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(load(4)), octScale), octOffset);
+		__m128 nz = _mm_sub_ps(_mm_sub_ps(oneF, _mm_andnot_ps(signMask, nx)), _mm_andnot_ps(signMask, ny));
+		__m128 fold = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), nz), _mm_setzero_ps());
+		nx = _mm_sub_ps(nx, _mm_xor_ps(fold, _mm_and_ps(nx, signMask)));
+		ny = _mm_sub_ps(ny, _mm_xor_ps(fold, _mm_and_ps(ny, signMask)));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+		_mm_storeu_ps(lanes[3], _mm_div_ps(nx, length));
+		_mm_storeu_ps(lanes[4], _mm_div_ps(ny, length));
+		_mm_storeu_ps(lanes[5], _mm_div_ps(nz, length));
+
+		for (int axis = 0; axis < 2; axis++) {
+			_mm_storeu_ps(lanes[6 + axis], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(load(5 + axis)), uvScale[axis]), uvMin[axis]));
+		}
+
+		for (int pair = 0; pair < 2; pair++) {
+			__m128i packed = load(7 + pair);
+			_mm_storeu_ps(lanes[8 + pair * 2], _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, byteMask)), colorScale));
+			_mm_storeu_ps(lanes[9 + pair * 2], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(packed, 8)), colorScale));
+		}
+
+		size_t lanesUsed = std::min<size_t>(4, count - ix);
+		for (size_t lane = 0; lane < lanesUsed; lane++) {
+			vertices[ix + lane] = VertexPosNormTexCol(
+				lanes[0][lane], lanes[1][lane], lanes[2][lane],
+				lanes[3][lane], lanes[4][lane], lanes[5][lane],
+				lanes[6][lane], lanes[7][lane],
+				lanes[8][lane], lanes[9][lane], lanes[10][lane], lanes[11][lane]);
+		}
+	}
+
+	indices.resize(header.IndexCount);
+	return __DecodeIndices(cursor, end, indices.data(), indices.size(), header.VertexCount);
+}
+
+void MeshCodec::__EncodePlane(const uint8_t* plane, size_t groups, std::vector<uint8_t>& result) {
+	// All of the modes go first, 4 to a byte, followed by each group's payload
+	size_t modeStart = result.size();
+	result.resize(modeStart + (groups + 3) / 4, 0);
+	for (size_t group = 0; group < groups; group++) {
+		const uint8_t* values = plane + group * GROUP_SIZE;
+		uint8_t bits = 0;
+		for (size_t ix = 0; ix < GROUP_SIZE; ix++) {
+			bits |= values[ix];
+		}
+		uint8_t mode = bits == 0 ? 0 : bits < 4 ? 1 : bits < 16 ? 2 : 3;
+		result[modeStart + group / 4] |= static_cast<uint8_t>(mode << ((group % 4) * 2));
+
+		switch (mode) {
+			case 1:
+				for (size_t ix = 0; ix < GROUP_SIZE; ix += 4) {
+					result.push_back(static_cast<uint8_t>(values[ix] | (values[ix + 1] << 2) | (values[ix + 2] << 4) | (values[ix + 3] << 6)));
+				}
+				break;
+			case 2:
+				for (size_t ix = 0; ix < GROUP_SIZE; ix += 2) {
+					result.push_back(static_cast<uint8_t>(values[ix] | (values[ix + 1] << 4)));
+				}
+				break;
+			case 3:
+				result.insert(result.end(), values, values + GROUP_SIZE);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+bool MeshCodec::__DecodePlane(const uint8_t*& data, const uint8_t* end, uint8_t* plane, size_t groups) {
+	size_t modeBytes = (groups + 3) / 4;
+	if (static_cast<size_t>(end - data) < modeBytes) {
+		return false;
+	}
+	const uint8_t* modes = data;
+	const uint8_t* payload = data + modeBytes;
+	const __m128i mask2 = _mm_set1_epi8(0x03);
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+	for (size_t group = 0; group < groups; group++) {
+		uint8_t mode = (modes[group / 4] >> ((group % 4) * 2)) & 0x03;
+		if (static_cast<size_t>(end - payload) < MODE_PAYLOAD[mode]) {
+			return false;
+		}
+
+		__m128i values;
+		switch (mode) {
+			case 0:
+				values = _mm_setzero_si128();
+				break;
+			case 1: {
+				// Split each byte into it's 4 2-bit values, then interleave them back into order
+				int32_t packed;
+				memcpy(&packed, payload, sizeof(int32_t));
+				__m128i bytes = _mm_cvtsi32_si128(packed);
+				__m128i v0 = _mm_and_si128(bytes, mask2);
+				__m128i v1 = _mm_and_si128(_mm_srli_epi16(bytes, 2), mask2);
+				__m128i v2 = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask2);
+				__m128i v3 = _mm_and_si128(_mm_srli_epi16(bytes, 6), mask2);
+				values = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v0, v1), _mm_unpacklo_epi8(v2, v3));
+				break;
+			}
+			case 2: {
+				__m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(payload));
+				values = _mm_unpacklo_epi8(_mm_and_si128(bytes, mask4), _mm_and_si128(_mm_srli_epi16(bytes, 4), mask4));
+				break;
+			}
+			default:
+				values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(payload));
+				break;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(plane + group * GROUP_SIZE), values);
+		payload += MODE_PAYLOAD[mode];
+	}
+	data = payload;
+	return true;
+}
+
+void MeshCodec::__OptimizeTriangleOrder(std::vector<uint32_t>& indices, size_t vertexCount) {
+	// Tipsify (Sander et al. 2007): we fan out around one vertex at a time, emitting all of it's remaining triangles,
+	// then move on to a vertex that was just used and is still in the cache. This keeps neighbouring triangles
+	// next to each other, which is what the edge and vertex FIFOs in the index coding rely on
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2 || vertexCount == 0) {
+		return;
+	}
+
+	// Build the list of triangles around each vertex
+	std::vector<uint32_t> live(vertexCount, 0);
+	for (size_t ix = 0; ix < triangleCount * 3; ix++) {
+		live[indices[ix]]++;
+	}
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		offsets[ix + 1] = offsets[ix] + live[ix];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t ix = 0; ix < triangleCount * 3; ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	uint32_t time = CACHE_SIZE + 1;
+	size_t cursor = 0;
+	int64_t fan = indices[0];
+
+	while (fan >= 0) {
+		candidates.clear();
+		for (uint32_t adj = offsets[fan]; adj < offsets[fan + 1]; adj++) {
+			uint32_t triangle = adjacency[adj];
+			if (emitted[triangle]) {
+				continue;
+			}
+			emitted[triangle] = true;
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				result.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				live[vertex]--;
+				if (time - cacheTime[vertex] > CACHE_SIZE) {
+					cacheTime[vertex] = time++;
+				}
+			}
+		}
+
+		// Prefer the candidate that will stay in the cache for the longest while we fan around it
+		fan = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (live[vertex] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (time - cacheTime[vertex] + 2 * live[vertex] <= CACHE_SIZE) {
+				priority = time - cacheTime[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fan = vertex;
+			}
+		}
+
+		// Nothing around us is left, back track through the recently used vertices, or failing that find any vertex
+		// that still has triangles
+		while (fan < 0 && !deadEnd.empty()) {
+			uint32_t vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[vertex] > 0) {
+				fan = vertex;
+			}
+		}
+		while (fan < 0 && cursor < vertexCount) {
+			if (live[cursor] > 0) {
+				fan = static_cast<int64_t>(cursor);
+			}
+			cursor++;
+		}
+	}
+
+	// Any indices that don't make up a whole triangle stay at the end
+	result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+	indices.swap(result);
+}
+
+// Writes a value as a varint, 7 bits at a time
+static inline void WriteVarint(uint64_t value, std::vector<uint8_t>& result) {
+	while (value >= 0x80) {
+		result.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	result.push_back(static_cast<uint8_t>(value));
+}
+
+static inline bool ReadVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+	value = 0;
+	for (uint32_t shift = 0; ; shift += 7) {
+		if (data == end || shift > 63) {
+			return false;
+		}
+		uint8_t byte = *data++;
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+}
+
+static inline uint64_t ZigZagDelta(uint32_t value, uint32_t last) {
+	int64_t delta = static_cast<int64_t>(value) - static_cast<int64_t>(last);
+	return (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+}
+
+static inline int64_t UnZigZagDelta(uint64_t zigzag, uint32_t last) {
+	return static_cast<int64_t>(last) + (static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+}
+
+// The recently used edges and vertices, shared by the encoder and decoder so that they always agree. Slot 0 is the
+// most recently pushed entry. Both sides start out with the same zeroed entries, so looking those up is harmless
+struct IndexFifo {
+	static const uint32_t SIZE = 16;
+	uint32_t EdgeA[SIZE] = {};
+	uint32_t EdgeB[SIZE] = {};
+	uint32_t Vertices[SIZE] = {};
+	uint32_t EdgeHead = 0;
+	uint32_t VertexHead = 0;
+
+	void PushEdge(uint32_t a, uint32_t b) {
+		EdgeHead = (EdgeHead + 1) % SIZE;
+		EdgeA[EdgeHead] = a;
+		EdgeB[EdgeHead] = b;
+	}
+	void PushVertex(uint32_t vertex) {
+		VertexHead = (VertexHead + 1) % SIZE;
+		Vertices[VertexHead] = vertex;
+	}
+	uint32_t EdgeSlot(uint32_t slot) const { return (EdgeHead + SIZE - slot) % SIZE; }
+	uint32_t GetVertex(uint32_t slot) const { return Vertices[(VertexHead + SIZE - slot) % SIZE]; }
+	int FindVertex(uint32_t vertex, uint32_t slots) const {
+		for (uint32_t slot = 0; slot < slots; slot++) {
+			if (GetVertex(slot) == vertex) {
+				return static_cast<int>(slot);
+			}
+		}
+		return -1;
+	}
+};
+
+// Codes for a vertex that isn't the third vertex of a triangle that shares an edge:
+// 0 = the next new vertex, 1-16 = a slot in the vertex FIFO, 17+ = 17 + the zigzagged delta from the last vertex
+static const uint64_t VERTEX_CODE_FIFO = 1;
+static const uint64_t VERTEX_CODE_DELTA = VERTEX_CODE_FIFO + IndexFifo::SIZE;
+
+// Codes for the third vertex of a triangle that shares an edge, packed in the low 4 bits of the triangle's byte:
+// 0 = the next new vertex, 1-14 = a slot in the vertex FIFO, 15 = a varint zigzagged delta follows
+static const uint32_t THIRD_FIFO_SLOTS = 14;
+static const uint8_t THIRD_CODE_DELTA = 15;
+// The high 4 bits are the slot of the shared edge in the edge FIFO, or this if no edge was shared
+static const uint8_t EDGE_MISS = 15;
+
+static void EncodeVertex(uint32_t vertex, uint32_t& next, uint32_t& last, IndexFifo& fifo, std::vector<uint8_t>& result) {
+	int slot = fifo.FindVertex(vertex, IndexFifo::SIZE);
+	if (vertex == next) {
+		WriteVarint(0, result);
+		next++;
+		fifo.PushVertex(vertex);
+	} else if (slot >= 0) {
+		WriteVarint(VERTEX_CODE_FIFO + slot, result);
+	} else {
+		WriteVarint(VERTEX_CODE_DELTA + ZigZagDelta(vertex, last), result);
+		fifo.PushVertex(vertex);
+	}
+	last = vertex;
+}
+
+static bool DecodeVertex(const uint8_t*& data, const uint8_t* end, uint32_t& next, uint32_t& last, IndexFifo& fifo, uint32_t vertexCount, uint32_t& vertex) {
+	uint64_t code;
+	if (!ReadVarint(data, end, code)) {
+		return false;
+	}
+	if (code == 0) {
+		vertex = next++;
+		fifo.PushVertex(vertex);
+	} else if (code < VERTEX_CODE_DELTA) {
+		vertex = fifo.GetVertex(static_cast<uint32_t>(code - VERTEX_CODE_FIFO));
+	} else {
+		int64_t index = UnZigZagDelta(code - VERTEX_CODE_DELTA, last);
+		if (index < 0 || index >= static_cast<int64_t>(vertexCount)) {
+			return false;
+		}
+		vertex = static_cast<uint32_t>(index);
+		fifo.PushVertex(vertex);
+	}
+	last = vertex;
+	return vertex < vertexCount;
+}
+
+void MeshCodec::__EncodeIndices(const std::vector<uint32_t>& indices, std::vector<uint8_t>& result) {
+	// Each triangle starts with a byte. If one of it's edges (rotating the triangle so that edge comes first) was
+	// used by a recent triangle, the high 4 bits say which one, and the low 4 bits code the third vertex. Since the
+	// triangles are in cache order, most triangles share an edge and only cost that one byte. Vertices being used for
+	// the first time are always the next one in order, and recently used vertices are looked up in a FIFO rather
+	// than stored again
+	IndexFifo fifo;
+	uint32_t next = 0, last = 0;
+	const size_t triangleCount = indices.size() / 3;
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		const uint32_t* corners = &indices[triangle * 3];
+
+		// Neighbouring triangles with the same winding run along their shared edge in opposite directions
+		int edgeSlot = -1, rotation = 0;
+		for (uint32_t slot = 0; slot < EDGE_MISS && edgeSlot < 0; slot++) {
+			uint32_t fifoIx = fifo.EdgeSlot(slot);
+			for (int rot = 0; rot < 3; rot++) {
+				if (corners[rot] == fifo.EdgeB[fifoIx] && corners[(rot + 1) % 3] == fifo.EdgeA[fifoIx]) {
+					edgeSlot = static_cast<int>(slot);
+					rotation = rot;
+					break;
+				}
+			}
+		}
+
+		if (edgeSlot < 0) {
+			result.push_back(static_cast<uint8_t>(EDGE_MISS << 4));
+			for (int corner = 0; corner < 3; corner++) {
+				EncodeVertex(corners[corner], next, last, fifo, result);
+			}
+			fifo.PushEdge(corners[0], corners[1]);
+			fifo.PushEdge(corners[1], corners[2]);
+			fifo.PushEdge(corners[2], corners[0]);
+			continue;
+		}
+
+		uint32_t a = corners[rotation], b = corners[(rotation + 1) % 3], c = corners[(rotation + 2) % 3];
+		int vertexSlot = fifo.FindVertex(c, THIRD_FIFO_SLOTS);
+		if (c == next) {
+			result.push_back(static_cast<uint8_t>(edgeSlot << 4));
+			next++;
+			fifo.PushVertex(c);
+		} else if (vertexSlot >= 0) {
+			result.push_back(static_cast<uint8_t>((edgeSlot << 4) | (1 + vertexSlot)));
+		} else {
+			result.push_back(static_cast<uint8_t>((edgeSlot << 4) | THIRD_CODE_DELTA));
+			WriteVarint(ZigZagDelta(c, last), result);
+			fifo.PushVertex(c);
+		}
+		last = c;
+		// The shared edge already has a triangle on both sides, so only the new edges are worth remembering
+		fifo.PushEdge(b, c);
+		fifo.PushEdge(c, a);
+	}
+
+	// Any left over indices that don't make up a triangle
+	for (size_t ix = triangleCount * 3; ix < indices.size(); ix++) {
+		EncodeVertex(indices[ix], next, last, fifo, result);
+	}
+}
+
+bool MeshCodec::__DecodeIndices(const uint8_t* data, const uint8_t* end, uint32_t* indices, size_t indexCount, uint32_t vertexCount) {
+	IndexFifo fifo;
+	uint32_t next = 0, last = 0;
+	const size_t triangleCount = indexCount / 3;
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		if (data == end) {
+			return false;
+		}
+		uint8_t code = *data++;
+		uint32_t* corners = indices + triangle * 3;
+		uint32_t edgeSlot = code >> 4;
+
+		if (edgeSlot == EDGE_MISS) {
+			for (int corner = 0; corner < 3; corner++) {
+				if (!DecodeVertex(data, end, next, last, fifo, vertexCount, corners[corner])) {
+					return false;
+				}
+			}
+			fifo.PushEdge(corners[0], corners[1]);
+			fifo.PushEdge(corners[1], corners[2]);
+			fifo.PushEdge(corners[2], corners[0]);
+			continue;
+		}
+
+		uint32_t fifoIx = fifo.EdgeSlot(edgeSlot);
+		uint32_t a = fifo.EdgeB[fifoIx], b = fifo.EdgeA[fifoIx], c;
+		uint8_t third = code & 0x0F;
+		if (third == 0) {
+			c = next++;
+			fifo.PushVertex(c);
+		} else if (third <= THIRD_FIFO_SLOTS) {
+			c = fifo.GetVertex(third - 1u);
+		} else {
+			uint64_t zigzag;
+			if (!ReadVarint(data, end, zigzag)) {
+				return false;
+			}
+			int64_t index = UnZigZagDelta(zigzag, last);
+			if (index < 0 || index >= static_cast<int64_t>(vertexCount)) {
+				return false;
+			}
+			c = static_cast<uint32_t>(index);
+			fifo.PushVertex(c);
+		}
+		if (c >= vertexCount) {
+			return false;
+		}
+		last = c;
+		corners[0] = a;
+		corners[1] = b;
+		corners[2] = c;
+		fifo.PushEdge(b, c);
+		fifo.PushEdge(c, a);
+	}
+
+	for (size_t ix = triangleCount * 3; ix < indexCount; ix++) {
+		if (!DecodeVertex(data, end, next, last, fifo, vertexCount, indices[ix])) {
+			return false;
+		}
+	}
+	return data == end;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// Compresses meshes for storing on disk. Vertices are quantized to 16 bits per channel (positions and UVs
+/// relative to their bounds, normals octahedral encoded, colors to 8 bits per component), reordered into the
+/// order the indices first use them, then each channel is delta and zigzag encoded and split into byte planes.
+/// Each plane is stored in groups of 16 bytes packed at 0, 2, 4 or 8 bits each, so the mostly zero high bytes
+/// of smooth data take up almost no space. Triangles are put in vertex cache order, and each one is stored as a
+/// byte that refers to an edge it shares with a recent triangle plus it's third vertex (the next new vertex, or
+/// one from a FIFO of recent vertices). Triangles that can't do that, or whose vertices are further away, fall
+/// back to variable length codes.
+///
+/// Positions and UVs are lossy (to 1/65535th of their bounds), so the codec is meant for caches and packed
+/// assets rather than for source data. Decoding the vertices uses SSE2. The triangle order is not kept
+/// </summary>
+class MeshCodec
+{
+public:
+	/// <summary>
+	/// Compresses a mesh
+	/// </summary>
+	/// <param name="vertices">The mesh's vertices</param>
+	/// <param name="indices">The mesh's indices as a triangle list, all of which must be less than the number of vertices</param>
+	/// <param name="result">Receives the compressed data</param>
+	static void Encode(const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices, std::vector<uint8_t>& result);
+	/// <summary>
+	/// Decompresses a mesh that was compressed with Encode. The triangles will be in vertex cache order (and may
+	/// start on a different corner, with the same winding), and the vertices will be in the order those triangles
+	/// first use them, rather than the order they were encoded in
+	/// </summary>
+	/// <param name="data">The compressed data</param>
+	/// <param name="size">The size of the compressed data, in bytes</param>
+	/// <param name="vertices">Receives the vertices</param>
+	/// <param name="indices">Receives the indices</param>
+	/// <returns>True if the data was decoded and all indices are in range, false if the data is invalid</returns>
+	static bool Decode(const uint8_t* data, size_t size, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices);
+
+protected:
+	MeshCodec() = default;
+	~MeshCodec() = default;
+
+	// Stored at the start of the compressed data, everything after it is the vertex planes and then the indices
+	struct Header {
+		uint32_t  VertexCount;
+		uint32_t  IndexCount;
+		glm::vec3 PositionMin;
+		glm::vec3 PositionScale;
+		glm::vec2 UVMin;
+		glm::vec2 UVScale;
+	};
+
+	// Positions (3), normals (2), UVs (2) and colors (2, two components per channel)
+	static const size_t CHANNELS = 9;
+	// The number of bytes in a group that share a bit width
+	static const size_t GROUP_SIZE = 16;
+	// The size of the vertex cache we order triangles for
+	static const uint32_t CACHE_SIZE = 16;
+
+	static void __EncodePlane(const uint8_t* plane, size_t groups, std::vector<uint8_t>& result);
+	static bool __DecodePlane(const uint8_t*& data, const uint8_t* end, uint8_t* plane, size_t groups);
+	static void __OptimizeTriangleOrder(std::vector<uint32_t>& indices, size_t vertexCount);
+	static void __EncodeIndices(const std::vector<uint32_t>& indices, std::vector<uint8_t>& result);
+	static bool __DecodeIndices(const uint8_t* data, const uint8_t* end, uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+};
@@ -0,0 +1,203 @@
+#include "MeshCodecTests.h"
+#include "MeshCodec.h"
+#include <Logging.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+int MeshCodecTests::_lastFailures = -1;
+
+typedef std::array<uint32_t, 3> Triangle;
+
+// Stores a vertex's index in it's color, one byte per component, so it survives the codec's 8 bit colors exactly
+static glm::vec4 IdToColor(uint32_t id) {
+	return glm::vec4((id & 0xFF) / 255.0f, ((id >> 8) & 0xFF) / 255.0f, ((id >> 16) & 0xFF) / 255.0f, ((id >> 24) & 0xFF) / 255.0f);
+}
+
+static uint32_t ColorToId(const glm::vec4& color) {
+	uint32_t result = 0;
+	for (int component = 0; component < 4; component++) {
+		result |= static_cast<uint32_t>(std::round(color[component] * 255.0f)) << (component * 8);
+	}
+	return result;
+}
+
+// Rotates a triangle so it starts on it's smallest index, which keeps it's winding but lets us compare triangles
+// that the codec started on a different corner
+static Triangle Canonical(Triangle triangle) {
+	std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+	return triangle;
+}
+
+static void AddVertex(std::vector<VertexPosNormTexCol>& vertices, const glm::vec3& position, const glm::vec2& uv) {
+	uint32_t id = static_cast<uint32_t>(vertices.size());
+	vertices.emplace_back(position, glm::vec3(0.0f, 0.0f, 1.0f), uv, IdToColor(id));
+}
+
+// A strip of quads with both sides drawn, every triangle after the first shares an edge and a vertex with a recent one
+static void MakeRibbon(size_t quads, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	for (size_t ix = 0; ix <= quads; ix++) {
+		float u = ix / static_cast<float>(quads);
+		AddVertex(vertices, glm::vec3(u * 10.0f, 0.0f, 0.0f), glm::vec2(u, 0.0f));
+		AddVertex(vertices, glm::vec3(u * 10.0f, 1.0f, 0.0f), glm::vec2(u, 1.0f));
+	}
+	for (uint32_t ix = 0; ix < quads; ix++) {
+		uint32_t a = ix * 2, b = a + 1, c = a + 2, d = a + 3;
+		uint32_t front[6] = { a, c, b, b, c, d };
+		uint32_t back[6]  = { a, b, c, b, d, c };
+		indices.insert(indices.end(), front, front + 6);
+		indices.insert(indices.end(), back, back + 6);
+	}
+}
+
+static void MakeGrid(size_t size, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	for (size_t y = 0; y <= size; y++) {
+		for (size_t x = 0; x <= size; x++) {
+			glm::vec2 uv = glm::vec2(x, y) / static_cast<float>(size);
+			AddVertex(vertices, glm::vec3(uv, 0.0f), uv);
+		}
+	}
+	const uint32_t stride = static_cast<uint32_t>(size + 1);
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			uint32_t a = y * stride + x, b = a + 1, c = a + stride, d = c + 1;
+			uint32_t quad[6] = { a, b, c, c, b, d };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+// Random triangles between random vertices, so almost nothing hits the FIFOs and the fallback codes get used
+static void MakeSoup(size_t vertexCount, size_t triangleCount, std::mt19937& random, std::vector<VertexPosNormTexCol>& vertices, std::vector<uint32_t>& indices) {
+	std::uniform_real_distribution<float> value(-50.0f, 50.0f);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		AddVertex(vertices, glm::vec3(value(random), value(random), value(random)), glm::vec2(value(random), value(random)));
+	}
+	std::uniform_int_distribution<uint32_t> index(0, static_cast<uint32_t>(vertexCount - 1));
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		uint32_t a = index(random), b, c;
+		do { b = index(random); } while (b == a);
+		do { c = index(random); } while (c == a || c == b);
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+}
+
+// Encodes and decodes a mesh, and checks that we get the same triangles back, with positions within the quantization error
+static bool RoundTrip(const std::string& name, const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices) {
+	std::vector<uint8_t> encoded;
+	MeshCodec::Encode(vertices, indices, encoded);
+
+	std::vector<VertexPosNormTexCol> decodedVertices;
+	std::vector<uint32_t> decodedIndices;
+	if (!MeshCodec::Decode(encoded.data(), encoded.size(), decodedVertices, decodedIndices)) {
+		LOG_ERROR("MeshCodec {}: failed to decode {} bytes", name, encoded.size());
+		return false;
+	}
+	if (decodedVertices.size() != vertices.size() || decodedIndices.size() != indices.size()) {
+		LOG_ERROR("MeshCodec {}: decoded {} vertices and {} indices, expected {} and {}", name,
+			decodedVertices.size(), decodedIndices.size(), vertices.size(), indices.size());
+		return false;
+	}
+
+	glm::vec3 posMin = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position, posMax = posMin;
+	for (const VertexPosNormTexCol& vertex : vertices) {
+		posMin = glm::min(posMin, vertex.Position);
+		posMax = glm::max(posMax, vertex.Position);
+	}
+	// Half a quantization step, plus a little for the float math on the way back
+	const glm::vec3 tolerance = (posMax - posMin) / 65535.0f + glm::vec3(1.0e-5f);
+
+	// Map the decoded vertices back to the ones they were made from
+	std::vector<uint32_t> ids(decodedVertices.size());
+	for (size_t ix = 0; ix < decodedVertices.size(); ix++) {
+		ids[ix] = ColorToId(decodedVertices[ix].Color);
+		if (ids[ix] >= vertices.size()) {
+			LOG_ERROR("MeshCodec {}: decoded vertex {} has an id of {}, which doesn't exist", name, ix, ids[ix]);
+			return false;
+		}
+		glm::vec3 error = glm::abs(decodedVertices[ix].Position - vertices[ids[ix]].Position);
+		if (glm::any(glm::greaterThan(error, tolerance))) {
+			LOG_ERROR("MeshCodec {}: vertex {} is off by ({}, {}, {})", name, ids[ix], error.x, error.y, error.z);
+			return false;
+		}
+	}
+
+	std::vector<Triangle> expected, actual;
+	for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+		expected.push_back(Canonical({ indices[ix], indices[ix + 1], indices[ix + 2] }));
+		actual.push_back(Canonical({ ids[decodedIndices[ix]], ids[decodedIndices[ix + 1]], ids[decodedIndices[ix + 2]] }));
+	}
+	std::sort(expected.begin(), expected.end());
+	std::sort(actual.begin(), actual.end());
+	if (expected != actual) {
+		LOG_ERROR("MeshCodec {}: the decoded triangles don't match the ones that were encoded", name);
+		return false;
+	}
+
+	LOG_INFO("MeshCodec {}: {} triangles in {} bytes ({:.2f} bytes per triangle)", name, indices.size() / 3, encoded.size(),
+		indices.empty() ? 0.0f : encoded.size() / (indices.size() / 3.0f));
+	return true;
+}
+
+bool MeshCodecTests::RunTests(uint32_t seed) {
+	std::mt19937 random(seed);
+
+	int failures = 0;
+	auto test = [&](const std::string& name, const std::vector<VertexPosNormTexCol>& vertices, const std::vector<uint32_t>& indices) {
+		if (!RoundTrip(name, vertices, indices)) {
+			failures++;
+		}
+	};
+
+	// Ribbons are the best case for the index coding, most of their triangles take a single byte
+	for (size_t quads : { 1, 16, 256, 4096 }) {
+		std::vector<VertexPosNormTexCol> vertices;
+		std::vector<uint32_t> indices;
+		MakeRibbon(quads, vertices, indices);
+		test("ribbon of " + std::to_string(quads) + " quads", vertices, indices);
+	}
+	for (size_t size : { 1, 7, 64 }) {
+		std::vector<VertexPosNormTexCol> vertices;
+		std::vector<uint32_t> indices;
+		MakeGrid(size, vertices, indices);
+		test(std::to_string(size) + "x" + std::to_string(size) + " grid", vertices, indices);
+	}
+	for (size_t triangles : { 1, 100, 5000 }) {
+		std::vector<VertexPosNormTexCol> vertices;
+		std::vector<uint32_t> indices;
+		MakeSoup(std::max<size_t>(triangles, 3), triangles, random, vertices, indices);
+		test("soup of " + std::to_string(triangles) + " triangles", vertices, indices);
+	}
+
+	_lastFailures = failures;
+	if (failures > 0) {
+		LOG_ERROR("MeshCodec round trip tests: {} failed", failures);
+	} else {
+		LOG_INFO("MeshCodec round trip tests passed");
+	}
+	return failures == 0;
+}
+
+void MeshCodecTests::DrawImGui() {
+	if (!ImGui::CollapsingHeader("Mesh Codec")) {
+		return;
+	}
+	if (ImGui::Button("Run Round Trip Tests")) {
+		RunTests();
+	}
+	ImGui::SameLine();
+	if (_lastFailures < 0) {
+		ImGui::Text("Not run");
+	} else if (_lastFailures == 0) {
+		ImGui::Text("Passed");
+	} else {
+		ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%d failed (see log)", _lastFailures);
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Round trip tests for the MeshCodec. Each test mesh is encoded and decoded, and every decoded triangle is matched back
+/// to the triangle it came from (the codec reorders triangles and vertices, so we tag every vertex with a unique color,
+/// which the codec stores exactly). The meshes cover the cases the index coding treats differently: strips where almost
+/// every triangle is a single byte (double sided ribbons), regular grids, and random triangle soups that miss the FIFOs
+/// </summary>
+class MeshCodecTests {
+public:
+	/// <summary>
+	/// Runs every round trip test, logging any mismatches
+	/// </summary>
+	/// <param name="seed">The seed for the random meshes</param>
+	/// <returns>True if every mesh decoded to the same triangles it was encoded from</returns>
+	static bool RunTests(uint32_t seed = 1234);
+
+	/// <summary>
+	/// Draws an ImGui button for running the tests, and shows the last result
+	/// </summary>
+	static void DrawImGui();
+
+protected:
+	MeshCodecTests() = default;
+
+	// -1 if the tests haven't been run, otherwise the number of failures from the last run
+	static int _lastFailures;
+};
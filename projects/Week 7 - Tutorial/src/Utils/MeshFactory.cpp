@@ -1,4 +1,6 @@
 #include "Utils/MeshFactory.h"
+#include <mutex>
+#include <memory>
 
 MeshBuilderParam MeshBuilderParam::CreateCube(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& eulerDeg /*= glm::vec3(0.0f)*/, const glm::vec4& col /*= glm::vec4(1.0f)*/) {
 	MeshBuilderParam result;
@@ -70,4 +72,230 @@ nlohmann::json MeshBuilderParam::ToJson() const {
 		result["params"][key] = GlmToJson(value);
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+void MeshFactory::EstimateSize(const MeshBuilderParam& param, size_t& vertexCount, size_t& indexCount) {
+	vertexCount = 0;
+	indexCount = 0;
+	switch (param.Type) {
+		case MeshBuilderType::Plane:
+			vertexCount = 4;
+			indexCount = 6;
+			break;
+		case MeshBuilderType::Cube:
+			vertexCount = 24;
+			indexCount = 36;
+			break;
+		case MeshBuilderType::IcoShere:
+		case MeshBuilderType::UvSphere:
+		{
+			auto it = param.Params.find("tessellation");
+			int tessellation = it == param.Params.end() ? 0 : (int)it->second.x;
+			if (param.Type == MeshBuilderType::IcoShere) {
+				EstimateIcoSphereSize(tessellation, vertexCount, indexCount);
+			} else {
+				EstimateUvSphereSize(tessellation, vertexCount, indexCount);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void MeshFactory::EstimateSize(const std::vector<MeshBuilderParam>& params, size_t& vertexCount, size_t& indexCount) {
+	vertexCount = 0;
+	indexCount = 0;
+	for (const MeshBuilderParam& param : params) {
+		size_t vertices, indices;
+		EstimateSize(param, vertices, indices);
+		vertexCount += vertices;
+		indexCount += indices;
+	}
+}
+
+void MeshFactory::EstimateIcoSphereSize(int tessellation, size_t& vertexCount, size_t& indexCount) {
+	const UnitSphere& sphere = GetUnitIcoSphere(tessellation);
+	vertexCount = sphere.Normals.size();
+	indexCount = sphere.Indices.size();
+}
+
+void MeshFactory::EstimateUvSphereSize(int tessellation, size_t& vertexCount, size_t& indexCount) {
+	// Must match the slice and stack counts in BuildUnitUvSphere
+	const size_t slices = 1 + ((size_t)1 << (tessellation + 1));
+	const size_t stacks = (slices / 2) + 1;
+	vertexCount = (stacks + 1) * (slices + 1);
+	// The top and bottom rings are a single triangle per slice
+	indexCount = (stacks - 1) * slices * 6;
+}
+
+// Gets the spherical UV coordinates for a point on the unit sphere
+static glm::vec2 SphereUV(const glm::vec3& pos) {
+	return glm::vec2(atan2f(pos.y, pos.x) / (2.0f * M_PI), (asinf(pos.z) / M_PI) + 0.5f);
+}
+
+static void BuildUnitIcoSphere(int tessellation, MeshFactory::UnitSphere& result) {
+	float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+	const glm::vec3 corners[12] = {
+		glm::vec3(-1, t, 0),  glm::vec3(1, t, 0),   glm::vec3(-1, -t, 0), glm::vec3(1, -t, 0),
+		glm::vec3(0, -1, t),  glm::vec3(0, 1, t),   glm::vec3(0, -1, -t), glm::vec3(0, 1, -t),
+		glm::vec3(t, 0, -1),  glm::vec3(t, 0, 1),   glm::vec3(-t, 0, -1), glm::vec3(-t, 0, 1)
+	};
+	for (const glm::vec3& corner : corners) {
+		result.Normals.push_back(glm::normalize(corner));
+	}
+
+	std::vector<glm::uvec3> faces = {
+		// 5 faces around point 0
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		// 5 adjacent faces
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		// 5 faces around point 3
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		// 5 adjacent faces
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+	};
+
+	// Every edge gets split exactly once, so we cache midpoints by the (order independent) pair of indices
+	std::unordered_map<uint64_t, uint32_t> midpointCache;
+	auto midpoint = [&](uint32_t a, uint32_t b) {
+		uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+		auto it = midpointCache.find(key);
+		if (it != midpointCache.end()) {
+			return it->second;
+		}
+		uint32_t ix = (uint32_t)result.Normals.size();
+		result.Normals.push_back(glm::normalize(result.Normals[a] + result.Normals[b]));
+		midpointCache[key] = ix;
+		return ix;
+	};
+
+	for (int level = 0; level < tessellation; level++) {
+		std::vector<glm::uvec3> subdivided;
+		subdivided.reserve(faces.size() * 4);
+		for (const glm::uvec3& face : faces) {
+			uint32_t a = midpoint(face[0], face[1]);
+			uint32_t b = midpoint(face[1], face[2]);
+			uint32_t c = midpoint(face[2], face[0]);
+			subdivided.emplace_back(face[0], a, c);
+			subdivided.emplace_back(face[1], b, a);
+			subdivided.emplace_back(face[2], c, b);
+			subdivided.emplace_back(a, b, c);
+		}
+		faces = std::move(subdivided);
+	}
+
+	result.UVs.reserve(result.Normals.size());
+	for (const glm::vec3& normal : result.Normals) {
+		result.UVs.push_back(SphereUV(normal));
+	}
+	result.Indices.reserve(faces.size() * 3);
+	for (const glm::uvec3& face : faces) {
+		result.Indices.push_back(face[0]);
+		result.Indices.push_back(face[1]);
+		result.Indices.push_back(face[2]);
+	}
+
+	// Triangles that cross the seam where U wraps from 1 back to 0 get a copy of one vertex with its U shifted
+	// by 1, so the texture doesn't get squished backwards across the whole triangle (the poles are still off)
+	auto splitVertex = [&](size_t ix, const glm::vec2& uv) {
+		const uint32_t index = result.Indices[ix];
+		result.Indices[ix] = (uint32_t)result.Normals.size();
+		result.Normals.push_back(result.Normals[index]);
+		result.UVs.push_back(uv);
+	};
+	const size_t numTriangles = faces.size();
+	for (size_t i = 0; i < numTriangles; i++) {
+		const glm::vec2 uv0 = result.UVs[result.Indices[i * 3 + 0]];
+		const glm::vec2 uv1 = result.UVs[result.Indices[i * 3 + 1]];
+		const glm::vec2 uv2 = result.UVs[result.Indices[i * 3 + 2]];
+
+		const float d1 = uv1.x - uv0.x;
+		const float d2 = uv2.x - uv0.x;
+
+		if (glm::abs(d1) > 0.5f && glm::abs(d2) > 0.5f)
+			splitVertex(i * 3 + 0, uv0 + glm::vec2((d1 > 0.0f) ? 1.0f : -1.0f, 0.0f));
+		else if (glm::abs(d1) > 0.5f)
+			splitVertex(i * 3 + 1, uv1 + glm::vec2((d1 < 0.0f) ? 1.0f : -1.0f, 0.0f));
+		else if (glm::abs(d2) > 0.5f)
+			splitVertex(i * 3 + 2, uv2 + glm::vec2((d2 < 0.0f) ? 1.0f : -1.0f, 0.0f));
+	}
+}
+
+static void BuildUnitUvSphere(int tessellation, MeshFactory::UnitSphere& result) {
+	int slices = 1 + (1 << (tessellation + 1));
+	int stacks = (slices / 2) + 1;
+
+	size_t numVerts, numIndices;
+	MeshFactory::EstimateUvSphereSize(tessellation, numVerts, numIndices);
+	result.Normals.reserve(numVerts);
+	result.UVs.reserve(numVerts);
+	result.Indices.reserve(numIndices);
+
+	float dLong = (M_PI * 2) / slices;
+	float dLat = M_PI / stacks;
+
+	for (int i = 0; i <= stacks; ++i) {
+		float stackAngle = M_PI / 2.0f - i * dLat;
+		float xy = cosf(stackAngle);
+		float z = sinf(stackAngle);
+
+		for (int j = 0; j <= slices; ++j) {
+			float sliceAngle = j * dLong;
+			result.Normals.emplace_back(xy * cosf(sliceAngle), xy * sinf(sliceAngle), z);
+			result.UVs.emplace_back((float)j / slices, 1.0f - (float)i / stacks);
+		}
+	}
+	result.UVs.front() = { 0.5f, 1.0f };
+	result.UVs.back() = { 0.5f, 0.0f };
+
+	// Body loop
+	for (int i = 0; i < stacks; ++i) {
+		uint32_t k1 = i * (slices + 1);
+		uint32_t k2 = k1 + slices + 1;
+		for (int j = 0; j < slices; ++j, ++k1, ++k2) {
+			// Our top loop
+			if (i != 0) {
+				result.Indices.push_back(k1);
+				result.Indices.push_back(k2);
+				result.Indices.push_back(k1 + 1);
+			}
+			// Everything but our bottom loop
+			if (i != (stacks - 1)) {
+				result.Indices.push_back(k1 + 1);
+				result.Indices.push_back(k2);
+				result.Indices.push_back(k2 + 1);
+			}
+		}
+	}
+}
+
+// Unit spheres by tessellation level. Entries are never removed, so references to them stay valid
+static std::mutex s_unitSphereLock;
+static std::unordered_map<int, std::unique_ptr<MeshFactory::UnitSphere>> s_unitIcoSpheres;
+static std::unordered_map<int, std::unique_ptr<MeshFactory::UnitSphere>> s_unitUvSpheres;
+
+const MeshFactory::UnitSphere& MeshFactory::GetUnitIcoSphere(int tessellation) {
+	std::lock_guard<std::mutex> lock(s_unitSphereLock);
+	std::unique_ptr<UnitSphere>& sphere = s_unitIcoSpheres[tessellation];
+	if (sphere == nullptr) {
+		sphere = std::make_unique<UnitSphere>();
+		BuildUnitIcoSphere(tessellation, *sphere);
+	}
+	return *sphere;
+}
+
+const MeshFactory::UnitSphere& MeshFactory::GetUnitUvSphere(int tessellation) {
+	std::lock_guard<std::mutex> lock(s_unitSphereLock);
+	std::unique_ptr<UnitSphere>& sphere = s_unitUvSpheres[tessellation];
+	if (sphere == nullptr) {
+		sphere = std::make_unique<UnitSphere>();
+		BuildUnitUvSphere(tessellation, *sphere);
+	}
+	return *sphere;
+}
+
+void MeshFactory::TransformUnitSphere(const UnitSphere& sphere, const glm::vec3& center, const glm::vec3& radii, glm::vec3* result) {
+	const glm::mat4 transform = glm::translate(MAT4_IDENTITY, center) * glm::scale(MAT4_IDENTITY, radii);
+	SimdKernels::TransformPoints(transform, sphere.Normals.data(), result, sphere.Normals.size());
+}
@@ -2,6 +2,7 @@
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include "MeshBuilder.h"
+#include "Utils/SimdKernels.h"
 #include "Graphics/VertexTypes.h"
 #include <json.hpp>
 
@@ -44,6 +45,17 @@ struct MeshBuilderParam {
 class MeshFactory
 {
 public:
+	/// <summary>
+	/// The topology of a sphere with a radius of 1 around the origin. Spheres of the same tessellation level
+	/// all share the same topology, so we generate it once and transform it for every sphere we add
+	/// </summary>
+	struct UnitSphere {
+		// The vertex positions, which are also the normals since the sphere is centered on the origin
+		std::vector<glm::vec3> Normals;
+		std::vector<glm::vec2> UVs;
+		std::vector<uint32_t>  Indices;
+	};
+
 	/// <summary>
 	/// Adds a cube to the given mesh
 	/// </summary>
@@ -138,11 +150,55 @@ public:
 	template <typename Vertex>
 	static void AddParameterized(MeshBuilder<Vertex>& mesh, const MeshBuilderParam& param);
 
+	/// <summary>
+	/// Gets the unit ico sphere for a tessellation level, generating it on first use. Thread safe
+	/// </summary>
+	static const UnitSphere& GetUnitIcoSphere(int tessellation);
+	/// <summary>
+	/// Gets the unit UV sphere for a tessellation level, generating it on first use. Thread safe
+	/// </summary>
+	static const UnitSphere& GetUnitUvSphere(int tessellation);
+	/// <summary>
+	/// Scales and offsets the positions of a unit sphere using the SIMD vertex kernels
+	/// </summary>
+	/// <param name="sphere">The unit sphere to transform</param>
+	/// <param name="center">The center of the output sphere</param>
+	/// <param name="radii">The radius of the output sphere along each axis</param>
+	/// <param name="result">Receives the positions, must have room for every vertex in the sphere</param>
+	static void TransformUnitSphere(const UnitSphere& sphere, const glm::vec3& center, const glm::vec3& radii, glm::vec3* result);
+
+	/// <summary>
+	/// Gets how many vertices and indices a parameterized object will add to a mesh
+	/// </summary>
+	/// <param name="param">The mesh object parameters</param>
+	/// <param name="vertexCount">Receives the number of vertices</param>
+	/// <param name="indexCount">Receives the number of indices</param>
+	static void EstimateSize(const MeshBuilderParam& param, size_t& vertexCount, size_t& indexCount);
+	/// <summary>
+	/// Estimates the total number of vertices and indices for a list of parameterized objects, so that a
+	/// MeshBuilder can be created with all of its storage up front
+	/// </summary>
+	static void EstimateSize(const std::vector<MeshBuilderParam>& params, size_t& vertexCount, size_t& indexCount);
+
+	/// <summary>
+	/// Gets the number of vertices and indices that AddIcoSphere will add for the given tessellation level.
+	/// The ico sphere's seam vertices can't be counted without generating it, so this will cache the unit sphere
+	/// </summary>
+	static void EstimateIcoSphereSize(int tessellation, size_t& vertexCount, size_t& indexCount);
+	/// <summary>
+	/// Gets the number of vertices and indices that AddUvSphere will add for the given tessellation level
+	/// </summary>
+	static void EstimateUvSphereSize(int tessellation, size_t& vertexCount, size_t& indexCount);
+
 protected:	
 	MeshFactory() = default;
 	~MeshFactory() = default;
 
 	inline static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
+
+	// Adds a transformed copy of a unit sphere to the mesh
+	template <typename Vertex>
+	static void __AddUnitSphere(MeshBuilder<Vertex>& data, const UnitSphere& sphere, const glm::vec3& center, const glm::vec3& radii, const glm::vec4& col);
 };
 
 
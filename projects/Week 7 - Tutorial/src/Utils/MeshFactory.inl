@@ -4,8 +4,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <GLM/gtx/euler_angles.hpp>
 #include <unordered_map>
-#include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexLayout.h"
 #include "Logging.h"
 #include "MeshFactory.h"
 #include "Utils/JsonGlmHelpers.h"
@@ -24,275 +24,6 @@ struct RGBA_Helper {
 	};
 };
 
-/// <summary>
-/// Structure for mapping and setting a Vertex's attribute based on a vertex declaration
-/// </summary>
-struct VertexParamMap {
-	uint32_t PositionOffset;
-	uint32_t NormalOffset;
-	uint32_t TextureOffset;
-	uint32_t ColorOffset;
-	uint32_t ColorSize;
-
-	VertexParamMap() :
-		PositionOffset(-1),
-		NormalOffset(-1),
-		TextureOffset(-1),
-		ColorOffset(-1),
-		ColorSize(0) {}
-	
-	VertexParamMap(const std::vector<BufferAttribute>& vDecl) : VertexParamMap() {
-		// Loop over all the vertex type's attributes
-		for (int ix = 0; ix < vDecl.size(); ix++) {
-			// If the attribute is a float3 position, store it's byte offset
-			if (vDecl[ix].Usage == AttribUsage::Position && vDecl[ix].Size == 3 && vDecl[ix].Type == AttributeType::Float) {
-				PositionOffset = vDecl[ix].Offset;
-			}
-			// If the attribute is a float3 normal, store it's byte offset
-			else if (vDecl[ix].Usage == AttribUsage::Normal && vDecl[ix].Size == 3 && vDecl[ix].Type == AttributeType::Float) {
-				NormalOffset = vDecl[ix].Offset;
-			}
-			// If the attribute is a float2 texture UV, store it's byte offset
-			else if (vDecl[ix].Usage == AttribUsage::Texture && vDecl[ix].Size == 2 && vDecl[ix].Type == AttributeType::Float) {
-				TextureOffset = vDecl[ix].Offset;
-			}
-			// If the attribute is a float2 texture UV, store it's byte offset
-			else if (vDecl[ix].Usage == AttribUsage::Color && vDecl[ix].Type == AttributeType::Float) {
-				ColorOffset = vDecl[ix].Offset;
-				ColorSize   = vDecl[ix].Size;
-			}
-		}
-	}
-
-	template <typename Vertex>
-	void SetPosition(Vertex& vertex, const glm::vec3& value) const {
-		if (PositionOffset != (uint32_t)-1) {
-			memcpy(GetPtrOffset(vertex, PositionOffset), glm::value_ptr(value), sizeof(glm::vec3));
-		}
-	}
-
-	template <typename Vertex>
-	void SetNormal(Vertex& vertex, const glm::vec3& value) const {
-		if (NormalOffset != (uint32_t)-1) {
-			memcpy(GetPtrOffset(vertex, NormalOffset), glm::value_ptr(value), sizeof(glm::vec3));
-		}
-	}
-
-	template <typename Vertex>
-	void SetTexture(Vertex& vertex, const glm::vec2& value) const {
-		if (TextureOffset != (uint32_t)-1) {
-			memcpy(GetPtrOffset(vertex, TextureOffset), glm::value_ptr(value), sizeof(glm::vec2));
-		}
-	}
-
-	template <typename Vertex>
-	void SetColor(Vertex& vertex, const glm::vec4& value) const {
-		if (ColorOffset != (uint32_t)-1) {
-			memcpy(GetPtrOffset(vertex, ColorOffset), glm::value_ptr(value), sizeof(float) * ColorSize);
-		}
-	}
-
-	template <typename Vertex>
-	glm::vec3 GetPosition(Vertex& vertex) const {
-		if (PositionOffset != (uint32_t)-1) {
-			return *GetPtrOffset<Vertex, glm::vec3>(vertex, PositionOffset); 
-		}
-		return glm::vec3(0.0f);
-	}
-
-	template <typename Vertex>
-	glm::vec3 GetNormal(Vertex& vertex) const {
-		if (NormalOffset != (uint32_t)-1) {
-			return *GetPtrOffset<Vertex, glm::vec3>(vertex, NormalOffset);
-		}
-		return glm::vec3(0.0f);
-	}
-
-	template <typename Vertex>
-	glm::vec2 GetTexture(Vertex& vertex) const {
-		if (TextureOffset != (uint32_t)-1) {
-			return *GetPtrOffset<Vertex, glm::vec2>(vertex, TextureOffset);
-		}
-		return glm::vec2(0.0f);
-	}
-
-	template <typename Vertex>
-	glm::vec4 GetColor(Vertex& vertex) const {
-		if (ColorOffset != (uint32_t)-1) {
-			switch (ColorSize) {
-				case 2:
-					return glm::vec4(*GetPtrOffset<Vertex, glm::vec2>(vertex, ColorOffset), 0, 1);
-				case 3:
-					return glm::vec4(*GetPtrOffset<Vertex, glm::vec3>(vertex, ColorOffset), 1);
-				case 4:
-					return *GetPtrOffset<Vertex, glm::vec4>(vertex, ColorOffset);
-			}
-		}
-		return glm::vec4(1.0f);
-	}
-
-private:
-	glm::vec4 _safetyBuffer; // Used to return references to a safe garbage data store
-
-	template <typename Vertex, typename EndType = void>
-	EndType* GetPtrOffset(Vertex& vert, uint32_t offset) const {
-		return reinterpret_cast<EndType*>(reinterpret_cast<uint8_t*>(&vert) + offset);
-	}
-};
-
-/// <summary>
-/// Helper function for creating a vertx and setting all fields if they exist
-/// </summary>
-/// <typeparam name="Vertex">The type of vertex to create</typeparam>
-/// <param name="pos">The position for the new vertex</param>
-/// <param name="norm">The normal for the new vertex</param>
-/// <param name="uv">The UV coordinates for the new vertex</param>
-/// <param name="col">The color for the new vertex</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
-/// <returns>A new vertex with the given properties</returns>
-template <typename Vertex>
-Vertex Create(glm::vec3 pos, glm::vec3 norm, glm::vec2 uv, glm::vec4 col, const VertexParamMap& vMap) {
-	Vertex result;
-	vMap.SetPosition(result, pos);
-	vMap.SetNormal(result, norm);
-	vMap.SetTexture(result, uv);
-	vMap.SetColor(result, col);
-	return result;
-}
-
-/// <summary>
-/// Adds a mid point between two points on an ico sphere to the list of vertices, or optionally gets it from a cache of existing midpoints
-/// </summary>
-/// <typeparam name="Vertex">The type of vertex of the mesh to operate on</typeparam>
-/// <param name="scale">The radius scaling of the sphere</param>
-/// <param name="center">The center of the sphere</param>
-/// <param name="a">The index of the first vertex</param>
-/// <param name="b">The index of the second vertex</param>
-/// <param name="vertices">The collection of vertices to work in</param>
-/// <param name="midpointCache">A map to use for caching existing vertices</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
-/// <returns>The index of the vertex in the vertices list</returns>
-template <typename Vertex>
-uint32_t AddMiddlePoint(glm::vec3 scale, glm::vec3 center, uint32_t a, uint32_t b, std::vector<Vertex>& vertices, std::unordered_map<uint64_t, uint32_t>& midpointCache, const VertexParamMap& vMap)
-{
-	// We calculate a unique 64 bit key for each index combination (order independent)
-	uint64_t key = 0;
-	if (a < b) {
-		key = (static_cast<uint64_t>(a) << 32ul) | static_cast<uint64_t>(b);
-	} else {
-		key = (static_cast<uint64_t>(b) << 32ul) | static_cast<uint64_t>(a);
-	}
-	// Attempt to find the midpoint between those 2 vertices
-	auto it = midpointCache.find(key);
-
-	// We had a midpoint already, return it's index
-	if (it != midpointCache.end())
-		return it->second;
-	// We do not have a midpoint, we need to calculate and add a new one
-	else {
-		// Get the two vertices that we are interpolating
-		Vertex p1 = vertices[a];
-		Vertex p2 = vertices[b];
-
-		// Create a new vertex
-		Vertex interpolated;
-
-		// Calculate position based on the average between the two normals and store
-		glm::vec3 p1Norm = glm::normalize(vMap.GetPosition(p1) - center);
-		glm::vec3 p2Norm = glm::normalize(vMap.GetPosition(p2) - center);
-		glm::vec3 pos = glm::normalize((p1Norm + p2Norm) / 2.0f);
-		vMap.SetPosition(interpolated, center + (pos * scale));
-
-		// The normal is just the position
-		vMap.SetNormal(interpolated, pos);
-		
-		// Calculate the UV coordinates for the point and store them
-		float u = atan2f(pos.y, pos.x) / (2.0f * M_PI);
-		float v = (asinf(pos.z) / M_PI) + 0.5f;
-		vMap.SetTexture(interpolated, glm::vec2(u, v));
-
-		// If the vertex has a color, interpolate the color and store it
-		if (vMap.ColorOffset != -1) {
-			vMap.SetColor(interpolated, (vMap.GetColor(p1) + vMap.GetColor(p2)) / 2.0f);
-		}
-
-		// Get the index of the new vertex, store it in the cache
-		uint32_t ix = vertices.size();
-		midpointCache[key] = ix;
-
-		// Add vertex to data and return it's index
-		vertices.push_back(interpolated);
-		return ix;
-	}
-}
-
-/// <summary>
-/// Handles correcting UV seams on spheres
-/// </summary>
-/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
-/// <param name="verts">The vertices to work on</param>
-/// <param name="indices">The indices of the triangles in the mesh</param>
-/// <param name="offset">The offset into the index buffer to start modifying from, should be a multiple of 3</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
-template <typename Vertex>
-void CorrectUVSeams(std::vector<Vertex>& verts, std::vector<uint32_t>& indices, size_t offset, const VertexParamMap& vMap) {
-	// Early bail if the vertex type does not have a texture attribute
-	if (vMap.TextureOffset == -1) return;
-
-	// lambda closure to easily add a vertex with unique texture coordinate to our mesh
-	auto addVertex = [&](size_t ix, const glm::vec2& uv) {
-		const uint32_t index = indices[ix];
-		indices[ix] = (uint32_t)verts.size();
-		Vertex vert = verts[index];
-		vMap.SetTexture(vert, uv);
-		verts.push_back(vert);
-	};
-
-	// fix texture seams (this is where the magic happens) TODO: fix seams on tops and bottoms
-	const size_t current_tris = offset / 3;
-	const size_t numTriangles = (indices.size() - offset) / 3;
-	// Iterate over all the triangles we added 
-	for (size_t i = current_tris; i < current_tris + numTriangles; ++i) {
-		// Get the UV coordinates
-		const glm::vec2& uv0 = vMap.GetTexture(verts[indices[i * 3 + 0]]);
-		const glm::vec2& uv1 = vMap.GetTexture(verts[indices[i * 3 + 1]]);
-		const glm::vec2& uv2 = vMap.GetTexture(verts[indices[i * 3 + 2]]);
-
-		const float d1 = uv1.x - uv0.x;
-		const float d2 = uv2.x - uv0.x;
-
-		if (abs(d1) > 0.5f && abs(d2) > 0.5f)
-			addVertex(i * 3 + 0, uv0 + glm::vec2((d1 > 0.0f) ? 1.0f : -1.0f, 0.0f));
-		else if (abs(d1) > 0.5f)
-			addVertex(i * 3 + 1, uv1 + glm::vec2((d1 < 0.0f) ? 1.0f : -1.0f, 0.0f));
-		else if (abs(d2) > 0.5f)
-			addVertex(i * 3 + 2, uv2 + glm::vec2((d2 < 0.0f) ? 1.0f : -1.0f, 0.0f));
-	}
-}
-
-/// <summary>
-/// Calculates the position, normal, and UV coords for a vertex on a sphere (used for iso-sphere generation)
-/// </summary>
-/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
-/// <param name="norm">The normal of the vertex to calculate</param>
-/// <param name="scale">The scale of the sphere</param>
-/// <param name="center">The center point of the sphere</param>
-/// <param name="color">The color of the sphere vertex</param>
-/// <param name="vMap">The mapping of vertex attributes to use</param>
-/// <returns>A vertex with the position, normal, and UV components set</returns>
-template <typename Vertex>
-Vertex CalculateSphereVert(glm::vec3 norm, glm::vec3 scale, glm::vec3 center, const VertexParamMap& vMap, glm::vec4 color = glm::vec4(1.0f)) {
-	Vertex vert;
-	glm::vec3 pos = glm::normalize(norm);
-	float u = atan2f(pos.y, pos.x) / (2.0f * M_PI);
-	float v = (asinf(pos.z) / M_PI) + 0.5f;
-	vMap.SetPosition(vert, center + (pos * scale));
-	vMap.SetNormal(vert, pos);
-	vMap.SetTexture(vert, glm::vec2(u, v));
-	vMap.SetColor(vert, color);
-	return vert;
-}
-
 template <typename Vertex>
 void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& center, float radius, int tessellation, const glm::vec4& col) {
 	AddIcoSphere<Vertex>(data, center, glm::vec3(radius), tessellation, col);
@@ -301,94 +32,7 @@ void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& cente
 template <typename Vertex>
 void MeshFactory::AddIcoSphere(MeshBuilder<Vertex>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
 	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
-
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
-		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
-		return;
-	}
-
-	uint32_t indexOffset = data.GetVertexCount();
-	uint32_t initialIndex = data.GetIndexCount();
-	std::vector<glm::ivec3> faces;
-
-	uint32_t estimatedFaces = 12 + pow(tessellation + 1, 3);
-
-	float t = (1.0f + sqrtf(5.0f)) / 2.0f;
-
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, t, 0),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, t, 0),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-1, -t, 0), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(1, -t, 0),  radii, center, vMap, col));
-
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, t),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, t),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, -1, -t), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(0, 1, -t),  radii, center, vMap, col));
-
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, -1),  radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(t, 0, 1),   radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, -1), radii, center, vMap, col));
-	data._vertices.emplace_back(CalculateSphereVert<Vertex>(glm::vec3(-t, 0, 1),  radii, center, vMap, col));
-
-	glm::ivec3 iOff = glm::ivec3(indexOffset);
-
-	// 5 faces around point 0
-	faces.emplace_back(iOff + glm::ivec3(0, 11, 5));
-	faces.emplace_back(iOff + glm::ivec3(0, 5, 1));
-	faces.emplace_back(iOff + glm::ivec3(0, 1, 7));
-	faces.emplace_back(iOff + glm::ivec3(0, 7, 10));
-	faces.emplace_back(iOff + glm::ivec3(0, 10, 11));
-
-	// 5 adjacent faces
-	faces.emplace_back(iOff + glm::ivec3(1, 5, 9));
-	faces.emplace_back(iOff + glm::ivec3(5, 11, 4));
-	faces.emplace_back(iOff + glm::ivec3(11, 10, 2));
-	faces.emplace_back(iOff + glm::ivec3(10, 7, 6));
-	faces.emplace_back(iOff + glm::ivec3(7, 1, 8));
-
-	// 5 faces around point 3
-	faces.emplace_back(iOff + glm::ivec3(3, 9, 4));
-	faces.emplace_back(iOff + glm::ivec3(3, 4, 2));
-	faces.emplace_back(iOff + glm::ivec3(3, 2, 6));
-	faces.emplace_back(iOff + glm::ivec3(3, 6, 8));
-	faces.emplace_back(iOff + glm::ivec3(3, 8, 9));
-
-	// 5 adjacent faces
-	faces.emplace_back(iOff + glm::ivec3(4, 9, 5));
-	faces.emplace_back(iOff + glm::ivec3(2, 4, 11));
-	faces.emplace_back(iOff + glm::ivec3(6, 2, 10));
-	faces.emplace_back(iOff + glm::ivec3(8, 6, 7));
-	faces.emplace_back(iOff + glm::ivec3(9, 8, 1));
-
-	// Cache used to index our midpoints
-	std::unordered_map<uint64_t, uint32_t> midPointCache;
-
-	for (int ix = 0; ix < tessellation; ix++)
-	{
-		std::vector<glm::ivec3> tempFaces;
-		for (auto& indices : faces)
-		{
-			uint32_t a = AddMiddlePoint(radii, center, indices[0], indices[1], data._vertices, midPointCache, vMap);
-			uint32_t b = AddMiddlePoint(radii, center, indices[1], indices[2], data._vertices, midPointCache, vMap);
-			uint32_t c = AddMiddlePoint(radii, center, indices[2], indices[0], data._vertices, midPointCache, vMap);
-
-			tempFaces.emplace_back(glm::ivec3(indices[0], a, c));
-			tempFaces.emplace_back(glm::ivec3(indices[1], b, a));
-			tempFaces.emplace_back(glm::ivec3(indices[2], c, b));
-			tempFaces.emplace_back(glm::ivec3(a, b, c));
-		}
-		faces = tempFaces;
-	}
-
-	for (auto& face : faces) {
-		data._indices.push_back(face[0]);
-		data._indices.push_back(face[1]);
-		data._indices.push_back(face[2]);
-	}
-
-	CorrectUVSeams(data._vertices, data._indices, initialIndex, vMap);
-
+	__AddUnitSphere(data, GetUnitIcoSphere(tessellation), center, radii, col);
 }
 
 template <typename Vertex>
@@ -399,91 +43,32 @@ void MeshFactory::AddUvSphere(MeshBuilder<Vertex>& data, const glm::vec3& center
 template <typename Vertex>
 void MeshFactory::AddUvSphere(MeshBuilder<Vertex>& data, const glm::vec3& center, const glm::vec3& radii, int tessellation, const glm::vec4& col) {
 	LOG_ASSERT(tessellation >= 0, "Tessellation must be greater than zero!");
+	__AddUnitSphere(data, GetUnitUvSphere(tessellation), center, radii, col);
+}
 
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
-		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
-		return;
-	}
-
-	int slices = 1 + pow(2, tessellation + 1);
-	int stacks = (slices / 2) + 1;
-
-	int numverts = (slices + 1) * (slices - 1) + 2;
-	std::vector<Vertex>& verts = data._vertices;
-
-	uint32_t offset = verts.size();
-	uint32_t initialIndex = data._indices.size();
-	verts.reserve(verts.size() + numverts);
-
-	float stackAngle, sliceAngle;
-	float x, y, z, xy;
-
-	float dLong = (M_PI * 2) / slices;
-	float dLat = M_PI / stacks;
-
-	for (int i = 0; i <= stacks; ++i) {
-		stackAngle = M_PI / 2.0f - i * dLat;
-		xy = cosf(stackAngle);
-		z = sinf(stackAngle);
-
-		for (int j = 0; j <= slices; ++j) {
-			sliceAngle = j * dLong;
-
-			x = xy * cosf(sliceAngle);
-			y = xy * sinf(sliceAngle);
+template <typename Vertex>
+void MeshFactory::__AddUnitSphere(MeshBuilder<Vertex>& data, const UnitSphere& sphere, const glm::vec3& center, const glm::vec3& radii, const glm::vec4& col) {
+	typedef VertexLayout<Vertex> Layout;
+	static_assert(Layout::HAS_POSITION, "Vertex type must have a position to add a sphere");
 
-			glm::vec3 normal = glm::vec3(x, y, z);
-			glm::vec2 uv = glm::vec2((float)j / slices, 1.0f - (float)i / stacks);
+	// Do all the positions in one go, then we just need to interleave everything into the vertices
+	std::vector<glm::vec3> positions(sphere.Normals.size());
+	TransformUnitSphere(sphere, center, radii, positions.data());
 
-			Vertex vert;
-			vMap.SetNormal(vert, normal);
-			vMap.SetPosition(vert, center + (normal * radii));
-			vMap.SetTexture(vert, uv);
-			vMap.SetColor(vert, col);
-			verts.push_back(vert);
-		}
-	}
-	vMap.SetTexture(verts[offset], { 0.5f, 1.0f });
-	vMap.SetTexture(verts[verts.size() - 1], { 0.5f, 0.0f });
-		
-	int numIndices = (slices - 1) * slices * 6;
-	data._indices.reserve(data._indices.size() + numIndices);
-
-	// Body loop
-	int k1, k2;
-	for (int i = 0; i < stacks; ++i)
-	{
-		k1 = i * (slices + 1);
-		k2 = k1 + slices + 1;
-		for (int j = 0; j < slices; ++j, ++k1, ++k2)
-		{
-			// Our top loop
-			if (i != 0) {
-				data._indices.push_back(offset + k1);
-				data._indices.push_back(offset + k2);
-				data._indices.push_back(offset + k1 + 1);
-			}
-
-			// Everything but our bottom loop
-			if (i != (stacks - 1)) {
-				data._indices.push_back(offset + k1 + 1);
-				data._indices.push_back(offset + k2);
-				data._indices.push_back(offset + k2 + 1);
-			}
-		}
+	data.ReserveVertexSpace(positions.size());
+	uint32_t offset = static_cast<uint32_t>(data.GetVertexCount());
+	for (size_t ix = 0; ix < positions.size(); ix++) {
+		data.AddVertex(Layout::Create(positions[ix], sphere.Normals[ix], sphere.UVs[ix], col));
 	}
+	data.AddIndexRange(sphere.Indices.data(), sphere.Indices.size(), offset);
 }
 
 template <typename Vertex>
 void MeshFactory::AddPlane(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, const glm::vec3& normal,
 	const glm::vec3& tangent, const glm::vec2& scale, const glm::vec4& col)
 {
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
-		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
-		return;
-	}
+	typedef VertexLayout<Vertex> Layout;
+	static_assert(Layout::HAS_POSITION, "Vertex type must have a position to add a plane");
 
 	glm::vec3 nNorm = glm::normalize(normal);
 	glm::vec3 nTangent = glm::normalize(tangent);
@@ -505,17 +90,13 @@ void MeshFactory::AddPlane(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, cons
 
 	Vertex verts[4];
 	for(int ix = 0; ix < 4; ix++) {
-		vMap.SetPosition(verts[ix], positions[ix]);
-		vMap.SetNormal(verts[ix], nNorm);
-		vMap.SetTexture(verts[ix], uvs[ix]);
-		vMap.SetColor(verts[ix], col);
+		verts[ix] = Layout::Create(positions[ix], nNorm, uvs[ix], col);
 	}
 
-
-	const uint32_t p1 = mesh.AddVertex(positions[0], nNorm, uvs[0], col);
-	const uint32_t p2 = mesh.AddVertex(positions[1], nNorm, uvs[1], col);
-	const uint32_t p3 = mesh.AddVertex(positions[2], nNorm, uvs[2], col);
-	const uint32_t p4 = mesh.AddVertex(positions[3], nNorm, uvs[3], col);
+	const uint32_t p1 = mesh.AddVertexRange(verts, 4);
+	const uint32_t p2 = p1 + 1;
+	const uint32_t p3 = p1 + 2;
+	const uint32_t p4 = p1 + 3;
 
 	mesh.AddIndexTri(p1, p3, p2);
 	mesh.AddIndexTri(p1, p4, p3);
@@ -530,11 +111,8 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::vec3& pos, const
 template <typename Vertex>
 void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform, const glm::vec4& col) {
 
-	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
-	if (vMap.PositionOffset == -1) {
-		LOG_WARN("Vertex type does not have position attribute, aborting AddIcoSphere");
-		return;
-	}
+	typedef VertexLayout<Vertex> Layout;
+	static_assert(Layout::HAS_POSITION, "Vertex type must have a position to add a cube");
 
 	glm::vec3 positions[] = {
 		glm::vec3(-0.5f, -0.5f, -0.5f),
@@ -547,9 +125,7 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform,
 		glm::vec3(-0.5f,  0.5f,  0.5f),
 		glm::vec3(0.5f,  0.5f,  0.5f),
 	};
-	for (auto& position : positions) {
-		position = transform * glm::vec4(position, 1.0f);
-	}
+	SimdKernels::TransformPoints(transform, positions, positions, 8);
 
 	glm::vec3 normals[] = {
 		glm::vec3(-1.0f,  0.0f,  0.0f), //0
@@ -559,10 +135,9 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform,
 		glm::vec3(0.0f,  0.0f, -1.0f), //4
 		glm::vec3(0.0f,  0.0f,  1.0f),
 	};
-	glm::mat3 rotation = transform; // Truncate the transform to just the rotation component for normals
-	for (auto& normal : normals) {
-		normal = rotation * normal;
-	}
+	// Use the inverse transpose so that non-uniform scales don't skew the normals
+	const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+	SimdKernels::TransformNormals(normalMatrix, normals, normals, 6);
 
 	glm::vec2 uvs[] = {
 		glm::vec2(0.0f, 0.0f), // 0
@@ -578,37 +153,37 @@ void MeshFactory::AddCube(MeshBuilder<Vertex>& mesh, const glm::mat4& transform,
 	mesh.ReserveVertexSpace(24);
 
 	// Bottom
-	indices[0] = mesh.AddVertex(Create<Vertex>(positions[0], normals[4], uvs[0], col, vMap));
-	indices[1] = mesh.AddVertex(Create<Vertex>(positions[2], normals[4], uvs[1], col, vMap));
-	indices[2] = mesh.AddVertex(Create<Vertex>(positions[3], normals[4], uvs[2], col, vMap));
-	indices[3] = mesh.AddVertex(Create<Vertex>(positions[1], normals[4], uvs[3], col, vMap));
+	indices[0] = mesh.AddVertex(Layout::Create(positions[0], normals[4], uvs[0], col));
+	indices[1] = mesh.AddVertex(Layout::Create(positions[2], normals[4], uvs[1], col));
+	indices[2] = mesh.AddVertex(Layout::Create(positions[3], normals[4], uvs[2], col));
+	indices[3] = mesh.AddVertex(Layout::Create(positions[1], normals[4], uvs[3], col));
 	// Top
-	indices[4] = mesh.AddVertex(Create<Vertex>(positions[6], normals[5], uvs[0], col, vMap));
-	indices[5] = mesh.AddVertex(Create<Vertex>(positions[4], normals[5], uvs[1], col, vMap));
-	indices[6] = mesh.AddVertex(Create<Vertex>(positions[5], normals[5], uvs[2], col, vMap));
-	indices[7] = mesh.AddVertex(Create<Vertex>(positions[7], normals[5], uvs[3], col, vMap));
+	indices[4] = mesh.AddVertex(Layout::Create(positions[6], normals[5], uvs[0], col));
+	indices[5] = mesh.AddVertex(Layout::Create(positions[4], normals[5], uvs[1], col));
+	indices[6] = mesh.AddVertex(Layout::Create(positions[5], normals[5], uvs[2], col));
+	indices[7] = mesh.AddVertex(Layout::Create(positions[7], normals[5], uvs[3], col));
 
 	// Left
-	indices[8]  = mesh.AddVertex(Create<Vertex>(positions[0], normals[0], uvs[0], col, vMap));
-	indices[9]  = mesh.AddVertex(Create<Vertex>(positions[4], normals[0], uvs[1], col, vMap));
-	indices[10] = mesh.AddVertex(Create<Vertex>(positions[6], normals[0], uvs[2], col, vMap));
-	indices[11] = mesh.AddVertex(Create<Vertex>(positions[2], normals[0], uvs[3], col, vMap));
+	indices[8]  = mesh.AddVertex(Layout::Create(positions[0], normals[0], uvs[0], col));
+	indices[9]  = mesh.AddVertex(Layout::Create(positions[4], normals[0], uvs[1], col));
+	indices[10] = mesh.AddVertex(Layout::Create(positions[6], normals[0], uvs[2], col));
+	indices[11] = mesh.AddVertex(Layout::Create(positions[2], normals[0], uvs[3], col));
 	// Right
-	indices[12] = mesh.AddVertex(Create<Vertex>(positions[3], normals[1], uvs[0], col, vMap));
-	indices[13] = mesh.AddVertex(Create<Vertex>(positions[7], normals[1], uvs[1], col, vMap));
-	indices[14] = mesh.AddVertex(Create<Vertex>(positions[5], normals[1], uvs[2], col, vMap));
-	indices[15] = mesh.AddVertex(Create<Vertex>(positions[1], normals[1], uvs[3], col, vMap));
+	indices[12] = mesh.AddVertex(Layout::Create(positions[3], normals[1], uvs[0], col));
+	indices[13] = mesh.AddVertex(Layout::Create(positions[7], normals[1], uvs[1], col));
+	indices[14] = mesh.AddVertex(Layout::Create(positions[5], normals[1], uvs[2], col));
+	indices[15] = mesh.AddVertex(Layout::Create(positions[1], normals[1], uvs[3], col));
 
 	// Front
-	indices[16] = mesh.AddVertex(Create<Vertex>(positions[2], normals[3], uvs[0], col, vMap));
-	indices[17] = mesh.AddVertex(Create<Vertex>(positions[6], normals[3], uvs[1], col, vMap));
-	indices[18] = mesh.AddVertex(Create<Vertex>(positions[7], normals[3], uvs[2], col, vMap));
-	indices[19] = mesh.AddVertex(Create<Vertex>(positions[3], normals[3], uvs[3], col, vMap));
+	indices[16] = mesh.AddVertex(Layout::Create(positions[2], normals[3], uvs[0], col));
+	indices[17] = mesh.AddVertex(Layout::Create(positions[6], normals[3], uvs[1], col));
+	indices[18] = mesh.AddVertex(Layout::Create(positions[7], normals[3], uvs[2], col));
+	indices[19] = mesh.AddVertex(Layout::Create(positions[3], normals[3], uvs[3], col));
 	// Back
-	indices[20] = mesh.AddVertex(Create<Vertex>(positions[1], normals[2], uvs[0], col, vMap));
-	indices[21] = mesh.AddVertex(Create<Vertex>(positions[5], normals[2], uvs[1], col, vMap));
-	indices[22] = mesh.AddVertex(Create<Vertex>(positions[4], normals[2], uvs[2], col, vMap));
-	indices[23] = mesh.AddVertex(Create<Vertex>(positions[0], normals[2], uvs[3], col, vMap));
+	indices[20] = mesh.AddVertex(Layout::Create(positions[1], normals[2], uvs[0], col));
+	indices[21] = mesh.AddVertex(Layout::Create(positions[5], normals[2], uvs[1], col));
+	indices[22] = mesh.AddVertex(Layout::Create(positions[4], normals[2], uvs[2], col));
+	indices[23] = mesh.AddVertex(Layout::Create(positions[0], normals[2], uvs[3], col));
 
 	#pragma endregion
 
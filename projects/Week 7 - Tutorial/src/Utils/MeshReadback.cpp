@@ -0,0 +1,87 @@
+#include "MeshReadback.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+/// <summary>
+/// Reads a float attribute back from a mesh's vertex buffers, caching the buffer data in case other attributes share it
+/// </summary>
+/// <returns>True if the mesh has the attribute, false if otherwise</returns>
+template <typename T>
+static bool ReadAttribute(const VertexArrayObject::Sptr& mesh, AttribUsage usage, std::map<GLuint, std::vector<uint8_t>>& cache, std::vector<T>& out, const T& defaultValue) {
+	for (const auto& binding : mesh->GetVertexBuffers()) {
+		if (binding.InstanceDivisor != 0) {
+			continue;
+		}
+		for (const BufferAttribute& attrib : binding.Attributes) {
+			if (attrib.Usage != usage || attrib.Type != AttributeType::Float) {
+				continue;
+			}
+
+			const VertexBuffer::Sptr& buffer = binding.Buffer;
+			std::vector<uint8_t>& data = cache[buffer->GetHandle()];
+			if (data.empty()) {
+				data.resize(buffer->GetTotalSize());
+				glGetNamedBufferSubData(buffer->GetHandle(), 0, data.size(), data.data());
+			}
+
+			size_t stride = attrib.Stride == 0 ? sizeof(float) * attrib.Size : attrib.Stride;
+			size_t components = std::min(static_cast<size_t>(attrib.Size), static_cast<size_t>(T::length()));
+			out.resize(buffer->GetElementCount(), defaultValue);
+			for (size_t ix = 0; ix < out.size(); ix++) {
+				memcpy(&out[ix], data.data() + ix * stride + attrib.Offset, components * sizeof(float));
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MeshReadback::Read(const VertexArrayObject::Sptr& mesh, MeshData& result) {
+	result = MeshData();
+	if (mesh == nullptr) {
+		return false;
+	}
+
+	std::map<GLuint, std::vector<uint8_t>> cache;
+	if (!ReadAttribute(mesh, AttribUsage::Position, cache, result.Positions, glm::vec3(0.0f)) || result.Positions.empty()) {
+		return false;
+	}
+	const size_t vertexCount = result.Positions.size();
+	ReadAttribute(mesh, AttribUsage::Normal, cache, result.Normals, glm::vec3(0.0f));
+	ReadAttribute(mesh, AttribUsage::Texture, cache, result.UVs, glm::vec2(0.0f));
+	ReadAttribute(mesh, AttribUsage::Color, cache, result.Colors, glm::vec4(1.0f));
+	// Missing attributes get defaults, and attributes can come from different buffers, so line everything up with the positions
+	result.Normals.resize(vertexCount, glm::vec3(0.0f));
+	result.UVs.resize(vertexCount, glm::vec2(0.0f));
+	result.Colors.resize(vertexCount, glm::vec4(1.0f));
+
+	const IndexBuffer::Sptr& indexBuffer = mesh->GetIndexBuffer();
+	if (indexBuffer != nullptr) {
+		std::vector<uint8_t> raw(indexBuffer->GetTotalSize());
+		glGetNamedBufferSubData(indexBuffer->GetHandle(), 0, raw.size(), raw.data());
+		result.Indices.resize(indexBuffer->GetElementCount());
+		for (size_t ix = 0; ix < result.Indices.size(); ix++) {
+			switch (indexBuffer->GetElementType()) {
+				case IndexType::UByte:  result.Indices[ix] = raw[ix]; break;
+				case IndexType::UShort: result.Indices[ix] = reinterpret_cast<const uint16_t*>(raw.data())[ix]; break;
+				case IndexType::UInt:   result.Indices[ix] = reinterpret_cast<const uint32_t*>(raw.data())[ix]; break;
+				default: return false;
+			}
+			if (result.Indices[ix] >= vertexCount) {
+				LOG_WARN("Mesh has an index out of range, cannot read it back");
+				return false;
+			}
+		}
+	} else {
+		result.Indices.resize(vertexCount);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			result.Indices[ix] = static_cast<uint32_t>(ix);
+		}
+	}
+	// Drop any partial triangle at the end
+	result.Indices.resize((result.Indices.size() / 3) * 3);
+	return !result.Indices.empty();
+}
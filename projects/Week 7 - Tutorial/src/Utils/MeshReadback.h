@@ -0,0 +1,39 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// The contents of a mesh after being read back from the GPU, with every attribute split into its own array.
+/// Attributes that the mesh does not have are filled with defaults, so all the arrays are the same length
+/// </summary>
+struct MeshData {
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> UVs;
+	std::vector<glm::vec4> Colors;
+	// 3 indices per triangle, meshes without an index buffer get one generated
+	std::vector<uint32_t>  Indices;
+};
+
+/// <summary>
+/// Helper class for reading meshes back from their OpenGL buffers, for tools that need to process mesh data
+/// on the CPU after it has been uploaded. This stalls on the GPU, so it should only be used at load or bake time
+/// </summary>
+class MeshReadback
+{
+public:
+	/// <summary>
+	/// Reads the float position, normal, UV and color attributes and the indices of a mesh
+	/// </summary>
+	/// <param name="mesh">The mesh to read</param>
+	/// <param name="result">Receives the mesh data</param>
+	/// <returns>True if the mesh had positions and valid indices, false if otherwise</returns>
+	static bool Read(const VertexArrayObject::Sptr& mesh, MeshData& result);
+
+protected:
+	MeshReadback() = default;
+	~MeshReadback() = default;
+};
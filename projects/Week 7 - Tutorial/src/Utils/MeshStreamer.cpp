@@ -0,0 +1,213 @@
+#include "MeshStreamer.h"
+#include <Logging.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <imgui.h>
+
+bool MeshStreamer::_isInitialized = false;
+size_t MeshStreamer::_uploadedBytes = 0;
+std::unordered_map<VertexArrayObject*, std::shared_ptr<MeshStreamer::StreamedMesh>> MeshStreamer::_meshes;
+std::vector<MeshStreamer::LoadedPage> MeshStreamer::_readyPages;
+std::vector<std::thread> MeshStreamer::_workers;
+std::mutex MeshStreamer::_jobMutex;
+std::condition_variable MeshStreamer::_jobSignal;
+std::queue<std::shared_ptr<MeshStreamer::StreamedMesh>> MeshStreamer::_pendingJobs;
+std::queue<MeshStreamer::LoadedPage> MeshStreamer::_completedPages;
+bool MeshStreamer::_isRunning = false;
+
+void MeshStreamer::Init(uint32_t numThreads) {
+	if (_isInitialized) return;
+
+	_uploadedBytes = 0;
+	_isRunning = true;
+	numThreads = std::max(numThreads, 1u);
+	for (uint32_t ix = 0; ix < numThreads; ix++) {
+		_workers.emplace_back(&MeshStreamer::__WorkerThread);
+	}
+	_isInitialized = true;
+}
+
+void MeshStreamer::Cleanup() {
+	if (!_isInitialized) return;
+
+	// Wake up all our workers and let them exit, any meshes still streaming keep whatever page they have
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_isRunning = false;
+		while (!_pendingJobs.empty()) _pendingJobs.pop();
+	}
+	_jobSignal.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	while (!_completedPages.empty()) _completedPages.pop();
+
+	_readyPages.clear();
+	_meshes.clear();
+	_isInitialized = false;
+}
+
+VertexArrayObject::Sptr MeshStreamer::Load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open file");
+	}
+	std::vector<ProgressiveMesh::PageEntry> pages;
+	if (!ProgressiveMesh::ReadPageTable(file, pages)) {
+		throw std::runtime_error("File is not a valid progressive mesh");
+	}
+
+	// Without the streamer we have no way to refine the mesh later, so go straight to the full detail page
+	uint32_t firstPage = _isInitialized ? 0 : (uint32_t)pages.size() - 1;
+	ProgressiveMeshPage page;
+	if (!ProgressiveMesh::ReadPage(file, pages[firstPage], page)) {
+		throw std::runtime_error("Failed to read progressive mesh page");
+	}
+	VertexArrayObject::Sptr result = ProgressiveMesh::CreateMesh(page);
+
+	if (_isInitialized && pages.size() > 1) {
+		std::shared_ptr<StreamedMesh> entry = std::make_shared<StreamedMesh>();
+		entry->Mesh = result;
+		entry->Path = path;
+		entry->Pages = std::move(pages);
+		entry->ResidentPage = firstPage;
+		_meshes[result.get()] = entry;
+
+		// Hand the rest of the pages off to our workers
+		{
+			std::lock_guard<std::mutex> lock(_jobMutex);
+			_pendingJobs.push(entry);
+		}
+		_jobSignal.notify_one();
+	}
+
+	return result;
+}
+
+size_t MeshStreamer::Update() {
+	if (!_isInitialized) return 0;
+	return __ApplyPages(MAX_UPLOAD_PER_FRAME);
+}
+
+void MeshStreamer::WaitForPending() {
+	if (!_isInitialized) return;
+	while (!_meshes.empty()) {
+		if (__ApplyPages(SIZE_MAX) == 0) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool MeshStreamer::IsStreaming(const VertexArrayObject::Sptr& mesh) {
+	return _meshes.find(mesh.get()) != _meshes.end();
+}
+
+void MeshStreamer::DrawImGui() {
+	ImGui::Text("Streaming meshes: %d", (int)_meshes.size());
+	ImGui::Text("Mesh data uploaded: %.2f MB", _uploadedBytes / (1024.0f * 1024.0f));
+}
+
+void MeshStreamer::__WorkerThread() {
+	while (true) {
+		std::shared_ptr<StreamedMesh> job;
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_jobSignal.wait(lock, [] { return !_isRunning || !_pendingJobs.empty(); });
+			if (!_isRunning) {
+				return;
+			}
+			job = _pendingJobs.front();
+			_pendingJobs.pop();
+		}
+
+		__ReadPages(job);
+	}
+}
+
+void MeshStreamer::__ReadPages(const std::shared_ptr<StreamedMesh>& mesh) {
+	// The page table and path never change after the mesh is queued, so we can read them without locking
+	std::ifstream file(mesh->Path, std::ios::binary);
+	for (uint32_t ix = mesh->ResidentPage + 1; ix < mesh->Pages.size(); ix++) {
+		LoadedPage page;
+		page.Mesh = mesh;
+		page.Index = ix;
+		if (!file || !ProgressiveMesh::ReadPage(file, mesh->Pages[ix], page.Data)) {
+			page.Index = FAILED_PAGE;
+			page.Data = ProgressiveMeshPage();
+		}
+
+		const bool failed = page.Index == FAILED_PAGE;
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		if (!_isRunning) {
+			return;
+		}
+		_completedPages.push(std::move(page));
+		if (failed) {
+			return;
+		}
+	}
+}
+
+size_t MeshStreamer::__ApplyPages(size_t budget) {
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		while (!_completedPages.empty()) {
+			_readyPages.push_back(std::move(_completedPages.front()));
+			_completedPages.pop();
+		}
+	}
+	if (_readyPages.empty()) {
+		return 0;
+	}
+
+	// If a mesh has several pages waiting, only the finest one is worth uploading
+	std::unordered_map<StreamedMesh*, uint32_t> finestReady;
+	for (const LoadedPage& page : _readyPages) {
+		if (page.Index != FAILED_PAGE) {
+			uint32_t& finest = finestReady[page.Mesh.get()];
+			finest = std::max(finest, page.Index);
+		}
+	}
+
+	size_t uploaded = 0, refined = 0;
+	std::vector<LoadedPage> deferred;
+	for (LoadedPage& page : _readyPages) {
+		StreamedMesh& mesh = *page.Mesh;
+		auto it = _meshes.find(mesh.Mesh.get());
+		if (it == _meshes.end() || it->second.get() != &mesh) {
+			continue;
+		}
+		if (page.Index == FAILED_PAGE) {
+			// Let any pages we've held back for the budget go up before we stop tracking the mesh
+			bool hasDeferred = std::any_of(deferred.begin(), deferred.end(), [&](const LoadedPage& other) { return other.Mesh.get() == &mesh; });
+			if (hasDeferred) {
+				deferred.push_back(std::move(page));
+				continue;
+			}
+			LOG_WARN("Failed to stream the rest of \"{}\", it will stay at page {} of {}", mesh.Path, mesh.ResidentPage + 1, mesh.Pages.size());
+			_meshes.erase(it);
+			continue;
+		}
+		if (page.Index < finestReady[&mesh]) {
+			continue;
+		}
+
+		size_t size = mesh.Pages[page.Index].GetDataSize();
+		if (uploaded > 0 && uploaded + size > budget) {
+			deferred.push_back(std::move(page));
+			continue;
+		}
+		ProgressiveMesh::UploadPage(mesh.Mesh, page.Data);
+		mesh.ResidentPage = page.Index;
+		uploaded += size;
+		refined++;
+		if (page.Index + 1 == mesh.Pages.size()) {
+			_meshes.erase(it);
+		}
+	}
+	_readyPages = std::move(deferred);
+	_uploadedBytes += uploaded;
+	return refined;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <cstdint>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/ProgressiveMesh.h"
+
+/// <summary>
+/// Helper class for streaming in progressive meshes (.pmesh files). Loading a mesh only reads it's coarsest
+/// page before returning, so the mesh can be drawn right away no matter how large the full mesh is. The finer
+/// pages are read on background threads, and swapped into the mesh on the main thread as they arrive.
+///
+/// Pages replace the mesh's buffer contents in place, so anything holding onto the mesh picks up the new
+/// detail automatically. Anything that was derived from the mesh's data (ex: bounds) should be refreshed
+/// when Update reports that meshes were refined
+/// </summary>
+class MeshStreamer {
+public:
+	/// <summary>
+	/// Initializes the mesh streamer, should be called after OpenGL has been initialized
+	/// </summary>
+	/// <param name="numThreads">The number of background threads to use for reading pages</param>
+	static void Init(uint32_t numThreads = 1);
+	/// <summary>
+	/// Stops all background threads and releases streaming data, should be called before closing the application
+	/// </summary>
+	static void Cleanup();
+	/// <summary>
+	/// Returns true if the streamer has been initialized and can stream meshes
+	/// </summary>
+	static bool IsInitialized() { return _isInitialized; }
+
+	/// <summary>
+	/// Loads a progressive mesh. The coarsest page is loaded before returning, and if the streamer is running the
+	/// rest of the pages are streamed in afterwards. If the streamer isn't running, the finest page is loaded instead
+	/// </summary>
+	/// <param name="path">The path to the .pmesh file to load</param>
+	/// <returns>The mesh that will be streamed into</returns>
+	static VertexArrayObject::Sptr Load(const std::string& path);
+
+	/// <summary>
+	/// Uploads pages that have finished loading, should be called once per frame on the main thread
+	/// </summary>
+	/// <returns>The number of meshes that gained detail this frame</returns>
+	static size_t Update();
+
+	/// <summary>
+	/// Blocks until every mesh has finished streaming, and uploads all of their finest pages
+	/// </summary>
+	static void WaitForPending();
+
+	/// <summary>
+	/// Returns true if the given mesh still has finer pages waiting to be streamed in
+	/// </summary>
+	static bool IsStreaming(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
+	/// Gets the number of meshes that still have pages waiting to be streamed in
+	/// </summary>
+	static size_t GetPendingCount() { return _meshes.size(); }
+
+	/// <summary>
+	/// Draws an ImGui widget showing the streaming stats
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The most bytes of mesh data we will upload in a single frame, to avoid hitches. We always upload at least one page
+	/// </summary>
+	static const size_t MAX_UPLOAD_PER_FRAME = 16 * 1024 * 1024;
+
+protected:
+	MeshStreamer() = default;
+
+	// Tracks the streaming state of a single mesh
+	struct StreamedMesh {
+		VertexArrayObject::Sptr                 Mesh;
+		std::string                             Path;
+		std::vector<ProgressiveMesh::PageEntry> Pages;
+		// The page that is currently uploaded to the mesh
+		uint32_t                                ResidentPage = 0;
+	};
+
+	// A page that has been read by a worker thread, and is waiting to be uploaded
+	struct LoadedPage {
+		std::shared_ptr<StreamedMesh> Mesh;
+		// The index of the page, or FAILED_PAGE if the worker couldn't read the rest of the mesh
+		uint32_t                      Index;
+		ProgressiveMeshPage           Data;
+	};
+	static const uint32_t FAILED_PAGE = UINT32_MAX;
+
+	static bool _isInitialized;
+	static size_t _uploadedBytes;
+
+	// Only touched by the main thread
+	static std::unordered_map<VertexArrayObject*, std::shared_ptr<StreamedMesh>> _meshes;
+	static std::vector<LoadedPage> _readyPages;
+
+	// Meshes are handed to the worker threads, which hand back their pages one at a time
+	static std::vector<std::thread> _workers;
+	static std::mutex _jobMutex;
+	static std::condition_variable _jobSignal;
+	static std::queue<std::shared_ptr<StreamedMesh>> _pendingJobs;
+	static std::queue<LoadedPage> _completedPages;
+	static bool _isRunning;
+
+	static void __WorkerThread();
+	static void __ReadPages(const std::shared_ptr<StreamedMesh>& mesh);
+	static size_t __ApplyPages(size_t budget);
+};
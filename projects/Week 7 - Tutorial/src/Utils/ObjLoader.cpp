@@ -1,4 +1,5 @@
 #include "ObjLoader.h"
+#include "Utils/SimdKernels.h"
 
 #include <string>
 #include <sstream>
@@ -47,6 +48,22 @@ static inline std::vector<std::string> SplitString(const std::string& text, cons
 #pragma endregion 
 
 VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
+{
+	std::vector<VertexPosNormTexCol> vertexData = ParseFile(filename);
+
+	// Create a vertex buffer and load all our vertex data
+	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
+	vertexBuffer->LoadData(vertexData.data(), vertexData.size());
+
+	// Create the VAO, and add the vertices
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
+
+	return result;
+	//return VertexArrayObject::Create();
+}
+
+std::vector<VertexPosNormTexCol> ObjLoader::ParseFile(const std::string& filename)
 {
 	// Open our file in binary mode
 	std::ifstream file;
@@ -131,28 +148,26 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 
 	// TODO: Generate mesh from the data we loaded
 	std::vector<VertexPosNormTexCol> vertexData;
+	vertexData.reserve(vertices.size());
+
+	// Gather the positions and normals in bulk, the position and normal indices are every 3rd int in our vertex list
+	std::vector<glm::vec3> vertexPositions(vertices.size());
+	std::vector<glm::vec3> vertexNormals(vertices.size());
+	if (!vertices.empty()) {
+		SimdKernels::GatherVec3(positions.data(), &vertices[0].x, 3, vertexPositions.data(), vertices.size());
+		SimdKernels::GatherVec3(normals.data(), &vertices[0].z, 3, vertexNormals.data(), vertices.size());
+	}
 
 	for (int ix = 0; ix < vertices.size(); ix++) {
 		glm::ivec3 attribs = vertices[ix];
 
 		// Extract attributes from lists (except color)
-		glm::vec3 position = positions[attribs.x];
 		glm::vec2 uv       = uvs[attribs.y];
-		glm::vec3 normal   = normals[attribs.z];
 		glm::vec4 color    = glm::vec4(1.0f);
 
 		// Add the vertex to the mesh
-		vertexData.push_back(VertexPosNormTexCol(position, normal, uv, color));
+		vertexData.push_back(VertexPosNormTexCol(vertexPositions[ix], vertexNormals[ix], uv, color));
 	}
 
-	// Create a vertex buffer and load all our vertex data
-	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
-	vertexBuffer->LoadData(vertexData.data(), vertexData.size());
-
-	// Create the VAO, and add the vertices
-	VertexArrayObject::Sptr result = VertexArrayObject::Create();
-	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
-
-	return result;
-	//return VertexArrayObject::Create();
+	return vertexData;
 }
@@ -7,6 +7,11 @@ class ObjLoader
 {
 public:
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	/// <summary>
+	/// Parses an OBJ file into a list of vertices (3 per triangle) without touching OpenGL, so it can be run on
+	/// a background thread and uploaded later
+	/// </summary>
+	static std::vector<VertexPosNormTexCol> ParseFile(const std::string& filename);
 
 protected:
 	ObjLoader() = default;
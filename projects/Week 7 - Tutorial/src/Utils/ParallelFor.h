@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Splits [0, count) into batches that get handed out to a pool of threads, returns once all batches are done.
+/// The function is called as func(begin, end) for each batch
+/// </summary>
+/// <param name="count">The number of items to process</param>
+/// <param name="batchSize">The number of items a thread grabs at a time</param>
+/// <param name="numThreads">The number of threads to use, including the calling thread</param>
+template <typename Func>
+void ParallelFor(size_t count, size_t batchSize, uint32_t numThreads, const Func& func) {
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (;;) {
+			size_t begin = next.fetch_add(batchSize);
+			if (begin >= count) {
+				break;
+			}
+			func(begin, std::min(begin + batchSize, count));
+		}
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t ix = 1; ix < numThreads; ix++) {
+		threads.emplace_back(worker);
+	}
+	// The calling thread pitches in too
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
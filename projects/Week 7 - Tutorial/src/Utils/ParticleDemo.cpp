@@ -0,0 +1,70 @@
+#include "ParticleDemo.h"
+#include <TTK/ParticleSystem.h>
+#include <imgui.h>
+
+std::unique_ptr<TTK::ParticleSystem> ParticleDemo::_system = nullptr;
+bool ParticleDemo::_isEnabled = false;
+std::unique_ptr<TTK::ParticleBenchmarkResult> ParticleDemo::_benchmark = nullptr;
+
+void ParticleDemo::Cleanup() {
+	_system = nullptr;
+	_benchmark = nullptr;
+}
+
+void ParticleDemo::Update(float dt) {
+	if (_isEnabled && _system != nullptr) {
+		_system->Update(dt);
+	}
+}
+
+void ParticleDemo::Draw(const Camera::Sptr& camera) {
+	if (_isEnabled && _system != nullptr) {
+		_system->Draw(camera->GetView(), camera->GetProjection());
+	}
+}
+
+void ParticleDemo::DrawImGui(const Camera::Sptr& camera) {
+	if (!ImGui::CollapsingHeader("Particles")) {
+		return;
+	}
+
+	ImGui::Checkbox("Enable Particles", &_isEnabled);
+	// The system needs our GL context, so we only make it once someone asks for it
+	if (_isEnabled && _system == nullptr) {
+		_system = std::make_unique<TTK::ParticleSystem>(MAX_PARTICLES);
+		TTK::EmitterSettings& settings = _system->Settings();
+		settings.Position = glm::vec3(0.0f, 0.0f, 1.0f);
+		settings.PositionSpread = glm::vec3(0.1f);
+		settings.Velocity = glm::vec3(0.0f, 0.0f, 5.0f);
+		settings.VelocitySpread = glm::vec3(1.5f, 1.5f, 1.0f);
+		settings.EmitRate = 20000.0f;
+		settings.StartColor = glm::vec4(1.0f, 0.8f, 0.3f, 1.0f);
+		settings.EndColor = glm::vec4(1.0f, 0.2f, 0.0f, 0.0f);
+	}
+
+	if (_system != nullptr) {
+		TTK::EmitterSettings& settings = _system->Settings();
+		ImGui::DragFloat3("Emitter Position", &settings.Position.x, 0.05f);
+		ImGui::DragFloat("Emit Rate", &settings.EmitRate, 100.0f, 0.0f, 1000000.0f);
+		bool useCompute = _system->GetUseCompute();
+		if (ImGui::Checkbox("Simulate on GPU", &useCompute)) {
+			_system->SetUseCompute(useCompute);
+		}
+		ImGui::Text("%zu / %zu particles, %u threads (%s)", _system->GetAliveCount(), _system->GetMaxParticles(),
+			_system->GetThreadCount(), TTK::ParticleSystem::GetSimdName());
+		ImGui::Text("Update: %.3fms, Draw: %.3fms", _system->GetLastUpdateMs(), _system->GetLastDrawMs());
+	}
+
+	// The benchmark stalls on the GPU for it's timings, so it's only run when asked
+	if (ImGui::Button("Run 1M Particle Benchmark")) {
+		_benchmark = std::make_unique<TTK::ParticleBenchmarkResult>(
+			TTK::ParticleSystem::RunBenchmark(camera->GetView(), camera->GetProjection(), BENCHMARK_PARTICLES));
+	}
+	if (_benchmark != nullptr) {
+		ImGui::Text("%zu particles, %u threads, %d frames", _benchmark->Particles, _benchmark->Threads, _benchmark->Frames);
+		ImGui::Text("CPU:     update %.3fms (GPU %.3fms), draw %.3fms (GPU %.3fms)",
+			_benchmark->Cpu.UpdateCpuMs, _benchmark->Cpu.UpdateGpuMs, _benchmark->Cpu.DrawCpuMs, _benchmark->Cpu.DrawGpuMs);
+		ImGui::Text("Compute: update %.3fms (GPU %.3fms), draw %.3fms (GPU %.3fms)",
+			_benchmark->Compute.UpdateCpuMs, _benchmark->Compute.UpdateGpuMs, _benchmark->Compute.DrawCpuMs, _benchmark->Compute.DrawGpuMs);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include "Camera.h"
+
+// Will be included in the CPP to avoid header bloat
+namespace TTK {
+	class ParticleSystem;
+	struct ParticleBenchmarkResult;
+}
+
+/// <summary>
+/// Helper class for showing off the toolkit's particle system in our scene. The debug window lets you turn on a
+/// fountain of particles above the scene, switch it between CPU and compute simulation, and run a benchmark that
+/// times both paths with a million live particles
+/// </summary>
+class ParticleDemo {
+public:
+	/// <summary>
+	/// Releases the particle system, should be called while the OpenGL context is still alive
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Spawns and simulates the demo particles if the demo is enabled
+	/// </summary>
+	/// <param name="dt">The time since the last update, in seconds</param>
+	static void Update(float dt);
+	/// <summary>
+	/// Draws the demo particles if the demo is enabled. Particles are blended, so this should be called after
+	/// the opaque parts of the scene have been drawn
+	/// </summary>
+	/// <param name="camera">The camera to draw the particles from</param>
+	static void Draw(const Camera::Sptr& camera);
+
+	static bool IsEnabled() { return _isEnabled; }
+
+	/// <summary>
+	/// Draws the ImGui widgets for the demo emitter and the benchmark
+	/// </summary>
+	/// <param name="camera">The camera that the benchmark will draw from</param>
+	static void DrawImGui(const Camera::Sptr& camera);
+
+	/// <summary>
+	/// The maximum number of particles in the demo emitter
+	/// </summary>
+	static const size_t MAX_PARTICLES = 100000;
+	/// <summary>
+	/// The number of particles used by the benchmark
+	/// </summary>
+	static const size_t BENCHMARK_PARTICLES = 1000000;
+
+protected:
+	ParticleDemo() = default;
+
+	static std::unique_ptr<TTK::ParticleSystem> _system;
+	static bool _isEnabled;
+	// The results of the last benchmark we ran, if any
+	static std::unique_ptr<TTK::ParticleBenchmarkResult> _benchmark;
+};
@@ -0,0 +1,362 @@
+#include "PlyLoader.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ParallelFor.h"
+#include "Graphics/IndexBuffer.h"
+#include "Graphics/VertexBuffer.h"
+#include "Graphics/VertexTypes.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// The number of vertices a thread converts at a time
+static const size_t PLY_BATCH = 4096;
+
+enum class PlyType {
+	Invalid,
+	Int8, UInt8,
+	Int16, UInt16,
+	Int32, UInt32,
+	Float32, Float64
+};
+
+struct PlyProperty {
+	std::string Name;
+	PlyType     Type = PlyType::Invalid;
+	// The type of a list's item count, or Invalid if this property is not a list
+	PlyType     CountType = PlyType::Invalid;
+	// The offset into the element's records, only valid for elements without lists
+	size_t      Offset = 0;
+};
+
+struct PlyElement {
+	std::string              Name;
+	size_t                   Count = 0;
+	std::vector<PlyProperty> Properties;
+	// The size of a record, or 0 if the records are variable size because of lists
+	size_t                   Stride = 0;
+
+	const PlyProperty* FindProperty(std::initializer_list<const char*> names) const {
+		for (const char* name : names) {
+			for (const PlyProperty& prop : Properties) {
+				if (prop.Name == name) return &prop;
+			}
+		}
+		return nullptr;
+	}
+};
+
+static PlyType ParsePlyType(const std::string& name) {
+	if (name == "char"   || name == "int8")    return PlyType::Int8;
+	if (name == "uchar"  || name == "uint8")   return PlyType::UInt8;
+	if (name == "short"  || name == "int16")   return PlyType::Int16;
+	if (name == "ushort" || name == "uint16")  return PlyType::UInt16;
+	if (name == "int"    || name == "int32")   return PlyType::Int32;
+	if (name == "uint"   || name == "uint32")  return PlyType::UInt32;
+	if (name == "float"  || name == "float32") return PlyType::Float32;
+	if (name == "double" || name == "float64") return PlyType::Float64;
+	return PlyType::Invalid;
+}
+
+static size_t GetPlyTypeSize(PlyType type) {
+	switch (type) {
+		case PlyType::Int8:    case PlyType::UInt8:  return 1;
+		case PlyType::Int16:   case PlyType::UInt16: return 2;
+		case PlyType::Int32:   case PlyType::UInt32: case PlyType::Float32: return 4;
+		case PlyType::Float64: return 8;
+		default: return 0;
+	}
+}
+
+template <typename T>
+static inline T ReadRaw(const uint8_t* data, bool bigEndian) {
+	uint8_t bytes[sizeof(T)];
+	memcpy(bytes, data, sizeof(T));
+	if (bigEndian) {
+		std::reverse(bytes, bytes + sizeof(T));
+	}
+	T result;
+	memcpy(&result, bytes, sizeof(T));
+	return result;
+}
+
+static inline double ReadPlyValue(const uint8_t* data, PlyType type, bool bigEndian) {
+	switch (type) {
+		case PlyType::Int8:    return static_cast<int8_t>(*data);
+		case PlyType::UInt8:   return *data;
+		case PlyType::Int16:   return ReadRaw<int16_t>(data, bigEndian);
+		case PlyType::UInt16:  return ReadRaw<uint16_t>(data, bigEndian);
+		case PlyType::Int32:   return ReadRaw<int32_t>(data, bigEndian);
+		case PlyType::UInt32:  return ReadRaw<uint32_t>(data, bigEndian);
+		case PlyType::Float32: return ReadRaw<float>(data, bigEndian);
+		case PlyType::Float64: return ReadRaw<double>(data, bigEndian);
+		default: return 0.0;
+	}
+}
+
+// Integer colors are stored from 0 to their max value, float colors are already 0 to 1
+static inline float ReadPlyColor(const uint8_t* data, PlyType type, bool bigEndian) {
+	double value = ReadPlyValue(data, type, bigEndian);
+	switch (type) {
+		case PlyType::UInt8:  return static_cast<float>(value / 255.0);
+		case PlyType::UInt16: return static_cast<float>(value / 65535.0);
+		default: return static_cast<float>(value);
+	}
+}
+
+/// <summary>
+/// Parses the text header at the start of a PLY file
+/// </summary>
+/// <returns>The offset of the first byte after the header</returns>
+static size_t ParsePlyHeader(const uint8_t* data, size_t size, std::vector<PlyElement>& elements, bool& bigEndian) {
+	static const char END_HEADER[] = "end_header";
+	const char* text = reinterpret_cast<const char*>(data);
+	const char* textEnd = text + size;
+	const char* headerEnd = std::search(text, textEnd, END_HEADER, END_HEADER + sizeof(END_HEADER) - 1);
+	if (size < 4 || memcmp(text, "ply", 3) != 0 || headerEnd == textEnd) {
+		throw std::runtime_error("File is not a PLY file");
+	}
+	const char* body = static_cast<const char*>(memchr(headerEnd, '\n', textEnd - headerEnd));
+	if (body == nullptr) {
+		throw std::runtime_error("PLY header is not terminated");
+	}
+
+	std::istringstream header(std::string(text, headerEnd));
+	std::string line;
+	bool hasFormat = false;
+	while (std::getline(header, line)) {
+		std::istringstream stream(line);
+		std::string command;
+		stream >> command;
+		if (command == "format") {
+			std::string format;
+			stream >> format;
+			if (format == "binary_little_endian") {
+				bigEndian = false;
+			} else if (format == "binary_big_endian") {
+				bigEndian = true;
+			} else {
+				throw std::runtime_error("Only binary PLY files are supported");
+			}
+			hasFormat = true;
+		}
+		else if (command == "element") {
+			PlyElement element;
+			stream >> element.Name >> element.Count;
+			if (!stream) {
+				throw std::runtime_error("Invalid PLY element: " + line);
+			}
+			elements.push_back(element);
+		}
+		else if (command == "property") {
+			if (elements.empty()) {
+				throw std::runtime_error("PLY property declared outside of an element");
+			}
+			PlyProperty prop;
+			std::string type;
+			stream >> type;
+			if (type == "list") {
+				std::string countType;
+				stream >> countType >> type;
+				prop.CountType = ParsePlyType(countType);
+				if (prop.CountType == PlyType::Invalid) {
+					throw std::runtime_error("Invalid PLY property: " + line);
+				}
+			}
+			prop.Type = ParsePlyType(type);
+			stream >> prop.Name;
+			if (prop.Type == PlyType::Invalid || prop.Name.empty()) {
+				throw std::runtime_error("Invalid PLY property: " + line);
+			}
+			elements.back().Properties.push_back(prop);
+		}
+	}
+	if (!hasFormat) {
+		throw std::runtime_error("PLY header does not specify a format");
+	}
+
+	// Work out where each property lives in the records of elements without lists
+	for (PlyElement& element : elements) {
+		size_t offset = 0;
+		for (PlyProperty& prop : element.Properties) {
+			if (prop.CountType != PlyType::Invalid) {
+				offset = 0;
+				break;
+			}
+			prop.Offset = offset;
+			offset += GetPlyTypeSize(prop.Type);
+		}
+		element.Stride = offset;
+	}
+	return static_cast<size_t>(body + 1 - text);
+}
+
+VertexArrayObject::Sptr PlyLoader::LoadFromFile(const std::string& filename) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MemoryMappedFile file;
+	if (!file.Open(filename)) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	std::vector<PlyElement> elements;
+	bool bigEndian = false;
+	const uint8_t* cursor = file.GetData() + ParsePlyHeader(file.GetData(), file.GetSize(), elements, bigEndian);
+	const uint8_t* end = file.GetData() + file.GetSize();
+
+	const uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<VertexPosNormTexCol> vertices;
+	std::vector<uint32_t> indices;
+	bool hasVertices = false, hasNormals = false;
+	for (const PlyElement& element : elements) {
+		// Vertices are fixed size records, so we can read them in parallel straight out of the file
+		if (element.Name == "vertex") {
+			if (element.Stride == 0) {
+				throw std::runtime_error("PLY vertices can not contain lists");
+			}
+			if (element.Count > UINT32_MAX || static_cast<size_t>(end - cursor) / element.Stride < element.Count) {
+				throw std::runtime_error("PLY file is too small for it's vertex count");
+			}
+			const PlyProperty* position[3] = { element.FindProperty({ "x" }), element.FindProperty({ "y" }), element.FindProperty({ "z" }) };
+			const PlyProperty* normal[3] = { element.FindProperty({ "nx" }), element.FindProperty({ "ny" }), element.FindProperty({ "nz" }) };
+			const PlyProperty* uv[2] = { element.FindProperty({ "u", "s", "texture_u", "texture_s" }), element.FindProperty({ "v", "t", "texture_v", "texture_t" }) };
+			const PlyProperty* color[4] = { element.FindProperty({ "red" }), element.FindProperty({ "green" }), element.FindProperty({ "blue" }), element.FindProperty({ "alpha" }) };
+			if (position[0] == nullptr || position[1] == nullptr || position[2] == nullptr) {
+				throw std::runtime_error("PLY vertices must have an x, y and z");
+			}
+			hasNormals = normal[0] != nullptr && normal[1] != nullptr && normal[2] != nullptr;
+			const bool hasUVs = uv[0] != nullptr && uv[1] != nullptr;
+			const bool hasColors = color[0] != nullptr && color[1] != nullptr && color[2] != nullptr;
+
+			vertices.resize(element.Count);
+			const uint8_t* records = cursor;
+			ParallelFor(element.Count, PLY_BATCH, numThreads, [&](size_t begin, size_t last) {
+				for (size_t ix = begin; ix < last; ix++) {
+					const uint8_t* record = records + ix * element.Stride;
+					VertexPosNormTexCol& vertex = vertices[ix];
+					vertex.Color = glm::vec4(1.0f);
+					for (int axis = 0; axis < 3; axis++) {
+						vertex.Position[axis] = static_cast<float>(ReadPlyValue(record + position[axis]->Offset, position[axis]->Type, bigEndian));
+						if (hasNormals) {
+							vertex.Normal[axis] = static_cast<float>(ReadPlyValue(record + normal[axis]->Offset, normal[axis]->Type, bigEndian));
+						}
+						if (hasColors) {
+							vertex.Color[axis] = ReadPlyColor(record + color[axis]->Offset, color[axis]->Type, bigEndian);
+						}
+					}
+					if (hasColors && color[3] != nullptr) {
+						vertex.Color.a = ReadPlyColor(record + color[3]->Offset, color[3]->Type, bigEndian);
+					}
+					if (hasUVs) {
+						vertex.UV.x = static_cast<float>(ReadPlyValue(record + uv[0]->Offset, uv[0]->Type, bigEndian));
+						vertex.UV.y = static_cast<float>(ReadPlyValue(record + uv[1]->Offset, uv[1]->Type, bigEndian));
+					}
+				}
+			});
+			cursor += element.Count * element.Stride;
+			hasVertices = true;
+			continue;
+		}
+
+		// Anything else with fixed size records can be skipped over in one go
+		if (element.Stride > 0) {
+			if (static_cast<size_t>(end - cursor) / element.Stride < element.Count) {
+				throw std::runtime_error("PLY file is too small for it's \"" + element.Name + "\" element");
+			}
+			cursor += element.Count * element.Stride;
+			continue;
+		}
+
+		// Faces are variable size records, so they have to be walked one at a time. Other elements with lists get walked and skipped
+		const PlyProperty* faceIndices = element.Name == "face" ? element.FindProperty({ "vertex_indices", "vertex_index" }) : nullptr;
+		if (faceIndices != nullptr && faceIndices->CountType == PlyType::Invalid) {
+			throw std::runtime_error("PLY face indices must be a list");
+		}
+		if (faceIndices != nullptr && !hasVertices) {
+			throw std::runtime_error("PLY faces must come after the vertices");
+		}
+		for (size_t ix = 0; ix < element.Count; ix++) {
+			for (const PlyProperty& prop : element.Properties) {
+				size_t itemSize = GetPlyTypeSize(prop.Type);
+				if (prop.CountType == PlyType::Invalid) {
+					if (static_cast<size_t>(end - cursor) < itemSize) {
+						throw std::runtime_error("PLY file ends in the middle of an element");
+					}
+					cursor += itemSize;
+					continue;
+				}
+				size_t countSize = GetPlyTypeSize(prop.CountType);
+				if (static_cast<size_t>(end - cursor) < countSize) {
+					throw std::runtime_error("PLY file ends in the middle of an element");
+				}
+				double count = ReadPlyValue(cursor, prop.CountType, bigEndian);
+				cursor += countSize;
+				if (count < 0.0 || static_cast<size_t>(end - cursor) / itemSize < static_cast<size_t>(count)) {
+					throw std::runtime_error("PLY file ends in the middle of an element");
+				}
+				size_t corners = static_cast<size_t>(count);
+				if (&prop == faceIndices) {
+					// Triangulate the polygon as a fan around it's first corner
+					uint32_t first = 0, previous = 0;
+					for (size_t corner = 0; corner < corners; corner++) {
+						double value = ReadPlyValue(cursor + corner * itemSize, prop.Type, bigEndian);
+						if (value < 0.0 || value >= static_cast<double>(vertices.size())) {
+							throw std::runtime_error("PLY face references a vertex that does not exist");
+						}
+						uint32_t index = static_cast<uint32_t>(value);
+						if (corner == 0) {
+							first = index;
+						} else if (corner >= 2) {
+							indices.push_back(first);
+							indices.push_back(previous);
+							indices.push_back(index);
+						}
+						previous = index;
+					}
+				}
+				cursor += corners * itemSize;
+			}
+		}
+	}
+	file.Close();
+
+	if (!hasVertices || indices.empty()) {
+		throw std::runtime_error("PLY file has no faces, point clouds are not supported");
+	}
+
+	// Scans often leave the normals out, so we generate smooth ones weighted by each triangle's area
+	if (!hasNormals) {
+		for (size_t ix = 0; ix < indices.size(); ix += 3) {
+			VertexPosNormTexCol& a = vertices[indices[ix]];
+			VertexPosNormTexCol& b = vertices[indices[ix + 1]];
+			VertexPosNormTexCol& c = vertices[indices[ix + 2]];
+			glm::vec3 normal = glm::cross(b.Position - a.Position, c.Position - a.Position);
+			a.Normal += normal;
+			b.Normal += normal;
+			c.Normal += normal;
+		}
+		ParallelFor(vertices.size(), PLY_BATCH, numThreads, [&](size_t begin, size_t last) {
+			for (size_t ix = begin; ix < last; ix++) {
+				float length = glm::length(vertices[ix].Normal);
+				vertices[ix].Normal = length > 0.0f ? vertices[ix].Normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+			}
+		});
+	}
+
+	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
+	vertexBuffer->LoadData(vertices.data(), vertices.size());
+	IndexBuffer::Sptr indexBuffer = IndexBuffer::Create();
+	indexBuffer->LoadData(indices.data(), indices.size());
+
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
+	result->SetIndexBuffer(indexBuffer);
+
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	LOG_INFO("Loaded \"{}\" ({} triangles, {} vertices) in {:.2f}ms", filename, indices.size() / 3, vertices.size(), ms);
+	return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Loads binary PLY files, as exported by most scanning tools. Vertex positions are required, and normals, UVs
+/// (u/v, s/t or texture_u/texture_v) and colors are read if they are present. Meshes without normals get smooth
+/// normals generated, and polygons are triangulated as fans
+/// </summary>
+class PlyLoader
+{
+public:
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+
+protected:
+	PlyLoader() = default;
+	~PlyLoader() = default;
+};
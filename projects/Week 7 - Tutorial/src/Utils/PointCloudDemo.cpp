@@ -0,0 +1,133 @@
+#include "PointCloudDemo.h"
+#include <TTK/PointCloud.h>
+#include <Logging.h>
+#include <imgui.h>
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <vector>
+
+const std::string PointCloudDemo::CLOUD_PATH = "point_cloud_demo.ply";
+const std::string PointCloudDemo::OCTREE_PATH = "point_cloud_demo.octree";
+
+std::unique_ptr<TTK::PointCloud> PointCloudDemo::_cloud = nullptr;
+bool PointCloudDemo::_isEnabled = true;
+int PointCloudDemo::_pointCount = 2000000;
+int PointCloudDemo::_maxPointsInMemory = 250000;
+double PointCloudDemo::_lastBuildMs = 0.0;
+
+void PointCloudDemo::Cleanup() {
+	_cloud = nullptr;
+}
+
+void PointCloudDemo::Draw(const Camera::Sptr& camera, int viewportHeight) {
+	if (_isEnabled && _cloud != nullptr) {
+		_cloud->Update(camera->GetView(), camera->GetProjection(), viewportHeight);
+		_cloud->Draw(camera->GetViewProjection());
+	}
+}
+
+bool PointCloudDemo::IsStreaming() {
+	return _isEnabled && _cloud != nullptr && _cloud->GetPendingLoads() > 0;
+}
+
+bool PointCloudDemo::_GenerateCloud(const std::string& path, size_t pointCount) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		LOG_ERROR("Failed to open \"{}\" for writing", path);
+		return false;
+	}
+	file << "ply\nformat binary_little_endian 1.0\nelement vertex " << pointCount << "\n"
+		<< "property float x\nproperty float y\nproperty float z\n"
+		<< "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n";
+
+	// A patch of rolling hills around the origin, with a bit of noise so it doesn't look like a mesh
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> coord(-20.0f, 20.0f);
+	std::normal_distribution<float> noise(0.0f, 0.02f);
+
+	const size_t recordSize = sizeof(float) * 3 + 3;
+	std::vector<uint8_t> chunk;
+	chunk.reserve(recordSize * 65536);
+	for (size_t ix = 0; ix < pointCount; ix++) {
+		float x = coord(random), y = coord(random);
+		float height = 0.8f * sinf(x * 0.3f) * cosf(y * 0.25f) + 0.3f * sinf(x * 1.7f + y * 1.1f);
+		float z = height - 1.0f + noise(random);
+
+		// Green in the valleys, brown on the slopes and white on the peaks
+		float t = glm::clamp((height + 1.1f) / 2.2f, 0.0f, 1.0f);
+		glm::vec3 color = t < 0.5f ?
+			glm::mix(glm::vec3(40, 120, 40), glm::vec3(120, 90, 50), t * 2.0f) :
+			glm::mix(glm::vec3(120, 90, 50), glm::vec3(240, 240, 240), (t - 0.5f) * 2.0f);
+
+		float position[3] = { x, y, z };
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(position);
+		chunk.insert(chunk.end(), bytes, bytes + sizeof(position));
+		chunk.push_back(static_cast<uint8_t>(color.r));
+		chunk.push_back(static_cast<uint8_t>(color.g));
+		chunk.push_back(static_cast<uint8_t>(color.b));
+
+		if (chunk.size() >= chunk.capacity()) {
+			file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+			chunk.clear();
+		}
+	}
+	file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+
+	LOG_INFO("Wrote a test point cloud with {} points to \"{}\"", pointCount, path);
+	return true;
+}
+
+void PointCloudDemo::DrawImGui() {
+	if (!ImGui::CollapsingHeader("Point Cloud")) {
+		return;
+	}
+
+	ImGui::DragInt("Test Cloud Points", &_pointCount, 10000.0f, 1000, 100000000);
+	if (ImGui::Button("Generate Test Cloud")) {
+		_GenerateCloud(CLOUD_PATH, static_cast<size_t>(_pointCount));
+	}
+
+	// A limit below the size of the cloud makes the build split it through temporary files
+	ImGui::DragInt("Max Points In Memory", &_maxPointsInMemory, 10000.0f, 10000, 100000000);
+	if (ImGui::Button("Build Octree")) {
+		// The cloud is reading from the octree we're about to replace, so we let it go first
+		_cloud = nullptr;
+
+		TTK::PointCloudBuildSettings settings;
+		settings.MaxPointsInMemory = static_cast<uint64_t>(_maxPointsInMemory);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		bool success = TTK::PointCloud::Build(CLOUD_PATH, OCTREE_PATH, settings);
+		_lastBuildMs = success ? std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() : -1.0;
+
+		if (success) {
+			try {
+				_cloud = std::make_unique<TTK::PointCloud>(OCTREE_PATH);
+			} catch (const std::exception& e) {
+				LOG_ERROR("Failed to open the point cloud we just built: {}", e.what());
+			}
+		}
+	}
+	ImGui::SameLine();
+	if (_lastBuildMs < 0.0) {
+		ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Build failed (see log)");
+	} else if (_lastBuildMs > 0.0) {
+		ImGui::Text("Built in %.1fms", _lastBuildMs);
+	}
+
+	if (_cloud != nullptr) {
+		TTK::PointCloudRenderSettings& settings = _cloud->Settings();
+		ImGui::Checkbox("Draw Point Cloud", &_isEnabled);
+		ImGui::DragFloat("Point Size", &settings.PointSize, 0.1f, 1.0f, 16.0f);
+		ImGui::DragFloat("Max Screen Error", &settings.MaxScreenError, 0.1f, 0.5f, 64.0f);
+		int pointBudget = static_cast<int>(settings.PointBudget);
+		if (ImGui::DragInt("Point Budget", &pointBudget, 10000.0f, 10000, 50000000)) {
+			settings.PointBudget = static_cast<uint32_t>(pointBudget);
+		}
+		ImGui::Text("%llu points in %zu nodes", static_cast<unsigned long long>(_cloud->GetTotalPoints()), _cloud->GetNodeCount());
+		ImGui::Text("Drawn: %u points, Resident: %u / %u nodes, Loading: %u", _cloud->GetDrawnPoints(),
+			_cloud->GetResidentNodes(), _cloud->GetSlotCount(), _cloud->GetPendingLoads());
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Camera.h"
+
+// Will be included in the CPP to avoid header bloat
+namespace TTK {
+	class PointCloud;
+}
+
+/// <summary>
+/// Helper class for showing off the toolkit's out-of-core point cloud renderer in our scene. The debug window lets you
+/// generate a test cloud (a noisy terrain, written as a binary PLY), convert it into an octree with a small in-memory
+/// limit so that the build has to split it through temporary files, and then stream and draw the result
+/// </summary>
+class PointCloudDemo {
+public:
+	/// <summary>
+	/// Releases the point cloud, should be called while the OpenGL context is still alive
+	/// </summary>
+	static void Cleanup();
+
+	/// <summary>
+	/// Selects and streams in the nodes to draw for the camera, then draws them, if a cloud is loaded and enabled
+	/// </summary>
+	/// <param name="camera">The camera to draw the cloud from</param>
+	/// <param name="viewportHeight">The height of the viewport we are drawing to, in pixels</param>
+	static void Draw(const Camera::Sptr& camera, int viewportHeight);
+
+	/// <summary>
+	/// Returns true while the cloud still has nodes loading in, so that we keep drawing until it's done
+	/// </summary>
+	static bool IsStreaming();
+
+	/// <summary>
+	/// Draws the ImGui widgets for generating, building and drawing the demo cloud
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The file the test cloud is written to, the octree is written beside it
+	/// </summary>
+	static const std::string CLOUD_PATH;
+	static const std::string OCTREE_PATH;
+
+protected:
+	PointCloudDemo() = default;
+
+	static std::unique_ptr<TTK::PointCloud> _cloud;
+	static bool _isEnabled;
+	// The size of the test cloud, and the in-memory limit to build it with
+	static int _pointCount;
+	static int _maxPointsInMemory;
+	// How long the last build took, or a negative value if it failed
+	static double _lastBuildMs;
+
+	static bool _GenerateCloud(const std::string& path, size_t pointCount);
+};
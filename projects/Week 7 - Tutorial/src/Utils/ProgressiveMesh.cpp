@@ -0,0 +1,259 @@
+#include "ProgressiveMesh.h"
+#include "Graphics/IndexBuffer.h"
+#include "Graphics/VertexBuffer.h"
+#include "Utils/MeshCodec.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+// Coarse pages that keep more than this fraction of the full mesh's vertices aren't worth streaming separately
+static const float MAX_PAGE_RATIO = 0.5f;
+
+// Picks which of the 6 axis directions a normal is closest to, so we don't merge vertices across hard edges
+static inline uint64_t NormalBucket(const glm::vec3& normal) {
+	glm::vec3 a = glm::abs(normal);
+	if (a.x >= a.y && a.x >= a.z) return normal.x >= 0.0f ? 0 : 1;
+	if (a.y >= a.z)               return normal.y >= 0.0f ? 2 : 3;
+	return normal.z >= 0.0f ? 4 : 5;
+}
+
+std::vector<ProgressiveMeshPage> ProgressiveMesh::BuildPages(const MeshData& mesh, uint32_t levels, uint32_t baseResolution) {
+	std::vector<ProgressiveMeshPage> result;
+	const size_t maxCoarseVertices = static_cast<size_t>(mesh.Positions.size() * MAX_PAGE_RATIO);
+	for (uint32_t level = 0; level < levels; level++) {
+		ProgressiveMeshPage page;
+		__ClusterVertices(mesh, baseResolution << level, page);
+		// Pages need to be smaller than the one after them to be worth anything, and meshes that collapse
+		// down to nothing at a resolution are better off starting at a finer one
+		if (page.Indices.empty() || page.Vertices.size() > maxCoarseVertices) {
+			continue;
+		}
+		if (!result.empty() && page.Vertices.size() <= result.back().Vertices.size()) {
+			continue;
+		}
+		result.push_back(std::move(page));
+	}
+
+	// The last page is always the original mesh
+	ProgressiveMeshPage full;
+	full.Vertices.resize(mesh.Positions.size());
+	for (size_t ix = 0; ix < mesh.Positions.size(); ix++) {
+		full.Vertices[ix] = VertexPosNormTexCol(mesh.Positions[ix], mesh.Normals[ix], mesh.UVs[ix], mesh.Colors[ix]);
+	}
+	full.Indices = mesh.Indices;
+	result.push_back(std::move(full));
+	return result;
+}
+
+void ProgressiveMesh::__ClusterVertices(const MeshData& mesh, uint32_t resolution, ProgressiveMeshPage& result) {
+	glm::vec3 min = glm::vec3(FLT_MAX), max = glm::vec3(-FLT_MAX);
+	for (const glm::vec3& pos : mesh.Positions) {
+		min = glm::min(min, pos);
+		max = glm::max(max, pos);
+	}
+	glm::vec3 extent = max - min;
+	float cellSize = glm::max(glm::max(extent.x, extent.y), extent.z) / resolution;
+	float invCellSize = cellSize > 0.0f ? 1.0f / cellSize : 0.0f;
+
+	// Each cluster is the average of all the vertices that land in the same cell and face roughly the same way
+	struct Cluster {
+		glm::vec3 Position = glm::vec3(0.0f);
+		glm::vec3 Normal = glm::vec3(0.0f);
+		glm::vec2 UV = glm::vec2(0.0f);
+		glm::vec4 Color = glm::vec4(0.0f);
+		uint32_t  Count = 0;
+	};
+	std::vector<Cluster> clusters;
+	std::unordered_map<uint64_t, uint32_t> cellToCluster;
+	std::vector<uint32_t> remap(mesh.Positions.size());
+	for (size_t ix = 0; ix < mesh.Positions.size(); ix++) {
+		glm::uvec3 cell = glm::uvec3(glm::min((mesh.Positions[ix] - min) * invCellSize, glm::vec3((float)resolution)));
+		uint64_t key = (uint64_t)cell.x | ((uint64_t)cell.y << 20) | ((uint64_t)cell.z << 40) | (NormalBucket(mesh.Normals[ix]) << 60);
+		auto it = cellToCluster.find(key);
+		if (it == cellToCluster.end()) {
+			it = cellToCluster.emplace(key, static_cast<uint32_t>(clusters.size())).first;
+			clusters.emplace_back();
+		}
+		Cluster& cluster = clusters[it->second];
+		cluster.Position += mesh.Positions[ix];
+		cluster.Normal += mesh.Normals[ix];
+		cluster.UV += mesh.UVs[ix];
+		cluster.Color += mesh.Colors[ix];
+		cluster.Count++;
+		remap[ix] = it->second;
+	}
+
+	// Collapse the triangles onto the clusters, dropping any that become degenerate or are duplicated. We can
+	// only pack a triangle into a single key if the cluster indices fit in 21 bits, otherwise we keep duplicates
+	std::vector<uint32_t> usedClusters(clusters.size(), UINT32_MAX);
+	std::unordered_set<uint64_t> seen;
+	const bool canDedupe = clusters.size() < (1u << 21);
+	for (size_t ix = 0; ix + 2 < mesh.Indices.size(); ix += 3) {
+		uint32_t a = remap[mesh.Indices[ix]], b = remap[mesh.Indices[ix + 1]], c = remap[mesh.Indices[ix + 2]];
+		if (a == b || b == c || c == a) {
+			continue;
+		}
+		// Rotate the smallest index to the front, so the same triangle always gets the same key without changing it's winding
+		while (a > b || a > c) {
+			uint32_t temp = a; a = b; b = c; c = temp;
+		}
+		if (canDedupe && !seen.insert((uint64_t)a | ((uint64_t)b << 21) | ((uint64_t)c << 42)).second) {
+			continue;
+		}
+		for (uint32_t corner : { a, b, c }) {
+			if (usedClusters[corner] == UINT32_MAX) {
+				const Cluster& cluster = clusters[corner];
+				float inv = 1.0f / cluster.Count;
+				float normalLength = glm::length(cluster.Normal);
+				usedClusters[corner] = static_cast<uint32_t>(result.Vertices.size());
+				result.Vertices.emplace_back(
+					cluster.Position * inv,
+					normalLength > 0.0f ? cluster.Normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f),
+					cluster.UV * inv,
+					cluster.Color * inv);
+			}
+			result.Indices.push_back(usedClusters[corner]);
+		}
+	}
+}
+
+bool ProgressiveMesh::Write(const std::string& path, const std::vector<ProgressiveMeshPage>& pages, bool compress) {
+	if (pages.empty()) {
+		return false;
+	}
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		LOG_WARN("Could not open \"{}\" to write a progressive mesh", path);
+		return false;
+	}
+
+	Header header;
+	header.Magic = MAGIC;
+	header.Version = VERSION;
+	header.PageCount = static_cast<uint32_t>(pages.size());
+	header.Reserved = 0;
+
+	std::vector<PageEntry> entries(pages.size());
+	std::vector<std::vector<uint8_t>> encoded(compress ? pages.size() : 0);
+	uint64_t offset = sizeof(Header) + sizeof(PageEntry) * pages.size();
+	uint64_t rawSize = 0, storedSize = 0;
+	for (size_t ix = 0; ix < pages.size(); ix++) {
+		entries[ix].Offset = offset;
+		entries[ix].VertexCount = static_cast<uint32_t>(pages[ix].Vertices.size());
+		entries[ix].IndexCount = static_cast<uint32_t>(pages[ix].Indices.size());
+		entries[ix].Encoding = compress ? PageEncoding::MeshCodec : PageEncoding::Raw;
+		entries[ix].Reserved = 0;
+		if (compress) {
+			MeshCodec::Encode(pages[ix].Vertices, pages[ix].Indices, encoded[ix]);
+			entries[ix].StoredSize = encoded[ix].size();
+		} else {
+			entries[ix].StoredSize = entries[ix].GetDataSize();
+		}
+		offset += entries[ix].StoredSize;
+		storedSize += entries[ix].StoredSize;
+		rawSize += entries[ix].GetDataSize();
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	file.write(reinterpret_cast<const char*>(entries.data()), sizeof(PageEntry) * entries.size());
+	for (size_t ix = 0; ix < pages.size(); ix++) {
+		if (compress) {
+			file.write(reinterpret_cast<const char*>(encoded[ix].data()), encoded[ix].size());
+		} else {
+			file.write(reinterpret_cast<const char*>(pages[ix].Vertices.data()), sizeof(VertexPosNormTexCol) * pages[ix].Vertices.size());
+			file.write(reinterpret_cast<const char*>(pages[ix].Indices.data()), sizeof(uint32_t) * pages[ix].Indices.size());
+		}
+	}
+	if (compress) {
+		LOG_INFO("Compressed the pages of \"{}\" from {} KB to {} KB ({:.1f}%)", path, rawSize / 1024, storedSize / 1024, 100.0 * storedSize / std::max<uint64_t>(rawSize, 1));
+	}
+	return file.good();
+}
+
+bool ProgressiveMesh::Convert(const VertexArrayObject::Sptr& mesh, const std::string& path, uint32_t levels, bool compress) {
+	MeshData data;
+	if (!MeshReadback::Read(mesh, data)) {
+		LOG_WARN("Could not read back mesh to convert to \"{}\"", path);
+		return false;
+	}
+	std::vector<ProgressiveMeshPage> pages = BuildPages(data, levels);
+	LOG_INFO("Writing progressive mesh \"{}\" with {} pages, the first page has {} of {} triangles", path, pages.size(),
+			 pages.front().Indices.size() / 3, pages.back().Indices.size() / 3);
+	return Write(path, pages, compress);
+}
+
+bool ProgressiveMesh::IsReadable(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	std::vector<PageEntry> pages;
+	return file && ReadPageTable(file, pages);
+}
+
+bool ProgressiveMesh::ReadPageTable(std::istream& stream, std::vector<PageEntry>& pages) {
+	Header header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(Header))) {
+		return false;
+	}
+	if (header.Magic != MAGIC || header.Version != VERSION || header.PageCount == 0) {
+		return false;
+	}
+	pages.resize(header.PageCount);
+	return static_cast<bool>(stream.read(reinterpret_cast<char*>(pages.data()), sizeof(PageEntry) * pages.size()));
+}
+
+bool ProgressiveMesh::ReadPage(std::istream& stream, const PageEntry& entry, ProgressiveMeshPage& page) {
+	stream.seekg(entry.Offset);
+	switch (entry.Encoding) {
+		case PageEncoding::Raw: {
+			if (entry.StoredSize != entry.GetDataSize()) {
+				return false;
+			}
+			page.Vertices.resize(entry.VertexCount);
+			page.Indices.resize(entry.IndexCount);
+			stream.read(reinterpret_cast<char*>(page.Vertices.data()), sizeof(VertexPosNormTexCol) * page.Vertices.size());
+			stream.read(reinterpret_cast<char*>(page.Indices.data()), sizeof(uint32_t) * page.Indices.size());
+			if (!stream) {
+				return false;
+			}
+			return std::all_of(page.Indices.begin(), page.Indices.end(), [&](uint32_t index) { return index < entry.VertexCount; });
+		}
+		case PageEncoding::MeshCodec: {
+			// Compressed pages are always smaller than twice their raw size, anything bigger is a corrupt table
+			if (entry.StoredSize > entry.GetDataSize() * 2 + 1024) {
+				return false;
+			}
+			// The decoder checks it's indices for us
+			std::vector<uint8_t> data(entry.StoredSize);
+			if (!stream.read(reinterpret_cast<char*>(data.data()), data.size())) {
+				return false;
+			}
+			return MeshCodec::Decode(data.data(), data.size(), page.Vertices, page.Indices) &&
+				page.Vertices.size() == entry.VertexCount && page.Indices.size() == entry.IndexCount;
+		}
+		default:
+			return false;
+	}
+}
+
+VertexArrayObject::Sptr ProgressiveMesh::CreateMesh(const ProgressiveMeshPage& page) {
+	VertexBuffer::Sptr vertices = VertexBuffer::Create();
+	vertices->LoadData(page.Vertices.data(), page.Vertices.size());
+	IndexBuffer::Sptr indices = IndexBuffer::Create();
+	indices->LoadData(page.Indices.data(), page.Indices.size());
+
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vertices, VertexPosNormTexCol::V_DECL);
+	result->SetIndexBuffer(indices);
+	return result;
+}
+
+void ProgressiveMesh::UploadPage(const VertexArrayObject::Sptr& mesh, const ProgressiveMeshPage& page) {
+	LOG_ASSERT(mesh->GetVertexBuffers().size() == 1 && mesh->GetIndexBuffer() != nullptr, "Mesh was not created from a progressive mesh page!");
+	// Re-allocating the buffers keeps their handles, so the VAO's bindings stay valid
+	mesh->GetVertexBuffers()[0].Buffer->LoadData(page.Vertices.data(), page.Vertices.size());
+	mesh->GetIndexBuffer()->LoadData(page.Indices.data(), page.Indices.size());
+	mesh->RefreshVertexCount();
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <istream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/MeshReadback.h"
+
+/// <summary>
+/// A single level of detail from a progressive mesh. Every page is a complete mesh on it's own, so a finer
+/// page can simply replace the coarser one without any stitching
+/// </summary>
+struct ProgressiveMeshPage {
+	std::vector<VertexPosNormTexCol> Vertices;
+	std::vector<uint32_t>            Indices;
+};
+
+/// <summary>
+/// Helper class for building, reading and writing progressive meshes (.pmesh files). A progressive mesh stores
+/// the same mesh at a few levels of detail, ordered from coarsest to finest, so that a loader can put the tiny
+/// first page on screen right away and swap in the finer pages as they are read. The coarse pages are made by
+/// clustering vertices on progressively finer grids, and the last page is always the original mesh.
+///
+/// The file is a Header, followed by a PageEntry for every page, followed by the page data. Raw pages are their
+/// vertices (as VertexPosNormTexCol) followed by their indices (as uint32_t), compressed pages are a MeshCodec
+/// blob. Files from any other version are rejected, so that they get re-converted
+/// </summary>
+class ProgressiveMesh
+{
+public:
+	// "PMSH" when read as bytes
+	static const uint32_t MAGIC = 0x48534D50;
+	static const uint32_t VERSION = 3;
+
+	enum class PageEncoding : uint32_t {
+		Raw       = 0,
+		MeshCodec = 1
+	};
+
+	struct Header {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t PageCount;
+		uint32_t Reserved;
+	};
+
+	struct PageEntry {
+		// The offset of the page's data from the start of the file, in bytes
+		uint64_t     Offset;
+		// The size of the page's data in the file, in bytes
+		uint64_t     StoredSize;
+		uint32_t     VertexCount;
+		uint32_t     IndexCount;
+		PageEncoding Encoding;
+		uint32_t     Reserved;
+
+		/// <summary>
+		/// Gets the size of the page once it's loaded, in bytes
+		/// </summary>
+		size_t GetDataSize() const { return VertexCount * sizeof(VertexPosNormTexCol) + IndexCount * sizeof(uint32_t); }
+	};
+
+	/// <summary>
+	/// Builds the pages for a mesh, from coarsest to finest. Levels that don't end up much smaller than the
+	/// full mesh are skipped, so small meshes may only get a single page
+	/// </summary>
+	/// <param name="mesh">The full detail mesh</param>
+	/// <param name="levels">The most coarse levels to generate before the full mesh</param>
+	/// <param name="baseResolution">The number of grid cells along the longest side of the mesh for the coarsest level, each level after doubles this</param>
+	static std::vector<ProgressiveMeshPage> BuildPages(const MeshData& mesh, uint32_t levels = 3, uint32_t baseResolution = 8);
+	/// <summary>
+	/// Writes a set of pages out to a .pmesh file
+	/// </summary>
+	/// <param name="compress">True to compress the pages with MeshCodec, which is lossy but around a quarter of the size</param>
+	/// <returns>True if the file was written, false if otherwise</returns>
+	static bool Write(const std::string& path, const std::vector<ProgressiveMeshPage>& pages, bool compress = true);
+	/// <summary>
+	/// Reads a mesh back from the GPU and writes it out as a .pmesh file. This is meant to be run as an
+	/// offline (or first run) step, since the read back stalls on the GPU
+	/// </summary>
+	/// <returns>True if the file was written, false if otherwise</returns>
+	static bool Convert(const VertexArrayObject::Sptr& mesh, const std::string& path, uint32_t levels = 3, bool compress = true);
+
+	/// <summary>
+	/// Checks if a .pmesh file exists and can be read by this version, so that stale files can be converted again
+	/// </summary>
+	static bool IsReadable(const std::string& path);
+	/// <summary>
+	/// Reads and validates the header and page table of a .pmesh file
+	/// </summary>
+	/// <param name="stream">The stream to read from, positioned at the start of the file</param>
+	/// <param name="pages">Receives the page table</param>
+	/// <returns>True if the file is a valid progressive mesh with at least one page, false if otherwise</returns>
+	static bool ReadPageTable(std::istream& stream, std::vector<PageEntry>& pages);
+	/// <summary>
+	/// Reads a single page of a .pmesh file, decompressing it if needed
+	/// </summary>
+	/// <returns>True if the page was read and all of it's indices are in range, false if otherwise</returns>
+	static bool ReadPage(std::istream& stream, const PageEntry& entry, ProgressiveMeshPage& page);
+
+	/// <summary>
+	/// Creates a new mesh from a page
+	/// </summary>
+	static VertexArrayObject::Sptr CreateMesh(const ProgressiveMeshPage& page);
+	/// <summary>
+	/// Replaces the contents of a mesh made with CreateMesh with another page. The buffers are re-filled in
+	/// place, so anything holding on to the mesh will draw the new page
+	/// </summary>
+	static void UploadPage(const VertexArrayObject::Sptr& mesh, const ProgressiveMeshPage& page);
+
+protected:
+	ProgressiveMesh() = default;
+	~ProgressiveMesh() = default;
+
+	static void __ClusterVertices(const MeshData& mesh, uint32_t resolution, ProgressiveMeshPage& result);
+};
@@ -1,10 +1,19 @@
 #include "Utils/ResourceManager/ResourceManager.h"
 
 #include "Utils/ObjLoader.h"
+#include "Utils/StlLoader.h"
+#include "Utils/PlyLoader.h"
+#include "Utils/MeshReadback.h"
+#include "Utils/MeshStreamer.h"
+#include "Utils/TextureStreamer.h"
+#include "Utils/IncrementalLoader.h"
 #include "../FileHelpers.h"
+#include "../StringUtils.h"
+#include <filesystem>
 
 std::map<Guid, Texture2D::Sptr> ResourceManager::_textures;
 std::map<Guid, VertexArrayObject::Sptr> ResourceManager::_meshes;
+std::map<Guid, TriangleBVH::Sptr> ResourceManager::_meshBVHs;
 std::map<Guid, Shader::Sptr> ResourceManager::_shaders;
 nlohmann::json ResourceManager::_manifest;
 
@@ -35,14 +44,35 @@ Guid ResourceManager::LoadTexture2D(const nlohmann::json& jsonData) {
 	desc.HorizontalWrap = horizontalWrap;
 	desc.VerticalWrap   = verticalWrap;
 
-	// Load the texture and store the result in our resources
-	Texture2D::Sptr texture = Texture2D::LoadFromFile(file, desc, forceRGBA);
+	// Load the texture and store the result in our resources, if the streamer is running we let it
+	// load the texture in the background instead
+	Texture2D::Sptr texture = TextureStreamer::IsInitialized() ?
+		TextureStreamer::Load(file, desc) :
+		Texture2D::LoadFromFile(file, desc, forceRGBA);
 	texture->OverrideGUID(result);
 	_textures[result] = texture;
 
 	return result;
 }
 
+VertexArrayObject::Sptr ResourceManager::__LoadMeshFile(const std::string& path) {
+	std::string extension = std::filesystem::path(path).extension().string();
+	StringTools::ToLower(extension);
+
+	// Progressive meshes come back with only their coarsest page loaded, and the mesh streamer fills in the rest in the background
+	if (extension == ".pmesh") {
+		return MeshStreamer::Load(path);
+	}
+	// Binary STL and PLY files are memory mapped and read straight into vertex arrays
+	if (extension == ".stl") {
+		return StlLoader::LoadFromFile(path);
+	}
+	if (extension == ".ply") {
+		return PlyLoader::LoadFromFile(path);
+	}
+	return ObjLoader::LoadFromFile(path);
+}
+
 Guid ResourceManager::LoadMesh(const nlohmann::json& jsonData) {
 	// Get the guid of the texture from the manifest
 	LOG_ASSERT(jsonData["guid"].is_string(), "JSON data must specify a GUID!");
@@ -53,14 +83,23 @@ Guid ResourceManager::LoadMesh(const nlohmann::json& jsonData) {
 	LOG_ASSERT(jsonData["path"].is_string(), "JSON data must specify at least the file path for a mesh!");
 	std::string file = jsonData["path"].get<std::string>();
 
-	// Load the texture and store the result in our resources
-	VertexArrayObject::Sptr mesh = ObjLoader::LoadFromFile(file);
-	mesh->OverrideGUID(result);
-	_meshes[result] = mesh;
+	// Load the mesh and store the result in our resources
+	__RegisterMesh(result, __LoadMeshFile(file), JsonGet(jsonData, "build_bvh", false));
 
 	return result;
 }
 
+void ResourceManager::__RegisterMesh(const Guid& id, const VertexArrayObject::Sptr& mesh, bool buildBVH) {
+	mesh->OverrideGUID(id);
+	_meshes[id] = mesh;
+
+	// Meshes that will be picked or traced against can have their BVH built up front, instead of hitching on
+	// first use. There's no point building one for a mesh that's about to be refined though
+	if (buildBVH && !MeshStreamer::IsStreaming(mesh)) {
+		GetMeshBVH(mesh);
+	}
+}
+
 Guid ResourceManager::LoadShader(const nlohmann::json& jsonData) {
 	// Get the guid of the texture from the manifest
 	LOG_ASSERT(jsonData["guid"].is_string(), "JSON data must specify a GUID!");
@@ -99,11 +138,12 @@ Guid ResourceManager::CreateTexture(const std::string& path, const Texture2DDesc
 	return result;
 }
 
-Guid ResourceManager::CreateMesh(const std::string& path) {
+Guid ResourceManager::CreateMesh(const std::string& path, bool buildBVH /*= false*/) {
 	Guid result = Guid::New();
 	nlohmann::json blob;
 	blob["guid"] = result.str();
 	blob["path"] = path;
+	blob["build_bvh"] = buildBVH;
 
 	_manifest["meshes"].push_back(blob);
 	LoadMesh(blob);
@@ -130,6 +170,31 @@ VertexArrayObject::Sptr ResourceManager::GetMesh(Guid id) {
 	return _meshes[id];
 }
 
+TriangleBVH::Sptr ResourceManager::GetMeshBVH(const VertexArrayObject::Sptr& mesh) {
+	if (mesh == nullptr) {
+		return nullptr;
+	}
+	auto it = _meshBVHs.find(mesh->GetGUID());
+	if (it != _meshBVHs.end()) {
+		return it->second;
+	}
+
+	MeshData data;
+	if (!MeshReadback::Read(mesh, data)) {
+		LOG_WARN("Could not read back mesh {} to build it's BVH", mesh->GetGUID().str());
+		return nullptr;
+	}
+	TriangleBVH::Sptr bvh = TriangleBVH::Create();
+	bvh->Build(data.Positions, data.Indices);
+
+	// Meshes that are still streaming in will have different triangles soon, so we only cache the final BVH
+	if (!MeshStreamer::IsStreaming(mesh)) {
+		_meshBVHs[mesh->GetGUID()] = bvh;
+		LOG_INFO("Built BVH for mesh {} ({} triangles, {} nodes, {} KB)", mesh->GetGUID().str(), bvh->GetTriangleCount(), bvh->GetNodeCount(), bvh->GetMemoryUsage() / 1024);
+	}
+	return bvh;
+}
+
 Shader::Sptr ResourceManager::GetShader(Guid id) {
 	return _shaders[id];
 }
@@ -159,6 +224,79 @@ void ResourceManager::LoadManifest(const std::string& path) {
 	}
 }
 
+void ResourceManager::LoadManifestIncremental(const std::string& path) {
+	std::string contents = FileHelpers::ReadFile(path);
+	nlohmann::json blob = nlohmann::json::parse(contents);
+
+	LOG_ASSERT(blob["textures"].is_array(), "Textures must exist and be an array!");
+	LOG_ASSERT(blob["meshes"].is_array(), "Meshes must exist and be an array!");
+	LOG_ASSERT(blob["shaders"].is_array(), "Shaders must exist and be an array!");
+
+	// The texture streamer already decodes in the background and only uploads small mips up front, so each
+	// texture only needs a single slice to hand it over
+	for (auto& texBlob : blob["textures"]) {
+		IncrementalLoader::Enqueue(FunctionLoaderTask::Create(JsonGet<std::string>(texBlob, "path", ""), [texBlob]() {
+			ResourceManager::LoadTexture2D(texBlob);
+		}));
+	}
+
+	for (auto& meshBlob : blob["meshes"]) {
+		LOG_ASSERT(meshBlob["guid"].is_string(), "JSON data must specify a GUID!");
+		LOG_ASSERT(meshBlob["path"].is_string(), "JSON data must specify at least the file path for a mesh!");
+		std::string file = meshBlob["path"].get<std::string>();
+		std::string extension = std::filesystem::path(file).extension().string();
+		StringTools::ToLower(extension);
+
+		// OBJ files are parsed in the background and uploaded in ranges, the other formats are either already
+		// streamed (.pmesh) or fast enough to load that we just do them in a single slice
+		if (extension != ".obj") {
+			IncrementalLoader::Enqueue(FunctionLoaderTask::Create(file, [meshBlob]() {
+				ResourceManager::LoadMesh(meshBlob);
+			}));
+			continue;
+		}
+
+		Guid id = Guid(meshBlob["guid"].get<std::string>());
+		bool buildBVH = JsonGet(meshBlob, "build_bvh", false);
+		IncrementalLoader::Enqueue(MeshLoaderTask::Create(file, [file]() { return ObjLoader::ParseFile(file); }, [id, buildBVH](const VertexArrayObject::Sptr& mesh) {
+			__RegisterMesh(id, mesh, buildBVH);
+		}));
+	}
+
+	for (auto& shaderBlob : blob["shaders"]) {
+		LOG_ASSERT(shaderBlob["guid"].is_string(), "JSON data must specify a GUID!");
+		LOG_ASSERT(shaderBlob["vs"].is_string(), "JSON data must specify the vertex shader path for a shader!");
+		LOG_ASSERT(shaderBlob["fs"].is_string(), "JSON data must specify the fragment shader path for a shader!");
+		Guid id = Guid(shaderBlob["guid"].get<std::string>());
+
+		IncrementalLoader::Enqueue(ShaderLoaderTask::Create(shaderBlob["vs"].get<std::string>(), shaderBlob["fs"].get<std::string>(), [id](const Shader::Sptr& shader) {
+			shader->OverrideGUID(id);
+			_shaders[id] = shader;
+		}));
+	}
+
+	// A task that fails is dropped by the loader, which would leave anything using it's GUID with nothing to
+	// find. Once everything else is done we check that each resource made it in, so the failures are easy to trace
+	IncrementalLoader::Enqueue(FunctionLoaderTask::Create("Checking " + path, [blob, path]() {
+		size_t missing = 0;
+		auto check = [&](const nlohmann::json& entries, const char* type, const char* pathKey, auto& loaded) {
+			for (auto& entry : entries) {
+				Guid id = Guid(entry["guid"].get<std::string>());
+				if (loaded.find(id) == loaded.end()) {
+					LOG_ERROR("Failed to load {} {} (\"{}\") from \"{}\"", type, id.str(), JsonGet<std::string>(entry, pathKey, ""), path);
+					missing++;
+				}
+			}
+		};
+		check(blob["textures"], "texture", "path", _textures);
+		check(blob["meshes"],   "mesh",    "path", _meshes);
+		check(blob["shaders"],  "shader",  "vs",   _shaders);
+		if (missing > 0) {
+			LOG_WARN("{} resources from \"{}\" failed to load, anything using them will be missing", missing, path);
+		}
+	}));
+}
+
 void ResourceManager::SaveManifest(const std::string& path) {
 	FileHelpers::WriteContentsToFile(path, _manifest.dump());
 }
@@ -166,6 +304,7 @@ void ResourceManager::SaveManifest(const std::string& path) {
 void ResourceManager::Cleanup() {
 	_textures.clear();
 	_meshes.clear();
+	_meshBVHs.clear();
 	_shaders.clear();
 }
 
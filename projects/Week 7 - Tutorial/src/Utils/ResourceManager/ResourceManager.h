@@ -8,6 +8,7 @@
 #include "Graphics/Shader.h";
 
 #include "Utils/GUID.hpp"
+#include "Utils/TriangleBVH.h"
 
 /// <summary>
 /// Utility class for managing and loading resources from JSON
@@ -50,9 +51,10 @@ public:
 	/// <summary>
 	/// Creates a manifest entry for a mesh with the given parameters
 	/// </summary>
-	/// <param name="path">The relative path of the mesh file to load (.obj file)</param>
+	/// <param name="path">The relative path of the mesh file to load (.obj, binary .stl or binary .ply file, or .pmesh file to stream it in progressively)</param>
+	/// <param name="buildBVH">True to build the mesh's triangle BVH as soon as it's loaded, rather than on first use</param>
 	/// <returns>A JSON blob that can be appended to a manifest</returns>
-	static Guid CreateMesh(const std::string& path);
+	static Guid CreateMesh(const std::string& path, bool buildBVH = false);
 	/// <summary>
 	/// Creates a manifest entry for a shader with the given parameters
 	/// </summary>
@@ -71,6 +73,14 @@ public:
 	/// <param name="id">The GUID of the mesh to fetch</param>
 	static VertexArrayObject::Sptr GetMesh(Guid id);
 	/// <summary>
+	/// Gets the triangle BVH for a mesh, for ray queries such as picking. The BVH is built from the mesh's
+	/// object space positions the first time it's requested, and cached by the mesh's GUID. Meshes that are
+	/// still being streamed in get a fresh BVH for their current detail that isn't cached
+	/// </summary>
+	/// <param name="mesh">The mesh to get the BVH for, does not need to be managed by the resource manager</param>
+	/// <returns>The mesh's BVH, or nullptr if the mesh could not be read back</returns>
+	static TriangleBVH::Sptr GetMeshBVH(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
 	/// Gets the shader with the given GUID, or nullptr if it has not been loaded
 	/// </summary>
 	/// <param name="id">The GUID of the shader to fetch</param>
@@ -86,6 +96,14 @@ public:
 	/// <param name="path">The path to the JSON manifest file</param>
 	static void LoadManifest(const std::string& path);
 	/// <summary>
+	/// Queues up loader tasks for everything in a manifest file, so that they can be loaded over several
+	/// frames by the IncrementalLoader. Resources are added to the manager as each one finishes, and once they're
+	/// all done any GUIDs that failed to load are logged. Textures are only loaded incrementally if the
+	/// TextureStreamer is running, otherwise each one is loaded in a single slice
+	/// </summary>
+	/// <param name="path">The path to the JSON manifest file</param>
+	static void LoadManifestIncremental(const std::string& path);
+	/// <summary>
 	/// Saves the manifest to the given JSON file
 	/// </summary>
 	/// <param name="path">The path to the file to output</param>
@@ -99,7 +117,13 @@ public:
 protected:
 	static std::map<Guid, Texture2D::Sptr> _textures;
 	static std::map<Guid, VertexArrayObject::Sptr> _meshes;
+	static std::map<Guid, TriangleBVH::Sptr> _meshBVHs;
 	static std::map<Guid, Shader::Sptr> _shaders;
 
 	static nlohmann::json _manifest;
+
+	// Picks a loader for a mesh file based on it's extension
+	static VertexArrayObject::Sptr __LoadMeshFile(const std::string& path);
+	// Stores a mesh that has finished loading under it's GUID, building it's BVH if the manifest asked for it
+	static void __RegisterMesh(const Guid& id, const VertexArrayObject::Sptr& mesh, bool buildBVH);
 };
\ No newline at end of file
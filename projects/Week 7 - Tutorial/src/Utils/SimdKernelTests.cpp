@@ -0,0 +1,274 @@
+#include "SimdKernelTests.h"
+#include <Logging.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <random>
+
+int SimdKernelTests::_lastFailures = -1;
+std::vector<SimdKernelTests::KernelTiming> SimdKernelTests::_timings;
+size_t SimdKernelTests::_timingCount = 0;
+
+// Counts around every multiple of 4, 8 and 16 we could trip over, plus a few large odd ones
+static const size_t TEST_COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 47, 63, 64, 65, 127, 129, 1001, 4099 };
+
+// The wide kernels add their products in a different order than glm does, so we allow for a little rounding.
+// Our inputs go up to 100 and matrix entries up to 2, so the terms being summed can be up to ~600 even when the
+// result cancels out to near 0, and the rounding error is relative to the terms rather than the result
+static const float ABSOLUTE_TOLERANCE = 600.0f * 1.0e-6f;
+
+static bool NearlyEqual(float a, float b) {
+	return std::fabs(a - b) <= std::max(ABSOLUTE_TOLERANCE, 1.0e-5f * std::max(std::fabs(a), std::fabs(b)));
+}
+
+static bool NearlyEqual(const glm::vec3& a, const glm::vec3& b) {
+	return NearlyEqual(a.x, b.x) && NearlyEqual(a.y, b.y) && NearlyEqual(a.z, b.z);
+}
+
+// Compares two arrays of vec3s, logging the first mismatch
+static bool CompareVec3s(const char* kernel, SimdLevel level, size_t count, const glm::vec3* expected, const glm::vec3* actual, bool exact) {
+	for (size_t ix = 0; ix < count; ix++) {
+		if (exact ? expected[ix] != actual[ix] : !NearlyEqual(expected[ix], actual[ix])) {
+			LOG_ERROR("{} ({}, count {}): element {} is ({}, {}, {}), expected ({}, {}, {})", kernel, SimdKernels::GetLevelName(level), count, ix,
+				actual[ix].x, actual[ix].y, actual[ix].z, expected[ix].x, expected[ix].y, expected[ix].z);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool CompareFloats(const char* kernel, SimdLevel level, size_t count, const float* expected, const float* actual) {
+	for (size_t ix = 0; ix < count; ix++) {
+		if (expected[ix] != actual[ix]) {
+			LOG_ERROR("{} ({}, count {}): element {} is {}, expected {}", kernel, SimdKernels::GetLevelName(level), count, ix, actual[ix], expected[ix]);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SimdKernelTests::RunTests(uint32_t seed) {
+	const SimdLevel restoreLevel = SimdKernels::GetActiveLevel();
+	const SimdLevel supported = SimdKernels::GetSupportedLevel();
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> unit(-2.0f, 2.0f);
+
+	int failures = 0;
+	int checks = 0;
+	auto check = [&](bool passed) {
+		checks++;
+		if (!passed) {
+			failures++;
+		}
+	};
+
+	for (size_t count : TEST_COUNTS) {
+		// We start one vertex into our arrays, so the kernels can't rely on their inputs being aligned
+		std::vector<glm::vec3> points(count + 1);
+		for (glm::vec3& point : points) {
+			point = glm::vec3(value(random), value(random), value(random));
+		}
+		const glm::vec3* in = points.data() + 1;
+
+		glm::mat4 transform;
+		for (int col = 0; col < 4; col++) {
+			for (int row = 0; row < 4; row++) {
+				transform[col][row] = unit(random);
+			}
+		}
+		const glm::mat3 normalMatrix = glm::mat3(transform);
+
+		std::vector<int32_t> indices(count * 3 + 1);
+		for (int32_t& index : indices) {
+			index = count > 0 ? (int32_t)(random() % count) : 0;
+		}
+
+		// Get our expected results from the scalar kernels
+		SimdKernels::SetActiveLevel(SimdLevel::Scalar);
+		std::vector<glm::vec3> refPoints(count), refNormals(count), refDirections(count), refGather(count), refAos(count);
+		std::vector<float> refX(count), refY(count), refZ(count);
+		glm::vec3 refMin, refMax;
+		SimdKernels::TransformPoints(transform, in, refPoints.data(), count);
+		SimdKernels::TransformNormals(normalMatrix, in, refNormals.data(), count, true);
+		SimdKernels::TransformNormals(normalMatrix, in, refDirections.data(), count, false);
+		SimdKernels::ComputeBounds(in, count, refMin, refMax);
+		SimdKernels::AosToSoa(in, refX.data(), refY.data(), refZ.data(), count);
+		SimdKernels::SoaToAos(refX.data(), refY.data(), refZ.data(), refAos.data(), count);
+		SimdKernels::GatherVec3(in, indices.data() + 1, 3, refGather.data(), count);
+
+		for (int levelIx = (int)SimdLevel::SSE42; levelIx <= (int)supported; levelIx++) {
+			const SimdLevel level = (SimdLevel)levelIx;
+			SimdKernels::SetActiveLevel(level);
+
+			std::vector<glm::vec3> out(count + 1);
+			SimdKernels::TransformPoints(transform, in, out.data() + 1, count);
+			check(CompareVec3s("TransformPoints", level, count, refPoints.data(), out.data() + 1, false));
+
+			// The kernels are allowed to work in place
+			std::vector<glm::vec3> inPlace(points);
+			SimdKernels::TransformPoints(transform, inPlace.data() + 1, inPlace.data() + 1, count);
+			check(CompareVec3s("TransformPoints (in place)", level, count, refPoints.data(), inPlace.data() + 1, false));
+
+			SimdKernels::TransformNormals(normalMatrix, in, out.data() + 1, count, true);
+			check(CompareVec3s("TransformNormals", level, count, refNormals.data(), out.data() + 1, false));
+
+			inPlace = points;
+			SimdKernels::TransformNormals(normalMatrix, inPlace.data() + 1, inPlace.data() + 1, count, false);
+			check(CompareVec3s("TransformNormals (in place, unnormalized)", level, count, refDirections.data(), inPlace.data() + 1, false));
+
+			glm::vec3 min, max;
+			SimdKernels::ComputeBounds(in, count, min, max);
+			bool boundsMatch = min == refMin && max == refMax;
+			if (!boundsMatch) {
+				LOG_ERROR("ComputeBounds ({}, count {}): bounds are ({}, {}, {}) to ({}, {}, {}), expected ({}, {}, {}) to ({}, {}, {})",
+					SimdKernels::GetLevelName(level), count, min.x, min.y, min.z, max.x, max.y, max.z,
+					refMin.x, refMin.y, refMin.z, refMax.x, refMax.y, refMax.z);
+			}
+			check(boundsMatch);
+
+			std::vector<float> x(count + 1), y(count + 1), z(count + 1);
+			SimdKernels::AosToSoa(in, x.data() + 1, y.data() + 1, z.data() + 1, count);
+			check(CompareFloats("AosToSoa (x)", level, count, refX.data(), x.data() + 1) &&
+				  CompareFloats("AosToSoa (y)", level, count, refY.data(), y.data() + 1) &&
+				  CompareFloats("AosToSoa (z)", level, count, refZ.data(), z.data() + 1));
+
+			SimdKernels::SoaToAos(x.data() + 1, y.data() + 1, z.data() + 1, out.data() + 1, count);
+			check(CompareVec3s("SoaToAos", level, count, refAos.data(), out.data() + 1, true));
+
+			SimdKernels::GatherVec3(in, indices.data() + 1, 3, out.data() + 1, count);
+			check(CompareVec3s("GatherVec3", level, count, refGather.data(), out.data() + 1, true));
+		}
+	}
+
+	SimdKernels::SetActiveLevel(restoreLevel);
+	_lastFailures = failures;
+
+	if (supported < SimdLevel::AVX512) {
+		LOG_WARN("This CPU only supports up to {}, higher levels were not tested", SimdKernels::GetLevelName(supported));
+	}
+	if (failures == 0) {
+		LOG_INFO("SIMD kernel tests passed ({} checks, up to {})", checks, SimdKernels::GetLevelName(supported));
+	} else {
+		LOG_ERROR("{} of {} SIMD kernel checks failed", failures, checks);
+	}
+	return failures == 0;
+}
+
+// Runs a kernel several times, and returns the fastest run in milliseconds
+static double TimeKernel(const std::function<void()>& kernel, int repeats) {
+	double best = DBL_MAX;
+	for (int ix = 0; ix < repeats; ix++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		kernel();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+void SimdKernelTests::RunTimings(size_t count, int repeats) {
+	const SimdLevel restoreLevel = SimdKernels::GetActiveLevel();
+	const SimdLevel supported = SimdKernels::GetSupportedLevel();
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+
+	std::vector<glm::vec3> points(count), out(count);
+	for (glm::vec3& point : points) {
+		point = glm::vec3(value(random), value(random), value(random));
+	}
+	std::vector<float> x(count), y(count), z(count);
+	std::vector<int32_t> indices(count * 3);
+	for (int32_t& index : indices) {
+		index = (int32_t)(random() % count);
+	}
+	const glm::mat4 transform = glm::mat4(0.5f, 0.1f, 0.2f, 0.0f, -0.1f, 0.9f, 0.3f, 0.0f, 0.2f, -0.3f, 1.1f, 0.0f, 4.0f, 5.0f, 6.0f, 1.0f);
+	const glm::mat3 normalMatrix = glm::mat3(transform);
+	glm::vec3 min, max;
+
+	const std::pair<const char*, std::function<void()>> kernels[] = {
+		{ "TransformPoints",  [&]() { SimdKernels::TransformPoints(transform, points.data(), out.data(), count); } },
+		{ "TransformNormals", [&]() { SimdKernels::TransformNormals(normalMatrix, points.data(), out.data(), count, true); } },
+		{ "ComputeBounds",    [&]() { SimdKernels::ComputeBounds(points.data(), count, min, max); } },
+		{ "AosToSoa",         [&]() { SimdKernels::AosToSoa(points.data(), x.data(), y.data(), z.data(), count); } },
+		{ "SoaToAos",         [&]() { SimdKernels::SoaToAos(x.data(), y.data(), z.data(), out.data(), count); } },
+		{ "GatherVec3",       [&]() { SimdKernels::GatherVec3(points.data(), indices.data(), 3, out.data(), count); } },
+	};
+
+	_timings.clear();
+	_timingCount = count;
+	LOG_INFO("SIMD kernel timings ({} vertices, best of {}):", count, repeats);
+	for (const auto& [name, kernel] : kernels) {
+		KernelTiming timing;
+		timing.Kernel = name;
+		for (int levelIx = 0; levelIx < LEVEL_COUNT; levelIx++) {
+			timing.Ms[levelIx] = -1.0;
+			if (levelIx <= (int)supported) {
+				SimdKernels::SetActiveLevel((SimdLevel)levelIx);
+				timing.Ms[levelIx] = TimeKernel(kernel, repeats);
+			}
+		}
+		LOG_INFO("\t{:<16} Scalar {:.3f}ms, SSE4.2 {:.3f}ms, AVX2 {:.3f}ms, AVX-512 {:.3f}ms",
+			name, timing.Ms[0], timing.Ms[1], timing.Ms[2], timing.Ms[3]);
+		_timings.push_back(timing);
+	}
+
+	SimdKernels::SetActiveLevel(restoreLevel);
+}
+
+void SimdKernelTests::DrawImGui() {
+	if (!ImGui::CollapsingHeader("SIMD Kernels")) {
+		return;
+	}
+
+	int level = (int)SimdKernels::GetActiveLevel();
+	const char* names[LEVEL_COUNT];
+	for (int ix = 0; ix < LEVEL_COUNT; ix++) {
+		names[ix] = SimdKernels::GetLevelName((SimdLevel)ix);
+	}
+	if (ImGui::Combo("Active Level", &level, names, (int)SimdKernels::GetSupportedLevel() + 1)) {
+		SimdKernels::SetActiveLevel((SimdLevel)level);
+	}
+
+	if (ImGui::Button("Run Tests")) {
+		RunTests();
+	}
+	ImGui::SameLine();
+	if (_lastFailures < 0) {
+		ImGui::Text("Not run");
+	} else if (_lastFailures == 0) {
+		ImGui::Text("Passed");
+	} else {
+		ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%d failed (see log)", _lastFailures);
+	}
+
+	if (ImGui::Button("Run Timings")) {
+		RunTimings();
+	}
+	if (!_timings.empty()) {
+		ImGui::Text("%zu vertices, best run in ms", _timingCount);
+		ImGui::Columns(LEVEL_COUNT + 1);
+		ImGui::Text("Kernel"); ImGui::NextColumn();
+		for (int ix = 0; ix < LEVEL_COUNT; ix++) {
+			ImGui::Text("%s", names[ix]); ImGui::NextColumn();
+		}
+		for (const KernelTiming& timing : _timings) {
+			ImGui::Text("%s", timing.Kernel); ImGui::NextColumn();
+			for (int ix = 0; ix < LEVEL_COUNT; ix++) {
+				if (timing.Ms[ix] < 0.0) {
+					ImGui::Text("-");
+				} else {
+					ImGui::Text("%.3f", timing.Ms[ix]);
+				}
+				ImGui::NextColumn();
+			}
+		}
+		ImGui::Columns(1);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "SimdKernels.h"
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Checks and times the SimdKernels. The tests force each instruction set the CPU supports in turn, and compare every
+/// kernel against the scalar reference on random inputs, with counts that leave a partial group of vertices at the end
+/// (so the scalar tails get tested as well), and with input pointers that aren't aligned to a whole vertex group.
+/// The timings run each kernel over a large array at each level, so the speed up over scalar can be seen
+/// </summary>
+class SimdKernelTests {
+public:
+	/// <summary>
+	/// Runs every kernel at every supported instruction set against the scalar reference, logging any mismatches.
+	/// The active level is restored afterwards
+	/// </summary>
+	/// <param name="seed">The seed for the random inputs</param>
+	/// <returns>True if every kernel matched the reference at every level</returns>
+	static bool RunTests(uint32_t seed = 1234);
+	/// <summary>
+	/// Times every kernel at every supported instruction set, logging the results. The active level is restored afterwards
+	/// </summary>
+	/// <param name="count">The number of vertices to run each kernel over</param>
+	/// <param name="repeats">The number of times to run each kernel, the fastest run is reported</param>
+	static void RunTimings(size_t count = 1u << 20, int repeats = 10);
+
+	/// <summary>
+	/// Draws ImGui buttons for running the tests and timings, and shows the last results
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// The number of instruction sets, including scalar
+	/// </summary>
+	static const int LEVEL_COUNT = (int)SimdLevel::AVX512 + 1;
+
+	/// <summary>
+	/// The timings for a single kernel, in milliseconds per run, or a negative number if the level isn't supported
+	/// </summary>
+	struct KernelTiming {
+		const char* Kernel;
+		double      Ms[LEVEL_COUNT];
+	};
+	static const std::vector<KernelTiming>& GetLastTimings() { return _timings; }
+
+protected:
+	SimdKernelTests() = default;
+
+	// -1 if the tests haven't been run, otherwise the number of failures from the last run
+	static int _lastFailures;
+	static std::vector<KernelTiming> _timings;
+	static size_t _timingCount;
+};
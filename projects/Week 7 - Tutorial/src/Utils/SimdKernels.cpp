@@ -0,0 +1,590 @@
+#include "SimdKernels.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// MSVC lets us use any intrinsic anywhere, other compilers need to be told which functions may use which instructions
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static_assert(sizeof(glm::vec3) == sizeof(float) * 3, "Kernels expect tightly packed vec3s");
+
+#pragma region Scalar
+
+static void TransformPoints_Scalar(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, size_t count) {
+	for (size_t ix = 0; ix < count; ix++) {
+		out[ix] = glm::vec3(m * glm::vec4(in[ix], 1.0f));
+	}
+}
+
+static void TransformNormals_Scalar(const glm::mat3& m, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize) {
+	for (size_t ix = 0; ix < count; ix++) {
+		glm::vec3 result = m * in[ix];
+		if (normalize) {
+			result /= glm::max(glm::length(result), FLT_MIN);
+		}
+		out[ix] = result;
+	}
+}
+
+static void ComputeBounds_Scalar(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max) {
+	min = glm::vec3(FLT_MAX);
+	max = glm::vec3(-FLT_MAX);
+	for (size_t ix = 0; ix < count; ix++) {
+		min = glm::min(min, points[ix]);
+		max = glm::max(max, points[ix]);
+	}
+}
+
+static void AosToSoa_Scalar(const glm::vec3* in, float* x, float* y, float* z, size_t count) {
+	for (size_t ix = 0; ix < count; ix++) {
+		x[ix] = in[ix].x;
+		y[ix] = in[ix].y;
+		z[ix] = in[ix].z;
+	}
+}
+
+static void SoaToAos_Scalar(const float* x, const float* y, const float* z, glm::vec3* out, size_t count) {
+	for (size_t ix = 0; ix < count; ix++) {
+		out[ix] = glm::vec3(x[ix], y[ix], z[ix]);
+	}
+}
+
+static void GatherVec3_Scalar(const glm::vec3* table, const int32_t* indices, size_t indexStride, glm::vec3* out, size_t count) {
+	for (size_t ix = 0; ix < count; ix++) {
+		out[ix] = table[indices[ix * indexStride]];
+	}
+}
+
+#pragma endregion
+
+// All of our wide kernels load 4 vec3s (12 floats) per 128 bit lane as 3 registers, and shuffle them into
+// registers of x's, y's and z's. The shuffles only work within 128 bit lanes, so the same sequence works for
+// SSE, AVX and AVX-512, as long as each lane is loaded with its own group of 4 vertices:
+//    m03 = x0 y0 z0 x1 | m14 = y1 z1 x2 y2 | m25 = z2 x3 y3 z3
+#define TRANSPOSE_IN(PREFIX, m03, m14, m25, x, y, z) { \
+		auto xy = PREFIX##_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2)); \
+		auto yz = PREFIX##_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1)); \
+		x = PREFIX##_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0)); \
+		y = PREFIX##_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)); \
+		z = PREFIX##_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1)); }
+
+#define TRANSPOSE_OUT(PREFIX, x, y, z, m03, m14, m25) { \
+		auto rxy = PREFIX##_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0)); \
+		auto ryz = PREFIX##_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1)); \
+		auto rzx = PREFIX##_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0)); \
+		m03 = PREFIX##_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0)); \
+		m14 = PREFIX##_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0)); \
+		m25 = PREFIX##_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1)); }
+
+#pragma region SSE 4.2
+
+SIMD_TARGET("sse4.2")
+static inline void Load3_SSE(const glm::vec3* p, __m128& x, __m128& y, __m128& z) {
+	const float* f = &p->x;
+	__m128 m03 = _mm_loadu_ps(f), m14 = _mm_loadu_ps(f + 4), m25 = _mm_loadu_ps(f + 8);
+	TRANSPOSE_IN(_mm, m03, m14, m25, x, y, z);
+}
+
+SIMD_TARGET("sse4.2")
+static inline void Store3_SSE(glm::vec3* p, __m128 x, __m128 y, __m128 z) {
+	float* f = &p->x;
+	__m128 m03, m14, m25;
+	TRANSPOSE_OUT(_mm, x, y, z, m03, m14, m25);
+	_mm_storeu_ps(f, m03);
+	_mm_storeu_ps(f + 4, m14);
+	_mm_storeu_ps(f + 8, m25);
+}
+
+SIMD_TARGET("sse4.2")
+static void TransformPoints_SSE(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, size_t count) {
+	__m128 c[4][3];
+	for (int col = 0; col < 4; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm_set1_ps(m[col][row]);
+		}
+	}
+	size_t ix = 0;
+	for (; ix + 4 <= count; ix += 4) {
+		__m128 x, y, z;
+		Load3_SSE(in + ix, x, y, z);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][0], x), _mm_mul_ps(c[1][0], y)), _mm_add_ps(_mm_mul_ps(c[2][0], z), c[3][0]));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][1], x), _mm_mul_ps(c[1][1], y)), _mm_add_ps(_mm_mul_ps(c[2][1], z), c[3][1]));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][2], x), _mm_mul_ps(c[1][2], y)), _mm_add_ps(_mm_mul_ps(c[2][2], z), c[3][2]));
+		Store3_SSE(out + ix, rx, ry, rz);
+	}
+	TransformPoints_Scalar(m, in + ix, out + ix, count - ix);
+}
+
+SIMD_TARGET("sse4.2")
+static void TransformNormals_SSE(const glm::mat3& m, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize) {
+	__m128 c[3][3];
+	for (int col = 0; col < 3; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm_set1_ps(m[col][row]);
+		}
+	}
+	const __m128 tiny = _mm_set1_ps(FLT_MIN);
+	size_t ix = 0;
+	for (; ix + 4 <= count; ix += 4) {
+		__m128 x, y, z;
+		Load3_SSE(in + ix, x, y, z);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][0], x), _mm_mul_ps(c[1][0], y)), _mm_mul_ps(c[2][0], z));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][1], x), _mm_mul_ps(c[1][1], y)), _mm_mul_ps(c[2][1], z));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][2], x), _mm_mul_ps(c[1][2], y)), _mm_mul_ps(c[2][2], z));
+		if (normalize) {
+			__m128 length = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz))), tiny);
+			rx = _mm_div_ps(rx, length);
+			ry = _mm_div_ps(ry, length);
+			rz = _mm_div_ps(rz, length);
+		}
+		Store3_SSE(out + ix, rx, ry, rz);
+	}
+	TransformNormals_Scalar(m, in + ix, out + ix, count - ix, normalize);
+}
+
+SIMD_TARGET("sse4.2")
+static void ComputeBounds_SSE(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max) {
+	__m128 minX = _mm_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+	size_t ix = 0;
+	for (; ix + 4 <= count; ix += 4) {
+		__m128 x, y, z;
+		Load3_SSE(points + ix, x, y, z);
+		minX = _mm_min_ps(minX, x); minY = _mm_min_ps(minY, y); minZ = _mm_min_ps(minZ, z);
+		maxX = _mm_max_ps(maxX, x); maxY = _mm_max_ps(maxY, y); maxZ = _mm_max_ps(maxZ, z);
+	}
+	alignas(16) float lanes[6][4];
+	_mm_store_ps(lanes[0], minX); _mm_store_ps(lanes[1], minY); _mm_store_ps(lanes[2], minZ);
+	_mm_store_ps(lanes[3], maxX); _mm_store_ps(lanes[4], maxY); _mm_store_ps(lanes[5], maxZ);
+	ComputeBounds_Scalar(points + ix, count - ix, min, max);
+	for (int lane = 0; lane < 4; lane++) {
+		min = glm::min(min, glm::vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+		max = glm::max(max, glm::vec3(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+	}
+}
+
+SIMD_TARGET("sse4.2")
+static void AosToSoa_SSE(const glm::vec3* in, float* x, float* y, float* z, size_t count) {
+	size_t ix = 0;
+	for (; ix + 4 <= count; ix += 4) {
+		__m128 vx, vy, vz;
+		Load3_SSE(in + ix, vx, vy, vz);
+		_mm_storeu_ps(x + ix, vx);
+		_mm_storeu_ps(y + ix, vy);
+		_mm_storeu_ps(z + ix, vz);
+	}
+	AosToSoa_Scalar(in + ix, x + ix, y + ix, z + ix, count - ix);
+}
+
+SIMD_TARGET("sse4.2")
+static void SoaToAos_SSE(const float* x, const float* y, const float* z, glm::vec3* out, size_t count) {
+	size_t ix = 0;
+	for (; ix + 4 <= count; ix += 4) {
+		Store3_SSE(out + ix, _mm_loadu_ps(x + ix), _mm_loadu_ps(y + ix), _mm_loadu_ps(z + ix));
+	}
+	SoaToAos_Scalar(x + ix, y + ix, z + ix, out + ix, count - ix);
+}
+
+#pragma endregion
+
+#pragma region AVX2
+
+SIMD_TARGET("avx2")
+static inline void Load3_AVX2(const glm::vec3* p, __m256& x, __m256& y, __m256& z) {
+	// The low lane gets vertices 0-3, the high lane gets vertices 4-7
+	const float* f = &p->x;
+	__m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f)), _mm_loadu_ps(f + 12), 1);
+	__m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 4)), _mm_loadu_ps(f + 16), 1);
+	__m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 8)), _mm_loadu_ps(f + 20), 1);
+	TRANSPOSE_IN(_mm256, m03, m14, m25, x, y, z);
+}
+
+SIMD_TARGET("avx2")
+static inline void Store3_AVX2(glm::vec3* p, __m256 x, __m256 y, __m256 z) {
+	float* f = &p->x;
+	__m256 m03, m14, m25;
+	TRANSPOSE_OUT(_mm256, x, y, z, m03, m14, m25);
+	_mm_storeu_ps(f,      _mm256_castps256_ps128(m03));
+	_mm_storeu_ps(f + 4,  _mm256_castps256_ps128(m14));
+	_mm_storeu_ps(f + 8,  _mm256_castps256_ps128(m25));
+	_mm_storeu_ps(f + 12, _mm256_extractf128_ps(m03, 1));
+	_mm_storeu_ps(f + 16, _mm256_extractf128_ps(m14, 1));
+	_mm_storeu_ps(f + 20, _mm256_extractf128_ps(m25, 1));
+}
+
+SIMD_TARGET("avx2")
+static void TransformPoints_AVX2(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, size_t count) {
+	__m256 c[4][3];
+	for (int col = 0; col < 4; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm256_set1_ps(m[col][row]);
+		}
+	}
+	size_t ix = 0;
+	for (; ix + 8 <= count; ix += 8) {
+		__m256 x, y, z;
+		Load3_AVX2(in + ix, x, y, z);
+		__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][0], x), _mm256_mul_ps(c[1][0], y)), _mm256_add_ps(_mm256_mul_ps(c[2][0], z), c[3][0]));
+		__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][1], x), _mm256_mul_ps(c[1][1], y)), _mm256_add_ps(_mm256_mul_ps(c[2][1], z), c[3][1]));
+		__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][2], x), _mm256_mul_ps(c[1][2], y)), _mm256_add_ps(_mm256_mul_ps(c[2][2], z), c[3][2]));
+		Store3_AVX2(out + ix, rx, ry, rz);
+	}
+	TransformPoints_SSE(m, in + ix, out + ix, count - ix);
+}
+
+SIMD_TARGET("avx2")
+static void TransformNormals_AVX2(const glm::mat3& m, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize) {
+	__m256 c[3][3];
+	for (int col = 0; col < 3; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm256_set1_ps(m[col][row]);
+		}
+	}
+	const __m256 tiny = _mm256_set1_ps(FLT_MIN);
+	size_t ix = 0;
+	for (; ix + 8 <= count; ix += 8) {
+		__m256 x, y, z;
+		Load3_AVX2(in + ix, x, y, z);
+		__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][0], x), _mm256_mul_ps(c[1][0], y)), _mm256_mul_ps(c[2][0], z));
+		__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][1], x), _mm256_mul_ps(c[1][1], y)), _mm256_mul_ps(c[2][1], z));
+		__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0][2], x), _mm256_mul_ps(c[1][2], y)), _mm256_mul_ps(c[2][2], z));
+		if (normalize) {
+			__m256 length = _mm256_max_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)), _mm256_mul_ps(rz, rz))), tiny);
+			rx = _mm256_div_ps(rx, length);
+			ry = _mm256_div_ps(ry, length);
+			rz = _mm256_div_ps(rz, length);
+		}
+		Store3_AVX2(out + ix, rx, ry, rz);
+	}
+	TransformNormals_SSE(m, in + ix, out + ix, count - ix, normalize);
+}
+
+SIMD_TARGET("avx2")
+static void ComputeBounds_AVX2(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max) {
+	__m256 minX = _mm256_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m256 maxX = _mm256_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+	size_t ix = 0;
+	for (; ix + 8 <= count; ix += 8) {
+		__m256 x, y, z;
+		Load3_AVX2(points + ix, x, y, z);
+		minX = _mm256_min_ps(minX, x); minY = _mm256_min_ps(minY, y); minZ = _mm256_min_ps(minZ, z);
+		maxX = _mm256_max_ps(maxX, x); maxY = _mm256_max_ps(maxY, y); maxZ = _mm256_max_ps(maxZ, z);
+	}
+	alignas(32) float lanes[6][8];
+	_mm256_store_ps(lanes[0], minX); _mm256_store_ps(lanes[1], minY); _mm256_store_ps(lanes[2], minZ);
+	_mm256_store_ps(lanes[3], maxX); _mm256_store_ps(lanes[4], maxY); _mm256_store_ps(lanes[5], maxZ);
+	ComputeBounds_SSE(points + ix, count - ix, min, max);
+	for (int lane = 0; lane < 8; lane++) {
+		min = glm::min(min, glm::vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+		max = glm::max(max, glm::vec3(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+	}
+}
+
+SIMD_TARGET("avx2")
+static void AosToSoa_AVX2(const glm::vec3* in, float* x, float* y, float* z, size_t count) {
+	size_t ix = 0;
+	for (; ix + 8 <= count; ix += 8) {
+		__m256 vx, vy, vz;
+		Load3_AVX2(in + ix, vx, vy, vz);
+		_mm256_storeu_ps(x + ix, vx);
+		_mm256_storeu_ps(y + ix, vy);
+		_mm256_storeu_ps(z + ix, vz);
+	}
+	AosToSoa_SSE(in + ix, x + ix, y + ix, z + ix, count - ix);
+}
+
+SIMD_TARGET("avx2")
+static void SoaToAos_AVX2(const float* x, const float* y, const float* z, glm::vec3* out, size_t count) {
+	size_t ix = 0;
+	for (; ix + 8 <= count; ix += 8) {
+		Store3_AVX2(out + ix, _mm256_loadu_ps(x + ix), _mm256_loadu_ps(y + ix), _mm256_loadu_ps(z + ix));
+	}
+	SoaToAos_SSE(x + ix, y + ix, z + ix, out + ix, count - ix);
+}
+
+#pragma endregion
+
+#pragma region AVX-512
+
+SIMD_TARGET("avx512f")
+static inline __m512 LoadLanes_AVX512(const float* f) {
+	// Each 128 bit lane gets its own group of 4 vertices, 12 floats apart
+	__m512 result = _mm512_castps128_ps512(_mm_loadu_ps(f));
+	result = _mm512_insertf32x4(result, _mm_loadu_ps(f + 12), 1);
+	result = _mm512_insertf32x4(result, _mm_loadu_ps(f + 24), 2);
+	result = _mm512_insertf32x4(result, _mm_loadu_ps(f + 36), 3);
+	return result;
+}
+
+SIMD_TARGET("avx512f")
+static inline void StoreLanes_AVX512(float* f, __m512 value) {
+	_mm_storeu_ps(f,      _mm512_castps512_ps128(value));
+	_mm_storeu_ps(f + 12, _mm512_extractf32x4_ps(value, 1));
+	_mm_storeu_ps(f + 24, _mm512_extractf32x4_ps(value, 2));
+	_mm_storeu_ps(f + 36, _mm512_extractf32x4_ps(value, 3));
+}
+
+SIMD_TARGET("avx512f")
+static inline void Load3_AVX512(const glm::vec3* p, __m512& x, __m512& y, __m512& z) {
+	const float* f = &p->x;
+	__m512 m03 = LoadLanes_AVX512(f), m14 = LoadLanes_AVX512(f + 4), m25 = LoadLanes_AVX512(f + 8);
+	TRANSPOSE_IN(_mm512, m03, m14, m25, x, y, z);
+}
+
+SIMD_TARGET("avx512f")
+static inline void Store3_AVX512(glm::vec3* p, __m512 x, __m512 y, __m512 z) {
+	float* f = &p->x;
+	__m512 m03, m14, m25;
+	TRANSPOSE_OUT(_mm512, x, y, z, m03, m14, m25);
+	StoreLanes_AVX512(f, m03);
+	StoreLanes_AVX512(f + 4, m14);
+	StoreLanes_AVX512(f + 8, m25);
+}
+
+SIMD_TARGET("avx512f")
+static void TransformPoints_AVX512(const glm::mat4& m, const glm::vec3* in, glm::vec3* out, size_t count) {
+	__m512 c[4][3];
+	for (int col = 0; col < 4; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm512_set1_ps(m[col][row]);
+		}
+	}
+	size_t ix = 0;
+	for (; ix + 16 <= count; ix += 16) {
+		__m512 x, y, z;
+		Load3_AVX512(in + ix, x, y, z);
+		__m512 rx = _mm512_fmadd_ps(c[0][0], x, _mm512_fmadd_ps(c[1][0], y, _mm512_fmadd_ps(c[2][0], z, c[3][0])));
+		__m512 ry = _mm512_fmadd_ps(c[0][1], x, _mm512_fmadd_ps(c[1][1], y, _mm512_fmadd_ps(c[2][1], z, c[3][1])));
+		__m512 rz = _mm512_fmadd_ps(c[0][2], x, _mm512_fmadd_ps(c[1][2], y, _mm512_fmadd_ps(c[2][2], z, c[3][2])));
+		Store3_AVX512(out + ix, rx, ry, rz);
+	}
+	TransformPoints_AVX2(m, in + ix, out + ix, count - ix);
+}
+
+SIMD_TARGET("avx512f")
+static void TransformNormals_AVX512(const glm::mat3& m, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize) {
+	__m512 c[3][3];
+	for (int col = 0; col < 3; col++) {
+		for (int row = 0; row < 3; row++) {
+			c[col][row] = _mm512_set1_ps(m[col][row]);
+		}
+	}
+	const __m512 tiny = _mm512_set1_ps(FLT_MIN);
+	size_t ix = 0;
+	for (; ix + 16 <= count; ix += 16) {
+		__m512 x, y, z;
+		Load3_AVX512(in + ix, x, y, z);
+		__m512 rx = _mm512_fmadd_ps(c[0][0], x, _mm512_fmadd_ps(c[1][0], y, _mm512_mul_ps(c[2][0], z)));
+		__m512 ry = _mm512_fmadd_ps(c[0][1], x, _mm512_fmadd_ps(c[1][1], y, _mm512_mul_ps(c[2][1], z)));
+		__m512 rz = _mm512_fmadd_ps(c[0][2], x, _mm512_fmadd_ps(c[1][2], y, _mm512_mul_ps(c[2][2], z)));
+		if (normalize) {
+			__m512 length = _mm512_max_ps(_mm512_sqrt_ps(_mm512_fmadd_ps(rx, rx, _mm512_fmadd_ps(ry, ry, _mm512_mul_ps(rz, rz)))), tiny);
+			rx = _mm512_div_ps(rx, length);
+			ry = _mm512_div_ps(ry, length);
+			rz = _mm512_div_ps(rz, length);
+		}
+		Store3_AVX512(out + ix, rx, ry, rz);
+	}
+	TransformNormals_AVX2(m, in + ix, out + ix, count - ix, normalize);
+}
+
+SIMD_TARGET("avx512f")
+static void ComputeBounds_AVX512(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max) {
+	__m512 minX = _mm512_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+	__m512 maxX = _mm512_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+	size_t ix = 0;
+	for (; ix + 16 <= count; ix += 16) {
+		__m512 x, y, z;
+		Load3_AVX512(points + ix, x, y, z);
+		minX = _mm512_min_ps(minX, x); minY = _mm512_min_ps(minY, y); minZ = _mm512_min_ps(minZ, z);
+		maxX = _mm512_max_ps(maxX, x); maxY = _mm512_max_ps(maxY, y); maxZ = _mm512_max_ps(maxZ, z);
+	}
+	ComputeBounds_AVX2(points + ix, count - ix, min, max);
+	min = glm::min(min, glm::vec3(_mm512_reduce_min_ps(minX), _mm512_reduce_min_ps(minY), _mm512_reduce_min_ps(minZ)));
+	max = glm::max(max, glm::vec3(_mm512_reduce_max_ps(maxX), _mm512_reduce_max_ps(maxY), _mm512_reduce_max_ps(maxZ)));
+}
+
+SIMD_TARGET("avx512f")
+static void AosToSoa_AVX512(const glm::vec3* in, float* x, float* y, float* z, size_t count) {
+	size_t ix = 0;
+	for (; ix + 16 <= count; ix += 16) {
+		__m512 vx, vy, vz;
+		Load3_AVX512(in + ix, vx, vy, vz);
+		_mm512_storeu_ps(x + ix, vx);
+		_mm512_storeu_ps(y + ix, vy);
+		_mm512_storeu_ps(z + ix, vz);
+	}
+	AosToSoa_AVX2(in + ix, x + ix, y + ix, z + ix, count - ix);
+}
+
+SIMD_TARGET("avx512f")
+static void SoaToAos_AVX512(const float* x, const float* y, const float* z, glm::vec3* out, size_t count) {
+	size_t ix = 0;
+	for (; ix + 16 <= count; ix += 16) {
+		Store3_AVX512(out + ix, _mm512_loadu_ps(x + ix), _mm512_loadu_ps(y + ix), _mm512_loadu_ps(z + ix));
+	}
+	SoaToAos_AVX2(x + ix, y + ix, z + ix, out + ix, count - ix);
+}
+
+#pragma endregion
+
+#undef TRANSPOSE_IN
+#undef TRANSPOSE_OUT
+
+#pragma region Dispatch
+
+// The kernels for a single instruction set
+struct KernelTable {
+	void (*TransformPoints)(const glm::mat4&, const glm::vec3*, glm::vec3*, size_t);
+	void (*TransformNormals)(const glm::mat3&, const glm::vec3*, glm::vec3*, size_t, bool);
+	void (*ComputeBounds)(const glm::vec3*, size_t, glm::vec3&, glm::vec3&);
+	void (*AosToSoa)(const glm::vec3*, float*, float*, float*, size_t);
+	void (*SoaToAos)(const float*, const float*, const float*, glm::vec3*, size_t);
+	void (*GatherVec3)(const glm::vec3*, const int32_t*, size_t, glm::vec3*, size_t);
+};
+
+// Indexed by SimdLevel. Every level uses the scalar gather: the AVX2 and AVX-512 gather instructions need three
+// gathers (plus one for strided indices) per group, and timed at around twice as slow as plain 12 byte loads
+static const KernelTable KERNEL_TABLES[] = {
+	{ TransformPoints_Scalar, TransformNormals_Scalar, ComputeBounds_Scalar, AosToSoa_Scalar, SoaToAos_Scalar, GatherVec3_Scalar },
+	{ TransformPoints_SSE,    TransformNormals_SSE,    ComputeBounds_SSE,    AosToSoa_SSE,    SoaToAos_SSE,    GatherVec3_Scalar },
+	{ TransformPoints_AVX2,   TransformNormals_AVX2,   ComputeBounds_AVX2,   AosToSoa_AVX2,   SoaToAos_AVX2,   GatherVec3_Scalar },
+	{ TransformPoints_AVX512, TransformNormals_AVX512, ComputeBounds_AVX512, AosToSoa_AVX512, SoaToAos_AVX512, GatherVec3_Scalar },
+};
+
+static void CpuId(int leaf, int subLeaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+	int result[4];
+	__cpuidex(result, leaf, subLeaf);
+	for (int ix = 0; ix < 4; ix++) regs[ix] = (uint32_t)result[ix];
+#else
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Reads which register states the OS saves on context switches, wide registers are useless if they aren't saved
+static uint64_t GetEnabledXStates() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+static SimdLevel DetectSimdLevel() {
+	uint32_t regs[4];
+	CpuId(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+
+	CpuId(1, 0, regs);
+	const bool sse42   = (regs[2] & (1u << 20)) != 0;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx     = (regs[2] & (1u << 28)) != 0;
+	if (!sse42) {
+		return SimdLevel::Scalar;
+	}
+	if (!osxsave || !avx || maxLeaf < 7) {
+		return SimdLevel::SSE42;
+	}
+
+	const uint64_t xstates = GetEnabledXStates();
+	// Bits 1 and 2 are the SSE and AVX state, 5-7 are the AVX-512 opmask and upper registers
+	const bool osAvx = (xstates & 0x6) == 0x6;
+	const bool osAvx512 = (xstates & 0xE6) == 0xE6;
+
+	CpuId(7, 0, regs);
+	const bool avx2    = (regs[1] & (1u << 5)) != 0;
+	const bool avx512f = (regs[1] & (1u << 16)) != 0;
+	if (avx512f && osAvx512) {
+		return SimdLevel::AVX512;
+	}
+	if (avx2 && osAvx) {
+		return SimdLevel::AVX2;
+	}
+	return SimdLevel::SSE42;
+}
+
+static SimdLevel GetDetectedLevel() {
+	static const SimdLevel detected = []() {
+		SimdLevel level = DetectSimdLevel();
+		LOG_INFO("Using {} vertex kernels", SimdKernels::GetLevelName(level));
+		return level;
+	}();
+	return detected;
+}
+
+// The level the kernels are running at, or -1 if we haven't picked one yet
+static std::atomic<int> s_activeLevel(-1);
+
+static const KernelTable& GetKernels() {
+	int level = s_activeLevel.load(std::memory_order_relaxed);
+	if (level < 0) {
+		level = (int)GetDetectedLevel();
+		s_activeLevel.store(level, std::memory_order_relaxed);
+	}
+	return KERNEL_TABLES[level];
+}
+
+#pragma endregion
+
+SimdLevel SimdKernels::GetSupportedLevel() {
+	return GetDetectedLevel();
+}
+
+SimdLevel SimdKernels::GetActiveLevel() {
+	GetKernels();
+	return (SimdLevel)s_activeLevel.load(std::memory_order_relaxed);
+}
+
+void SimdKernels::SetActiveLevel(SimdLevel level) {
+	s_activeLevel.store((int)std::min(level, GetSupportedLevel()), std::memory_order_relaxed);
+}
+
+const char* SimdKernels::GetLevelName(SimdLevel level) {
+	switch (level) {
+		case SimdLevel::Scalar: return "Scalar";
+		case SimdLevel::SSE42:  return "SSE4.2";
+		case SimdLevel::AVX2:   return "AVX2";
+		case SimdLevel::AVX512: return "AVX-512";
+		default:                return "Unknown";
+	}
+}
+
+void SimdKernels::TransformPoints(const glm::mat4& transform, const glm::vec3* in, glm::vec3* out, size_t count) {
+	GetKernels().TransformPoints(transform, in, out, count);
+}
+
+void SimdKernels::TransformNormals(const glm::mat3& transform, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize) {
+	GetKernels().TransformNormals(transform, in, out, count, normalize);
+}
+
+void SimdKernels::ComputeBounds(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max) {
+	GetKernels().ComputeBounds(points, count, min, max);
+}
+
+void SimdKernels::AosToSoa(const glm::vec3* in, float* x, float* y, float* z, size_t count) {
+	GetKernels().AosToSoa(in, x, y, z, count);
+}
+
+void SimdKernels::SoaToAos(const float* x, const float* y, const float* z, glm::vec3* out, size_t count) {
+	GetKernels().SoaToAos(x, y, z, out, count);
+}
+
+void SimdKernels::GatherVec3(const glm::vec3* table, const int32_t* indices, size_t indexStride, glm::vec3* out, size_t count) {
+	GetKernels().GatherVec3(table, indices, indexStride, out, count);
+}
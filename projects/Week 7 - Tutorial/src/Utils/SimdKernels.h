@@ -0,0 +1,78 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// The instruction sets our kernels have implementations for, in order of preference
+/// </summary>
+enum class SimdLevel {
+	Scalar = 0,
+	SSE42  = 1,
+	AVX2   = 2,
+	AVX512 = 3
+};
+
+/// <summary>
+/// A small library of kernels for processing large arrays of vertex data. Every kernel has a plain scalar
+/// reference implementation, plus SSE4.2, AVX2 and AVX-512 versions, and the best one the CPU supports is
+/// picked at runtime using CPUID. All of the kernels work on tightly packed glm vectors, and process 4, 8 or 16
+/// vertices at a time by transposing them into registers of x's, y's and z's (except for GatherVec3, where the
+/// scalar loop timed faster than the gather instructions). See SimdKernelTests for checking and timing them
+/// </summary>
+class SimdKernels
+{
+public:
+	/// <summary>
+	/// Gets the best instruction set that this CPU and OS support
+	/// </summary>
+	static SimdLevel GetSupportedLevel();
+	/// <summary>
+	/// Gets the instruction set that the kernels are currently using
+	/// </summary>
+	static SimdLevel GetActiveLevel();
+	/// <summary>
+	/// Overrides the instruction set to use, ex: to compare against the scalar reference. Levels above what
+	/// the CPU supports are clamped to the supported level
+	/// </summary>
+	static void SetActiveLevel(SimdLevel level);
+	/// <summary>
+	/// Gets a human readable name for an instruction set
+	/// </summary>
+	static const char* GetLevelName(SimdLevel level);
+
+	/// <summary>
+	/// Transforms an array of points by a matrix (with w = 1). in and out may be the same array
+	/// </summary>
+	static void TransformPoints(const glm::mat4& transform, const glm::vec3* in, glm::vec3* out, size_t count);
+	/// <summary>
+	/// Transforms an array of directions by a 3x3 matrix, optionally re-normalizing the results. For normals,
+	/// pass in the inverse transpose of the model matrix. in and out may be the same array
+	/// </summary>
+	static void TransformNormals(const glm::mat3& transform, const glm::vec3* in, glm::vec3* out, size_t count, bool normalize = true);
+	/// <summary>
+	/// Finds the axis aligned bounds of an array of points. If count is 0, min will be FLT_MAX and max will be -FLT_MAX
+	/// </summary>
+	static void ComputeBounds(const glm::vec3* points, size_t count, glm::vec3& min, glm::vec3& max);
+	/// <summary>
+	/// Splits an array of vec3s into separate arrays for each component
+	/// </summary>
+	static void AosToSoa(const glm::vec3* in, float* x, float* y, float* z, size_t count);
+	/// <summary>
+	/// Interleaves separate component arrays into an array of vec3s
+	/// </summary>
+	static void SoaToAos(const float* x, const float* y, const float* z, glm::vec3* out, size_t count);
+	/// <summary>
+	/// Looks up vec3s by index, out[i] = table[indices[i * indexStride]]. Indices must be in range
+	/// </summary>
+	/// <param name="table">The values to look up</param>
+	/// <param name="indices">The indices to look up, ex: one component of an array of ivec3s</param>
+	/// <param name="indexStride">The distance between consecutive indices, in ints</param>
+	/// <param name="out">Receives the values</param>
+	/// <param name="count">The number of values to look up</param>
+	static void GatherVec3(const glm::vec3* table, const int32_t* indices, size_t indexStride, glm::vec3* out, size_t count);
+
+protected:
+	SimdKernels() = default;
+	~SimdKernels() = default;
+};
@@ -0,0 +1,171 @@
+#include "StagingAllocator.h"
+#include <Logging.h>
+#include <algorithm>
+#include <iterator>
+
+void* StagingBufferPool::Allocate(size_t bytes) {
+	__CheckThread();
+	__ReclaimRetired();
+
+	size_t size = (std::max<size_t>(bytes, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+	// First fit out of our existing blocks
+	size_t blockIx = _blocks.size();
+	size_t offset = 0;
+	for (size_t ix = 0; ix < _blocks.size() && blockIx == _blocks.size(); ix++) {
+		for (const auto& [rangeOffset, rangeSize] : _blocks[ix].FreeRanges) {
+			if (rangeSize >= size) {
+				blockIx = ix;
+				offset = rangeOffset;
+				break;
+			}
+		}
+	}
+
+	// Big allocations get a block to themselves, so they don't leave a regular block mostly empty when they go
+	if (blockIx == _blocks.size()) {
+		blockIx = __CreateBlock(size > BLOCK_SIZE / 2 ? size : BLOCK_SIZE);
+		offset = 0;
+	}
+
+	Block& block = _blocks[blockIx];
+	auto it = block.FreeRanges.find(offset);
+	size_t remaining = it->second - size;
+	block.FreeRanges.erase(it);
+	if (remaining > 0) {
+		block.FreeRanges[offset + size] = remaining;
+	}
+	block.Used += size;
+
+	void* result = block.Data + offset;
+	_allocations[result] = { blockIx, offset, size };
+	_allocatedBytes += size;
+	return result;
+}
+
+void StagingBufferPool::Free(void* ptr) {
+	__CheckThread();
+	auto it = _allocations.find(ptr);
+	if (it == _allocations.end()) {
+		LOG_WARN("Attempted to free a pointer that was not allocated from the staging pool");
+		return;
+	}
+	// The fence goes in after any copies out of this range, we can't hand it out again until it has signalled
+	_retired.push_back({ it->second, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	_allocatedBytes -= it->second.Size;
+	_allocations.erase(it);
+
+	__ReclaimRetired();
+}
+
+GLuint StagingBufferPool::GetHandle(const void* ptr) {
+	auto it = _allocations.find(ptr);
+	return it == _allocations.end() ? 0 : _blocks[it->second.Block].Handle;
+}
+
+size_t StagingBufferPool::GetOffset(const void* ptr) {
+	auto it = _allocations.find(ptr);
+	return it == _allocations.end() ? 0 : it->second.Offset;
+}
+
+void StagingBufferPool::__CheckThread() {
+	if (_owner == std::thread::id()) {
+		_owner = std::this_thread::get_id();
+	}
+	LOG_ASSERT(_owner == std::this_thread::get_id(), "The staging buffer pool can only be used from the thread that owns the GL context!");
+}
+
+void StagingBufferPool::__ReclaimRetired() {
+	// Fences signal in order, so we can stop at the first one that hasn't
+	size_t done = 0;
+	for (; done < _retired.size(); done++) {
+		GLenum status = glClientWaitSync(_retired[done].Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		glDeleteSync(_retired[done].Fence);
+		__ReleaseRange(_retired[done].Range);
+	}
+	_retired.erase(_retired.begin(), _retired.begin() + done);
+}
+
+void StagingBufferPool::__ReleaseRange(const Allocation& range) {
+	Block& block = _blocks[range.Block];
+	block.Used -= range.Size;
+
+	// Put the range back, merging it with the free ranges on either side
+	size_t offset = range.Offset;
+	size_t size = range.Size;
+	auto next = block.FreeRanges.lower_bound(offset);
+	if (next != block.FreeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		next = block.FreeRanges.erase(next);
+	}
+	if (next != block.FreeRanges.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			offset = prev->first;
+			size += prev->second;
+			block.FreeRanges.erase(prev);
+		}
+	}
+	block.FreeRanges[offset] = size;
+
+	// Hang on to one empty regular block so that the next builder doesn't have to map a new one, release the rest
+	if (block.Used == 0) {
+		bool keep = false;
+		if (block.Size == BLOCK_SIZE) {
+			keep = true;
+			for (size_t ix = 0; ix < _blocks.size(); ix++) {
+				if (ix != range.Block && _blocks[ix].Handle != 0 && _blocks[ix].Used == 0 && _blocks[ix].Size == BLOCK_SIZE) {
+					keep = false;
+					break;
+				}
+			}
+		}
+		if (!keep) {
+			glUnmapNamedBuffer(block.Handle);
+			glDeleteBuffers(1, &block.Handle);
+			_reservedBytes -= block.Size;
+			block = Block();
+		}
+	}
+}
+
+size_t StagingBufferPool::__CreateBlock(size_t size) {
+	// Persistent + coherent lets us keep the pointer around and write to it like normal memory, and client storage
+	// hints to the driver that the buffer should live in system memory, since the CPU is the one filling it
+	const GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	GLuint handle = 0;
+	glCreateBuffers(1, &handle);
+	glNamedBufferStorage(handle, size, nullptr, mapFlags | GL_CLIENT_STORAGE_BIT);
+	void* data = glMapNamedBufferRange(handle, 0, size, mapFlags);
+	if (data == nullptr) {
+		LOG_WARN("Failed to map a staging buffer of {} bytes", size);
+		glDeleteBuffers(1, &handle);
+		throw std::bad_alloc();
+	}
+
+	// Re-use the slot of a block we've released, if there is one
+	size_t result = _blocks.size();
+	for (size_t ix = 0; ix < _blocks.size(); ix++) {
+		if (_blocks[ix].Handle == 0) {
+			result = ix;
+			break;
+		}
+	}
+	if (result == _blocks.size()) {
+		_blocks.emplace_back();
+	}
+
+	Block& block = _blocks[result];
+	block.Handle = handle;
+	block.Data = static_cast<unsigned char*>(data);
+	block.Size = size;
+	block.Used = 0;
+	block.FreeRanges.clear();
+	block.FreeRanges[0] = size;
+	_reservedBytes += size;
+	return result;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <glad/glad.h>
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <thread>
+#include <type_traits>
+#include <cstddef>
+#include <new>
+
+/// <summary>
+/// Where a MeshBuilder keeps its vertices and indices while they are being built
+/// Heap:    Regular system memory, which gets copied into the buffer by the driver when baked
+/// Staging: A persistently mapped, CPU visible OpenGL buffer that is written to directly,
+///          and copied GPU side into the final buffer when baked
+/// </summary>
+enum class BuilderStorage {
+	Heap,
+	Staging
+};
+
+/// <summary>
+/// Hands out staging memory from a few large, persistently mapped buffers, and keeps track of which buffer
+/// (and where in it) each allocation lives, so that we can find it again when it comes time to copy or free it.
+///
+/// Creating and mapping a buffer is expensive, so we only do it when none of our blocks have room. Freed ranges
+/// may still be the source of a copy the GPU hasn't run yet, so they are fenced, and only handed out again once
+/// the GPU is done with them. Since it talks to OpenGL, the pool can only be used from the thread that owns the context
+/// </summary>
+class StagingBufferPool
+{
+public:
+	/// <summary>
+	/// Sub-allocates the given number of bytes out of one of our mapped blocks, creating a new block if needed
+	/// </summary>
+	/// <param name="bytes">The number of bytes to allocate</param>
+	/// <returns>A pointer to the mapped storage, throws std::bad_alloc if a new block could not be mapped</returns>
+	static void* Allocate(size_t bytes);
+	/// <summary>
+	/// Returns a range that was returned by Allocate to the pool, once the GPU has finished any copies out of it
+	/// </summary>
+	/// <param name="ptr">The pointer that was returned by Allocate</param>
+	static void Free(void* ptr);
+	/// <summary>
+	/// Gets the OpenGL buffer that backs a pointer returned by Allocate, or 0 if the pointer did not come from the pool
+	/// </summary>
+	static GLuint GetHandle(const void* ptr);
+	/// <summary>
+	/// Gets the offset in bytes of a pointer returned by Allocate within the buffer returned by GetHandle
+	/// </summary>
+	static size_t GetOffset(const void* ptr);
+
+	/// <summary>
+	/// Returns the total number of bytes that are currently allocated from the pool
+	/// </summary>
+	static size_t GetAllocatedBytes() { return _allocatedBytes; }
+	/// <summary>
+	/// Returns the total size of all the mapped blocks that the pool is holding on to
+	/// </summary>
+	static size_t GetReservedBytes() { return _reservedBytes; }
+
+	/// <summary>
+	/// The size of a regular block, allocations bigger than half of this get a block of their own
+	/// </summary>
+	static const size_t BLOCK_SIZE = 16 * 1024 * 1024;
+	/// <summary>
+	/// Every allocation starts on a multiple of this many bytes
+	/// </summary>
+	static const size_t ALIGNMENT = 64;
+
+protected:
+	StagingBufferPool() = default;
+	~StagingBufferPool() = default;
+
+	struct Block {
+		GLuint         Handle = 0;
+		unsigned char* Data   = nullptr;
+		size_t         Size   = 0;
+		// The number of bytes that are allocated or waiting on a fence
+		size_t         Used   = 0;
+		// Free ranges in the block, as offset -> size, with neighbouring ranges merged
+		std::map<size_t, size_t> FreeRanges;
+	};
+
+	struct Allocation {
+		size_t Block;
+		size_t Offset;
+		size_t Size;
+	};
+
+	// A range that has been freed, but that the GPU may still be reading from
+	struct RetiredRange {
+		Allocation Range;
+		GLsync     Fence;
+	};
+
+	// Blocks are never removed from the list so that allocations can refer to them by index, released blocks have a 0 handle
+	inline static std::vector<Block> _blocks;
+	inline static std::unordered_map<const void*, Allocation> _allocations;
+	inline static std::vector<RetiredRange> _retired;
+	inline static size_t _allocatedBytes = 0;
+	inline static size_t _reservedBytes = 0;
+	// The thread that first used the pool, which has to be the one with our GL context
+	inline static std::thread::id _owner;
+
+	static void __CheckThread();
+	static void __ReclaimRetired();
+	static void __ReleaseRange(const Allocation& range);
+	static size_t __CreateBlock(size_t size);
+};
+
+/// <summary>
+/// A standard library allocator that can either allocate from the heap, or out of the staging buffer pool.
+/// Containers using this allocator can be filled in place, and then copied to the GPU without another CPU copy
+/// </summary>
+/// <typeparam name="T">The type of element to allocate</typeparam>
+template <typename T>
+class StagingAllocator
+{
+public:
+	typedef T value_type;
+	// Our storage mode has to follow the data around, otherwise swaps and moves would mix up the two pools
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	StagingAllocator(BuilderStorage storage = BuilderStorage::Heap) noexcept :
+		Storage(storage) {}
+	template <typename U>
+	StagingAllocator(const StagingAllocator<U>& other) noexcept :
+		Storage(other.Storage) {}
+
+	T* allocate(size_t count) {
+		if (Storage == BuilderStorage::Staging) {
+			return static_cast<T*>(StagingBufferPool::Allocate(count * sizeof(T)));
+		}
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, size_t count) noexcept {
+		if (Storage == BuilderStorage::Staging) {
+			StagingBufferPool::Free(ptr);
+		} else {
+			::operator delete(ptr);
+		}
+	}
+
+	BuilderStorage Storage;
+};
+
+template <typename T, typename U>
+bool operator==(const StagingAllocator<T>& a, const StagingAllocator<U>& b) { return a.Storage == b.Storage; }
+template <typename T, typename U>
+bool operator!=(const StagingAllocator<T>& a, const StagingAllocator<U>& b) { return a.Storage != b.Storage; }
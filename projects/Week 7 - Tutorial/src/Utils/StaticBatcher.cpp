@@ -0,0 +1,122 @@
+#include "StaticBatcher.h"
+#include "Utils/MeshBuilder.h"
+#include "Utils/MeshReadback.h"
+#include "Utils/SimdKernels.h"
+#include "Graphics/VertexTypes.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <map>
+#include <tuple>
+
+std::vector<StaticBatchChunk> StaticBatcher::Build(const std::vector<StaticBatchInstance>& instances, std::vector<bool>& outBatched, const StaticBatchSettings& settings) {
+	outBatched.assign(instances.size(), false);
+
+	// Read everything back and find which cell each instance lands in. We bin whole objects by the center of
+	// their bounds rather than splitting triangles, so a chunk's bounds may poke a little out of its cell
+	std::vector<MeshData> meshes(instances.size());
+	std::map<std::tuple<uint32_t, int, int, int>, std::vector<size_t>> cells;
+	const float cellScale = 1.0f / glm::max(settings.ChunkSize, 0.001f);
+	for (size_t ix = 0; ix < instances.size(); ix++) {
+		const StaticBatchInstance& instance = instances[ix];
+		if (!MeshReadback::Read(instance.Mesh, meshes[ix])) {
+			LOG_WARN("Could not read mesh for static batch instance {}, it will not be batched", ix);
+			continue;
+		}
+		// Move the mesh into world space up front, so we can bin it by its world bounds
+		MeshData& mesh = meshes[ix];
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.Transform)));
+		SimdKernels::TransformPoints(instance.Transform, mesh.Positions.data(), mesh.Positions.data(), mesh.Positions.size());
+		SimdKernels::TransformNormals(normalMatrix, mesh.Normals.data(), mesh.Normals.data(), mesh.Normals.size());
+		glm::vec3 min, max;
+		SimdKernels::ComputeBounds(mesh.Positions.data(), mesh.Positions.size(), min, max);
+		glm::ivec3 cell = glm::ivec3(glm::floor((min + max) * 0.5f * cellScale));
+		cells[std::make_tuple(instance.Group, cell.x, cell.y, cell.z)].push_back(ix);
+	}
+
+	std::vector<StaticBatchChunk> result;
+	for (const auto& [key, members] : cells) {
+		size_t next = 0;
+		while (next < members.size()) {
+			// Take as many instances as will fit under the vertex limit, always taking at least one
+			size_t end = next;
+			size_t vertexCount = 0, indexCount = 0;
+			while (end < members.size()) {
+				const MeshData& mesh = meshes[members[end]];
+				if (end > next && vertexCount + mesh.Positions.size() > settings.MaxChunkVertices) {
+					break;
+				}
+				vertexCount += mesh.Positions.size();
+				indexCount += mesh.Indices.size();
+				end++;
+			}
+
+			MeshBuilder<VertexPosNormTexCol> builder(BuilderStorage::Staging, vertexCount, indexCount);
+			StaticBatchChunk chunk;
+			chunk.Group = std::get<0>(key);
+			chunk.Min = glm::vec3(FLT_MAX);
+			chunk.Max = glm::vec3(-FLT_MAX);
+			chunk.InstanceCount = static_cast<uint32_t>(end - next);
+
+			for (size_t member = next; member < end; member++) {
+				const size_t ix = members[member];
+				const MeshData& mesh = meshes[ix];
+				const glm::mat4& transform = instances[ix].Transform;
+
+				uint32_t offset = static_cast<uint32_t>(builder.GetVertexCount());
+				for (size_t vert = 0; vert < mesh.Positions.size(); vert++) {
+					builder.AddVertex(mesh.Positions[vert], mesh.Normals[vert], mesh.UVs[vert], mesh.Colors[vert]);
+				}
+				glm::vec3 min, max;
+				SimdKernels::ComputeBounds(mesh.Positions.data(), mesh.Positions.size(), min, max);
+				chunk.Min = glm::min(chunk.Min, min);
+				chunk.Max = glm::max(chunk.Max, max);
+
+				// Mirrored transforms turn our triangles inside out, so flip their winding back
+				if (glm::determinant(glm::mat3(transform)) < 0.0f) {
+					for (size_t tri = 0; tri < mesh.Indices.size(); tri += 3) {
+						builder.AddIndexTri(offset + mesh.Indices[tri], offset + mesh.Indices[tri + 2], offset + mesh.Indices[tri + 1]);
+					}
+				} else {
+					builder.AddIndexRange(mesh.Indices.data(), mesh.Indices.size(), offset);
+				}
+				outBatched[ix] = true;
+			}
+
+			chunk.Mesh = builder.Bake();
+			result.push_back(chunk);
+			next = end;
+		}
+	}
+
+	LOG_INFO("Merged {} static objects into {} chunks", std::count(outBatched.begin(), outBatched.end(), true), result.size());
+	return result;
+}
+
+void StaticBatcher::ExtractFrustum(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+	// GLM matrices are column major, so we need to pull the rows out ourselves
+	glm::mat4 rows = glm::transpose(viewProjection);
+	planes[0] = rows[3] + rows[0]; // Left
+	planes[1] = rows[3] - rows[0]; // Right
+	planes[2] = rows[3] + rows[1]; // Bottom
+	planes[3] = rows[3] - rows[1]; // Top
+	planes[4] = rows[3] + rows[2]; // Near
+	planes[5] = rows[3] - rows[2]; // Far
+}
+
+bool StaticBatcher::IsBoxVisible(const glm::vec4 planes[6], const glm::vec3& min, const glm::vec3& max) {
+	for (int ix = 0; ix < 6; ix++) {
+		// Test the corner of the box that is furthest along the plane's normal, if that's outside so is the whole box
+		glm::vec3 normal = glm::vec3(planes[ix]);
+		glm::vec3 corner = glm::vec3(
+			normal.x >= 0.0f ? max.x : min.x,
+			normal.y >= 0.0f ? max.y : min.y,
+			normal.z >= 0.0f ? max.z : min.z
+		);
+		if (glm::dot(normal, corner) + planes[ix].w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
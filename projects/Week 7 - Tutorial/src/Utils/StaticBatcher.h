@@ -0,0 +1,77 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Settings for building static batches
+/// </summary>
+struct StaticBatchSettings {
+	/// <summary>
+	/// The size of the grid cells that objects are sorted into, in world units. Each group gets one chunk
+	/// per cell, so smaller cells cull more precisely at the cost of more draw calls
+	/// </summary>
+	float    ChunkSize = 16.0f;
+	/// <summary>
+	/// The most vertices we'll put into a single chunk, cells with more than this get split into more chunks
+	/// </summary>
+	uint32_t MaxChunkVertices = 1 << 18;
+};
+
+/// <summary>
+/// An object that should be merged into the static batches
+/// </summary>
+struct StaticBatchInstance {
+	VertexArrayObject::Sptr Mesh;
+	glm::mat4               Transform = glm::mat4(1.0f);
+	// Objects are only merged with others in the same group, ex: everything sharing a material
+	uint32_t                Group = 0;
+};
+
+/// <summary>
+/// A merged mesh, with its vertices already in world space
+/// </summary>
+struct StaticBatchChunk {
+	VertexArrayObject::Sptr Mesh;
+	uint32_t                Group;
+	// The world space bounds of the chunk, for culling
+	glm::vec3               Min;
+	glm::vec3               Max;
+	// The number of instances that were merged into this chunk
+	uint32_t                InstanceCount;
+};
+
+/// <summary>
+/// Helper class for merging static objects together at load time, so that lots of small objects can be drawn
+/// with a handful of draw calls. Objects are pre-transformed into world space, grouped by whatever the caller
+/// needs to keep separate (ex: material), and then split up by a grid so that the chunks can still be culled
+/// </summary>
+class StaticBatcher
+{
+public:
+	/// <summary>
+	/// Merges the given instances into chunks. The meshes are read back from the GPU, so this should only
+	/// be done at load time. The chunks use the VertexPosNormTexCol layout
+	/// </summary>
+	/// <param name="instances">The objects to merge</param>
+	/// <param name="outBatched">Receives whether each instance made it into a chunk, instances whose mesh can't be read are left out</param>
+	/// <param name="settings">The settings to build the chunks with</param>
+	/// <returns>The merged chunks</returns>
+	static std::vector<StaticBatchChunk> Build(const std::vector<StaticBatchInstance>& instances, std::vector<bool>& outBatched,
+											   const StaticBatchSettings& settings = StaticBatchSettings());
+
+	/// <summary>
+	/// Extracts the 6 planes of the view frustum from a view projection matrix, with the normals facing inwards
+	/// </summary>
+	static void ExtractFrustum(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	/// <summary>
+	/// Checks if an axis aligned box is at least partially inside of a frustum
+	/// </summary>
+	static bool IsBoxVisible(const glm::vec4 planes[6], const glm::vec3& min, const glm::vec3& max);
+
+protected:
+	StaticBatcher() = default;
+	~StaticBatcher() = default;
+};
@@ -0,0 +1,89 @@
+#include "StlLoader.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/VertexWelder.h"
+#include "Graphics/IndexBuffer.h"
+#include "Graphics/VertexBuffer.h"
+#include "Graphics/VertexTypes.h"
+#include <Logging.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+// An 80 byte header we don't care about, followed by the triangle count
+static const size_t STL_HEADER_SIZE = 84;
+// A face normal and 3 corners as floats, followed by a 2 byte attribute count
+static const size_t STL_RECORD_SIZE = 50;
+// The number of triangles a thread converts at a time
+static const size_t STL_BATCH = 4096;
+
+// Adding zero turns -0 into 0, so the welder sees them as the same value
+static inline glm::vec3 ReadVec3(const uint8_t* data) {
+	glm::vec3 result;
+	memcpy(&result, data, sizeof(glm::vec3));
+	return result + glm::vec3(0.0f);
+}
+
+VertexArrayObject::Sptr StlLoader::LoadFromFile(const std::string& filename) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	MemoryMappedFile file;
+	if (!file.Open(filename)) {
+		throw std::runtime_error("Failed to open file");
+	}
+	if (file.GetSize() < STL_HEADER_SIZE) {
+		throw std::runtime_error("File is too small to be a binary STL");
+	}
+
+	// ASCII STLs start with "solid", but so do plenty of binary ones, so we go by whether the size adds up
+	uint32_t triangleCount;
+	memcpy(&triangleCount, file.GetData() + 80, sizeof(uint32_t));
+	if (file.GetSize() != STL_HEADER_SIZE + static_cast<size_t>(triangleCount) * STL_RECORD_SIZE) {
+		if (memcmp(file.GetData(), "solid", 5) == 0) {
+			throw std::runtime_error("ASCII STL files are not supported, export as binary STL");
+		}
+		throw std::runtime_error("Binary STL size does not match it's triangle count");
+	}
+	if (triangleCount == 0 || triangleCount > UINT32_MAX / 3) {
+		throw std::runtime_error("Binary STL has an invalid triangle count");
+	}
+
+	// Expand the records into a triangle soup. Some exporters leave the normals as zero, so we fill those in from the winding
+	const uint8_t* records = file.GetData() + STL_HEADER_SIZE;
+	std::vector<VertexPosNormTexCol> soup(static_cast<size_t>(triangleCount) * 3);
+	const uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	ParallelFor(triangleCount, STL_BATCH, numThreads, [&](size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) {
+			const uint8_t* record = records + ix * STL_RECORD_SIZE;
+			glm::vec3 normal = ReadVec3(record);
+			glm::vec3 a = ReadVec3(record + 12), b = ReadVec3(record + 24), c = ReadVec3(record + 36);
+			if (glm::dot(normal, normal) == 0.0f) {
+				glm::vec3 cross = glm::cross(b - a, c - a);
+				float length = glm::length(cross);
+				normal = length > 0.0f ? cross / length : glm::vec3(0.0f, 0.0f, 1.0f);
+			}
+			soup[ix * 3 + 0] = VertexPosNormTexCol(a, normal, glm::vec2(0.0f), glm::vec4(1.0f));
+			soup[ix * 3 + 1] = VertexPosNormTexCol(b, normal, glm::vec2(0.0f), glm::vec4(1.0f));
+			soup[ix * 3 + 2] = VertexPosNormTexCol(c, normal, glm::vec2(0.0f), glm::vec4(1.0f));
+		}
+	});
+	file.Close();
+
+	std::vector<VertexPosNormTexCol> vertices;
+	std::vector<uint32_t> indices;
+	VertexWelder::Weld(soup.data(), soup.size(), vertices, indices, numThreads);
+
+	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
+	vertexBuffer->LoadData(vertices.data(), vertices.size());
+	IndexBuffer::Sptr indexBuffer = IndexBuffer::Create();
+	indexBuffer->LoadData(indices.data(), indices.size());
+
+	VertexArrayObject::Sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
+	result->SetIndexBuffer(indexBuffer);
+
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	LOG_INFO("Loaded \"{}\" ({} triangles, welded {} corners into {} vertices) in {:.2f}ms", filename, triangleCount, soup.size(), vertices.size(), ms);
+	return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Loads binary STL files, as exported by most CAD packages. STL stores every triangle with it's own face
+/// normal and 3 unshared corners, so the triangles are welded back into an indexed mesh on load. The mesh
+/// stays flat shaded, corners are only shared between triangles that face the same way
+/// </summary>
+class StlLoader
+{
+public:
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+
+protected:
+	StlLoader() = default;
+	~StlLoader() = default;
+};
@@ -0,0 +1,410 @@
+#include "TextureStreamer.h"
+#include <stb_image.h>
+#include <Logging.h>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <chrono>
+#include <imgui.h>
+
+bool TextureStreamer::_isInitialized = false;
+size_t TextureStreamer::_budget = 0;
+size_t TextureStreamer::_residentBytes = 0;
+std::atomic<size_t> TextureStreamer::_pendingCount(0);
+std::map<std::weak_ptr<Texture2D>, std::shared_ptr<TextureStreamer::StreamedTexture>, std::owner_less<>> TextureStreamer::_textures;
+std::vector<std::thread> TextureStreamer::_workers;
+std::mutex TextureStreamer::_jobMutex;
+std::condition_variable TextureStreamer::_jobSignal;
+std::condition_variable TextureStreamer::_idleSignal;
+std::queue<std::shared_ptr<TextureStreamer::StreamedTexture>> TextureStreamer::_pendingJobs;
+std::queue<std::shared_ptr<TextureStreamer::StreamedTexture>> TextureStreamer::_completedJobs;
+bool TextureStreamer::_isRunning = false;
+
+// Used to mark a texture that only has it's placeholder resident
+static const uint32_t NO_LEVELS_RESIDENT = UINT32_MAX;
+
+void TextureStreamer::Init(size_t budgetBytes, uint32_t numThreads) {
+	if (_isInitialized) return;
+
+	_budget = budgetBytes;
+	_residentBytes = 0;
+
+	// STBI's flip setting is global, so we set it once here rather than racing our worker threads.
+	// This matches what Texture2D does when it loads an image
+	stbi_set_flip_vertically_on_load(true);
+
+	_isRunning = true;
+	numThreads = std::max(numThreads, 1u);
+	for (uint32_t ix = 0; ix < numThreads; ix++) {
+		_workers.emplace_back(&TextureStreamer::__WorkerThread);
+	}
+	_isInitialized = true;
+}
+
+void TextureStreamer::Cleanup() {
+	if (!_isInitialized) return;
+
+	// Wake up all our workers and let them exit
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_isRunning = false;
+		while (!_pendingJobs.empty()) _pendingJobs.pop();
+	}
+	_jobSignal.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+	while (!_completedJobs.empty()) _completedJobs.pop();
+
+	_textures.clear();
+	_residentBytes = 0;
+	_pendingCount = 0;
+	_isInitialized = false;
+}
+
+Texture2D::Sptr TextureStreamer::Load(const std::string& path, const Texture2DDescription& description) {
+	LOG_ASSERT(_isInitialized, "Texture streamer has not been initialized!");
+
+	// Create the texture without a size, so that it does not allocate any storage
+	Texture2DDescription desc = description;
+	desc.Filename = "";
+	desc.Width = desc.Height = 0;
+	Texture2D::Sptr result = std::make_shared<Texture2D>(desc);
+	result->_description.Filename = path;
+
+	// Give the texture a 1x1 grey placeholder until it's smallest mips are ready
+	const uint8_t placeholder[4] = { 128, 128, 128, 255 };
+	glTextureStorage2D(result->_handle, 1, GL_RGBA8, 1, 1);
+	glTextureSubImage2D(result->_handle, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	result->_description.Width = result->_description.Height = 1;
+	result->_description.Format = InternalFormat::RGBA8;
+
+	std::shared_ptr<StreamedTexture> entry = std::make_shared<StreamedTexture>();
+	entry->Texture = result;
+	entry->Path = path;
+	entry->ResidentLevel = NO_LEVELS_RESIDENT;
+	_textures[result] = entry;
+
+	__QueueDecode(entry);
+
+	return result;
+}
+
+void TextureStreamer::ReportUsage(const Texture2D::Sptr& texture, float screenPixels) {
+	auto it = _textures.find(texture);
+	if (it != _textures.end()) {
+		it->second->MaxScreenPixels = std::max(it->second->MaxScreenPixels, screenPixels);
+	}
+}
+
+void TextureStreamer::Update() {
+	if (!_isInitialized) return;
+
+	// Grab all the textures that have finished decoding
+	std::vector<std::shared_ptr<StreamedTexture>> completed;
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		while (!_completedJobs.empty()) {
+			completed.push_back(_completedJobs.front());
+			_completedJobs.pop();
+		}
+	}
+
+	// Newly decoded textures get their smallest mips uploaded right away, regardless of budget
+	for (auto& entry : completed) {
+		// The texture may have been destroyed while we were decoding it
+		if (entry->Texture.expired()) {
+			continue;
+		}
+
+		// Textures we're decoding again already have their tail resident, we just needed the data back
+		// (if the decode failed, we keep the sizes we had and try again next time we need it)
+		if (entry->IsReloading) {
+			entry->IsReloading = false;
+			if (!entry->DecodedLevels.empty()) {
+				entry->Levels = std::move(entry->DecodedLevels);
+				entry->HasCpuData = true;
+			}
+			entry->DecodedLevels.clear();
+			continue;
+		}
+
+		entry->Levels = std::move(entry->DecodedLevels);
+		entry->DecodedLevels.clear();
+		entry->HasCpuData = !entry->Levels.empty();
+
+		entry->IsDecoded = true;
+		if (entry->Levels.empty()) {
+			continue;
+		}
+		uint32_t tail = 0;
+		while (tail < entry->Levels.size() - 1 && std::max(entry->Levels[tail].Width, entry->Levels[tail].Height) > MIN_RESIDENT_SIZE) {
+			tail++;
+		}
+		entry->TailLevel = tail;
+		entry->TargetLevel = tail;
+		__MakeResident(*entry, tail);
+	}
+
+	// Forget about textures that have been destroyed, their GPU storage went with them
+	for (auto it = _textures.begin(); it != _textures.end();) {
+		if (it->first.expired()) {
+			if (it->second->ResidentLevel != NO_LEVELS_RESIDENT) {
+				_residentBytes -= __GetResidentSize(*it->second, it->second->ResidentLevel);
+			}
+			it = _textures.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// Determine what level each texture should be at based on it's screen coverage
+	std::vector<StreamedTexture*> promotions;
+	for (auto& [key, entry] : _textures) {
+		if (!entry->IsDecoded || entry->Levels.empty()) {
+			continue;
+		}
+		uint32_t lastLevel = (uint32_t)entry->Levels.size() - 1;
+
+		if (entry->MaxScreenPixels > 0.0f) {
+			entry->FramesUnused = 0;
+			// We want roughly one texel per pixel, so every halving of the screen size drops a mip level
+			float fullSize = (float)std::max(entry->Levels[0].Width, entry->Levels[0].Height);
+			float level = std::floor(std::log2(std::max(fullSize / entry->MaxScreenPixels, 1.0f)));
+			entry->TargetLevel = std::min((uint32_t)level, lastLevel);
+		} else if (entry->FramesUnused < UNUSED_FRAME_LIMIT) {
+			entry->FramesUnused++;
+		} else {
+			// Unused for a while, let it fall back to it's smallest resident set
+			entry->TargetLevel = entry->TailLevel;
+		}
+		entry->MaxScreenPixels = 0.0f;
+
+		// Drop levels we have too much detail for. We leave one level of slack to avoid thrashing
+		// when an object hovers around a boundary
+		if (entry->ResidentLevel != NO_LEVELS_RESIDENT && entry->ResidentLevel + 1 < entry->TargetLevel) {
+			__MakeResident(*entry, entry->TargetLevel);
+		}
+		else if (entry->ResidentLevel != NO_LEVELS_RESIDENT && entry->ResidentLevel > entry->TargetLevel) {
+			// We need the CPU data for the finer levels, if it's been released we have to decode it again first
+			if (entry->HasCpuData) {
+				promotions.push_back(entry.get());
+			} else if (!entry->IsReloading) {
+				entry->IsReloading = true;
+				__QueueDecode(entry);
+			}
+		}
+	}
+
+	// If we're over budget (ex: the budget was lowered), drop a level from whichever textures have the
+	// most detail relative to what they need until we fit again. We never drop below the tail levels
+	while (_residentBytes > _budget) {
+		StreamedTexture* victim = nullptr;
+		int victimExcess = INT_MIN;
+		for (auto& [key, entry] : _textures) {
+			if (entry->ResidentLevel == NO_LEVELS_RESIDENT || entry->ResidentLevel >= entry->TailLevel) {
+				continue;
+			}
+			int excess = (int)entry->TargetLevel - (int)entry->ResidentLevel;
+			if (excess > victimExcess) {
+				victim = entry.get();
+				victimExcess = excess;
+			}
+		}
+		if (victim == nullptr) {
+			break;
+		}
+		__MakeResident(*victim, victim->ResidentLevel + 1);
+	}
+
+	// Textures that are the furthest behind get first dibs on the budget
+	std::sort(promotions.begin(), promotions.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+		return (a->ResidentLevel - a->TargetLevel) > (b->ResidentLevel - b->TargetLevel);
+	});
+
+	// Promote textures one level at a time, so that each frame's uploads stay small
+	size_t uploaded = 0;
+	for (StreamedTexture* entry : promotions) {
+		uint32_t next = entry->ResidentLevel - 1;
+		size_t cost = __GetResidentSize(*entry, next) - __GetResidentSize(*entry, entry->ResidentLevel);
+		if (_residentBytes + cost > _budget) {
+			continue;
+		}
+		if (uploaded > 0 && uploaded + cost > MAX_UPLOAD_PER_FRAME) {
+			break;
+		}
+		__MakeResident(*entry, next);
+		uploaded += cost;
+	}
+}
+
+void TextureStreamer::WaitForPending() {
+	{
+		std::unique_lock<std::mutex> lock(_jobMutex);
+		_idleSignal.wait(lock, [] { return _pendingCount == 0; });
+	}
+	Update();
+}
+
+bool TextureStreamer::WaitForPending(float timeoutMs) {
+	bool idle;
+	{
+		std::unique_lock<std::mutex> lock(_jobMutex);
+		idle = _idleSignal.wait_for(lock, std::chrono::duration<float, std::milli>(timeoutMs), [] { return _pendingCount == 0; });
+	}
+	Update();
+	return idle;
+}
+
+void TextureStreamer::DrawImGui() {
+	ImGui::Text("Streamed textures: %d (%d decoding)", (int)_textures.size(), (int)_pendingCount);
+	ImGui::Text("Resident: %.2f / %.2f MB", _residentBytes / (1024.0f * 1024.0f), _budget / (1024.0f * 1024.0f));
+	int budgetMb = (int)(_budget / (1024 * 1024));
+	if (ImGui::DragInt("Budget (MB)", &budgetMb, 1.0f, 1, 4096)) {
+		_budget = (size_t)budgetMb * 1024 * 1024;
+	}
+}
+
+void TextureStreamer::__WorkerThread() {
+	while (true) {
+		std::shared_ptr<StreamedTexture> job;
+		{
+			std::unique_lock<std::mutex> lock(_jobMutex);
+			_jobSignal.wait(lock, [] { return !_isRunning || !_pendingJobs.empty(); });
+			if (!_isRunning) {
+				return;
+			}
+			job = _pendingJobs.front();
+			_pendingJobs.pop();
+		}
+
+		__Decode(*job);
+
+		{
+			std::lock_guard<std::mutex> lock(_jobMutex);
+			_completedJobs.push(job);
+			_pendingCount--;
+			if (_pendingCount == 0) {
+				_idleSignal.notify_all();
+			}
+		}
+	}
+}
+
+void TextureStreamer::__QueueDecode(const std::shared_ptr<StreamedTexture>& texture) {
+	{
+		std::lock_guard<std::mutex> lock(_jobMutex);
+		_pendingJobs.push(texture);
+		_pendingCount++;
+	}
+	_jobSignal.notify_one();
+}
+
+void TextureStreamer::__ReleaseCpuData(StreamedTexture& texture) {
+	// We keep the sizes around, since we still need them to work out our resident size
+	for (MipLevel& level : texture.Levels) {
+		std::vector<uint8_t>().swap(level.Data);
+	}
+	texture.HasCpuData = false;
+}
+
+void TextureStreamer::__Decode(StreamedTexture& texture) {
+	int width, height, numChannels;
+	uint8_t* data = stbi_load(texture.Path.c_str(), &width, &height, &numChannels, 4);
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", texture.Path);
+		return;
+	}
+
+	// We build the chain locally, since the main thread may still be reading the old one
+	std::vector<MipLevel> levels;
+	MipLevel base;
+	base.Width = width;
+	base.Height = height;
+	base.Data.assign(data, data + (size_t)width * height * 4);
+	stbi_image_free(data);
+	levels.push_back(std::move(base));
+
+	// Build the rest of the mip chain with a simple box filter
+	while (levels.back().Width > 1 || levels.back().Height > 1) {
+		const MipLevel& src = levels.back();
+		MipLevel dst;
+		dst.Width = std::max(src.Width / 2, 1u);
+		dst.Height = std::max(src.Height / 2, 1u);
+		dst.Data.resize((size_t)dst.Width * dst.Height * 4);
+		for (uint32_t y = 0; y < dst.Height; y++) {
+			// Clamp our source texels so we handle odd (and 1 texel) dimensions
+			uint32_t y0 = std::min(y * 2, src.Height - 1), y1 = std::min(y * 2 + 1, src.Height - 1);
+			for (uint32_t x = 0; x < dst.Width; x++) {
+				uint32_t x0 = std::min(x * 2, src.Width - 1), x1 = std::min(x * 2 + 1, src.Width - 1);
+				for (uint32_t c = 0; c < 4; c++) {
+					uint32_t sum =
+						src.Data[((size_t)y0 * src.Width + x0) * 4 + c] + src.Data[((size_t)y0 * src.Width + x1) * 4 + c] +
+						src.Data[((size_t)y1 * src.Width + x0) * 4 + c] + src.Data[((size_t)y1 * src.Width + x1) * 4 + c];
+					dst.Data[((size_t)y * dst.Width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+				}
+			}
+		}
+		levels.push_back(std::move(dst));
+	}
+	texture.DecodedLevels = std::move(levels);
+}
+
+size_t TextureStreamer::__GetResidentSize(const StreamedTexture& texture, uint32_t residentLevel) {
+	size_t result = 0;
+	for (size_t ix = residentLevel; ix < texture.Levels.size(); ix++) {
+		result += texture.Levels[ix].GetSize();
+	}
+	return result;
+}
+
+void TextureStreamer::__MakeResident(StreamedTexture& texture, uint32_t residentLevel) {
+	Texture2D::Sptr target = texture.Texture.lock();
+	if (target == nullptr) {
+		return;
+	}
+	uint32_t numLevels = (uint32_t)texture.Levels.size() - residentLevel;
+	const MipLevel& top = texture.Levels[residentLevel];
+
+	// Immutable storage can't be resized, so we allocate a new texture with just the levels we want
+	GLuint handle = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &handle);
+	glTextureStorage2D(handle, numLevels, GL_RGBA8, top.Width, top.Height);
+	glTextureParameteri(handle, GL_TEXTURE_WRAP_S, (GLenum)target->_description.HorizontalWrap);
+	glTextureParameteri(handle, GL_TEXTURE_WRAP_T, (GLenum)target->_description.VerticalWrap);
+	glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (uint32_t level = residentLevel; level < texture.Levels.size(); level++) {
+		const MipLevel& mip = texture.Levels[level];
+		// Levels that are already on the GPU can be copied over without touching the CPU data
+		if (texture.ResidentLevel != NO_LEVELS_RESIDENT && level >= texture.ResidentLevel) {
+			glCopyImageSubData(target->_handle, GL_TEXTURE_2D, level - texture.ResidentLevel, 0, 0, 0,
+							   handle, GL_TEXTURE_2D, level - residentLevel, 0, 0, 0,
+							   mip.Width, mip.Height, 1);
+		} else {
+			glTextureSubImage2D(handle, level - residentLevel, 0, 0, mip.Width, mip.Height, GL_RGBA, GL_UNSIGNED_BYTE, mip.Data.data());
+		}
+	}
+
+	// Swap the new storage into the texture, anything holding onto the texture will pick it up on their next bind
+	glDeleteTextures(1, &target->_handle);
+	target->_handle = handle;
+	target->_description.Width = top.Width;
+	target->_description.Height = top.Height;
+	target->_description.Format = InternalFormat::RGBA8;
+
+	if (texture.ResidentLevel != NO_LEVELS_RESIDENT) {
+		_residentBytes -= __GetResidentSize(texture, texture.ResidentLevel);
+	}
+	_residentBytes += __GetResidentSize(texture, residentLevel);
+	texture.ResidentLevel = residentLevel;
+
+	// With the whole chain on the GPU we don't need the CPU copy anymore. Demoting only copies
+	// levels that are already resident, so we'll only need it again if we're promoted after that
+	if (residentLevel == 0) {
+		__ReleaseCpuData(texture);
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <atomic>
+
+#include "Graphics/Texture2D.h"
+
+/// <summary>
+/// Helper class for streaming textures in by mip level. Textures are decoded and have their mip chains
+/// built on background threads, and only the smallest mips are made resident at first. Every frame the
+/// application reports how large each texture appears on screen, and the streamer will promote textures
+/// to finer mip levels (or demote them) to match, while keeping the total size of all resident levels
+/// under a memory budget.
+///
+/// Only the resident levels of a texture are allocated on the GPU, when a texture is promoted or demoted
+/// we allocate new storage and copy the levels that are shared on the GPU, so the budget reflects actual VRAM use
+/// </summary>
+class TextureStreamer {
+public:
+	/// <summary>
+	/// Initializes the texture streamer, should be called after OpenGL has been initialized
+	/// </summary>
+	/// <param name="budgetBytes">The maximum number of bytes of texture data that can be resident on the GPU</param>
+	/// <param name="numThreads">The number of background threads to use for decoding textures</param>
+	static void Init(size_t budgetBytes = 256 * 1024 * 1024, uint32_t numThreads = 2);
+	/// <summary>
+	/// Stops all background threads and releases streaming data, should be called before closing the application
+	/// </summary>
+	static void Cleanup();
+	/// <summary>
+	/// Returns true if the streamer has been initialized and can stream textures
+	/// </summary>
+	static bool IsInitialized() { return _isInitialized; }
+
+	/// <summary>
+	/// Begins streaming a texture from a file. The texture is returned immediately with a 1x1 placeholder, and
+	/// will be filled in with it's smallest mips once it has been decoded
+	/// </summary>
+	/// <param name="path">The path to the image to load</param>
+	/// <param name="description">The description to use for wrap modes, the size and format will be taken from the file</param>
+	/// <returns>The texture that will be streamed into</returns>
+	static Texture2D::Sptr Load(const std::string& path, const Texture2DDescription& description = Texture2DDescription());
+
+	/// <summary>
+	/// Reports that a texture is being used this frame, covering the given number of pixels along it's
+	/// largest axis. The largest coverage reported in a frame will determine the mip level we stream towards
+	/// </summary>
+	/// <param name="texture">The texture that is being drawn</param>
+	/// <param name="screenPixels">The approximate number of pixels the texture is being stretched across</param>
+	static void ReportUsage(const Texture2D::Sptr& texture, float screenPixels);
+
+	/// <summary>
+	/// Applies completed decodes, and promotes or demotes textures towards their target level. Should be
+	/// called once per frame on the main thread, after all usage for the frame has been reported
+	/// </summary>
+	static void Update();
+
+	/// <summary>
+	/// Blocks until all pending textures have been decoded, and makes their smallest mips resident.
+	/// Useful for load-time work that needs real texture data (ex: impostor baking)
+	/// </summary>
+	static void WaitForPending();
+	/// <summary>
+	/// Blocks until all pending textures have been decoded, or until the timeout expires
+	/// </summary>
+	/// <param name="timeoutMs">The longest we should wait, in milliseconds</param>
+	/// <returns>True if there are no more textures waiting to be decoded</returns>
+	static bool WaitForPending(float timeoutMs);
+
+	/// <summary>
+	/// Sets the maximum number of bytes of texture data that can be resident on the GPU
+	/// </summary>
+	static void SetBudget(size_t budgetBytes) { _budget = budgetBytes; }
+	static size_t GetBudget() { return _budget; }
+	/// <summary>
+	/// Gets the number of bytes of texture data that are currently resident on the GPU
+	/// </summary>
+	static size_t GetResidentBytes() { return _residentBytes; }
+	/// <summary>
+	/// Gets the number of textures that are still waiting to be decoded
+	/// </summary>
+	static size_t GetPendingCount() { return _pendingCount; }
+
+	/// <summary>
+	/// Draws an ImGui widget showing the streaming stats, and allowing the budget to be edited
+	/// </summary>
+	static void DrawImGui();
+
+	/// <summary>
+	/// Any textures that are this size or smaller (along their largest axis) are made resident as soon as they are decoded
+	/// </summary>
+	static const uint32_t MIN_RESIDENT_SIZE = 64;
+	/// <summary>
+	/// The most bytes of texture data we will upload in a single frame, to avoid hitches
+	/// </summary>
+	static const size_t   MAX_UPLOAD_PER_FRAME = 8 * 1024 * 1024;
+	/// <summary>
+	/// The number of frames a texture can go without being used before we let it drop back to it's smallest mips
+	/// </summary>
+	static const uint32_t UNUSED_FRAME_LIMIT = 120;
+
+protected:
+	TextureStreamer() = default;
+
+	// A single decoded mip level, stored on the CPU as RGBA8
+	struct MipLevel {
+		uint32_t Width;
+		uint32_t Height;
+		// Released once the full mip chain is resident, see HasCpuData
+		std::vector<uint8_t> Data;
+
+		size_t GetSize() const { return (size_t)Width * Height * 4; }
+	};
+
+	// Tracks the streaming state of a single texture
+	struct StreamedTexture {
+		// We don't want to keep textures alive just because we're streaming them, entries
+		// for textures that have been destroyed are removed in Update
+		std::weak_ptr<Texture2D> Texture;
+		std::string           Path;
+		// The mip chain, only touched by the main thread
+		std::vector<MipLevel> Levels;
+		// Filled in by the decode threads, and moved into Levels on the main thread
+		std::vector<MipLevel> DecodedLevels;
+		// True once the decode threads have filled in the levels
+		bool                  IsDecoded = false;
+		// True if the CPU copy of the mip chain is in memory. The CPU copy is released once
+		// every level is resident, and decoded again if the texture is promoted after being demoted
+		bool                  HasCpuData = false;
+		// True while we're waiting for the mip chain to be decoded again
+		bool                  IsReloading = false;
+		// The finest level that is currently resident, or UINT32_MAX if only the placeholder is resident
+		uint32_t              ResidentLevel = 0;
+		// The first level that is small enough to be made resident as soon as it's decoded
+		uint32_t              TailLevel = 0;
+		// The level we want to have resident, based on screen coverage
+		uint32_t              TargetLevel = 0;
+		// The largest coverage reported this frame, in pixels
+		float                 MaxScreenPixels = 0.0f;
+		// The number of frames since the texture was last reported as used
+		uint32_t              FramesUnused = 0;
+	};
+
+	static bool _isInitialized;
+	static size_t _budget;
+	static size_t _residentBytes;
+	static std::atomic<size_t> _pendingCount;
+
+	// Keyed by the texture's control block rather than it's address, so a new texture that happens to be
+	// allocated where a destroyed one used to be can't pick up it's entry
+	static std::map<std::weak_ptr<Texture2D>, std::shared_ptr<StreamedTexture>, std::owner_less<>> _textures;
+
+	// Decode jobs are handed to the worker threads, and finished jobs are handed back to the main thread
+	static std::vector<std::thread> _workers;
+	static std::mutex _jobMutex;
+	static std::condition_variable _jobSignal;
+	// Signalled when the last pending decode finishes
+	static std::condition_variable _idleSignal;
+	static std::queue<std::shared_ptr<StreamedTexture>> _pendingJobs;
+	static std::queue<std::shared_ptr<StreamedTexture>> _completedJobs;
+	static bool _isRunning;
+
+	static void __WorkerThread();
+	static void __QueueDecode(const std::shared_ptr<StreamedTexture>& texture);
+	static void __ReleaseCpuData(StreamedTexture& texture);
+	static void __Decode(StreamedTexture& texture);
+	static size_t __GetResidentSize(const StreamedTexture& texture, uint32_t residentLevel);
+	static void __MakeResident(StreamedTexture& texture, uint32_t residentLevel);
+};
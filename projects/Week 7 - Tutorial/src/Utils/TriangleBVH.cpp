@@ -0,0 +1,487 @@
+#include "TriangleBVH.h"
+#include <Logging.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+// Hits closer than this are ignored, so rays don't hit the surface they start on
+static const float RAY_EPSILON = 1e-5f;
+// Triangles that are this close to parallel with a ray are treated as a miss
+static const float DET_EPSILON = 1e-10f;
+
+// An axis aligned box that we grow as we add things to it
+struct BuildBounds {
+	glm::vec3 Min = glm::vec3(FLT_MAX);
+	glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+	void Grow(const glm::vec3& point) {
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+	void Grow(const BuildBounds& other) {
+		Min = glm::min(Min, other.Min);
+		Max = glm::max(Max, other.Max);
+	}
+	float Area() const {
+		glm::vec3 size = glm::max(Max - Min, glm::vec3(0.0f));
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+};
+
+// Avoids dividing by zero for axis aligned rays, while keeping the sign
+static inline float SafeInverse(float value) {
+	return 1.0f / (std::abs(value) > 1e-12f ? value : std::copysign(1e-12f, value));
+}
+
+// Loads the 3 floats of a vector along with whatever comes after them, callers need to mask out the 4th lane
+static inline __m128 LoadVec3Unsafe(const glm::vec3& value) {
+	return _mm_loadu_ps(&value.x);
+}
+
+// The packet, unpacked into SSE registers along with it's inverse directions
+struct PacketSSE {
+	__m128 Ox, Oy, Oz;
+	__m128 Dx, Dy, Dz;
+	__m128 Ix, Iy, Iz;
+};
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 SafeInverse(__m128 value) {
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 sign = _mm_and_ps(value, signMask);
+	__m128 magnitude = _mm_max_ps(_mm_andnot_ps(signMask, value), _mm_set1_ps(1e-12f));
+	return _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(magnitude, sign));
+}
+
+static inline float HorizontalMin(__m128 value) {
+	value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+	value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(value);
+}
+
+static inline float HorizontalMax(__m128 value) {
+	value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+	value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(value);
+}
+
+// Gets the distance along a ray to a box, or FLT_MAX if the ray misses it. The origin and inverse direction hold
+// x, y, z in the first 3 lanes and 0 in the 4th, and the box bounds are loaded straight out of the node
+static inline float RayBoxDistance(__m128 origin, __m128 invDir, float tMax, const glm::vec3& min, const glm::vec3& max) {
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(LoadVec3Unsafe(min), xyzMask), origin), invDir);
+	__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(LoadVec3Unsafe(max), xyzMask), origin), invDir);
+	// The 4th lane comes out as 0, which clamps the near distance for us, but the far distance needs tMax there
+	__m128 tLow = _mm_min_ps(t1, t2);
+	__m128 tHigh = Select(xyzMask, _mm_max_ps(t1, t2), _mm_set1_ps(tMax));
+	float tNear = HorizontalMax(tLow);
+	float tFar = HorizontalMin(tHigh);
+	return tNear <= tFar ? tNear : FLT_MAX;
+}
+
+// Tests all 4 rays against a box, returning a mask of the lanes that hit it, and the distances to the box
+static inline __m128 PacketBoxTest(const PacketSSE& rays, __m128 tMax, const glm::vec3& min, const glm::vec3& max, __m128& tNear) {
+	__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min.x), rays.Ox), rays.Ix);
+	__m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max.x), rays.Ox), rays.Ix);
+	__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min.y), rays.Oy), rays.Iy);
+	__m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max.y), rays.Oy), rays.Iy);
+	__m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min.z), rays.Oz), rays.Iz);
+	__m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max.z), rays.Oz), rays.Iz);
+
+	__m128 tLow = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+	tLow = _mm_max_ps(tLow, _mm_max_ps(_mm_min_ps(t1z, t2z), _mm_setzero_ps()));
+	__m128 tHigh = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+	tHigh = _mm_min_ps(tHigh, _mm_min_ps(_mm_max_ps(t1z, t2z), tMax));
+
+	tNear = tLow;
+	return _mm_cmple_ps(tLow, tHigh);
+}
+
+TriangleBVH::TriangleBVH() :
+	_nodes(std::vector<Node>()),
+	_blocks(std::vector<TriangleBlock>()),
+	_triangleCount(0)
+{ }
+
+void TriangleBVH::Build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+	_nodes.clear();
+	_blocks.clear();
+	_triangleCount = 0;
+
+	size_t triCount = indices.empty() ? positions.size() / 3 : indices.size() / 3;
+	if (triCount == 0) {
+		return;
+	}
+	LOG_ASSERT(triCount < NO_HIT, "Too many triangles for a single BVH!");
+
+	auto getVertex = [&](size_t tri, int corner) -> const glm::vec3& {
+		return indices.empty() ? positions[tri * 3 + corner] : positions[indices[tri * 3 + corner]];
+	};
+
+	// Everything we split on is based on the triangle bounds and centroids, so calculate those up front
+	std::vector<BuildBounds> triBounds(triCount);
+	std::vector<glm::vec3> centroids(triCount);
+	std::vector<uint32_t> order(triCount);
+	for (size_t ix = 0; ix < triCount; ix++) {
+		triBounds[ix].Grow(getVertex(ix, 0));
+		triBounds[ix].Grow(getVertex(ix, 1));
+		triBounds[ix].Grow(getVertex(ix, 2));
+		centroids[ix] = (triBounds[ix].Min + triBounds[ix].Max) * 0.5f;
+		order[ix] = static_cast<uint32_t>(ix);
+	}
+
+	// A binary tree with single triangle leaves has 2N-1 nodes, so we'll never need more than that
+	_nodes.reserve(triCount * 2);
+	_nodes.emplace_back();
+
+	struct BuildTask {
+		uint32_t Node;
+		uint32_t First;
+		uint32_t Count;
+		uint32_t Depth;
+	};
+	std::vector<BuildTask> tasks;
+	tasks.push_back({ 0, 0, static_cast<uint32_t>(triCount), 0 });
+
+	while (!tasks.empty()) {
+		BuildTask task = tasks.back();
+		tasks.pop_back();
+
+		BuildBounds bounds, centroidBounds;
+		for (uint32_t ix = task.First; ix < task.First + task.Count; ix++) {
+			bounds.Grow(triBounds[order[ix]]);
+			centroidBounds.Grow(centroids[order[ix]]);
+		}
+		_nodes[task.Node].Min = bounds.Min;
+		_nodes[task.Node].Max = bounds.Max;
+
+		if (task.Count <= MAX_LEAF_SIZE || task.Depth + 1 >= MAX_DEPTH) {
+			_nodes[task.Node].LeftFirst = task.First;
+			_nodes[task.Node].Count = task.Count;
+			continue;
+		}
+
+		// Bin the centroids along each axis, and find the split with the lowest surface area heuristic cost
+		glm::vec3 extent = centroidBounds.Max - centroidBounds.Min;
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+		for (int axis = 0; axis < 3; axis++) {
+			if (extent[axis] <= 1e-12f) {
+				continue;
+			}
+			BuildBounds bins[SAH_BINS];
+			uint32_t counts[SAH_BINS] = { 0 };
+			float scale = SAH_BINS / extent[axis];
+			for (uint32_t ix = task.First; ix < task.First + task.Count; ix++) {
+				uint32_t tri = order[ix];
+				uint32_t bin = std::min(static_cast<uint32_t>((centroids[tri][axis] - centroidBounds.Min[axis]) * scale), SAH_BINS - 1);
+				counts[bin]++;
+				bins[bin].Grow(triBounds[tri]);
+			}
+
+			// Sweep from the left to get the cost of everything on the left of each plane, then sweep from the right
+			float leftArea[SAH_BINS - 1];
+			uint32_t leftCount[SAH_BINS - 1];
+			BuildBounds sweep;
+			uint32_t count = 0;
+			for (uint32_t ix = 0; ix < SAH_BINS - 1; ix++) {
+				sweep.Grow(bins[ix]);
+				count += counts[ix];
+				leftArea[ix] = sweep.Area();
+				leftCount[ix] = count;
+			}
+			sweep = BuildBounds();
+			count = 0;
+			for (uint32_t ix = SAH_BINS - 1; ix > 0; ix--) {
+				sweep.Grow(bins[ix]);
+				count += counts[ix];
+				if (leftCount[ix - 1] == 0 || count == 0) {
+					continue;
+				}
+				float cost = leftCount[ix - 1] * leftArea[ix - 1] + count * sweep.Area();
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = ix;
+				}
+			}
+		}
+
+		uint32_t mid = task.First + task.Count / 2;
+		if (bestAxis >= 0) {
+			float scale = SAH_BINS / extent[bestAxis];
+			auto it = std::partition(order.begin() + task.First, order.begin() + task.First + task.Count, [&](uint32_t tri) {
+				uint32_t bin = std::min(static_cast<uint32_t>((centroids[tri][bestAxis] - centroidBounds.Min[bestAxis]) * scale), SAH_BINS - 1);
+				return bin < bestSplit;
+			});
+			mid = static_cast<uint32_t>(it - order.begin());
+		}
+		// If all our centroids are in the same spot, we can't do any better than splitting the range in half
+		if (mid == task.First || mid == task.First + task.Count) {
+			mid = task.First + task.Count / 2;
+		}
+
+		uint32_t left = static_cast<uint32_t>(_nodes.size());
+		_nodes.emplace_back();
+		_nodes.emplace_back();
+		_nodes[task.Node].LeftFirst = left;
+		_nodes[task.Node].Count = 0;
+
+		tasks.push_back({ left + 1, mid, task.First + task.Count - mid, task.Depth + 1 });
+		tasks.push_back({ left, task.First, mid - task.First, task.Depth + 1 });
+	}
+
+	// Pack each leaf's triangles into blocks, leaves only go over MAX_LEAF_SIZE if we hit the depth limit
+	_blocks.reserve((triCount + MAX_LEAF_SIZE - 1) / MAX_LEAF_SIZE * 2);
+	for (Node& node : _nodes) {
+		if (node.Count == 0) {
+			continue;
+		}
+		const uint32_t first = node.LeftFirst;
+		node.LeftFirst = static_cast<uint32_t>(_blocks.size());
+		for (uint32_t offset = 0; offset < node.Count; offset += 4) {
+			TriangleBlock block = TriangleBlock();
+			for (int lane = 0; lane < 4; lane++) {
+				block.Index[lane] = NO_HIT;
+			}
+			for (uint32_t lane = 0; lane < 4 && offset + lane < node.Count; lane++) {
+				uint32_t tri = order[first + offset + lane];
+				const glm::vec3& a = getVertex(tri, 0);
+				glm::vec3 edge1 = getVertex(tri, 1) - a;
+				glm::vec3 edge2 = getVertex(tri, 2) - a;
+				block.V0X[lane] = a.x;        block.V0Y[lane] = a.y;        block.V0Z[lane] = a.z;
+				block.Edge1X[lane] = edge1.x; block.Edge1Y[lane] = edge1.y; block.Edge1Z[lane] = edge1.z;
+				block.Edge2X[lane] = edge2.x; block.Edge2Y[lane] = edge2.y; block.Edge2Z[lane] = edge2.z;
+				block.Index[lane] = tri;
+			}
+			_blocks.push_back(block);
+		}
+	}
+	_triangleCount = triCount;
+}
+
+bool TriangleBVH::Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const {
+	return __Intersect<false>(origin, dir, tMax, hit);
+}
+
+bool TriangleBVH::Occluded(const glm::vec3& origin, const glm::vec3& dir, float tMax) const {
+	RayHit hit;
+	return __Intersect<true>(origin, dir, tMax, hit);
+}
+
+int TriangleBVH::IntersectPacket(const RayPacket4& packet, PacketHit4& hit) const {
+	return __IntersectPacket<false>(packet, hit);
+}
+
+int TriangleBVH::OccludedPacket(const RayPacket4& packet) const {
+	PacketHit4 hit;
+	return __IntersectPacket<true>(packet, hit);
+}
+
+template <bool ANY_HIT>
+bool TriangleBVH::__Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const {
+	hit.T = tMax;
+	hit.Triangle = NO_HIT;
+	hit.U = hit.V = 0.0f;
+	const __m128 originXYZ = _mm_setr_ps(origin.x, origin.y, origin.z, 0.0f);
+	const __m128 invDirXYZ = _mm_setr_ps(SafeInverse(dir.x), SafeInverse(dir.y), SafeInverse(dir.z), 0.0f);
+	if (_nodes.empty() || RayBoxDistance(originXYZ, invDirXYZ, tMax, _nodes[0].Min, _nodes[0].Max) == FLT_MAX) {
+		return false;
+	}
+
+	// Leaves test the ray against 4 triangles at a time, so we keep the ray broadcast across all 4 lanes
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	uint32_t stack[MAX_DEPTH + 1];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = _nodes[stack[--stackSize]];
+
+		if (node.Count > 0) {
+			const uint32_t blockCount = (node.Count + 3) / 4;
+			for (uint32_t ix = node.LeftFirst; ix < node.LeftFirst + blockCount; ix++) {
+				// Moller-Trumbore for one ray against 4 triangles, double sided
+				const TriangleBlock& block = _blocks[ix];
+				__m128 e1x = _mm_load_ps(block.Edge1X), e1y = _mm_load_ps(block.Edge1Y), e1z = _mm_load_ps(block.Edge1Z);
+				__m128 e2x = _mm_load_ps(block.Edge2X), e2y = _mm_load_ps(block.Edge2Y), e2z = _mm_load_ps(block.Edge2Z);
+
+				__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+				__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+				__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+				__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+				__m128 invDet = _mm_div_ps(one, det);
+
+				__m128 tx = _mm_sub_ps(ox, _mm_load_ps(block.V0X));
+				__m128 ty = _mm_sub_ps(oy, _mm_load_ps(block.V0Y));
+				__m128 tz = _mm_sub_ps(oz, _mm_load_ps(block.V0Z));
+				__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+
+				__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+				__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+				__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+				__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+				// Padding lanes have zero length edges, so the determinant test rejects them
+				__m128 mask = _mm_cmpgt_ps(_mm_and_ps(det, absMask), _mm_set1_ps(DET_EPSILON));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+				mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+				mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(RAY_EPSILON)));
+				mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(hit.T)));
+				if (_mm_movemask_ps(mask) == 0) {
+					continue;
+				}
+				if (ANY_HIT) {
+					return true;
+				}
+
+				// Find which of the lanes that hit is closest
+				__m128 candidates = Select(mask, t, _mm_set1_ps(FLT_MAX));
+				float closest = HorizontalMin(candidates);
+				int lanes = _mm_movemask_ps(_mm_cmpeq_ps(candidates, _mm_set1_ps(closest)));
+				int lane = 0;
+				while ((lanes & (1 << lane)) == 0) lane++;
+
+				alignas(16) float us[4], vs[4];
+				_mm_store_ps(us, u);
+				_mm_store_ps(vs, v);
+				hit.T = closest;
+				hit.Triangle = block.Index[lane];
+				hit.U = us[lane];
+				hit.V = vs[lane];
+			}
+		} else {
+			uint32_t nearChild = node.LeftFirst, farChild = node.LeftFirst + 1;
+			float nearDist = RayBoxDistance(originXYZ, invDirXYZ, hit.T, _nodes[nearChild].Min, _nodes[nearChild].Max);
+			float farDist = RayBoxDistance(originXYZ, invDirXYZ, hit.T, _nodes[farChild].Min, _nodes[farChild].Max);
+			// Visit the closer child first, so it's hits can cull the further one
+			if (nearDist > farDist) {
+				std::swap(nearChild, farChild);
+				std::swap(nearDist, farDist);
+			}
+			if (farDist != FLT_MAX) stack[stackSize++] = farChild;
+			if (nearDist != FLT_MAX) stack[stackSize++] = nearChild;
+		}
+	}
+	return hit.Triangle != NO_HIT;
+}
+
+template <bool ANY_HIT>
+int TriangleBVH::__IntersectPacket(const RayPacket4& packet, PacketHit4& hit) const {
+	PacketSSE rays;
+	rays.Ox = _mm_load_ps(packet.OriginX);
+	rays.Oy = _mm_load_ps(packet.OriginY);
+	rays.Oz = _mm_load_ps(packet.OriginZ);
+	rays.Dx = _mm_load_ps(packet.DirX);
+	rays.Dy = _mm_load_ps(packet.DirY);
+	rays.Dz = _mm_load_ps(packet.DirZ);
+	rays.Ix = SafeInverse(rays.Dx);
+	rays.Iy = SafeInverse(rays.Dy);
+	rays.Iz = SafeInverse(rays.Dz);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	__m128 tMax = _mm_load_ps(packet.TMax);
+	__m128 active = _mm_cmpgt_ps(tMax, zero);
+	__m128 hitMask = zero;
+	__m128 bestU = zero, bestV = zero;
+	__m128 bestTri = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	uint32_t stack[MAX_DEPTH + 1];
+	uint32_t stackSize = 0;
+	if (!_nodes.empty() && _mm_movemask_ps(active) != 0) {
+		stack[stackSize++] = 0;
+	}
+
+	// Any hit traversals retire lanes as they hit, so we can stop as soon as every lane is done
+	while (stackSize > 0 && _mm_movemask_ps(active) != 0) {
+		const Node& node = _nodes[stack[--stackSize]];
+
+		if (node.Count > 0) {
+			for (uint32_t ix = 0; ix < node.Count; ix++) {
+				// Moller-Trumbore for one triangle against all 4 rays
+				const TriangleBlock& block = _blocks[node.LeftFirst + ix / 4];
+				const uint32_t lane = ix % 4;
+				__m128 e1x = _mm_set1_ps(block.Edge1X[lane]), e1y = _mm_set1_ps(block.Edge1Y[lane]), e1z = _mm_set1_ps(block.Edge1Z[lane]);
+				__m128 e2x = _mm_set1_ps(block.Edge2X[lane]), e2y = _mm_set1_ps(block.Edge2Y[lane]), e2z = _mm_set1_ps(block.Edge2Z[lane]);
+
+				__m128 px = _mm_sub_ps(_mm_mul_ps(rays.Dy, e2z), _mm_mul_ps(rays.Dz, e2y));
+				__m128 py = _mm_sub_ps(_mm_mul_ps(rays.Dz, e2x), _mm_mul_ps(rays.Dx, e2z));
+				__m128 pz = _mm_sub_ps(_mm_mul_ps(rays.Dx, e2y), _mm_mul_ps(rays.Dy, e2x));
+				__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+				__m128 invDet = _mm_div_ps(one, det);
+
+				__m128 tx = _mm_sub_ps(rays.Ox, _mm_set1_ps(block.V0X[lane]));
+				__m128 ty = _mm_sub_ps(rays.Oy, _mm_set1_ps(block.V0Y[lane]));
+				__m128 tz = _mm_sub_ps(rays.Oz, _mm_set1_ps(block.V0Z[lane]));
+				__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+
+				__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+				__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+				__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rays.Dx, qx), _mm_mul_ps(rays.Dy, qy)), _mm_mul_ps(rays.Dz, qz)), invDet);
+				__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+				__m128 mask = _mm_and_ps(active, _mm_cmpgt_ps(_mm_and_ps(det, absMask), _mm_set1_ps(DET_EPSILON)));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+				mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+				mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(RAY_EPSILON)));
+				mask = _mm_and_ps(mask, _mm_cmplt_ps(t, tMax));
+				if (_mm_movemask_ps(mask) == 0) {
+					continue;
+				}
+
+				tMax = Select(mask, t, tMax);
+				bestU = Select(mask, u, bestU);
+				bestV = Select(mask, v, bestV);
+				bestTri = Select(mask, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(block.Index[lane]))), bestTri);
+				hitMask = _mm_or_ps(hitMask, mask);
+				if (ANY_HIT) {
+					active = _mm_andnot_ps(mask, active);
+				}
+			}
+		} else {
+			uint32_t nearChild = node.LeftFirst, farChild = node.LeftFirst + 1;
+			__m128 nearT, farT;
+			__m128 nearMask = _mm_and_ps(active, PacketBoxTest(rays, tMax, _nodes[nearChild].Min, _nodes[nearChild].Max, nearT));
+			__m128 farMask = _mm_and_ps(active, PacketBoxTest(rays, tMax, _nodes[farChild].Min, _nodes[farChild].Max, farT));
+			bool hitNear = _mm_movemask_ps(nearMask) != 0;
+			bool hitFar = _mm_movemask_ps(farMask) != 0;
+
+			// Order the children by the closest distance any of our rays has to them
+			if (hitNear && hitFar) {
+				const __m128 inf = _mm_set1_ps(FLT_MAX);
+				if (HorizontalMin(Select(nearMask, nearT, inf)) > HorizontalMin(Select(farMask, farT, inf))) {
+					std::swap(nearChild, farChild);
+				}
+			} else if (hitFar) {
+				std::swap(nearChild, farChild);
+				std::swap(hitNear, hitFar);
+			}
+			if (hitFar) stack[stackSize++] = farChild;
+			if (hitNear) stack[stackSize++] = nearChild;
+		}
+	}
+
+	_mm_store_ps(hit.T, tMax);
+	_mm_store_ps(hit.U, bestU);
+	_mm_store_ps(hit.V, bestV);
+	_mm_store_si128(reinterpret_cast<__m128i*>(hit.Triangle), _mm_castps_si128(bestTri));
+	return _mm_movemask_ps(hitMask);
+}
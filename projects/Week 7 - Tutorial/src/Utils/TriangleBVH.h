@@ -0,0 +1,160 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// The closest hit along a single ray
+/// </summary>
+struct RayHit {
+	// The distance along the ray to the hit
+	float    T;
+	// The index of the triangle that was hit, as it was passed to Build, or TriangleBVH::NO_HIT
+	uint32_t Triangle;
+	// The barycentric coordinates of the hit, weighting the triangle's second and third vertices
+	float    U, V;
+};
+
+/// <summary>
+/// A group of 4 rays that are traced together using SSE. Lanes with a TMax of zero or less are inactive
+/// </summary>
+struct alignas(16) RayPacket4 {
+	float OriginX[4], OriginY[4], OriginZ[4];
+	float DirX[4], DirY[4], DirZ[4];
+	float TMax[4];
+
+	/// <summary>
+	/// Sets up a single lane of the packet
+	/// </summary>
+	void Set(int lane, const glm::vec3& origin, const glm::vec3& dir, float tMax) {
+		OriginX[lane] = origin.x; OriginY[lane] = origin.y; OriginZ[lane] = origin.z;
+		DirX[lane] = dir.x; DirY[lane] = dir.y; DirZ[lane] = dir.z;
+		TMax[lane] = tMax;
+	}
+};
+
+/// <summary>
+/// The closest hits for each lane of a ray packet
+/// </summary>
+struct alignas(16) PacketHit4 {
+	float    T[4];
+	uint32_t Triangle[4];
+	float    U[4];
+	float    V[4];
+};
+
+/// <summary>
+/// A bounding volume hierarchy over a triangle soup, for tracing rays against static geometry on the CPU.
+/// The tree is built with the surface area heuristic using binned centroids, and stored as a flat array of nodes
+/// with up to MAX_LEAF_SIZE triangles per leaf. Each leaf's triangles are packed into a single block, so a lone
+/// ray can test the whole leaf at once with SSE. Rays can be traced one at a time, or as packets of 4
+/// </summary>
+class TriangleBVH final
+{
+public:
+	typedef std::shared_ptr<TriangleBVH> Sptr;
+
+	static inline Sptr Create() {
+		return std::make_shared<TriangleBVH>();
+	}
+
+	// The triangle index we return when a ray doesn't hit anything
+	static constexpr uint32_t NO_HIT = ~0u;
+	// The most triangles we will store in a single leaf, this matches the width of our triangle blocks
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+	// The number of bins we use along each axis when evaluating split candidates
+	static constexpr uint32_t SAH_BINS = 12;
+
+	// We'll disallow moving and copying, the tree can get pretty large
+	TriangleBVH(const TriangleBVH& other) = delete;
+	TriangleBVH(TriangleBVH&& other) = delete;
+	TriangleBVH& operator=(const TriangleBVH& other) = delete;
+	TriangleBVH& operator=(TriangleBVH&& other) = delete;
+
+public:
+	TriangleBVH();
+	~TriangleBVH() = default;
+
+	/// <summary>
+	/// Builds the tree over the given triangles, replacing any existing contents
+	/// </summary>
+	/// <param name="positions">The vertex positions</param>
+	/// <param name="indices">3 indices per triangle into positions, or empty if every 3 positions make a triangle</param>
+	void Build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices = std::vector<uint32_t>());
+
+	/// <summary>
+	/// Finds the closest hit along a ray. Triangles are double sided
+	/// </summary>
+	/// <param name="origin">The origin of the ray</param>
+	/// <param name="dir">The direction of the ray, does not need to be normalized</param>
+	/// <param name="tMax">The furthest distance along the ray to consider, in multiples of dir</param>
+	/// <param name="hit">Receives the closest hit, if any</param>
+	/// <returns>True if the ray hit something, false if otherwise</returns>
+	bool Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const;
+	/// <summary>
+	/// Checks if a ray hits anything at all before tMax, which is cheaper than finding the closest hit
+	/// </summary>
+	bool Occluded(const glm::vec3& origin, const glm::vec3& dir, float tMax) const;
+
+	/// <summary>
+	/// Finds the closest hit for each active ray in a packet. Rays in a packet should be roughly
+	/// coherent (ex: starting from the same point), since a node is visited if any ray hits it
+	/// </summary>
+	/// <param name="packet">The rays to trace</param>
+	/// <param name="hit">Receives the hits, lanes that missed or were inactive will have a triangle of NO_HIT</param>
+	/// <returns>A bitmask of the lanes that hit something</returns>
+	int IntersectPacket(const RayPacket4& packet, PacketHit4& hit) const;
+	/// <summary>
+	/// Checks which rays in a packet hit anything before their TMax
+	/// </summary>
+	/// <returns>A bitmask of the lanes that are occluded</returns>
+	int OccludedPacket(const RayPacket4& packet) const;
+
+	size_t GetTriangleCount() const { return _triangleCount; }
+	size_t GetNodeCount() const { return _nodes.size(); }
+	/// <summary>
+	/// Gets the number of bytes used by the nodes and triangles of the tree
+	/// </summary>
+	size_t GetMemoryUsage() const { return _nodes.size() * sizeof(Node) + _blocks.size() * sizeof(TriangleBlock); }
+	/// <summary>
+	/// Gets the bounds of everything in the tree, only valid if the tree is not empty
+	/// </summary>
+	glm::vec3 GetMin() const { return _nodes.empty() ? glm::vec3(0.0f) : _nodes[0].Min; }
+	glm::vec3 GetMax() const { return _nodes.empty() ? glm::vec3(0.0f) : _nodes[0].Max; }
+
+protected:
+	// A single node in the tree, either an interior node with 2 children, or a leaf with some triangles
+	struct Node {
+		glm::vec3 Min;
+		// For interior nodes, the index of the left child (the right child is right after it).
+		// For leaves, the index of the first triangle block
+		uint32_t  LeftFirst;
+		glm::vec3 Max;
+		// The number of triangles in the leaf, or 0 for interior nodes
+		uint32_t  Count;
+	};
+
+	// We store triangles in the form Moller-Trumbore wants them, in groups of 4 split up by component so they
+	// can be loaded straight into SSE registers. Leaves own a contiguous range of blocks, and any lanes the leaf
+	// doesn't fill are left as degenerate triangles that can never be hit
+	struct alignas(16) TriangleBlock {
+		float    V0X[4], V0Y[4], V0Z[4];
+		float    Edge1X[4], Edge1Y[4], Edge1Z[4];
+		float    Edge2X[4], Edge2Y[4], Edge2Z[4];
+		uint32_t Index[4];
+	};
+
+	std::vector<Node>          _nodes;
+	std::vector<TriangleBlock> _blocks;
+	size_t                     _triangleCount;
+
+	// The deepest the tree can get before we start forcing leaves, keeps our traversal stacks a fixed size
+	static constexpr uint32_t MAX_DEPTH = 64;
+
+	// Closest hit and any hit traversals only differ in when they stop, so they share an implementation
+	template <bool ANY_HIT>
+	bool __Intersect(const glm::vec3& origin, const glm::vec3& dir, float tMax, RayHit& hit) const;
+	template <bool ANY_HIT>
+	int __IntersectPacket(const RayPacket4& packet, PacketHit4& hit) const;
+};
@@ -0,0 +1,125 @@
+#include "VertexWelder.h"
+#include "Utils/ParallelFor.h"
+
+#include <cstring>
+#include <unordered_set>
+
+// Below this many vertices, spinning up threads costs more than it saves
+static const size_t MIN_PARALLEL_VERTICES = 32 * 1024;
+// The number of vertices a thread hashes at a time
+static const size_t HASH_BATCH = 4096;
+
+static_assert(sizeof(VertexPosNormTexCol) % sizeof(uint32_t) == 0, "VertexPosNormTexCol must be made of 32 bit fields to be hashed");
+
+static inline uint64_t HashVertex(const VertexPosNormTexCol& vertex) {
+	uint32_t words[sizeof(VertexPosNormTexCol) / sizeof(uint32_t)];
+	memcpy(words, &vertex, sizeof(words));
+	uint64_t hash = 0;
+	for (uint32_t word : words) {
+		hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+	}
+	// Finish with a full avalanche, since we use the top bits to pick a partition
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// Lets a set of vertex indices use our pre-computed hashes, and compare the vertices they point to
+struct WeldIndexHash {
+	const uint64_t* Hashes;
+	size_t operator()(uint32_t index) const { return static_cast<size_t>(Hashes[index]); }
+};
+struct WeldIndexEqual {
+	const VertexPosNormTexCol* Vertices;
+	bool operator()(uint32_t a, uint32_t b) const { return memcmp(&Vertices[a], &Vertices[b], sizeof(VertexPosNormTexCol)) == 0; }
+};
+
+void VertexWelder::Weld(const VertexPosNormTexCol* vertices, size_t count, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outRemap, uint32_t numThreads) {
+	outVertices.clear();
+	outRemap.resize(count);
+	if (count == 0) {
+		return;
+	}
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	if (count < MIN_PARALLEL_VERTICES) {
+		numThreads = 1;
+	}
+
+	std::vector<uint64_t> hashes(count);
+	ParallelFor(count, HASH_BATCH, numThreads, [&](size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) {
+			hashes[ix] = HashVertex(vertices[ix]);
+		}
+	});
+
+	// Identical vertices always share a partition, so each partition can be welded without any locking. We use
+	// a few partitions per thread so that an unlucky partition doesn't hold everyone else up
+	uint32_t partitionBits = 0;
+	while ((1u << partitionBits) < numThreads * 4) {
+		partitionBits++;
+	}
+	const uint32_t numPartitions = 1u << partitionBits;
+	auto partitionOf = [&](size_t index) {
+		return partitionBits == 0 ? 0u : static_cast<uint32_t>(hashes[index] >> (64 - partitionBits));
+	};
+
+	// Bucket the vertices by partition, each thread counts and then scatters a contiguous chunk, so vertices
+	// stay in their original order within a partition
+	const size_t chunkSize = (count + numThreads - 1) / numThreads;
+	std::vector<size_t> offsets(static_cast<size_t>(numThreads) * numPartitions, 0);
+	ParallelFor(numThreads, 1, numThreads, [&](size_t begin, size_t end) {
+		for (size_t chunk = begin; chunk < end; chunk++) {
+			size_t* counts = &offsets[chunk * numPartitions];
+			for (size_t ix = chunk * chunkSize; ix < std::min((chunk + 1) * chunkSize, count); ix++) {
+				counts[partitionOf(ix)]++;
+			}
+		}
+	});
+	std::vector<size_t> partitionStart(numPartitions + 1);
+	size_t running = 0;
+	for (uint32_t partition = 0; partition < numPartitions; partition++) {
+		partitionStart[partition] = running;
+		for (uint32_t chunk = 0; chunk < numThreads; chunk++) {
+			size_t chunkCount = offsets[chunk * numPartitions + partition];
+			offsets[chunk * numPartitions + partition] = running;
+			running += chunkCount;
+		}
+	}
+	partitionStart[numPartitions] = running;
+
+	std::vector<uint32_t> order(count);
+	ParallelFor(numThreads, 1, numThreads, [&](size_t begin, size_t end) {
+		for (size_t chunk = begin; chunk < end; chunk++) {
+			size_t* next = &offsets[chunk * numPartitions];
+			for (size_t ix = chunk * chunkSize; ix < std::min((chunk + 1) * chunkSize, count); ix++) {
+				order[next[partitionOf(ix)]++] = static_cast<uint32_t>(ix);
+			}
+		}
+	});
+
+	// Weld each partition, every vertex is pointed at the first vertex that matches it
+	ParallelFor(numPartitions, 1, numThreads, [&](size_t begin, size_t end) {
+		for (size_t partition = begin; partition < end; partition++) {
+			size_t first = partitionStart[partition], last = partitionStart[partition + 1];
+			std::unordered_set<uint32_t, WeldIndexHash, WeldIndexEqual> unique(last - first, WeldIndexHash{ hashes.data() }, WeldIndexEqual{ vertices });
+			for (size_t ix = first; ix < last; ix++) {
+				outRemap[order[ix]] = *unique.insert(order[ix]).first;
+			}
+		}
+	});
+
+	// Compact the unique vertices. A vertex's match always comes before it, so it's new index is already known
+	for (size_t ix = 0; ix < count; ix++) {
+		if (outRemap[ix] == ix) {
+			outRemap[ix] = static_cast<uint32_t>(outVertices.size());
+			outVertices.push_back(vertices[ix]);
+		} else {
+			outRemap[ix] = outRemap[outRemap[ix]];
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// Helper class for turning a triangle soup into an indexed mesh, by merging vertices that are bit for bit
+/// identical. Vertices are hashed and split into partitions by hash, and the partitions are welded on separate
+/// threads, so large scans and CAD exports don't take a single core's worth of time to load
+/// </summary>
+class VertexWelder
+{
+public:
+	/// <summary>
+	/// Merges identical vertices. Every unique vertex is kept in the order it first appears
+	/// </summary>
+	/// <param name="vertices">The vertices to weld</param>
+	/// <param name="count">The number of vertices</param>
+	/// <param name="outVertices">Receives the unique vertices</param>
+	/// <param name="outRemap">Receives the index into outVertices for every input vertex, for a triangle soup these are the mesh's indices</param>
+	/// <param name="numThreads">The number of threads to use, or 0 to use one per hardware thread</param>
+	static void Weld(const VertexPosNormTexCol* vertices, size_t count, std::vector<VertexPosNormTexCol>& outVertices, std::vector<uint32_t>& outRemap, uint32_t numThreads = 0);
+
+protected:
+	VertexWelder() = default;
+	~VertexWelder() = default;
+};
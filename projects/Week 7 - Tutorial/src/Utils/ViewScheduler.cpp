@@ -0,0 +1,88 @@
+#include "ViewScheduler.h"
+#include <algorithm>
+#include <imgui.h>
+
+ViewScheduler::ViewScheduler(float budgetMs) :
+	_views(std::vector<SecondaryView::Sptr>()),
+	_budgetMs(budgetMs),
+	_lastFrameCostMs(0.0f),
+	_lastRenderedCount(0)
+{ }
+
+void ViewScheduler::AddView(const SecondaryView::Sptr& view) {
+	if (std::find(_views.begin(), _views.end(), view) == _views.end()) {
+		_views.push_back(view);
+	}
+}
+
+void ViewScheduler::RemoveView(const SecondaryView::Sptr& view) {
+	auto it = std::find(_views.begin(), _views.end(), view);
+	if (it != _views.end()) {
+		_views.erase(it);
+	}
+}
+
+uint32_t ViewScheduler::Update(double time, const SecondaryView::RenderFunc& render, const glm::ivec2& windowSize) {
+	// Pick up any timings that have come back from the GPU since last frame
+	for (const SecondaryView::Sptr& view : _views) {
+		view->PollTiming();
+	}
+
+	// Gather up the views that are due, most overdue first
+	std::vector<std::pair<float, SecondaryView*>> due;
+	for (const SecondaryView::Sptr& view : _views) {
+		if (!view->IsEnabled()) continue;
+		float urgency = view->GetUrgency(time);
+		if (urgency >= 1.0f) {
+			due.emplace_back(urgency, view.get());
+		}
+	}
+	std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	float spentMs = 0.0f;
+	uint32_t rendered = 0;
+	for (const auto& [urgency, view] : due) {
+		// Anything that doesn't fit this frame will be even more overdue next frame, so it'll get a turn
+		float costMs = view->GetEstimatedCostMs();
+		if (rendered > 0 && spentMs + costMs > _budgetMs) {
+			continue;
+		}
+		view->Render(render, time);
+		spentMs += costMs;
+		rendered++;
+	}
+
+	if (rendered > 0) {
+		Framebuffer::Unbind();
+		glViewport(0, 0, windowSize.x, windowSize.y);
+	}
+	_lastFrameCostMs = spentMs;
+	_lastRenderedCount = rendered;
+	return rendered;
+}
+
+void ViewScheduler::DrawImGui() {
+	ImGui::DragFloat("View budget (ms)", &_budgetMs, 0.05f, 0.0f, 33.0f);
+	ImGui::Text("Rendered %d views this frame, ~%.2f ms", (int)_lastRenderedCount, _lastFrameCostMs);
+	for (const SecondaryView::Sptr& view : _views) {
+		ImGui::PushID(view.get());
+		if (ImGui::CollapsingHeader(view->Name.c_str())) {
+			bool isEnabled = view->IsEnabled();
+			if (ImGui::Checkbox("Enabled", &isEnabled)) {
+				view->SetEnabled(isEnabled);
+			}
+			float scale = view->GetResolutionScale();
+			if (ImGui::SliderFloat("Resolution", &scale, 0.05f, 1.0f)) {
+				view->SetResolutionScale(scale);
+			}
+			float interval = view->GetUpdateInterval();
+			if (ImGui::DragFloat("Interval (s)", &interval, 0.01f, 0.0f, 10.0f)) {
+				view->SetUpdateInterval(interval);
+			}
+			ImGui::Text("%dx%d, ~%.2f ms per update", (int)view->GetWidth(), (int)view->GetHeight(), view->GetEstimatedCostMs());
+			// OpenGL textures are bottom up, so flip the V coordinates
+			ImGui::Image((ImTextureID)(intptr_t)view->GetTexture()->GetHandle(), ImVec2(128.0f, 128.0f * view->GetHeight() / view->GetWidth()), ImVec2(0, 1), ImVec2(1, 0));
+		}
+		ImGui::PopID();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "Graphics/SecondaryView.h"
+
+/// <summary>
+/// Spreads the updates for secondary views across frames. Each frame, views that are due for an update are
+/// rendered in order of how overdue they are, until the estimated GPU cost for the frame hits our budget.
+/// The most overdue view is always rendered, so that a single expensive view can't be starved forever
+/// </summary>
+class ViewScheduler final
+{
+public:
+	typedef std::shared_ptr<ViewScheduler> Sptr;
+
+	static inline Sptr Create(float budgetMs = 2.0f) {
+		return std::make_shared<ViewScheduler>(budgetMs);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new view scheduler
+	/// </summary>
+	/// <param name="budgetMs">The most GPU time we want to spend on secondary views each frame, in milliseconds</param>
+	ViewScheduler(float budgetMs);
+
+	/// <summary>
+	/// Adds a view to be updated by this scheduler
+	/// </summary>
+	void AddView(const SecondaryView::Sptr& view);
+	/// <summary>
+	/// Removes a view from this scheduler
+	/// </summary>
+	void RemoveView(const SecondaryView::Sptr& view);
+	const std::vector<SecondaryView::Sptr>& GetViews() const { return _views; }
+
+	void SetBudgetMs(float value) { _budgetMs = value; }
+	float GetBudgetMs() const { return _budgetMs; }
+
+	/// <summary>
+	/// Renders the views that are due this frame, within our budget. Rebinds the window and restores the viewport when done
+	/// </summary>
+	/// <param name="time">The current time, in seconds</param>
+	/// <param name="render">The function that renders the scene</param>
+	/// <param name="windowSize">The size of the window, used to restore the viewport</param>
+	/// <returns>The number of views that were rendered</returns>
+	uint32_t Update(double time, const SecondaryView::RenderFunc& render, const glm::ivec2& windowSize);
+
+	/// <summary>
+	/// Draws an ImGui widget with the budget, and the settings and preview for each view
+	/// </summary>
+	void DrawImGui();
+
+protected:
+	std::vector<SecondaryView::Sptr> _views;
+	float    _budgetMs;
+	float    _lastFrameCostMs;
+	uint32_t _lastRenderedCount;
+};
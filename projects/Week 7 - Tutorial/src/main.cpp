@@ -23,12 +23,30 @@
 #include "Graphics/Shader.h"
 #include "Graphics/Texture2D.h"
 #include "Graphics/VertexTypes.h"
+#include "Graphics/MaterialTable.h"
+#include "Graphics/Impostor.h"
+#include "Graphics/SecondaryView.h"
 
 // Utilities
 #include "Utils/MeshBuilder.h"
 #include "Utils/MeshFactory.h"
 #include "Utils/ObjLoader.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/ImpostorBaker.h"
+#include "Utils/TextureStreamer.h"
+#include "Utils/MeshStreamer.h"
+#include "Utils/ProgressiveMesh.h"
+#include "Utils/IncrementalLoader.h"
+#include "Utils/FrameLimiter.h"
+#include "Utils/FrameCapture.h"
+#include "Utils/IdleMode.h"
+#include "Utils/ViewScheduler.h"
+#include "Utils/LightmapBaker.h"
+#include "Utils/StaticBatcher.h"
+#include "Utils/ParticleDemo.h"
+#include "Utils/PointCloudDemo.h"
+#include "Utils/SimdKernelTests.h"
+#include "Utils/MeshCodecTests.h"
 
 #include "Camera.h"
 #include "Utils/ResourceManager/ResourceManager.h"
@@ -120,6 +138,12 @@ bool initGLAD() {
 ////////////////// NEW IN WEEK 7 /////////////////////
 //////////////////////////////////////////////////////
 
+// A cull mask that includes every layer
+const uint32_t ALL_LAYERS = ~0u;
+
+// How fast the camera flies around, in units per second
+const float CAMERA_SPEED = 4.0f;
+
 glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
 glm::mat3 MAT3_IDENTITY = glm::mat3(1.0f);
 
@@ -143,18 +167,24 @@ struct MaterialInfo : IResource {
 	Texture2D::Sptr Texture;
 	float           Shininess;
 
+	// The index of this material's parameters in the scene's material table, passed to draws as the base instance
+	uint32_t        TableIndex = 0;
+
+	/// <summary>
+	/// Gets the parameters for this material as they should be stored in the GPU material table
+	/// </summary>
+	MaterialParams GetParams() const {
+		MaterialParams result;
+		result.Shininess = Shininess;
+		return result;
+	}
+
 	/// <summary>
 	/// Handles applying this material's state to the OpenGL pipeline
-	/// Will bind the shader, update material uniforms, and bind textures
+	/// Material parameters live in the material table, so we only need to bind textures
 	/// </summary>
 	virtual void Apply() {
-		// Material properties
-		Shader->SetUniform("u_Material.Shininess", Shininess);
-
-		// For textures, we pass the *slot* that the texture sure draw from
-		Shader->SetUniform("u_Material.Diffuse", 0);
-
-		// Bind the texture
+		// Bind the texture, the shader samples the diffuse from slot 0
 		if (Texture != nullptr) {
 			Texture->Bind(0);
 		}
@@ -202,6 +232,20 @@ struct RenderObject {
 	VertexArrayObject::Sptr Mesh;
 	// The object's material
 	MaterialInfo::Sptr      Material;
+	// The impostor to draw instead of the mesh when the object is far away, or nullptr
+	Impostor::Sptr          Impostor;
+	// The distance from the camera past which the impostor is used, or 0 to never use an impostor
+	float                   ImpostorDistance;
+	// The radius of the mesh's bounding sphere in object space, or a negative value if it needs to be calculated
+	float                   BoundingRadius;
+	// The layer this object is on (0-31), views can choose which layers they draw
+	uint32_t                Layer;
+	// True if this object never moves, static objects get their lighting baked into the scene's lightmap
+	bool                    IsStatic;
+	// A copy of the mesh with lightmap UVs, or nullptr if the object hasn't been baked
+	VertexArrayObject::Sptr LightmapMesh;
+	// True if this object has been merged into one of the scene's static batches, and should not be drawn on it's own
+	bool                    IsBatched;
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> MeshBuilderParams;
@@ -219,6 +263,13 @@ struct RenderObject {
 		Transform(MAT4_IDENTITY),
 		Mesh(nullptr),
 		Material(nullptr),
+		Impostor(nullptr),
+		ImpostorDistance(0.0f),
+		BoundingRadius(-1.0f),
+		Layer(0),
+		IsStatic(false),
+		LightmapMesh(nullptr),
+		IsBatched(false),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Position(ZERO),
 		Rotation(ZERO),
@@ -230,17 +281,31 @@ struct RenderObject {
 		Transform = glm::translate(MAT4_IDENTITY, Position) * glm::mat4_cast(glm::quat(glm::radians(Rotation))) * glm::scale(MAT4_IDENTITY, Scale);
 	}
 
+	// Recalculates the object space bounding radius from the mesh
+	void RecalcBounds() {
+		glm::vec3 center;
+		BoundingRadius = 0.0f;
+		if (Mesh != nullptr && ImpostorBaker::CalculateBounds(Mesh, center, BoundingRadius)) {
+			// The bounds are around the center of the mesh, but we measure distance from the origin
+			BoundingRadius += glm::length(center);
+		}
+	}
+
 	// Regenerates this object's mesh if it is using the MeshFactory
 	void GenerateMesh() {
 		if (MeshBuilderParams.size() > 0) {
 			if (Mesh != nullptr) {
 				LOG_WARN("Overriding existing mesh!");
 			}
-			MeshBuilder<VertexPosNormTexCol> mesh;
+			// We know the size of everything ahead of time, so we can build straight into staging memory
+			size_t vertexCount, indexCount;
+			MeshFactory::EstimateSize(MeshBuilderParams, vertexCount, indexCount);
+			MeshBuilder<VertexPosNormTexCol> mesh(BuilderStorage::Staging, vertexCount, indexCount);
 			for (int ix = 0; ix < MeshBuilderParams.size(); ix++) {
 				MeshFactory::AddParameterized(mesh, MeshBuilderParams[ix]);
 			}
 			Mesh = mesh.Bake();
+			BoundingRadius = -1.0f;
 		}
 	}
 
@@ -257,13 +322,19 @@ struct RenderObject {
 		result.Position = ParseJsonVec3(data["position"]);
 		result.Rotation = ParseJsonVec3(data["rotation"]);
 		result.Scale = ParseJsonVec3(data["scale"]);
+		result.ImpostorDistance = JsonGet(data, "impostor_distance", 0.0f);
+		result.Layer = glm::min(JsonGet(data, "layer", 0u), 31u);
+		result.IsStatic = JsonGet(data, "static", false);
 		// If we have mesh parameters, we'll use that instead of the existing mesh
 		if (data.contains("mesh_params") && data["mesh_params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = data["mesh_params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexCol> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result.MeshBuilderParams.push_back(p);
+				result.MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
+			}
+			size_t vertexCount, indexCount;
+			MeshFactory::EstimateSize(result.MeshBuilderParams, vertexCount, indexCount);
+			MeshBuilder<VertexPosNormTexCol> mesh(BuilderStorage::Staging, vertexCount, indexCount);
+			for (const MeshBuilderParam& p : result.MeshBuilderParams) {
 				MeshFactory::AddParameterized(mesh, p);
 			}
 			result.Mesh = mesh.Bake();
@@ -283,6 +354,9 @@ struct RenderObject {
 			{ "position", GlmToJson(Position) },
 			{ "rotation", GlmToJson(Rotation) },
 			{ "scale", GlmToJson(Scale) },
+			{ "impostor_distance", ImpostorDistance },
+			{ "layer", Layer },
+			{ "static", IsStatic },
 		};
 		if (MeshBuilderParams.size() > 0) {
 			std::vector<nlohmann::json> params = std::vector<nlohmann::json>();
@@ -330,11 +404,45 @@ struct Light {
 
 };
 
+// A chunk of static objects that share a material and layer, merged into a single world space mesh
+struct StaticBatch {
+	VertexArrayObject::Sptr Mesh;
+	MaterialInfo::Sptr      Material;
+	uint32_t                Layer;
+	// World space bounds, for frustum culling
+	glm::vec3               Min;
+	glm::vec3               Max;
+};
+
+// The result of casting a ray into the scene
+struct ScenePick {
+	// The object that was hit, or nullptr if the ray missed everything
+	RenderObject* Object = nullptr;
+	// The distance along the ray to the hit, in multiples of the ray's direction
+	float         Distance = 0.0f;
+	// The world space position of the hit
+	glm::vec3     Position = glm::vec3(0.0f);
+	// The index of the triangle that was hit within the object's mesh
+	uint32_t      Triangle = TriangleBVH::NO_HIT;
+	// The barycentric coordinates of the hit, weighting the triangle's second and third vertices
+	glm::vec2     Barycentric = glm::vec2(0.0f);
+};
+
 // Temporary structure for storing all our scene stuffs
 struct Scene {
 	typedef std::shared_ptr<Scene> Sptr;
 
 	std::unordered_map<Guid, MaterialInfo::Sptr> Materials; // Really should be in resources but meh
+	// GPU resident parameters for all the materials in the scene
+	MaterialTable::Sptr        MaterialTable;
+	// All the impostors that have been baked for objects in the scene
+	std::vector<Impostor::Sptr> Impostors;
+	// The baked lighting for all static objects in the scene, or nullptr if it hasn't been baked
+	Texture2D::Sptr            Lightmap;
+	// Lets us toggle between baked and dynamic lighting for static objects
+	bool                       UseLightmap;
+	// Static objects that have been merged together to save on draw calls
+	std::vector<StaticBatch>   StaticBatches;
 
 	// Stores all the objects in our scene
 	std::vector<RenderObject>  Objects;
@@ -347,6 +455,11 @@ struct Scene {
 
 	Scene() :
 		Materials(std::unordered_map<Guid, MaterialInfo::Sptr>()),
+		MaterialTable(MaterialTable::Create()),
+		Impostors(std::vector<Impostor::Sptr>()),
+		Lightmap(nullptr),
+		UseLightmap(true),
+		StaticBatches(std::vector<StaticBatch>()),
 		Objects(std::vector<RenderObject>()),
 		Lights(std::vector<Light>()),
 		Camera(nullptr),
@@ -365,17 +478,244 @@ struct Scene {
 		return it == Objects.end() ? nullptr : &(*it);
 	}
 
+	/// <summary>
+	/// Adds a material to the scene, and allocates a slot for it's parameters in the material table
+	/// </summary>
+	/// <param name="material">The material to add</param>
+	void AddMaterial(const MaterialInfo::Sptr& material) {
+		material->TableIndex = MaterialTable->Allocate(material->GetParams());
+		Materials[material->GetGUID()] = material;
+	}
+
+	/// <summary>
+	/// Bakes impostors for all objects that have an impostor distance set. Objects that share the same
+	/// mesh and material will share an impostor, so they can be drawn in a single instanced draw
+	/// </summary>
+	/// <param name="settings">The settings to bake the impostors with</param>
+	void BakeImpostors(const ImpostorBakeSettings& settings = ImpostorBakeSettings()) {
+		ClearImpostors();
+		for (RenderObject& object : Objects) {
+			BakeImpostor(object, settings);
+		}
+	}
+
+	/// <summary>
+	/// Removes the impostors from all objects, so that they can be re-baked one at a time with BakeImpostor
+	/// </summary>
+	void ClearImpostors() {
+		Impostors.clear();
+		for (RenderObject& object : Objects) {
+			object.Impostor = nullptr;
+		}
+	}
+
+	/// <summary>
+	/// Bakes the impostor for a single object, if it has an impostor distance set. If another object with the
+	/// same mesh and material has already been baked, it's impostor is shared instead. Baking one object at a
+	/// time lets a load spread the bakes out over several frames
+	/// </summary>
+	/// <param name="object">The object to bake, should belong to this scene</param>
+	/// <param name="settings">The settings to bake the impostor with</param>
+	void BakeImpostor(RenderObject& object, const ImpostorBakeSettings& settings = ImpostorBakeSettings()) {
+		object.Impostor = nullptr;
+		if (object.ImpostorDistance <= 0.0f || object.Mesh == nullptr || object.Material == nullptr) {
+			return;
+		}
+		for (const RenderObject& other : Objects) {
+			if (other.Impostor != nullptr && other.Mesh == object.Mesh && other.Material == object.Material) {
+				object.Impostor = other.Impostor;
+				return;
+			}
+		}
+		Impostor::Sptr impostor = ImpostorBaker::Bake(object.Mesh, object.Material->Texture, settings);
+		if (impostor != nullptr) {
+			impostor->SetMaterialIndex(object.Material->TableIndex);
+			Impostors.push_back(impostor);
+		}
+		object.Impostor = impostor;
+	}
+
+	/// <summary>
+	/// Bakes the lighting for all static objects into a lightmap. Static objects will be drawn with the
+	/// lightmap instead of the dynamic lights until they are re-baked
+	/// </summary>
+	/// <param name="settings">The settings to bake the lightmap with</param>
+	void BakeLightmap(const LightmapBakeSettings& settings = LightmapBakeSettings()) {
+		std::vector<RenderObject*> bakedObjects;
+		std::vector<LightmapInstance> instances;
+		for (RenderObject& object : Objects) {
+			object.LightmapMesh = nullptr;
+			if (!object.IsStatic || object.Mesh == nullptr) {
+				continue;
+			}
+			object.RecalcTransform();
+			LightmapInstance instance;
+			instance.Mesh = object.Mesh;
+			instance.Transform = object.Transform;
+			instances.push_back(instance);
+			bakedObjects.push_back(&object);
+		}
+
+		std::vector<LightmapLight> lights;
+		for (const Light& light : Lights) {
+			lights.push_back({ light.Position, light.Color, light.Attenuation });
+		}
+
+		std::vector<VertexArrayObject::Sptr> meshes;
+		Lightmap = LightmapBaker::Bake(instances, lights, meshes, settings);
+		if (Lightmap != nullptr) {
+			for (size_t ix = 0; ix < bakedObjects.size(); ix++) {
+				bakedObjects[ix]->LightmapMesh = meshes[ix];
+			}
+		}
+		// Objects that got baked are drawn with the lightmap now, so pull them out of the batches
+		BuildStaticBatches();
+	}
+
+	/// <summary>
+	/// Merges static objects that share a material and layer into a few large world space meshes. Objects
+	/// with an impostor or a baked lightmap are left alone, since they need to be drawn on their own
+	/// </summary>
+	/// <param name="settings">The settings to build the batches with</param>
+	void BuildStaticBatches(const StaticBatchSettings& settings = StaticBatchSettings()) {
+		StaticBatches.clear();
+
+		// Each unique material and layer pair gets it's own group of batches
+		std::vector<std::pair<MaterialInfo::Sptr, uint32_t>> groups;
+		std::vector<StaticBatchInstance> instances;
+		std::vector<RenderObject*> sources;
+		for (RenderObject& object : Objects) {
+			object.IsBatched = false;
+			if (!object.IsStatic || object.Mesh == nullptr || object.Material == nullptr ||
+				object.ImpostorDistance > 0.0f || object.LightmapMesh != nullptr) {
+				continue;
+			}
+			auto key = std::make_pair(object.Material, object.Layer);
+			auto it = std::find(groups.begin(), groups.end(), key);
+			if (it == groups.end()) {
+				it = groups.insert(groups.end(), key);
+			}
+			object.RecalcTransform();
+			StaticBatchInstance instance;
+			instance.Mesh = object.Mesh;
+			instance.Transform = object.Transform;
+			instance.Group = static_cast<uint32_t>(it - groups.begin());
+			instances.push_back(instance);
+			sources.push_back(&object);
+		}
+		if (instances.empty()) {
+			return;
+		}
+
+		std::vector<bool> batched;
+		std::vector<StaticBatchChunk> chunks = StaticBatcher::Build(instances, batched, settings);
+		for (const StaticBatchChunk& chunk : chunks) {
+			StaticBatch batch;
+			batch.Mesh = chunk.Mesh;
+			batch.Material = groups[chunk.Group].first;
+			batch.Layer = groups[chunk.Group].second;
+			batch.Min = chunk.Min;
+			batch.Max = chunk.Max;
+			StaticBatches.push_back(batch);
+		}
+		for (size_t ix = 0; ix < sources.size(); ix++) {
+			sources[ix]->IsBatched = batched[ix];
+		}
+	}
+
+	/// <summary>
+	/// Finds the closest object hit by a world space ray, testing against the actual triangles of each object's mesh
+	/// </summary>
+	/// <param name="origin">The origin of the ray</param>
+	/// <param name="dir">The direction of the ray, does not need to be normalized</param>
+	/// <param name="tMax">The furthest distance along the ray to consider, in multiples of dir</param>
+	/// <param name="result">Receives the closest hit, if any</param>
+	/// <returns>True if the ray hit an object, false if otherwise</returns>
+	bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float tMax, ScenePick& result) {
+		result = ScenePick();
+		result.Distance = tMax;
+		for (RenderObject& object : Objects) {
+			if (object.Mesh == nullptr) {
+				continue;
+			}
+
+			// Skip anything whose bounding sphere the ray misses before paying for the BVH
+			if (object.BoundingRadius < 0.0f) {
+				object.RecalcBounds();
+			}
+			glm::vec3 center = object.Transform[3];
+			float maxScale = glm::max(glm::length(glm::vec3(object.Transform[0])), glm::max(glm::length(glm::vec3(object.Transform[1])), glm::length(glm::vec3(object.Transform[2]))));
+			float radius = object.BoundingRadius * maxScale;
+			glm::vec3 toCenter = center - origin;
+			float along = glm::clamp(glm::dot(toCenter, dir) / glm::max(glm::dot(dir, dir), 1e-12f), 0.0f, result.Distance);
+			if (glm::distance(origin + dir * along, center) > radius) {
+				continue;
+			}
+
+			TriangleBVH::Sptr bvh = ResourceManager::GetMeshBVH(object.Mesh);
+			if (bvh == nullptr) {
+				continue;
+			}
+
+			// Moving the ray into object space is an affine transform, so distances along it stay the same
+			glm::mat4 worldToObject = glm::inverse(object.Transform);
+			glm::vec3 localOrigin = worldToObject * glm::vec4(origin, 1.0f);
+			glm::vec3 localDir = glm::mat3(worldToObject) * dir;
+			RayHit hit;
+			if (bvh->Intersect(localOrigin, localDir, result.Distance, hit)) {
+				result.Object = &object;
+				result.Distance = hit.T;
+				result.Position = origin + dir * hit.T;
+				result.Triangle = hit.Triangle;
+				result.Barycentric = glm::vec2(hit.U, hit.V);
+			}
+		}
+		return result.Object != nullptr;
+	}
+
+	/// <summary>
+	/// Finds the closest object under the given cursor position, as seen from the scene's camera
+	/// </summary>
+	/// <param name="cursor">The cursor position in window coordinates, with the origin at the top left</param>
+	/// <param name="viewportSize">The size of the window in the same units as the cursor</param>
+	/// <param name="result">Receives the closest hit, if any</param>
+	/// <returns>True if there was an object under the cursor, false if otherwise</returns>
+	bool PickFromCursor(const glm::vec2& cursor, const glm::ivec2& viewportSize, ScenePick& result) {
+		result = ScenePick();
+		if (Camera == nullptr || viewportSize.x <= 0 || viewportSize.y <= 0) {
+			return false;
+		}
+		// Unproject the cursor onto the near and far planes, and cast a ray between them
+		glm::vec2 ndc = glm::vec2(cursor.x / viewportSize.x * 2.0f - 1.0f, 1.0f - cursor.y / viewportSize.y * 2.0f);
+		glm::mat4 inverseViewProj = glm::inverse(Camera->GetViewProjection());
+		glm::vec4 nearPoint = inverseViewProj * glm::vec4(ndc, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+		glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 dir = glm::vec3(farPoint) / farPoint.w - origin;
+		return Raycast(origin, dir, 1.0f, result);
+	}
+
+	/// <summary>
+	/// Re-uploads the parameters for the given material, should be called after a material is edited
+	/// </summary>
+	/// <param name="material">The material that was changed</param>
+	void UpdateMaterial(const MaterialInfo::Sptr& material) {
+		MaterialTable->Set(material->TableIndex, material->GetParams());
+	}
+
 	/// <summary>
 	/// Loads a scene from a JSON blob
 	/// </summary>
-	static Scene::Sptr FromJson(const nlohmann::json& data) {
+	/// <param name="data">The JSON blob to load from</param>
+	/// <param name="buildBatches">False to skip building the static batches, so the caller can build them later</param>
+	static Scene::Sptr FromJson(const nlohmann::json& data, bool buildBatches = true) {
 		Scene::Sptr result = std::make_shared<Scene>();
 		result->BaseShader = ResourceManager::GetShader(Guid(data["default_shader"]));
 
 		LOG_ASSERT(data["materials"].is_array(), "Materials not present in scene!");
 		for (auto& material : data["materials"]) {
 			MaterialInfo::Sptr mat = MaterialInfo::FromJson(material);
-			result->Materials[mat->GetGUID()] = mat;
+			result->AddMaterial(mat);
 		}
 
 		LOG_ASSERT(data["objects"].is_array(), "Objects not present in scene!");
@@ -395,6 +735,10 @@ struct Scene {
 		result->Camera->SetPosition(ParseJsonVec3(data["camera"]["position"]));
 		result->Camera->SetForward(ParseJsonVec3(data["camera"]["normal"]));
 
+		if (buildBatches) {
+			result->BuildStaticBatches();
+		}
+
 		return result;
 	}
 
@@ -462,6 +806,45 @@ struct Scene {
 		nlohmann::json blob = nlohmann::json::parse(content);
 		return FromJson(blob);
 	}
+
+	/// <summary>
+	/// Queues up a scene to be loaded by the IncrementalLoader, behind anything that is already queued (such
+	/// as the resources it uses). Creating the scene, building it's static batches and baking each of it's impostors
+	/// are done as separate slices, so the scene is ready to draw as soon as it's handed back
+	/// </summary>
+	/// <param name="path">The path of the file to read from</param>
+	/// <param name="onLoaded">Invoked with the new scene once it has been fully loaded</param>
+	static void LoadIncremental(const std::string& path, const std::function<void(const Scene::Sptr&)>& onLoaded) {
+		LOG_INFO("Queued scene load from \"{}\"", path);
+		std::shared_ptr<Scene::Sptr> result = std::make_shared<Scene::Sptr>(nullptr);
+		IncrementalLoader::Enqueue(FunctionLoaderTask::Create(path, [path, result]() {
+			std::string content = FileHelpers::ReadFile(path);
+			*result = FromJson(nlohmann::json::parse(content), false);
+		}));
+		IncrementalLoader::Enqueue(FunctionLoaderTask::Create("Static batches", [path, result, onLoaded]() {
+			// If the scene failed to load, the loader will have already logged why
+			Scene::Sptr scene = *result;
+			if (scene == nullptr) {
+				return;
+			}
+			scene->BuildStaticBatches();
+
+			// We don't know how many objects there are until the scene has been read, so the rest of the load is
+			// queued from here. Impostors need actual texture data to bake with, so we let the streamer finish first
+			IncrementalLoader::Enqueue(WaitLoaderTask::Create("Decoding textures",
+				[]() { return TextureStreamer::GetPendingCount() == 0; },
+				[]() { TextureStreamer::WaitForPending(0.0f); }));
+			IncrementalLoader::Enqueue(LoopLoaderTask::Create("Impostors", scene->Objects.size(), [scene](size_t index) {
+				if (index == 0) {
+					scene->ClearImpostors();
+				}
+				scene->BakeImpostor(scene->Objects[index]);
+			}));
+			IncrementalLoader::Enqueue(FunctionLoaderTask::Create(path, [scene, onLoaded]() {
+				onLoaded(scene);
+			}));
+		}));
+	}
 };
 
 /// <summary>
@@ -500,9 +883,10 @@ void SetupShaderAndLights(const Shader::Sptr& shader, Light* lights, int numLigh
 /// Draws a widget for saving or loading our scene
 /// </summary>
 /// <param name="scene">Reference to scene pointer</param>
+/// <param name="loadedScene">Reference to the scene pointer that will receive the new scene once it's loaded</param>
 /// <param name="path">Reference to path string storage</param>
-/// <returns>True if a new scene has been loaded</returns>
-bool DrawSaveLoadImGui(Scene::Sptr& scene, std::string& path) {
+/// <returns>True if a new scene has started loading</returns>
+bool DrawSaveLoadImGui(Scene::Sptr& scene, Scene::Sptr& loadedScene, std::string& path) {
 	// Since we can change the internal capacity of an std::string,
 	// we can do cool things like this!
 	ImGui::InputText("Path", path.data(), path.capacity());
@@ -512,17 +896,55 @@ bool DrawSaveLoadImGui(Scene::Sptr& scene, std::string& path) {
 		scene->Save(path);
 	}
 	ImGui::SameLine();
-	// Load scene from file button
-	if (ImGui::Button("Load")) {
-		// Since it's a reference to a ptr, this will
-		// overwrite the existing scene!
-		scene = Scene::Load(path);
+	// Load scene from file button, the scene is loaded over the next few frames so we don't allow
+	// another load to start until it's done
+	if (IncrementalLoader::IsBusy()) {
+		ImGui::Text("Loading... %.0f%%", IncrementalLoader::GetProgress());
+	}
+	else if (ImGui::Button("Load")) {
+		// The old scene keeps running until the new one is ready to be swapped in
+		Scene::Sptr* result = &loadedScene;
+		Scene::LoadIncremental(path, [result](const Scene::Sptr& loaded) {
+			*result = loaded;
+		});
 
 		return true;
 	}
 	return false;
 }
 
+/// <summary>
+/// Shows a progress bar while the incremental loader works through it's queue, giving the loader most of
+/// each frame since there's nothing else to draw
+/// </summary>
+/// <param name="window">The window to draw the load screen to</param>
+void RunLoadScreen(GLFWwindow* window) {
+	float budget = IncrementalLoader::GetBudget();
+	IncrementalLoader::SetBudget(12.0f);
+
+	while (IncrementalLoader::IsBusy() && !glfwWindowShouldClose(window)) {
+		glfwPollEvents();
+		ImGuiHelper::StartFrame();
+
+		IncrementalLoader::Update();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(400.0f, 0.0f), ImGuiCond_Always);
+		if (ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse)) {
+			IncrementalLoader::DrawImGui();
+		}
+		ImGui::End();
+
+		ImGuiHelper::EndFrame();
+		glfwSwapBuffers(window);
+	}
+
+	// If the window was closed part way through we still finish the load, so that we have a complete scene to clean up
+	IncrementalLoader::Flush();
+	IncrementalLoader::SetBudget(budget);
+}
+
 /// <summary>
 /// Draws some ImGui controls for the given light
 /// </summary>
@@ -544,6 +966,109 @@ bool DrawLightImGui(const char* title, Light& light) {
 	return result;
 }
 
+/// <summary>
+/// Renders all the objects in the scene that are on one of the given layers, from the given camera
+/// </summary>
+/// <param name="scene">The scene to render</param>
+/// <param name="impostorShader">The shader to draw impostors with</param>
+/// <param name="lightmapShader">The shader to draw static objects with when the scene has a lightmap</param>
+/// <param name="camera">The camera to render from</param>
+/// <param name="cullMask">A bitmask of the layers to draw, objects on other layers are skipped</param>
+/// <param name="viewportSize">The size of the target we're rendering to, in pixels</param>
+void RenderScene(const Scene::Sptr& scene, const Shader::Sptr& impostorShader, const Shader::Sptr& lightmapShader, const Camera::Sptr& camera, uint32_t cullMask, const glm::ivec2& viewportSize) {
+	Shader::Sptr shader = scene->BaseShader;
+
+	// Bind our shader for use
+	shader->Bind();
+
+	// Update our application level uniforms every frame
+	shader->SetUniform("u_CamPos", camera->GetPosition());
+
+	// Static objects with baked lighting get drawn after everything else, so we only swap shaders once
+	bool useLightmap = scene->UseLightmap && scene->Lightmap != nullptr;
+	std::vector<const RenderObject*> lightmapped;
+
+	// Render all our objects
+	for (RenderObject& object : scene->Objects) {
+		if ((cullMask & (1u << object.Layer)) == 0) {
+			continue;
+		}
+
+		// Let the texture streamer know roughly how many pixels this object's texture covers
+		if (object.Material->Texture != nullptr) {
+			if (object.BoundingRadius < 0.0f) {
+				object.RecalcBounds();
+			}
+			glm::vec3 scale = glm::abs(object.Scale);
+			float radius = object.BoundingRadius * glm::max(scale.x, glm::max(scale.y, scale.z));
+			float dist = glm::max(glm::distance(camera->GetPosition(), object.Position), 0.01f);
+			float screenPixels = radius * camera->GetProjection()[1][1] * viewportSize.y / dist;
+			TextureStreamer::ReportUsage(object.Material->Texture, screenPixels);
+		}
+
+		if (useLightmap && object.LightmapMesh != nullptr) {
+			// Lightmapped objects use their own shader, so they're drawn together after this loop
+			lightmapped.push_back(&object);
+		} else if (object.IsBatched) {
+			// Drawn as part of one of the scene's static batches below
+			continue;
+		} else if (object.Impostor != nullptr && glm::distance(camera->GetPosition(), object.Position) > object.ImpostorDistance) {
+			// Far away objects are swapped out for their impostor, which we'll draw all at once later
+			object.Impostor->AddInstance(object.Transform);
+		} else {
+			// Set vertex shader parameters
+			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * object.Transform);
+			shader->SetUniformMatrix("u_Model", object.Transform);
+			shader->SetUniformMatrix("u_NormalMatrix", glm::mat3(glm::transpose(glm::inverse(object.Transform))));
+
+			// Apply this object's material
+			object.Material->Apply();
+
+			// Draw the object, the base instance selects the material in the material table
+			object.Mesh->DrawInstanced(1, object.Material->TableIndex);
+		}
+	}
+
+	// Draw the static batches that are in view, their vertices are already in world space
+	if (!scene->StaticBatches.empty()) {
+		glm::vec4 frustum[6];
+		StaticBatcher::ExtractFrustum(camera->GetViewProjection(), frustum);
+		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection());
+		shader->SetUniformMatrix("u_Model", MAT4_IDENTITY);
+		shader->SetUniformMatrix("u_NormalMatrix", MAT3_IDENTITY);
+		for (const StaticBatch& batch : scene->StaticBatches) {
+			if ((cullMask & (1u << batch.Layer)) == 0 || !StaticBatcher::IsBoxVisible(frustum, batch.Min, batch.Max)) {
+				continue;
+			}
+			batch.Material->Apply();
+			batch.Mesh->DrawInstanced(1, batch.Material->TableIndex);
+		}
+	}
+
+	// Draw our static objects with their baked lighting
+	if (!lightmapped.empty()) {
+		lightmapShader->Bind();
+		scene->Lightmap->Bind(1);
+		for (const RenderObject* object : lightmapped) {
+			lightmapShader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * object->Transform);
+			lightmapShader->SetUniformMatrix("u_Model", object->Transform);
+			lightmapShader->SetUniformMatrix("u_NormalMatrix", glm::mat3(glm::transpose(glm::inverse(object->Transform))));
+			object->Material->Apply();
+			object->LightmapMesh->Draw();
+		}
+	}
+
+	// Draw all the impostors that were queued up for this view, one instanced draw per impostor
+	if (!scene->Impostors.empty()) {
+		impostorShader->Bind();
+		impostorShader->SetUniformMatrix("u_ViewProjection", camera->GetViewProjection());
+		impostorShader->SetUniform("u_CamPos", camera->GetPosition());
+		for (const Impostor::Sptr& impostor : scene->Impostors) {
+			impostor->Draw(impostorShader);
+		}
+	}
+}
+
 //////////////////////////////////////////////////////
 ////////////////// END OF NEW ////////////////////////
 //////////////////////////////////////////////////////
@@ -570,6 +1095,21 @@ int main() {
 	// Initialize our resource manager
 	ResourceManager::Init();
 
+	// Stream our textures in by mip level, rather than loading everything at full size up front
+	TextureStreamer::Init();
+
+	// Large meshes show up as a coarse version right away, and fill in their detail in the background
+	MeshStreamer::Init();
+
+	// Keep the CPU from running too far ahead of the GPU, so that input isn't stuck behind queued up frames
+	FrameLimiter::Init(window);
+
+	// Lets us save screenshots and record video without stalling on the GPU
+	FrameCapture::Init();
+
+	// Only redraw when something changes, so we don't burn power while the user is idle
+	IdleMode::Init(window);
+
 	// GL states, we'll enable depth testing and backface fulling
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
@@ -582,8 +1122,12 @@ int main() {
 	bool loadScene = false;
 	// For now we can use a toggle to generate our scene vs load from file
 	if (loadScene) {
-		ResourceManager::LoadManifest("manifest.json");
-		scene = Scene::Load("scene.json");
+		// Resources and the scene are loaded a slice at a time behind a load screen, so the window stays responsive
+		ResourceManager::LoadManifestIncremental("manifest.json");
+		Scene::LoadIncremental("scene.json", [&scene](const Scene::Sptr& loaded) {
+			scene = loaded;
+		});
+		RunLoadScreen(window);
 	} 
 	else {
 		// Create our OpenGL resources
@@ -591,8 +1135,15 @@ int main() {
 			{ ShaderPartType::Vertex, "shaders/vertex_shader.glsl" },
 			{ ShaderPartType::Fragment, "shaders/frag_blinn_phong_textured.glsl" }
 		});
-		Guid monkeyMesh = ResourceManager::CreateMesh("Monkey.obj");
-		Guid FlowerMesh = ResourceManager::CreateMesh("Flower.obj");
+		// We'll be clicking on these, so build their BVHs up front
+		Guid monkeyMesh = ResourceManager::CreateMesh("Monkey.obj", true);
+		// The flower is our heaviest mesh, so we convert it to a progressive mesh the first time we run (or if the
+		// one we have was written by an older version)
+		std::string flowerPath = "Flower.pmesh";
+		if (!ProgressiveMesh::IsReadable(flowerPath) && !ProgressiveMesh::Convert(ObjLoader::LoadFromFile("Flower.obj"), flowerPath)) {
+			flowerPath = "Flower.obj";
+		}
+		Guid FlowerMesh = ResourceManager::CreateMesh(flowerPath, true);
 		Guid boxTexture = ResourceManager::CreateTexture("textures/box-diffuse.png");
 		Guid monkeyTex  = ResourceManager::CreateTexture("textures/monkey-uvMap.png");
 		Guid flowerTex = ResourceManager::CreateTexture("textures/flower-uvMap.png");
@@ -611,19 +1162,19 @@ int main() {
 		boxMaterial->Shader = scene->BaseShader;
 		boxMaterial->Texture = ResourceManager::GetTexture(boxTexture);
 		boxMaterial->Shininess = 8.0f;
-		scene->Materials[boxMaterial->GetGUID()] = boxMaterial;
+		scene->AddMaterial(boxMaterial);
 
 		MaterialInfo::Sptr monkeyMaterial = std::make_shared<MaterialInfo>();
 		monkeyMaterial->Shader = scene->BaseShader;
 		monkeyMaterial->Texture = ResourceManager::GetTexture(monkeyTex);
 		monkeyMaterial->Shininess = 1.0f;
-		scene->Materials[monkeyMaterial->GetGUID()] = monkeyMaterial;
+		scene->AddMaterial(monkeyMaterial);
 
 		MaterialInfo::Sptr flowerMaterial = std::make_shared<MaterialInfo>();
 		flowerMaterial->Shader = scene->BaseShader;
 		flowerMaterial->Texture = ResourceManager::GetTexture(flowerTex);
 		flowerMaterial->Shininess = 1.0f;
-		scene->Materials[monkeyMaterial->GetGUID()] = flowerMaterial;
+		scene->AddMaterial(flowerMaterial);
 		// Create some lights for our scene
 		scene->Lights.resize(3);
 		scene->Lights[0].Position = glm::vec3(0.0f, 1.0f, 3.0f);
@@ -646,6 +1197,7 @@ int main() {
 		plane.GenerateMesh();
 		plane.Name = "Plane";
 		plane.Material = boxMaterial;
+		plane.IsStatic = true;
 		scene->Objects.push_back(plane);
 
 		RenderObject square = RenderObject();
@@ -654,6 +1206,7 @@ int main() {
 		square.Position = glm::vec3(0.0f, 0.0f, 2.0f);
 		square.Name = "Square";
 		square.Material = boxMaterial;
+		square.IsStatic = true;
 		scene->Objects.push_back(square);
 
 		RenderObject monkey1 = RenderObject();
@@ -668,19 +1221,53 @@ int main() {
 		Flower2.Mesh     = ResourceManager::GetMesh(FlowerMesh);
 		Flower2.Material = flowerMaterial;
 		Flower2.Rotation.z = 180.0f;
+		Flower2.ImpostorDistance = 6.0f;
 		Flower2.Name = "Flower 2";
 		scene->Objects.push_back(Flower2);
 
+		scene->BuildStaticBatches();
+
 		// Save the scene to a JSON file
 		scene->Save("scene.json");
 	}
 
+	// Shader for drawing the impostors that stand in for far away objects
+	Shader::Sptr impostorShader = Shader::Create();
+	impostorShader->LoadShaderPartFromFile("shaders/vert_impostor.glsl", ShaderPartType::Vertex);
+	impostorShader->LoadShaderPartFromFile("shaders/frag_impostor.glsl", ShaderPartType::Fragment);
+	impostorShader->Link();
+
+	// Shader for drawing static objects with their lighting baked into a lightmap
+	Shader::Sptr lightmapShader = Shader::Create();
+	lightmapShader->LoadShaderPartFromFile("shaders/vert_lightmapped.glsl", ShaderPartType::Vertex);
+	lightmapShader->LoadShaderPartFromFile("shaders/frag_lightmapped.glsl", ShaderPartType::Fragment);
+	lightmapShader->Link();
+	lightmapShader->SetUniform("u_AmbientCol", glm::vec3(0.1f));
+
 	// Post-load setup
 	SetupShaderAndLights(scene->BaseShader, scene->Lights.data(), scene->Lights.size());
+	SetupShaderAndLights(impostorShader, scene->Lights.data(), scene->Lights.size());
+	// Impostors need actual texture data to bake with
+	TextureStreamer::WaitForPending();
+	scene->BakeImpostors();
 
 	RenderObject* monkey1 = scene->FindObjectByName("Monkey 1");
 	RenderObject* Flower2 = scene->FindObjectByName("Flower 2");
 
+	// Secondary views share a per-frame budget, so adding more of them won't tank our frame rate
+	ViewScheduler::Sptr viewScheduler = ViewScheduler::Create();
+
+	// A top down minimap, which doesn't need to be full resolution or updated every frame
+	Camera::Sptr minimapCamera = Camera::Create();
+	minimapCamera->SetPosition(glm::vec3(0.0f, 0.0f, 12.0f));
+	minimapCamera->SetUp(glm::vec3(0.0f, 1.0f, 0.0f));
+	minimapCamera->LookAt(glm::vec3(0.0f));
+	SecondaryView::Sptr minimap = SecondaryView::Create(minimapCamera, 512, 512);
+	minimap->Name = "Minimap";
+	minimap->SetResolutionScale(0.5f);
+	minimap->SetUpdateInterval(0.1f);
+	viewScheduler->AddView(minimap);
+
 	// We'll use this to allow editing the save/load path
 	// via ImGui, note the reserve to allocate extra space
 	// for input!
@@ -689,33 +1276,81 @@ int main() {
 
 	bool isRotating = true;
 
+	// The last thing the user clicked on, and whether the mouse was down last frame so we only pick on the click
+	ScenePick selection;
+	bool wasMouseDown = false;
+
+	// Set when streamed meshes gain detail, so we can re-bake impostors and batches once they're done
+	bool meshesRefined = false;
+	// Scenes loaded from the debug window are loaded over several frames, and swapped in here once they're done
+	Scene::Sptr loadedScene = nullptr;
+
 	// Our high-precision timer
 	double lastFrame = glfwGetTime();
 
 	///// Game loop /////
 	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
+		// Time spent waiting for input shouldn't count towards our animations
+		if (IdleMode::WaitForEvents()) {
+			lastFrame = glfwGetTime();
+		}
+		FrameLimiter::BeginFrame();
 		ImGuiHelper::StartFrame();
 
 		// Calculate the time since our last frame (dt)
 		double thisFrame = glfwGetTime();
 		float dt = static_cast<float>(thisFrame - lastFrame);
 
+		// Give any loads in progress their slice of the frame, and keep drawing until they're done
+		if (IncrementalLoader::Update()) {
+			IdleMode::RequestRedraw();
+		}
+		// Swap in a newly loaded scene before anything gets a chance to use the old one this frame
+		if (loadedScene != nullptr) {
+			scene = loadedScene;
+			loadedScene = nullptr;
+
+			// Re-initialize lights, as they may have moved around
+			SetupShaderAndLights(scene->BaseShader, scene->Lights.data(), scene->Lights.size());
+			SetupShaderAndLights(impostorShader, scene->Lights.data(), scene->Lights.size());
+
+			// Our selection pointed into the old scene
+			selection = ScenePick();
+
+			// Re-fetch the monkeys so we can do a behaviour for them
+			monkey1 = scene->FindObjectByName("Monkey 1");
+			Flower2 = scene->FindObjectByName("Flower2 2");
+			IdleMode::RequestRedraw();
+		}
+
 		// Showcasing how to use the imGui library!
 		bool isDebugWindowOpen = ImGui::Begin("Debugging");
 		if (isDebugWindowOpen) {
 			// Make a checkbox for the monkey rotation
 			ImGui::Checkbox("Rotating", &isRotating);
 
+			// Baking is slow, so we only do it when asked. Lights or static objects that move after baking won't update
+			if (ImGui::Button("Bake Lightmap")) {
+				scene->BakeLightmap();
+			}
+			ImGui::SameLine();
+			ImGui::Checkbox("Use Lightmap", &scene->UseLightmap);
+			// Batches are also only built on load, re-build them if static objects have been edited
+			if (ImGui::Button("Rebuild Static Batches")) {
+				scene->BuildStaticBatches();
+			}
+			ImGui::SameLine();
+			ImGui::Text("%d batches", (int)scene->StaticBatches.size());
+			if (selection.Object != nullptr) {
+				ImGui::Text("Selected: %s (triangle %u)", selection.Object->Name.c_str(), selection.Triangle);
+			} else {
+				ImGui::Text("Selected: none");
+			}
+
 			// Make a new area for the scene saving/loading
 			ImGui::Separator();
-			if (DrawSaveLoadImGui(scene, scenePath)) {
-				// Re-initialize lights, as they may have moved around
-				SetupShaderAndLights(scene->BaseShader, scene->Lights.data(), scene->Lights.size());
-
-				// Re-fetch the monkeys so we can do a behaviour for them
-				monkey1 = scene->FindObjectByName("Monkey 1");
-				Flower2 = scene->FindObjectByName("Flower2 2");
+			if (DrawSaveLoadImGui(scene, loadedScene, scenePath)) {
+				IdleMode::RequestRedraw();
 			}
 			ImGui::Separator();
 		}
@@ -724,20 +1359,61 @@ int main() {
 		if (isRotating) {
 			monkey1->Rotation += glm::vec3(0.0f, 0.0f, dt * 90.0f);
 			Flower2->Rotation -= glm::vec3(0.0f, 0.0f, dt * 90.0f); 
+			IdleMode::RequestRedraw();
 		}
 
-		// Clear the color and depth buffers
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
 		// Grab shorthands to the camera and shader from the scene
 		Shader::Sptr shader = scene->BaseShader;
 		Camera::Sptr camera = scene->Camera;
 
-		// Bind our shader for use
-		shader->Bind();
+		// Grab the freshest input we can right before we move the camera
+		FrameLimiter::SampleLateInput();
+
+		// Fly the camera around with WASD, and Q/E for down/up
+		if (!ImGui::GetIO().WantCaptureKeyboard) {
+			glm::vec3 forward = camera->GetForward();
+			glm::vec3 right = glm::normalize(glm::cross(forward, camera->GetUp()));
+			glm::vec3 movement = glm::vec3(0.0f);
+			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) movement += forward;
+			if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) movement -= forward;
+			if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) movement += right;
+			if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) movement -= right;
+			if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) movement += camera->GetUp();
+			if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) movement -= camera->GetUp();
+			if (glm::length(movement) > 0.0f) {
+				camera->SetPosition(camera->GetPosition() + glm::normalize(movement) * CAMERA_SPEED * dt);
+				IdleMode::RequestRedraw();
+			}
+		}
+
+		// Select whatever is under the cursor when the user clicks on the scene
+		bool isMouseDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (isMouseDown && !wasMouseDown && !ImGui::GetIO().WantCaptureMouse) {
+			double cursorX, cursorY;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+			scene->PickFromCursor(glm::vec2((float)cursorX, (float)cursorY), windowSize, selection);
+			IdleMode::RequestRedraw();
+		}
+		wasMouseDown = isMouseDown;
+
+		// Draw some ImGui stuff for the materials, any edits will be uploaded when we flush the table
+		if (isDebugWindowOpen) {
+			for (auto& [guid, material] : scene->Materials) {
+				ImGui::PushID(material.get());
+				std::string label = material->Name.empty() ? guid.str() : material->Name;
+				if (ImGui::CollapsingHeader(("Material " + label).c_str())) {
+					if (ImGui::DragFloat("Shininess", &material->Shininess, 0.1f, 0.0f, 256.0f)) {
+						scene->UpdateMaterial(material);
+					}
+				}
+				ImGui::PopID();
+			}
+			ImGui::Separator();
+		}
 
-		// Update our application level uniforms every frame
-		shader->SetUniform("u_CamPos", scene->Camera->GetPosition());
+		// Upload any material changes, and bind the table for our draws to index into
+		scene->MaterialTable->Flush();
+		scene->MaterialTable->Bind(0);
 
 		// Draw some ImGui stuff for the lights
 		if (isDebugWindowOpen) {
@@ -746,31 +1422,20 @@ int main() {
 				sprintf_s(buff, "Light %d##%d", ix, ix);
 				if (DrawLightImGui(buff, scene->Lights[ix])) {
 					SetShaderLight(shader, "u_Lights", ix, scene->Lights[ix]);
+					SetShaderLight(impostorShader, "u_Lights", ix, scene->Lights[ix]);
 				}
 			}
 			// Split lights from the objects in ImGui
 			ImGui::Separator();
 		}
 
-
-		// Render all our objects
+		// Update all our objects
 		for (int ix = 0; ix < scene->Objects.size(); ix++) {
 			RenderObject* object = &scene->Objects[ix];
 
 			// Update the object's transform for rendering
 			object->RecalcTransform();
 
-			// Set vertex shader parameters
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * object->Transform);
-			shader->SetUniformMatrix("u_Model", object->Transform);
-			shader->SetUniformMatrix("u_NormalMatrix", glm::mat3(glm::transpose(glm::inverse(object->Transform))));
-
-			// Apply this object's material
-			object->Material->Apply();
-
-			// Draw the object
-			object->Mesh->Draw();
-
 			// If our debug window is open, then let's draw some info for our objects!
 			if (isDebugWindowOpen) {
 				// All these elements will go into the last opened window
@@ -779,27 +1444,126 @@ int main() {
 					ImGui::DragFloat3("Position", &object->Position.x, 0.01f);
 					ImGui::DragFloat3("Rotation", &object->Rotation.x, 1.0f);
 					ImGui::DragFloat3("Scale",    &object->Scale.x, 0.01f, 0.0f);
+					ImGui::Checkbox("Static", &object->IsStatic);
+					int layer = (int)object->Layer;
+					if (ImGui::SliderInt("Layer", &layer, 0, 31)) {
+						object->Layer = (uint32_t)layer;
+					}
+					if (object->Impostor != nullptr) {
+						ImGui::DragFloat("Impostor Distance", &object->ImpostorDistance, 0.1f, 0.0f);
+					}
 					ImGui::PopID(); // Pop the ImGui ID scope for the object
 				}
 			}
 		}
 
+		// Render any secondary views that are due this frame
+		auto renderScene = [&](const Camera::Sptr& viewCamera, uint32_t cullMask, const glm::ivec2& viewportSize) {
+			RenderScene(scene, impostorShader, lightmapShader, viewCamera, cullMask, viewportSize);
+		};
+		viewScheduler->Update(thisFrame, renderScene, windowSize);
+
+		// Clear the color and depth buffers, and render the main view
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		RenderScene(scene, impostorShader, lightmapShader, camera, ALL_LAYERS, windowSize);
+
+		// The demo point cloud is opaque, so it's drawn with the rest of the scene
+		PointCloudDemo::Draw(camera, windowSize.y);
+
+		// Particles are blended over the top of the scene, so they go after everything opaque
+		ParticleDemo::Update(dt);
+		ParticleDemo::Draw(camera);
+
+		// Stream texture mips in or out based on what we drew this frame
+		TextureStreamer::Update();
+
+		// Swap in any mesh detail that finished loading. Bounds were calculated from the coarse pages, so we
+		// re-calculate them, and re-bake anything made from the meshes once they're all at full detail
+		if (MeshStreamer::Update() > 0) {
+			for (RenderObject& object : scene->Objects) {
+				object.BoundingRadius = -1.0f;
+			}
+			meshesRefined = true;
+			IdleMode::RequestRedraw();
+		}
+		if (meshesRefined && MeshStreamer::GetPendingCount() == 0) {
+			scene->BakeImpostors();
+			scene->BuildStaticBatches();
+			meshesRefined = false;
+		}
+
+		// Keep drawing while textures, meshes or point cloud nodes are still streaming in, while we're recording, or while particles are running
+		if (TextureStreamer::GetPendingCount() > 0 || MeshStreamer::GetPendingCount() > 0 || PointCloudDemo::IsStreaming() ||
+			FrameCapture::IsCapturing() || ParticleDemo::IsEnabled()) {
+			IdleMode::RequestRedraw();
+		}
+
 		// If our debug window is open, notify that we no longer will render new
 		// elements to it
 		if (isDebugWindowOpen) {
+			ImGui::Separator();
+			TextureStreamer::DrawImGui();
+			ImGui::Separator();
+			MeshStreamer::DrawImGui();
+			ImGui::Separator();
+			IncrementalLoader::DrawImGui();
+			ImGui::Separator();
+			FrameLimiter::DrawImGui();
+			ImGui::Separator();
+			FrameCapture::DrawImGui();
+			ImGui::Separator();
+			IdleMode::DrawImGui();
+			ImGui::Separator();
+			viewScheduler->DrawImGui();
+			ImGui::Separator();
+			ParticleDemo::DrawImGui(camera);
+			ImGui::Separator();
+			PointCloudDemo::DrawImGui();
+			ImGui::Separator();
+			SimdKernelTests::DrawImGui();
+			ImGui::Separator();
+			MeshCodecTests::DrawImGui();
 			ImGui::End();
 		}
 
 		VertexArrayObject::Unbind();
 
+		// Read back the scene (before ImGui draws over it) if we're capturing
+		FrameCapture::EndFrame(windowSize.x, windowSize.y);
+
+		IdleMode::EndFrame();
+
 		lastFrame = thisFrame;
 		ImGuiHelper::EndFrame();
 		glfwSwapBuffers(window);
+		FrameLimiter::EndFrame();
 	}
 
+	// Give the window it's callbacks back before ImGui unhooks from it
+	IdleMode::Cleanup();
+
 	// Clean up the ImGui library
 	ImGuiHelper::Cleanup();
 
+	// Clean up the impostor baker
+	ImpostorBaker::Cleanup();
+
+	// Finish writing any captured frames
+	FrameCapture::Cleanup();
+
+	// Release any outstanding frame fences
+	FrameLimiter::Cleanup();
+
+	// Stop the particle demo's worker threads and release it's buffers
+	ParticleDemo::Cleanup();
+
+	// Stop the point cloud's loader thread and release it's buffers
+	PointCloudDemo::Cleanup();
+
+	// Stop our texture and mesh streaming threads
+	TextureStreamer::Cleanup();
+	MeshStreamer::Cleanup();
+
 	// Clean up the resource manager
 	ResourceManager::Cleanup();
 
@@ -0,0 +1,262 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+main.cpp
+Benchmark for Entity::UpdateTransforms.
+Times the single pass over the depth-first sorted nodes against the recursive
+updates NOU used to do, on deep chains, wide fan-outs, and forests of short chains.
+The parallel pass hands separate subtrees to the worker threads, so the forests
+and fan-outs can be threaded, while a chain has to be done in order.
+*/
+
+#include "NOU/Entity.h"
+
+#include "GLM/gtx/transform.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace nou;
+
+//How many frames we time each update over.
+static const int NUM_FRAMES = 50;
+
+//The hierarchy we're timing, plus its parent links for the old code to walk.
+//(Transform keeps its parent to itself, so we hang on to our own copy.)
+struct Hierarchy
+{
+	const char* name;
+	std::vector<std::unique_ptr<Entity>> entities;
+	std::vector<int> parents;
+};
+
+//This is how RecomputeGlobal used to work - every call rebuilds the local
+//matrix of the object and every one of its ancestors, all the way up to the root.
+static glm::mat4 OldRecomputeGlobal(const Hierarchy& h, int ix)
+{
+	const Transform& t = h.entities[ix]->transform;
+
+	glm::mat4 local = glm::translate(t.m_pos) *
+					  glm::toMat4(t.m_rotation) *
+					  glm::scale(t.m_scale);
+
+	if (h.parents[ix] >= 0)
+		return OldRecomputeGlobal(h, h.parents[ix]) * local;
+
+	return local;
+}
+
+//This is how DoFK used to work - recursive from each root,
+//but every object is only computed once.
+static void OldDoFK(const Hierarchy& h, const std::vector<std::vector<int>>& children,
+					int ix, const glm::mat4& parentGlobal, std::vector<glm::mat4>& globals)
+{
+	const Transform& t = h.entities[ix]->transform;
+
+	glm::mat4 local = glm::translate(t.m_pos) *
+					  glm::toMat4(glm::normalize(t.m_rotation)) *
+					  glm::scale(t.m_scale);
+
+	globals[ix] = parentGlobal * local;
+
+	for (int child : children[ix])
+		OldDoFK(h, children, child, globals[ix], globals);
+}
+
+static int AddNode(Hierarchy& h, int parent)
+{
+	h.entities.push_back(Entity::Allocate());
+	h.parents.push_back(parent);
+
+	int ix = (int)h.entities.size() - 1;
+	Transform& t = h.entities[ix]->transform;
+
+	//A little bit of everything, so none of the matrices are trivial.
+	t.m_pos = glm::vec3(0.1f * (ix % 7), 0.2f, -0.05f * (ix % 3));
+	t.m_rotation = glm::angleAxis(0.01f * (ix % 11), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+	t.m_scale = glm::vec3(1.0f);
+
+	if (parent >= 0)
+		t.SetParent(&h.entities[parent]->transform);
+
+	return ix;
+}
+
+static Hierarchy MakeChain(const char* name, size_t length)
+{
+	Hierarchy h;
+	h.name = name;
+
+	int parent = -1;
+
+	for (size_t ix = 0; ix < length; ++ix)
+		parent = AddNode(h, parent);
+
+	return h;
+}
+
+static Hierarchy MakeFanOut(const char* name, size_t width)
+{
+	Hierarchy h;
+	h.name = name;
+
+	int root = AddNode(h, -1);
+
+	for (size_t ix = 0; ix < width; ++ix)
+		AddNode(h, root);
+
+	return h;
+}
+
+static Hierarchy MakeForest(const char* name, size_t chains, size_t length)
+{
+	Hierarchy h;
+	h.name = name;
+
+	for (size_t c = 0; c < chains; ++c)
+	{
+		int parent = -1;
+
+		for (size_t ix = 0; ix < length; ++ix)
+			parent = AddNode(h, parent);
+	}
+
+	return h;
+}
+
+//Nudges every object, so that every update has to recompute everything.
+static void MoveEverything(Hierarchy& h, int frame)
+{
+	float offset = (frame % 2 == 0) ? 0.001f : -0.001f;
+
+	for (auto& entity : h.entities)
+		entity->transform.m_pos.x += offset;
+}
+
+template<typename Func>
+static double TimeFrames(Hierarchy& h, bool move, Func update)
+{
+	double total = 0.0;
+
+	for (int frame = 0; frame < NUM_FRAMES; ++frame)
+	{
+		if (move)
+			MoveEverything(h, frame);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		update();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		total += std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	return total / NUM_FRAMES;
+}
+
+static void RunBenchmark(Hierarchy& h)
+{
+	size_t count = h.entities.size();
+	std::vector<glm::mat4> globals(count);
+
+	std::vector<std::vector<int>> children(count);
+
+	for (size_t ix = 0; ix < count; ++ix)
+	{
+		if (h.parents[ix] >= 0)
+			children[h.parents[ix]].push_back((int)ix);
+	}
+
+	//The first update sorts the hierarchy, which only happens again when it changes.
+	//We time that separately, so it doesn't get mixed in with the per-frame cost.
+	auto start = std::chrono::high_resolution_clock::now();
+	Entity::UpdateTransforms(false);
+	double sortMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	double oldRecompute = TimeFrames(h, true, [&]()
+	{
+		for (size_t ix = 0; ix < count; ++ix)
+			globals[ix] = OldRecomputeGlobal(h, (int)ix);
+	});
+
+	double oldFK = TimeFrames(h, true, [&]()
+	{
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			if (h.parents[ix] < 0)
+				OldDoFK(h, children, (int)ix, glm::mat4(1.0f), globals);
+		}
+	});
+
+	double serial = TimeFrames(h, true, []() { Entity::UpdateTransforms(false); });
+	double parallel = TimeFrames(h, true, []() { Entity::UpdateTransforms(true); });
+	double unchanged = TimeFrames(h, false, []() { Entity::UpdateTransforms(true); });
+
+	//Make sure we're actually getting the same answers as the old code.
+	for (size_t ix = 0; ix < count; ++ix)
+	{
+		if (h.parents[ix] < 0)
+			OldDoFK(h, children, (int)ix, glm::mat4(1.0f), globals);
+	}
+
+	float maxError = 0.0f;
+
+	for (size_t ix = 0; ix < count; ++ix)
+	{
+		const glm::mat4& global = h.entities[ix]->transform.GetGlobal();
+
+		for (int col = 0; col < 4; ++col)
+		{
+			for (int row = 0; row < 4; ++row)
+				maxError = glm::max(maxError, glm::abs(global[col][row] - globals[ix][col][row]));
+		}
+	}
+
+	printf("%-28s %7zu nodes\n", h.name, count);
+	printf("    old RecomputeGlobal per object: %9.3f ms\n", oldRecompute);
+	printf("    old DoFK from each root:        %9.3f ms\n", oldFK);
+	printf("    UpdateTransforms (serial):      %9.3f ms  (%.1fx old DoFK)\n", serial, oldFK / serial);
+	printf("    UpdateTransforms (parallel):    %9.3f ms  (%.1fx old DoFK)\n", parallel, oldFK / parallel);
+	printf("    UpdateTransforms (nothing moved): %7.3f ms\n", unchanged);
+	printf("    first update (with sort):       %9.3f ms\n", sortMs);
+	printf("    max difference from old DoFK:   %9.2e\n\n", maxError);
+}
+
+int main()
+{
+	printf("Timing %d frames per update, %u hardware threads.\n\n",
+		NUM_FRAMES, std::thread::hardware_concurrency());
+
+	//The old code recursed once per parent, so chains are kept short enough
+	//not to overflow the stack. Every object in a chain depends on the one
+	//above it, so a chain never gets threaded however long it is.
+	{
+		Hierarchy h = MakeChain("Deep chain", 256);
+		RunBenchmark(h);
+	}
+	{
+		Hierarchy h = MakeChain("Deep chain", 2048);
+		RunBenchmark(h);
+	}
+	{
+		Hierarchy h = MakeFanOut("Wide fan-out", 1024);
+		RunBenchmark(h);
+	}
+	{
+		Hierarchy h = MakeFanOut("Wide fan-out", 32768);
+		RunBenchmark(h);
+	}
+	{
+		Hierarchy h = MakeForest("Forest (chains of 16)", 1024, 16);
+		RunBenchmark(h);
+	}
+	{
+		Hierarchy h = MakeForest("Forest (chains of 16)", 8192, 16);
+		RunBenchmark(h);
+	}
+
+	return 0;
+}
\ No newline at end of file